@@ -665,4 +665,45 @@ JNI_CreateJavaVM(JavaVM **p_jvm, void **p_jnienv, void *vm_args);
 jint JNICALL
 JNI_GetCreatedJavaVMs(JavaVM **vmBuf, jsize bufLen, jsize *nVMs);
 
+/* The following are WINJ extensions, not part of the specification. */
+
+/**
+ * Statistics about garbage collection in a virtual machine.  Pause
+ * times are in microseconds of processor time.  Collections empty the
+ * whole heap, including the nursery, while minor collections empty
+ * only the nursery.  Setting WINJ_GC to "marksweep" disables the
+ * nursery. */
+struct WINJGCStats {
+  jlong collections;  /* number of collections so far */
+  jlong pause_total;  /* time spent in all collections */
+  jlong pause_last;   /* time spent in most recent collection */
+  jlong pause_max;    /* time spent in longest collection */
+  jlong heap_bytes;   /* bytes in heap regions */
+  jlong live_bytes;   /* bytes in objects kept by last collection */
+  jlong freed_bytes;  /* bytes in objects reclaimed so far */
+  jlong minor_collections; /* number of times nursery was emptied */
+  jlong minor_pause_total; /* time spent emptying nursery */
+  jlong minor_pause_max;   /* longest time spent emptying nursery */
+  jlong promoted_bytes;    /* bytes copied out of nursery so far */
+};
+typedef struct WINJGCStats WINJGCStats;
+
+jint JNICALL
+WINJ_GetGCStats(JavaVM *jvm, WINJGCStats *stats);
+
+/**
+ * Statistics about compilation of hot methods to machine code.  These
+ * are all zero where no compiler is available or when WINJ_JIT is set
+ * to "off".  Otherwise WINJ_JIT may give the number of invocations
+ * and loop iterations after which a method is compiled. */
+struct WINJJITStats {
+  jlong compiled;   /* methods compiled so far */
+  jlong code_bytes; /* bytes of machine code generated */
+  jlong entries;    /* times compiled code was run */
+};
+typedef struct WINJJITStats WINJJITStats;
+
+jint JNICALL
+WINJ_GetJITStats(JavaVM *jvm, WINJJITStats *stats);
+
 #endif /* RIPPLE_WINJ_H */
@@ -21,7 +21,12 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#include <math.h>
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include "ripple/winj.h"
 
 /**
@@ -113,6 +118,992 @@ unsigned char check_class[] = {
   0x01, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x02, 0x00,
   0x1D };
 
+/**
+ * A compiled Java class with static methods that exercise the byte
+ * code interpreter: loops, long and double arithmetic, recursion,
+ * static fields and both kinds of switch statement.
+ *
+ public class Loop {
+    public static int count = 0;
+
+    public static int factorial(int nn) {
+        int result;
+        for (result = 1; nn > 0; --nn)
+            result *= nn;
+        return result;
+    }
+
+    public static int nested(int nn) {
+        int total = 0;
+        for (int ii = 0; ii < nn; ++ii)
+            for (int jj = 0; jj < nn; ++jj)
+                total += (ii ^ jj) & 7;
+        return total;
+    }
+
+    public static long fibonacci(int nn) {
+        long aa = 0, bb = 1;
+        for (int ii = 0; ii < nn; ++ii) {
+            long cc = aa + bb;
+            aa = bb;
+            bb = cc;
+        }
+        return aa;
+    }
+
+    public static int depth(int nn) {
+        ++count;
+        return (nn > 0) ? depth(nn - 1) + 1 : 0;
+    }
+
+    public static int choose(int nn) {
+        switch (nn) {
+        case 0: return 10;
+        case 1: return 20;
+        case 2: return 30;
+        case 3: return 40;
+        default: return -1;
+        }
+    }
+
+    public static int sparse(int nn) {
+        switch (nn) {
+        case -1000: return 1000;
+        case 7: return 2;
+        case 300: return 3;
+        case 100000: return 4;
+        default: return 0;
+        }
+    }
+
+    public static int harmonic(int nn) {
+        double sum = 0.0;
+        for (int ii = 1; ii <= nn; ++ii)
+            sum += 1.0 / ii;
+        return (int)(sum * 1000.0);
+    }
+ } */
+unsigned char loop_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x1C, 0x01, 0x00, 0x04, 0x4C, 0x6F, 0x6F,
+  0x70, 0x07, 0x00, 0x01, 0x01, 0x00, 0x10, 0x6A,
+  0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61, 0x6E, 0x67,
+  0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63, 0x74, 0x07,
+  0x00, 0x03, 0x01, 0x00, 0x05, 0x63, 0x6F, 0x75,
+  0x6E, 0x74, 0x01, 0x00, 0x01, 0x49, 0x01, 0x00,
+  0x06, 0x3C, 0x69, 0x6E, 0x69, 0x74, 0x3E, 0x01,
+  0x00, 0x03, 0x28, 0x29, 0x56, 0x0C, 0x00, 0x07,
+  0x00, 0x08, 0x0A, 0x00, 0x04, 0x00, 0x09, 0x01,
+  0x00, 0x04, 0x43, 0x6F, 0x64, 0x65, 0x01, 0x00,
+  0x09, 0x66, 0x61, 0x63, 0x74, 0x6F, 0x72, 0x69,
+  0x61, 0x6C, 0x01, 0x00, 0x04, 0x28, 0x49, 0x29,
+  0x49, 0x01, 0x00, 0x06, 0x6E, 0x65, 0x73, 0x74,
+  0x65, 0x64, 0x01, 0x00, 0x09, 0x66, 0x69, 0x62,
+  0x6F, 0x6E, 0x61, 0x63, 0x63, 0x69, 0x01, 0x00,
+  0x04, 0x28, 0x49, 0x29, 0x4A, 0x0C, 0x00, 0x05,
+  0x00, 0x06, 0x09, 0x00, 0x02, 0x00, 0x11, 0x01,
+  0x00, 0x05, 0x64, 0x65, 0x70, 0x74, 0x68, 0x0C,
+  0x00, 0x13, 0x00, 0x0D, 0x0A, 0x00, 0x02, 0x00,
+  0x14, 0x01, 0x00, 0x06, 0x63, 0x68, 0x6F, 0x6F,
+  0x73, 0x65, 0x01, 0x00, 0x06, 0x73, 0x70, 0x61,
+  0x72, 0x73, 0x65, 0x06, 0x40, 0x8F, 0x40, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08, 0x68,
+  0x61, 0x72, 0x6D, 0x6F, 0x6E, 0x69, 0x63, 0x01,
+  0x00, 0x08, 0x3C, 0x63, 0x6C, 0x69, 0x6E, 0x69,
+  0x74, 0x3E, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x09, 0x00, 0x05,
+  0x00, 0x06, 0x00, 0x00, 0x00, 0x09, 0x00, 0x01,
+  0x00, 0x07, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x0A,
+  0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00,
+  0x0C, 0x00, 0x0D, 0x00, 0x01, 0x00, 0x0B, 0x00,
+  0x00, 0x00, 0x1E, 0x00, 0x02, 0x00, 0x02, 0x00,
+  0x00, 0x00, 0x12, 0x04, 0x3C, 0x1A, 0x9E, 0x00,
+  0x0D, 0x1B, 0x1A, 0x68, 0x3C, 0x84, 0x00, 0xFF,
+  0xA7, 0xFF, 0xF5, 0x1B, 0xAC, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x09, 0x00, 0x0E, 0x00, 0x0D, 0x00,
+  0x01, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x33, 0x00,
+  0x03, 0x00, 0x04, 0x00, 0x00, 0x00, 0x27, 0x03,
+  0x3C, 0x03, 0x3D, 0x1C, 0x1A, 0xA2, 0x00, 0x1F,
+  0x03, 0x3E, 0x1D, 0x1A, 0xA2, 0x00, 0x12, 0x1B,
+  0x1C, 0x1D, 0x82, 0x10, 0x07, 0x7E, 0x60, 0x3C,
+  0x84, 0x03, 0x01, 0xA7, 0xFF, 0xEF, 0x84, 0x02,
+  0x01, 0xA7, 0xFF, 0xE2, 0x1B, 0xAC, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x09, 0x00, 0x0F, 0x00, 0x10,
+  0x00, 0x01, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x2B,
+  0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 0x1F,
+  0x09, 0x40, 0x0A, 0x42, 0x03, 0x36, 0x05, 0x15,
+  0x05, 0x1A, 0xA2, 0x00, 0x13, 0x1F, 0x21, 0x61,
+  0x37, 0x06, 0x21, 0x40, 0x16, 0x06, 0x42, 0x84,
+  0x05, 0x01, 0xA7, 0xFF, 0xED, 0x1F, 0xAD, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x13, 0x00,
+  0x0D, 0x00, 0x01, 0x00, 0x0B, 0x00, 0x00, 0x00,
+  0x25, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x19, 0xB2, 0x00, 0x12, 0x04, 0x60, 0xB3, 0x00,
+  0x12, 0x1A, 0x9E, 0x00, 0x0E, 0x1A, 0x04, 0x64,
+  0xB8, 0x00, 0x15, 0x04, 0x60, 0xA7, 0x00, 0x04,
+  0x03, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x16, 0x00, 0x0D, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x3A, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x2E, 0x1A, 0xAA, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x2B, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x1F,
+  0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00, 0x25,
+  0x00, 0x00, 0x00, 0x28, 0x10, 0x0A, 0xAC, 0x10,
+  0x14, 0xAC, 0x10, 0x1E, 0xAC, 0x10, 0x28, 0xAC,
+  0x02, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x17, 0x00, 0x0D, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x44, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x38, 0x1A, 0xAB, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x35, 0x00, 0x00, 0x00, 0x04,
+  0xFF, 0xFF, 0xFC, 0x18, 0x00, 0x00, 0x00, 0x2B,
+  0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x2F,
+  0x00, 0x00, 0x01, 0x2C, 0x00, 0x00, 0x00, 0x31,
+  0x00, 0x01, 0x86, 0xA0, 0x00, 0x00, 0x00, 0x33,
+  0x11, 0x03, 0xE8, 0xAC, 0x05, 0xAC, 0x06, 0xAC,
+  0x07, 0xAC, 0x03, 0xAC, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x09, 0x00, 0x1A, 0x00, 0x0D, 0x00, 0x01,
+  0x00, 0x0B, 0x00, 0x00, 0x00, 0x29, 0x00, 0x06,
+  0x00, 0x04, 0x00, 0x00, 0x00, 0x1D, 0x0E, 0x48,
+  0x04, 0x3E, 0x1D, 0x1A, 0xA3, 0x00, 0x10, 0x27,
+  0x0F, 0x1D, 0x87, 0x6F, 0x63, 0x48, 0x84, 0x03,
+  0x01, 0xA7, 0xFF, 0xF1, 0x27, 0x14, 0x00, 0x18,
+  0x6B, 0x8E, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x1B, 0x00, 0x08, 0x00, 0x01, 0x00,
+  0x0B, 0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x05, 0x03, 0xB3, 0x00,
+  0x12, 0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ * Compiled Java classes for checking objects and virtual methods.
+ * Bird overrides legs() so that the call in Animal.total() reaches a
+ * different method depending on the class of the receiver.
+ *
+ public class Animal {
+    public int legs() { return 4; }
+
+    public int total(int nn) {
+        int sum = 0;
+        for (int ii = 0; ii < nn; ++ii)
+            sum += legs();
+        return sum;
+    }
+
+    public static int count(int kind, int nn) {
+        Animal animal = (kind == 0) ? new Animal() : new Bird();
+        return animal.total(nn);
+    }
+
+    public static int missing(int nn) {
+        Animal animal = null;
+        return animal.legs();
+    }
+ } */
+unsigned char animal_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x19, 0x01, 0x00, 0x06, 0x41, 0x6E, 0x69,
+  0x6D, 0x61, 0x6C, 0x07, 0x00, 0x01, 0x01, 0x00,
+  0x10, 0x6A, 0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61,
+  0x6E, 0x67, 0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63,
+  0x74, 0x07, 0x00, 0x03, 0x01, 0x00, 0x06, 0x3C,
+  0x69, 0x6E, 0x69, 0x74, 0x3E, 0x01, 0x00, 0x03,
+  0x28, 0x29, 0x56, 0x0C, 0x00, 0x05, 0x00, 0x06,
+  0x0A, 0x00, 0x04, 0x00, 0x07, 0x01, 0x00, 0x04,
+  0x43, 0x6F, 0x64, 0x65, 0x01, 0x00, 0x04, 0x6C,
+  0x65, 0x67, 0x73, 0x01, 0x00, 0x03, 0x28, 0x29,
+  0x49, 0x0C, 0x00, 0x0A, 0x00, 0x0B, 0x0A, 0x00,
+  0x02, 0x00, 0x0C, 0x01, 0x00, 0x05, 0x74, 0x6F,
+  0x74, 0x61, 0x6C, 0x01, 0x00, 0x04, 0x28, 0x49,
+  0x29, 0x49, 0x0A, 0x00, 0x02, 0x00, 0x07, 0x01,
+  0x00, 0x04, 0x42, 0x69, 0x72, 0x64, 0x07, 0x00,
+  0x11, 0x0A, 0x00, 0x12, 0x00, 0x07, 0x0C, 0x00,
+  0x0E, 0x00, 0x0F, 0x0A, 0x00, 0x02, 0x00, 0x14,
+  0x01, 0x00, 0x05, 0x63, 0x6F, 0x75, 0x6E, 0x74,
+  0x01, 0x00, 0x05, 0x28, 0x49, 0x49, 0x29, 0x49,
+  0x01, 0x00, 0x07, 0x6D, 0x69, 0x73, 0x73, 0x69,
+  0x6E, 0x67, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x01,
+  0x00, 0x05, 0x00, 0x06, 0x00, 0x01, 0x00, 0x09,
+  0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x08,
+  0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x0A, 0x00, 0x0B, 0x00, 0x01, 0x00, 0x09, 0x00,
+  0x00, 0x00, 0x0E, 0x00, 0x01, 0x00, 0x01, 0x00,
+  0x00, 0x00, 0x02, 0x07, 0xAC, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x01, 0x00, 0x0E, 0x00, 0x0F, 0x00,
+  0x01, 0x00, 0x09, 0x00, 0x00, 0x00, 0x24, 0x00,
+  0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0x18, 0x03,
+  0x3D, 0x03, 0x3E, 0x1D, 0x1B, 0xA2, 0x00, 0x10,
+  0x1C, 0x2A, 0xB6, 0x00, 0x0D, 0x60, 0x3D, 0x84,
+  0x03, 0x01, 0xA7, 0xFF, 0xF1, 0x1C, 0xAC, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x16, 0x00,
+  0x17, 0x00, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00,
+  0x28, 0x00, 0x02, 0x00, 0x03, 0x00, 0x00, 0x00,
+  0x1C, 0x1A, 0x9A, 0x00, 0x0D, 0xBB, 0x00, 0x02,
+  0x59, 0xB7, 0x00, 0x10, 0xA7, 0x00, 0x0A, 0xBB,
+  0x00, 0x12, 0x59, 0xB7, 0x00, 0x13, 0x4D, 0x2C,
+  0x1B, 0xB6, 0x00, 0x15, 0xAC, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x09, 0x00, 0x18, 0x00, 0x0F, 0x00,
+  0x01, 0x00, 0x09, 0x00, 0x00, 0x00, 0x13, 0x00,
+  0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x07, 0x01,
+  0x4C, 0x2B, 0xB6, 0x00, 0x0D, 0xAC, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00 };
+
+/**
+ public class Bird extends Animal {
+    public int legs() { return super.legs() / 2; }
+ } */
+unsigned char bird_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0E, 0x01, 0x00, 0x04, 0x42, 0x69, 0x72,
+  0x64, 0x07, 0x00, 0x01, 0x01, 0x00, 0x06, 0x41,
+  0x6E, 0x69, 0x6D, 0x61, 0x6C, 0x07, 0x00, 0x03,
+  0x01, 0x00, 0x06, 0x3C, 0x69, 0x6E, 0x69, 0x74,
+  0x3E, 0x01, 0x00, 0x03, 0x28, 0x29, 0x56, 0x0C,
+  0x00, 0x05, 0x00, 0x06, 0x0A, 0x00, 0x04, 0x00,
+  0x07, 0x01, 0x00, 0x04, 0x43, 0x6F, 0x64, 0x65,
+  0x01, 0x00, 0x04, 0x6C, 0x65, 0x67, 0x73, 0x01,
+  0x00, 0x03, 0x28, 0x29, 0x49, 0x0C, 0x00, 0x0A,
+  0x00, 0x0B, 0x0A, 0x00, 0x04, 0x00, 0x0C, 0x00,
+  0x21, 0x00, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x02, 0x00, 0x01, 0x00, 0x05, 0x00,
+  0x06, 0x00, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00,
+  0x11, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x05, 0x2A, 0xB7, 0x00, 0x08, 0xB1, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x0A, 0x00, 0x0B,
+  0x00, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00, 0x13,
+  0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x07,
+  0x2A, 0xB7, 0x00, 0x0D, 0x05, 0x6C, 0xAC, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ * Classes with instance fields of every type.  Node.chain() builds a
+ * linked list which is long enough that collections move most of it
+ * while only the head is held by a local variable.
+ *
+ public class Node {
+    public byte tag;
+    public boolean flag;
+    public char letter;
+    public short small;
+    public int count;
+    public float ratio;
+    public long big;
+    public double exact;
+    public Node next;
+
+    public static long chain(int nn) {
+        Node head = null;
+        for (int ii = 0; ii < nn; ++ii) {
+            Node node = new Node();
+            node.count = ii;
+            node.big = ii;
+            node.tag = (byte)ii;
+            node.next = head;
+            head = node;
+        }
+        long sum = 0;
+        for (; head != null; head = head.next)
+            sum += head.big + head.count + head.tag;
+        return sum;
+    }
+ } */
+unsigned char node_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x27, 0x01, 0x00, 0x04, 0x4E, 0x6F, 0x64,
+  0x65, 0x07, 0x00, 0x01, 0x01, 0x00, 0x10, 0x6A,
+  0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61, 0x6E, 0x67,
+  0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63, 0x74, 0x07,
+  0x00, 0x03, 0x01, 0x00, 0x03, 0x74, 0x61, 0x67,
+  0x01, 0x00, 0x01, 0x42, 0x01, 0x00, 0x04, 0x66,
+  0x6C, 0x61, 0x67, 0x01, 0x00, 0x01, 0x5A, 0x01,
+  0x00, 0x06, 0x6C, 0x65, 0x74, 0x74, 0x65, 0x72,
+  0x01, 0x00, 0x01, 0x43, 0x01, 0x00, 0x05, 0x73,
+  0x6D, 0x61, 0x6C, 0x6C, 0x01, 0x00, 0x01, 0x53,
+  0x01, 0x00, 0x05, 0x63, 0x6F, 0x75, 0x6E, 0x74,
+  0x01, 0x00, 0x01, 0x49, 0x01, 0x00, 0x05, 0x72,
+  0x61, 0x74, 0x69, 0x6F, 0x01, 0x00, 0x01, 0x46,
+  0x01, 0x00, 0x03, 0x62, 0x69, 0x67, 0x01, 0x00,
+  0x01, 0x4A, 0x01, 0x00, 0x05, 0x65, 0x78, 0x61,
+  0x63, 0x74, 0x01, 0x00, 0x01, 0x44, 0x01, 0x00,
+  0x04, 0x6E, 0x65, 0x78, 0x74, 0x01, 0x00, 0x06,
+  0x4C, 0x4E, 0x6F, 0x64, 0x65, 0x3B, 0x01, 0x00,
+  0x06, 0x3C, 0x69, 0x6E, 0x69, 0x74, 0x3E, 0x01,
+  0x00, 0x03, 0x28, 0x29, 0x56, 0x0C, 0x00, 0x17,
+  0x00, 0x18, 0x0A, 0x00, 0x04, 0x00, 0x19, 0x0A,
+  0x00, 0x02, 0x00, 0x19, 0x0C, 0x00, 0x0D, 0x00,
+  0x0E, 0x09, 0x00, 0x02, 0x00, 0x1C, 0x0C, 0x00,
+  0x11, 0x00, 0x12, 0x09, 0x00, 0x02, 0x00, 0x1E,
+  0x0C, 0x00, 0x05, 0x00, 0x06, 0x09, 0x00, 0x02,
+  0x00, 0x20, 0x0C, 0x00, 0x15, 0x00, 0x16, 0x09,
+  0x00, 0x02, 0x00, 0x22, 0x01, 0x00, 0x05, 0x63,
+  0x68, 0x61, 0x69, 0x6E, 0x01, 0x00, 0x04, 0x28,
+  0x49, 0x29, 0x4A, 0x01, 0x00, 0x04, 0x43, 0x6F,
+  0x64, 0x65, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x09, 0x00, 0x01, 0x00, 0x05,
+  0x00, 0x06, 0x00, 0x00, 0x00, 0x01, 0x00, 0x07,
+  0x00, 0x08, 0x00, 0x00, 0x00, 0x01, 0x00, 0x09,
+  0x00, 0x0A, 0x00, 0x00, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x0C, 0x00, 0x00, 0x00, 0x01, 0x00, 0x0D,
+  0x00, 0x0E, 0x00, 0x00, 0x00, 0x01, 0x00, 0x0F,
+  0x00, 0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x11,
+  0x00, 0x12, 0x00, 0x00, 0x00, 0x01, 0x00, 0x13,
+  0x00, 0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x15,
+  0x00, 0x16, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01,
+  0x00, 0x17, 0x00, 0x18, 0x00, 0x01, 0x00, 0x26,
+  0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x1A,
+  0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00,
+  0x24, 0x00, 0x25, 0x00, 0x01, 0x00, 0x26, 0x00,
+  0x00, 0x00, 0x62, 0x00, 0x06, 0x00, 0x06, 0x00,
+  0x00, 0x00, 0x56, 0x01, 0x4C, 0x03, 0x3D, 0x1C,
+  0x1A, 0xA2, 0x00, 0x29, 0xBB, 0x00, 0x02, 0x59,
+  0xB7, 0x00, 0x1B, 0x4E, 0x2D, 0x1C, 0xB5, 0x00,
+  0x1D, 0x2D, 0x1C, 0x85, 0xB5, 0x00, 0x1F, 0x2D,
+  0x1C, 0x91, 0xB5, 0x00, 0x21, 0x2D, 0x2B, 0xB5,
+  0x00, 0x23, 0x2D, 0x4C, 0x84, 0x02, 0x01, 0xA7,
+  0xFF, 0xD8, 0x09, 0x37, 0x04, 0x2B, 0xC6, 0x00,
+  0x20, 0x16, 0x04, 0x2B, 0xB4, 0x00, 0x1F, 0x61,
+  0x2B, 0xB4, 0x00, 0x1D, 0x85, 0x61, 0x2B, 0xB4,
+  0x00, 0x21, 0x85, 0x61, 0x37, 0x04, 0x2B, 0xB4,
+  0x00, 0x23, 0x4C, 0xA7, 0xFF, 0xE2, 0x16, 0x04,
+  0xAD, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ public class Leaf extends Node {
+    public int extra;
+    public Node other;
+ } */
+unsigned char leaf_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0E, 0x01, 0x00, 0x04, 0x4C, 0x65, 0x61,
+  0x66, 0x07, 0x00, 0x01, 0x01, 0x00, 0x04, 0x4E,
+  0x6F, 0x64, 0x65, 0x07, 0x00, 0x03, 0x01, 0x00,
+  0x05, 0x65, 0x78, 0x74, 0x72, 0x61, 0x01, 0x00,
+  0x01, 0x49, 0x01, 0x00, 0x05, 0x6F, 0x74, 0x68,
+  0x65, 0x72, 0x01, 0x00, 0x06, 0x4C, 0x4E, 0x6F,
+  0x64, 0x65, 0x3B, 0x01, 0x00, 0x06, 0x3C, 0x69,
+  0x6E, 0x69, 0x74, 0x3E, 0x01, 0x00, 0x03, 0x28,
+  0x29, 0x56, 0x0C, 0x00, 0x09, 0x00, 0x0A, 0x0A,
+  0x00, 0x04, 0x00, 0x0B, 0x01, 0x00, 0x04, 0x43,
+  0x6F, 0x64, 0x65, 0x00, 0x21, 0x00, 0x02, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01, 0x00,
+  0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x07, 0x00, 0x08, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x01, 0x00, 0x09, 0x00, 0x0A, 0x00, 0x01, 0x00,
+  0x0D, 0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00,
+  0x0C, 0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ * Classes which answer the same call in different ways.  Shapes.total()
+ * calls through an interface while Shapes.edges() calls through a
+ * class, so call sites see one, a few or many receiver classes
+ * depending on how many kinds of shape are asked for.  Shapes.corners()
+ * checks and casts to both a class and an interface.
+ *
+ public interface Shape {
+    int sides();
+ }
+ public class Triangle implements Shape {
+    public int sides() { return 3; }
+ }
+ public class Square extends Triangle {
+    public int sides() { return 4; }
+ }
+ public class Pentagon extends Square {
+    public int sides() { return 5; }
+ }
+ public class Hexagon extends Pentagon {
+    public int sides() { return 6; }
+ }
+ public class Cell extends Hexagon { }
+ public class Shapes {
+    public static Triangle make(int kind) {
+        if (kind == 0) return new Triangle();
+        if (kind == 1) return new Square();
+        if (kind == 2) return new Pentagon();
+        if (kind == 3) return new Hexagon();
+        return new Cell();
+    }
+
+    public static int total(int nn, int kinds) {
+        int sum = 0;
+        for (int ii = 0; ii < nn; ++ii) {
+            Shape shape = make(ii % kinds);
+            sum += shape.sides();
+        }
+        return sum;
+    }
+
+    public static int edges(int nn, int kinds) {
+        int sum = 0;
+        for (int ii = 0; ii < nn; ++ii)
+            sum += make(ii % kinds).sides();
+        return sum;
+    }
+
+    public static int corners(int nn, int kinds) {
+        int sum = 0;
+        for (int ii = 0; ii < nn; ++ii) {
+            Object shape = make(ii % kinds);
+            if (shape instanceof Pentagon)
+                sum += ((Shape)shape).sides();
+        }
+        return sum;
+    }
+
+    public static Pentagon narrow(Object shape) {
+        return (Pentagon)shape;
+    }
+ } */
+unsigned char shape_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x08, 0x01, 0x00, 0x05, 0x53, 0x68, 0x61,
+  0x70, 0x65, 0x07, 0x00, 0x01, 0x01, 0x00, 0x10,
+  0x6A, 0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61, 0x6E,
+  0x67, 0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63, 0x74,
+  0x07, 0x00, 0x03, 0x01, 0x00, 0x05, 0x73, 0x69,
+  0x64, 0x65, 0x73, 0x01, 0x00, 0x03, 0x28, 0x29,
+  0x49, 0x01, 0x00, 0x04, 0x43, 0x6F, 0x64, 0x65,
+  0x06, 0x01, 0x00, 0x02, 0x00, 0x04, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x01, 0x04, 0x01, 0x00, 0x05,
+  0x00, 0x06, 0x00, 0x00, 0x00, 0x00 };
+
+unsigned char triangle_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0E, 0x01, 0x00, 0x08, 0x54, 0x72, 0x69,
+  0x61, 0x6E, 0x67, 0x6C, 0x65, 0x07, 0x00, 0x01,
+  0x01, 0x00, 0x10, 0x6A, 0x61, 0x76, 0x61, 0x2F,
+  0x6C, 0x61, 0x6E, 0x67, 0x2F, 0x4F, 0x62, 0x6A,
+  0x65, 0x63, 0x74, 0x07, 0x00, 0x03, 0x01, 0x00,
+  0x05, 0x53, 0x68, 0x61, 0x70, 0x65, 0x07, 0x00,
+  0x05, 0x01, 0x00, 0x06, 0x3C, 0x69, 0x6E, 0x69,
+  0x74, 0x3E, 0x01, 0x00, 0x03, 0x28, 0x29, 0x56,
+  0x0C, 0x00, 0x07, 0x00, 0x08, 0x0A, 0x00, 0x04,
+  0x00, 0x09, 0x01, 0x00, 0x05, 0x73, 0x69, 0x64,
+  0x65, 0x73, 0x01, 0x00, 0x03, 0x28, 0x29, 0x49,
+  0x01, 0x00, 0x04, 0x43, 0x6F, 0x64, 0x65, 0x00,
+  0x21, 0x00, 0x02, 0x00, 0x04, 0x00, 0x01, 0x00,
+  0x06, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01, 0x00,
+  0x07, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0D, 0x00,
+  0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01, 0x00,
+  0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x0A, 0xB1,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x0C, 0x00, 0x01, 0x00, 0x0D, 0x00, 0x00,
+  0x00, 0x0F, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+  0x00, 0x03, 0x10, 0x03, 0xAC, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00 };
+
+unsigned char square_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0C, 0x01, 0x00, 0x06, 0x53, 0x71, 0x75,
+  0x61, 0x72, 0x65, 0x07, 0x00, 0x01, 0x01, 0x00,
+  0x08, 0x54, 0x72, 0x69, 0x61, 0x6E, 0x67, 0x6C,
+  0x65, 0x07, 0x00, 0x03, 0x01, 0x00, 0x06, 0x3C,
+  0x69, 0x6E, 0x69, 0x74, 0x3E, 0x01, 0x00, 0x03,
+  0x28, 0x29, 0x56, 0x0C, 0x00, 0x05, 0x00, 0x06,
+  0x0A, 0x00, 0x04, 0x00, 0x07, 0x01, 0x00, 0x05,
+  0x73, 0x69, 0x64, 0x65, 0x73, 0x01, 0x00, 0x03,
+  0x28, 0x29, 0x49, 0x01, 0x00, 0x04, 0x43, 0x6F,
+  0x64, 0x65, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01,
+  0x00, 0x05, 0x00, 0x06, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x08,
+  0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x09, 0x00, 0x0A, 0x00, 0x01, 0x00, 0x0B, 0x00,
+  0x00, 0x00, 0x0F, 0x00, 0x01, 0x00, 0x01, 0x00,
+  0x00, 0x00, 0x03, 0x10, 0x04, 0xAC, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00 };
+
+unsigned char pentagon_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0C, 0x01, 0x00, 0x08, 0x50, 0x65, 0x6E,
+  0x74, 0x61, 0x67, 0x6F, 0x6E, 0x07, 0x00, 0x01,
+  0x01, 0x00, 0x06, 0x53, 0x71, 0x75, 0x61, 0x72,
+  0x65, 0x07, 0x00, 0x03, 0x01, 0x00, 0x06, 0x3C,
+  0x69, 0x6E, 0x69, 0x74, 0x3E, 0x01, 0x00, 0x03,
+  0x28, 0x29, 0x56, 0x0C, 0x00, 0x05, 0x00, 0x06,
+  0x0A, 0x00, 0x04, 0x00, 0x07, 0x01, 0x00, 0x05,
+  0x73, 0x69, 0x64, 0x65, 0x73, 0x01, 0x00, 0x03,
+  0x28, 0x29, 0x49, 0x01, 0x00, 0x04, 0x43, 0x6F,
+  0x64, 0x65, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x01,
+  0x00, 0x05, 0x00, 0x06, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x08,
+  0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+  0x09, 0x00, 0x0A, 0x00, 0x01, 0x00, 0x0B, 0x00,
+  0x00, 0x00, 0x0F, 0x00, 0x01, 0x00, 0x01, 0x00,
+  0x00, 0x00, 0x03, 0x10, 0x05, 0xAC, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00 };
+
+unsigned char hexagon_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0C, 0x01, 0x00, 0x07, 0x48, 0x65, 0x78,
+  0x61, 0x67, 0x6F, 0x6E, 0x07, 0x00, 0x01, 0x01,
+  0x00, 0x08, 0x50, 0x65, 0x6E, 0x74, 0x61, 0x67,
+  0x6F, 0x6E, 0x07, 0x00, 0x03, 0x01, 0x00, 0x06,
+  0x3C, 0x69, 0x6E, 0x69, 0x74, 0x3E, 0x01, 0x00,
+  0x03, 0x28, 0x29, 0x56, 0x0C, 0x00, 0x05, 0x00,
+  0x06, 0x0A, 0x00, 0x04, 0x00, 0x07, 0x01, 0x00,
+  0x05, 0x73, 0x69, 0x64, 0x65, 0x73, 0x01, 0x00,
+  0x03, 0x28, 0x29, 0x49, 0x01, 0x00, 0x04, 0x43,
+  0x6F, 0x64, 0x65, 0x00, 0x21, 0x00, 0x02, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+  0x01, 0x00, 0x05, 0x00, 0x06, 0x00, 0x01, 0x00,
+  0x0B, 0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00,
+  0x08, 0xB1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x09, 0x00, 0x0A, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x0F, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x03, 0x10, 0x06, 0xAC, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00 };
+
+unsigned char cell_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x0A, 0x01, 0x00, 0x04, 0x43, 0x65, 0x6C,
+  0x6C, 0x07, 0x00, 0x01, 0x01, 0x00, 0x07, 0x48,
+  0x65, 0x78, 0x61, 0x67, 0x6F, 0x6E, 0x07, 0x00,
+  0x03, 0x01, 0x00, 0x06, 0x3C, 0x69, 0x6E, 0x69,
+  0x74, 0x3E, 0x01, 0x00, 0x03, 0x28, 0x29, 0x56,
+  0x0C, 0x00, 0x05, 0x00, 0x06, 0x0A, 0x00, 0x04,
+  0x00, 0x07, 0x01, 0x00, 0x04, 0x43, 0x6F, 0x64,
+  0x65, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00,
+  0x05, 0x00, 0x06, 0x00, 0x01, 0x00, 0x09, 0x00,
+  0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01, 0x00,
+  0x00, 0x00, 0x05, 0x2A, 0xB7, 0x00, 0x08, 0xB1,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+unsigned char shapes_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x3D,
+  0x00, 0x29, 0x01, 0x00, 0x06, 0x53, 0x68, 0x61,
+  0x70, 0x65, 0x73, 0x07, 0x00, 0x01, 0x01, 0x00,
+  0x10, 0x6A, 0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61,
+  0x6E, 0x67, 0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63,
+  0x74, 0x07, 0x00, 0x03, 0x01, 0x00, 0x08, 0x54,
+  0x72, 0x69, 0x61, 0x6E, 0x67, 0x6C, 0x65, 0x07,
+  0x00, 0x05, 0x01, 0x00, 0x06, 0x3C, 0x69, 0x6E,
+  0x69, 0x74, 0x3E, 0x01, 0x00, 0x03, 0x28, 0x29,
+  0x56, 0x0C, 0x00, 0x07, 0x00, 0x08, 0x0A, 0x00,
+  0x06, 0x00, 0x09, 0x01, 0x00, 0x06, 0x53, 0x71,
+  0x75, 0x61, 0x72, 0x65, 0x07, 0x00, 0x0B, 0x0A,
+  0x00, 0x0C, 0x00, 0x09, 0x01, 0x00, 0x08, 0x50,
+  0x65, 0x6E, 0x74, 0x61, 0x67, 0x6F, 0x6E, 0x07,
+  0x00, 0x0E, 0x0A, 0x00, 0x0F, 0x00, 0x09, 0x01,
+  0x00, 0x07, 0x48, 0x65, 0x78, 0x61, 0x67, 0x6F,
+  0x6E, 0x07, 0x00, 0x11, 0x0A, 0x00, 0x12, 0x00,
+  0x09, 0x01, 0x00, 0x04, 0x43, 0x65, 0x6C, 0x6C,
+  0x07, 0x00, 0x14, 0x0A, 0x00, 0x15, 0x00, 0x09,
+  0x01, 0x00, 0x04, 0x6D, 0x61, 0x6B, 0x65, 0x01,
+  0x00, 0x0D, 0x28, 0x49, 0x29, 0x4C, 0x54, 0x72,
+  0x69, 0x61, 0x6E, 0x67, 0x6C, 0x65, 0x3B, 0x0C,
+  0x00, 0x17, 0x00, 0x18, 0x0A, 0x00, 0x02, 0x00,
+  0x19, 0x01, 0x00, 0x05, 0x53, 0x68, 0x61, 0x70,
+  0x65, 0x07, 0x00, 0x1B, 0x01, 0x00, 0x05, 0x73,
+  0x69, 0x64, 0x65, 0x73, 0x01, 0x00, 0x03, 0x28,
+  0x29, 0x49, 0x0C, 0x00, 0x1D, 0x00, 0x1E, 0x0B,
+  0x00, 0x1C, 0x00, 0x1F, 0x01, 0x00, 0x05, 0x74,
+  0x6F, 0x74, 0x61, 0x6C, 0x01, 0x00, 0x05, 0x28,
+  0x49, 0x49, 0x29, 0x49, 0x0A, 0x00, 0x06, 0x00,
+  0x1F, 0x01, 0x00, 0x05, 0x65, 0x64, 0x67, 0x65,
+  0x73, 0x01, 0x00, 0x07, 0x63, 0x6F, 0x72, 0x6E,
+  0x65, 0x72, 0x73, 0x01, 0x00, 0x06, 0x6E, 0x61,
+  0x72, 0x72, 0x6F, 0x77, 0x01, 0x00, 0x1E, 0x28,
+  0x4C, 0x6A, 0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61,
+  0x6E, 0x67, 0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63,
+  0x74, 0x3B, 0x29, 0x4C, 0x50, 0x65, 0x6E, 0x74,
+  0x61, 0x67, 0x6F, 0x6E, 0x3B, 0x01, 0x00, 0x04,
+  0x43, 0x6F, 0x64, 0x65, 0x00, 0x21, 0x00, 0x02,
+  0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05,
+  0x00, 0x09, 0x00, 0x17, 0x00, 0x18, 0x00, 0x01,
+  0x00, 0x28, 0x00, 0x00, 0x00, 0x48, 0x00, 0x02,
+  0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x1A, 0x03,
+  0xA0, 0x00, 0x0B, 0xBB, 0x00, 0x06, 0x59, 0xB7,
+  0x00, 0x0A, 0xB0, 0x1A, 0x04, 0xA0, 0x00, 0x0B,
+  0xBB, 0x00, 0x0C, 0x59, 0xB7, 0x00, 0x0D, 0xB0,
+  0x1A, 0x05, 0xA0, 0x00, 0x0B, 0xBB, 0x00, 0x0F,
+  0x59, 0xB7, 0x00, 0x10, 0xB0, 0x1A, 0x06, 0xA0,
+  0x00, 0x0B, 0xBB, 0x00, 0x12, 0x59, 0xB7, 0x00,
+  0x13, 0xB0, 0xBB, 0x00, 0x15, 0x59, 0xB7, 0x00,
+  0x16, 0xB0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x21, 0x00, 0x22, 0x00, 0x01, 0x00, 0x28,
+  0x00, 0x00, 0x00, 0x2B, 0x00, 0x03, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x1F, 0x03, 0x3D, 0x03, 0x3E,
+  0x1D, 0x1A, 0xA2, 0x00, 0x17, 0x1C, 0x1D, 0x1B,
+  0x70, 0xB8, 0x00, 0x1A, 0xB9, 0x00, 0x20, 0x01,
+  0x00, 0x60, 0x3D, 0x84, 0x03, 0x01, 0xA7, 0xFF,
+  0xEA, 0x1C, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x09, 0x00, 0x24, 0x00, 0x22, 0x00, 0x01, 0x00,
+  0x28, 0x00, 0x00, 0x00, 0x29, 0x00, 0x03, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x1D, 0x03, 0x3D, 0x03,
+  0x3E, 0x1D, 0x1A, 0xA2, 0x00, 0x15, 0x1C, 0x1D,
+  0x1B, 0x70, 0xB8, 0x00, 0x1A, 0xB6, 0x00, 0x23,
+  0x60, 0x3D, 0x84, 0x03, 0x01, 0xA7, 0xFF, 0xEC,
+  0x1C, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x25, 0x00, 0x22, 0x00, 0x01, 0x00, 0x28,
+  0x00, 0x00, 0x00, 0x3A, 0x00, 0x03, 0x00, 0x05,
+  0x00, 0x00, 0x00, 0x2E, 0x03, 0x3D, 0x03, 0x3E,
+  0x1D, 0x1A, 0xA2, 0x00, 0x26, 0x1D, 0x1B, 0x70,
+  0xB8, 0x00, 0x1A, 0x3A, 0x04, 0x19, 0x04, 0xC1,
+  0x00, 0x0F, 0x99, 0x00, 0x10, 0x1C, 0x19, 0x04,
+  0xC0, 0x00, 0x1C, 0xB9, 0x00, 0x20, 0x01, 0x00,
+  0x60, 0x3D, 0x84, 0x03, 0x01, 0xA7, 0xFF, 0xDB,
+  0x1C, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x26, 0x00, 0x27, 0x00, 0x01, 0x00, 0x28,
+  0x00, 0x00, 0x00, 0x11, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x05, 0x2A, 0xC0, 0x00, 0x0F,
+  0xB0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ * A Java archive containing the classes above, as made by:
+ *
+ *   $ zip -0 animals.jar Loop.class
+ *   $ zip -9 animals.jar Animal.class Bird.class
+ *
+ * Loop is stored without compression while the others are deflated,
+ * Animal with dynamic Huffman codes and Bird with fixed ones.  There
+ * is also an empty META-INF/ directory entry. */
+unsigned char animals_jar[] = {
+  0x50, 0x4B, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x21, 0x5C, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4D, 0x45,
+  0x54, 0x41, 0x2D, 0x49, 0x4E, 0x46, 0x2F, 0x50,
+  0x4B, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08,
+  0x00, 0x00, 0x00, 0x21, 0x5C, 0x28, 0xE4, 0xA7,
+  0x71, 0x19, 0x01, 0x00, 0x00, 0x7C, 0x01, 0x00,
+  0x00, 0x0C, 0x00, 0x00, 0x00, 0x41, 0x6E, 0x69,
+  0x6D, 0x61, 0x6C, 0x2E, 0x63, 0x6C, 0x61, 0x73,
+  0x73, 0x3D, 0x8D, 0x4F, 0x4E, 0xC2, 0x40, 0x18,
+  0xC5, 0xDF, 0x74, 0x5A, 0x46, 0x6A, 0xC1, 0x02,
+  0xFE, 0x41, 0xA9, 0x0B, 0x13, 0x17, 0x05, 0x4D,
+  0xB8, 0x80, 0x25, 0x51, 0x57, 0x4D, 0x34, 0xEE,
+  0x4C, 0xDC, 0x59, 0xA1, 0x69, 0x86, 0x94, 0x36,
+  0xB1, 0xD5, 0x13, 0x78, 0x0A, 0x97, 0x6E, 0xD8,
+  0xB8, 0x71, 0x03, 0x89, 0x24, 0x1E, 0xC0, 0xDB,
+  0x78, 0x01, 0xF5, 0x1B, 0x18, 0x9D, 0xC5, 0xBC,
+  0x99, 0xEF, 0xF7, 0xDE, 0xF7, 0x3E, 0xBF, 0xDF,
+  0x3F, 0x00, 0x04, 0xD8, 0x65, 0xA8, 0x9C, 0x66,
+  0x72, 0x12, 0xA5, 0x02, 0x8C, 0xC1, 0x1D, 0x47,
+  0x8F, 0x51, 0x3F, 0x8D, 0xB2, 0xA4, 0x7F, 0x75,
+  0x37, 0x8E, 0x87, 0xA5, 0x00, 0x27, 0xC7, 0x89,
+  0xCC, 0x64, 0x39, 0x60, 0xE0, 0x7E, 0xF7, 0xDA,
+  0x81, 0x85, 0x8A, 0x0D, 0x13, 0x82, 0xC1, 0x3C,
+  0xCF, 0x47, 0x31, 0x49, 0x1A, 0x27, 0xC5, 0x92,
+  0x86, 0x0E, 0x6C, 0xAC, 0xDB, 0x30, 0xE0, 0x30,
+  0x58, 0x65, 0x5E, 0x46, 0x29, 0x61, 0x3F, 0xEC,
+  0x86, 0x6A, 0xA6, 0x12, 0x67, 0xF2, 0x7E, 0x24,
+  0xD0, 0xB0, 0xD1, 0x84, 0x70, 0x50, 0xC7, 0x86,
+  0x02, 0x9B, 0x64, 0x1E, 0xE6, 0x0F, 0x59, 0x49,
+  0xEA, 0x87, 0xE4, 0x66, 0x10, 0x13, 0x59, 0x14,
+  0x32, 0x4B, 0x70, 0x40, 0xDC, 0x84, 0x3A, 0x16,
+  0x98, 0xEA, 0xA6, 0xBB, 0x4A, 0xBF, 0x06, 0x29,
+  0x53, 0xD3, 0xDE, 0x1C, 0x6B, 0x6F, 0x4B, 0x03,
+  0x53, 0xE5, 0x1A, 0xD7, 0x35, 0x36, 0xC4, 0xAB,
+  0x66, 0xD4, 0xA5, 0xD9, 0xA1, 0x5E, 0xD9, 0xE6,
+  0x01, 0x1F, 0xEC, 0x77, 0x5E, 0xE0, 0x7A, 0xBD,
+  0x19, 0x6A, 0xB7, 0xC1, 0x13, 0x67, 0xD3, 0x9F,
+  0x2F, 0x6F, 0x95, 0xA8, 0x62, 0x1B, 0x3B, 0x3A,
+  0xE1, 0x53, 0x82, 0x93, 0x7A, 0x7B, 0xCF, 0xA8,
+  0x2D, 0x60, 0xDC, 0xCC, 0xE1, 0x4E, 0x61, 0x2F,
+  0xD0, 0xA4, 0x57, 0xEB, 0xF2, 0xB8, 0x33, 0xC3,
+  0xD6, 0x5F, 0xAA, 0xFD, 0xDF, 0xD3, 0x22, 0x35,
+  0x48, 0x05, 0xBB, 0x38, 0xA2, 0xFD, 0x2B, 0x03,
+  0x7E, 0x01, 0x50, 0x4B, 0x03, 0x04, 0x14, 0x00,
+  0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x21, 0x5C,
+  0xA3, 0xAE, 0x01, 0xA7, 0x82, 0x00, 0x00, 0x00,
+  0xA5, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00,
+  0x42, 0x69, 0x72, 0x64, 0x2E, 0x63, 0x6C, 0x61,
+  0x73, 0x73, 0x3B, 0xF5, 0x6F, 0xD7, 0x3E, 0x06,
+  0x06, 0x06, 0x5B, 0x06, 0x3E, 0x46, 0x06, 0x16,
+  0xA7, 0xCC, 0xA2, 0x14, 0x76, 0x06, 0x46, 0x46,
+  0x06, 0x36, 0xC7, 0xBC, 0xCC, 0xDC, 0xC4, 0x1C,
+  0x76, 0x06, 0x66, 0x20, 0xDB, 0x26, 0x33, 0x2F,
+  0xB3, 0xC4, 0x8E, 0x91, 0x81, 0x59, 0x43, 0x33,
+  0x8C, 0x87, 0x81, 0x95, 0x81, 0x8D, 0x8B, 0x81,
+  0x85, 0x81, 0x1D, 0xA8, 0xDC, 0x39, 0x3F, 0x25,
+  0x15, 0x48, 0xE5, 0xA4, 0xA6, 0x17, 0x83, 0x65,
+  0x3D, 0x79, 0x18, 0xB8, 0x18, 0xB8, 0x41, 0xB2,
+  0x3C, 0x0C, 0x8A, 0x0C, 0x4C, 0x40, 0x1A, 0x04,
+  0x98, 0x18, 0x18, 0x41, 0x9A, 0x80, 0x24, 0x27,
+  0x90, 0x27, 0x08, 0xA4, 0x19, 0x81, 0x34, 0xAB,
+  0xD6, 0x76, 0x06, 0x8E, 0x8D, 0x60, 0x05, 0x8C,
+  0x20, 0x5D, 0x50, 0x69, 0x61, 0xB0, 0x72, 0x06,
+  0x06, 0x76, 0xA0, 0x34, 0x2F, 0x6B, 0xCE, 0x1A,
+  0xB0, 0x02, 0x06, 0x00, 0x50, 0x4B, 0x03, 0x04,
+  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x21, 0x5C, 0xAA, 0xB3, 0x0B, 0x3C, 0xD0, 0x02,
+  0x00, 0x00, 0xD0, 0x02, 0x00, 0x00, 0x0A, 0x00,
+  0x00, 0x00, 0x4C, 0x6F, 0x6F, 0x70, 0x2E, 0x63,
+  0x6C, 0x61, 0x73, 0x73, 0xCA, 0xFE, 0xBA, 0xBE,
+  0x00, 0x00, 0x00, 0x3D, 0x00, 0x1C, 0x01, 0x00,
+  0x04, 0x4C, 0x6F, 0x6F, 0x70, 0x07, 0x00, 0x01,
+  0x01, 0x00, 0x10, 0x6A, 0x61, 0x76, 0x61, 0x2F,
+  0x6C, 0x61, 0x6E, 0x67, 0x2F, 0x4F, 0x62, 0x6A,
+  0x65, 0x63, 0x74, 0x07, 0x00, 0x03, 0x01, 0x00,
+  0x05, 0x63, 0x6F, 0x75, 0x6E, 0x74, 0x01, 0x00,
+  0x01, 0x49, 0x01, 0x00, 0x06, 0x3C, 0x69, 0x6E,
+  0x69, 0x74, 0x3E, 0x01, 0x00, 0x03, 0x28, 0x29,
+  0x56, 0x0C, 0x00, 0x07, 0x00, 0x08, 0x0A, 0x00,
+  0x04, 0x00, 0x09, 0x01, 0x00, 0x04, 0x43, 0x6F,
+  0x64, 0x65, 0x01, 0x00, 0x09, 0x66, 0x61, 0x63,
+  0x74, 0x6F, 0x72, 0x69, 0x61, 0x6C, 0x01, 0x00,
+  0x04, 0x28, 0x49, 0x29, 0x49, 0x01, 0x00, 0x06,
+  0x6E, 0x65, 0x73, 0x74, 0x65, 0x64, 0x01, 0x00,
+  0x09, 0x66, 0x69, 0x62, 0x6F, 0x6E, 0x61, 0x63,
+  0x63, 0x69, 0x01, 0x00, 0x04, 0x28, 0x49, 0x29,
+  0x4A, 0x0C, 0x00, 0x05, 0x00, 0x06, 0x09, 0x00,
+  0x02, 0x00, 0x11, 0x01, 0x00, 0x05, 0x64, 0x65,
+  0x70, 0x74, 0x68, 0x0C, 0x00, 0x13, 0x00, 0x0D,
+  0x0A, 0x00, 0x02, 0x00, 0x14, 0x01, 0x00, 0x06,
+  0x63, 0x68, 0x6F, 0x6F, 0x73, 0x65, 0x01, 0x00,
+  0x06, 0x73, 0x70, 0x61, 0x72, 0x73, 0x65, 0x06,
+  0x40, 0x8F, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x08, 0x68, 0x61, 0x72, 0x6D, 0x6F,
+  0x6E, 0x69, 0x63, 0x01, 0x00, 0x08, 0x3C, 0x63,
+  0x6C, 0x69, 0x6E, 0x69, 0x74, 0x3E, 0x00, 0x21,
+  0x00, 0x02, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x09, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00,
+  0x00, 0x09, 0x00, 0x01, 0x00, 0x07, 0x00, 0x08,
+  0x00, 0x01, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x11,
+  0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x05,
+  0x2A, 0xB7, 0x00, 0x0A, 0xB1, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x09, 0x00, 0x0C, 0x00, 0x0D, 0x00,
+  0x01, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x1E, 0x00,
+  0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x12, 0x04,
+  0x3C, 0x1A, 0x9E, 0x00, 0x0D, 0x1B, 0x1A, 0x68,
+  0x3C, 0x84, 0x00, 0xFF, 0xA7, 0xFF, 0xF5, 0x1B,
+  0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00,
+  0x0E, 0x00, 0x0D, 0x00, 0x01, 0x00, 0x0B, 0x00,
+  0x00, 0x00, 0x33, 0x00, 0x03, 0x00, 0x04, 0x00,
+  0x00, 0x00, 0x27, 0x03, 0x3C, 0x03, 0x3D, 0x1C,
+  0x1A, 0xA2, 0x00, 0x1F, 0x03, 0x3E, 0x1D, 0x1A,
+  0xA2, 0x00, 0x12, 0x1B, 0x1C, 0x1D, 0x82, 0x10,
+  0x07, 0x7E, 0x60, 0x3C, 0x84, 0x03, 0x01, 0xA7,
+  0xFF, 0xEF, 0x84, 0x02, 0x01, 0xA7, 0xFF, 0xE2,
+  0x1B, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x0F, 0x00, 0x10, 0x00, 0x01, 0x00, 0x0B,
+  0x00, 0x00, 0x00, 0x2B, 0x00, 0x04, 0x00, 0x08,
+  0x00, 0x00, 0x00, 0x1F, 0x09, 0x40, 0x0A, 0x42,
+  0x03, 0x36, 0x05, 0x15, 0x05, 0x1A, 0xA2, 0x00,
+  0x13, 0x1F, 0x21, 0x61, 0x37, 0x06, 0x21, 0x40,
+  0x16, 0x06, 0x42, 0x84, 0x05, 0x01, 0xA7, 0xFF,
+  0xED, 0x1F, 0xAD, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x09, 0x00, 0x13, 0x00, 0x0D, 0x00, 0x01, 0x00,
+  0x0B, 0x00, 0x00, 0x00, 0x25, 0x00, 0x02, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x19, 0xB2, 0x00, 0x12,
+  0x04, 0x60, 0xB3, 0x00, 0x12, 0x1A, 0x9E, 0x00,
+  0x0E, 0x1A, 0x04, 0x64, 0xB8, 0x00, 0x15, 0x04,
+  0x60, 0xA7, 0x00, 0x04, 0x03, 0xAC, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x09, 0x00, 0x16, 0x00, 0x0D,
+  0x00, 0x01, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x3A,
+  0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x2E,
+  0x1A, 0xAA, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2B,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+  0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x22,
+  0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x28,
+  0x10, 0x0A, 0xAC, 0x10, 0x14, 0xAC, 0x10, 0x1E,
+  0xAC, 0x10, 0x28, 0xAC, 0x02, 0xAC, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x09, 0x00, 0x17, 0x00, 0x0D,
+  0x00, 0x01, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x44,
+  0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x38,
+  0x1A, 0xAB, 0x00, 0x00, 0x00, 0x00, 0x00, 0x35,
+  0x00, 0x00, 0x00, 0x04, 0xFF, 0xFF, 0xFC, 0x18,
+  0x00, 0x00, 0x00, 0x2B, 0x00, 0x00, 0x00, 0x07,
+  0x00, 0x00, 0x00, 0x2F, 0x00, 0x00, 0x01, 0x2C,
+  0x00, 0x00, 0x00, 0x31, 0x00, 0x01, 0x86, 0xA0,
+  0x00, 0x00, 0x00, 0x33, 0x11, 0x03, 0xE8, 0xAC,
+  0x05, 0xAC, 0x06, 0xAC, 0x07, 0xAC, 0x03, 0xAC,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x1A,
+  0x00, 0x0D, 0x00, 0x01, 0x00, 0x0B, 0x00, 0x00,
+  0x00, 0x29, 0x00, 0x06, 0x00, 0x04, 0x00, 0x00,
+  0x00, 0x1D, 0x0E, 0x48, 0x04, 0x3E, 0x1D, 0x1A,
+  0xA3, 0x00, 0x10, 0x27, 0x0F, 0x1D, 0x87, 0x6F,
+  0x63, 0x48, 0x84, 0x03, 0x01, 0xA7, 0xFF, 0xF1,
+  0x27, 0x14, 0x00, 0x18, 0x6B, 0x8E, 0xAC, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x1B, 0x00,
+  0x08, 0x00, 0x01, 0x00, 0x0B, 0x00, 0x00, 0x00,
+  0x11, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x05, 0x03, 0xB3, 0x00, 0x12, 0xB1, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x50, 0x4B, 0x01, 0x02,
+  0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x21, 0x5C, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x10, 0x00, 0xED, 0x41, 0x00, 0x00,
+  0x00, 0x00, 0x4D, 0x45, 0x54, 0x41, 0x2D, 0x49,
+  0x4E, 0x46, 0x2F, 0x50, 0x4B, 0x01, 0x02, 0x14,
+  0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00,
+  0x00, 0x21, 0x5C, 0x28, 0xE4, 0xA7, 0x71, 0x19,
+  0x01, 0x00, 0x00, 0x7C, 0x01, 0x00, 0x00, 0x0C,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0xA4, 0x01, 0x27, 0x00, 0x00,
+  0x00, 0x41, 0x6E, 0x69, 0x6D, 0x61, 0x6C, 0x2E,
+  0x63, 0x6C, 0x61, 0x73, 0x73, 0x50, 0x4B, 0x01,
+  0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x08,
+  0x00, 0x00, 0x00, 0x21, 0x5C, 0xA3, 0xAE, 0x01,
+  0xA7, 0x82, 0x00, 0x00, 0x00, 0xA5, 0x00, 0x00,
+  0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0xA4, 0x01, 0x6A,
+  0x01, 0x00, 0x00, 0x42, 0x69, 0x72, 0x64, 0x2E,
+  0x63, 0x6C, 0x61, 0x73, 0x73, 0x50, 0x4B, 0x01,
+  0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x21, 0x5C, 0xAA, 0xB3, 0x0B,
+  0x3C, 0xD0, 0x02, 0x00, 0x00, 0xD0, 0x02, 0x00,
+  0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0xA4, 0x01, 0x14,
+  0x02, 0x00, 0x00, 0x4C, 0x6F, 0x6F, 0x70, 0x2E,
+  0x63, 0x6C, 0x61, 0x73, 0x73, 0x50, 0x4B, 0x05,
+  0x06, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x04,
+  0x00, 0xE1, 0x00, 0x00, 0x00, 0x0C, 0x05, 0x00,
+  0x00, 0x00, 0x00 };
+
+/**
+ public class Many {
+    public static int sum(int a0, int a1, int a2, int a3, int a4,
+                          int a5, int a6, int a7, int a8, int a9) {
+        return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9;
+    }
+
+    public static int wide(long j0, long j1, ..., long j126, int last) {
+        return last;
+    }
+ } */
+unsigned char many_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x34,
+  0x00, 0x0A, 0x01, 0x00, 0x04, 0x4D, 0x61, 0x6E,
+  0x79, 0x07, 0x00, 0x01, 0x01, 0x00, 0x10, 0x6A,
+  0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61, 0x6E, 0x67,
+  0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63, 0x74, 0x07,
+  0x00, 0x03, 0x01, 0x00, 0x03, 0x73, 0x75, 0x6D,
+  0x01, 0x00, 0x0D, 0x28, 0x49, 0x49, 0x49, 0x49,
+  0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x29, 0x49,
+  0x01, 0x00, 0x04, 0x43, 0x6F, 0x64, 0x65, 0x01,
+  0x00, 0x04, 0x77, 0x69, 0x64, 0x65, 0x01, 0x00,
+  0x83, 0x28, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A, 0x4A,
+  0x4A, 0x49, 0x29, 0x49, 0x00, 0x21, 0x00, 0x02,
+  0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+  0x00, 0x09, 0x00, 0x05, 0x00, 0x06, 0x00, 0x01,
+  0x00, 0x07, 0x00, 0x00, 0x00, 0x26, 0x00, 0x02,
+  0x00, 0x0A, 0x00, 0x00, 0x00, 0x1A, 0x1A, 0x1B,
+  0x60, 0x1C, 0x60, 0x1D, 0x60, 0x15, 0x04, 0x60,
+  0x15, 0x05, 0x60, 0x15, 0x06, 0x60, 0x15, 0x07,
+  0x60, 0x15, 0x08, 0x60, 0x15, 0x09, 0x60, 0xAC,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x08,
+  0x00, 0x09, 0x00, 0x01, 0x00, 0x07, 0x00, 0x00,
+  0x00, 0x0F, 0x00, 0x01, 0x00, 0xFF, 0x00, 0x00,
+  0x00, 0x03, 0x15, 0xFE, 0xAC, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00 };
+
+/**
+ public class Fused {
+    public static int sum(int[] array) {
+        int sum = 0;
+        for (int ii = 0; ii < array.length; ++ii)
+            sum += ii;
+        return sum;
+    }
+
+    public static int order(int aa, int bb) {
+        if (aa < bb)
+            return -1;
+        if (bb >= aa)
+            return 0;
+        return 1;
+    }
+
+    public static int scale(int aa) { return aa * 10; }
+
+    public static int middle(int nn, int[] array)
+    { return ((nn == 0) ? 100 : nn) < array.length ? 1 : 0; }
+ } */
+unsigned char fused_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x34,
+  0x00, 0x0E, 0x01, 0x00, 0x05, 0x46, 0x75, 0x73,
+  0x65, 0x64, 0x07, 0x00, 0x01, 0x01, 0x00, 0x10,
+  0x6A, 0x61, 0x76, 0x61, 0x2F, 0x6C, 0x61, 0x6E,
+  0x67, 0x2F, 0x4F, 0x62, 0x6A, 0x65, 0x63, 0x74,
+  0x07, 0x00, 0x03, 0x01, 0x00, 0x04, 0x43, 0x6F,
+  0x64, 0x65, 0x01, 0x00, 0x03, 0x73, 0x75, 0x6D,
+  0x01, 0x00, 0x05, 0x28, 0x5B, 0x49, 0x29, 0x49,
+  0x01, 0x00, 0x05, 0x6F, 0x72, 0x64, 0x65, 0x72,
+  0x01, 0x00, 0x05, 0x28, 0x49, 0x49, 0x29, 0x49,
+  0x01, 0x00, 0x05, 0x73, 0x63, 0x61, 0x6C, 0x65,
+  0x01, 0x00, 0x04, 0x28, 0x49, 0x29, 0x49, 0x01,
+  0x00, 0x06, 0x6D, 0x69, 0x64, 0x64, 0x6C, 0x65,
+  0x01, 0x00, 0x06, 0x28, 0x49, 0x5B, 0x49, 0x29,
+  0x49, 0x00, 0x21, 0x00, 0x02, 0x00, 0x04, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x09, 0x00,
+  0x06, 0x00, 0x07, 0x00, 0x01, 0x00, 0x05, 0x00,
+  0x00, 0x00, 0x22, 0x00, 0x02, 0x00, 0x03, 0x00,
+  0x00, 0x00, 0x16, 0x03, 0x3C, 0x03, 0x3D, 0x1C,
+  0x2A, 0xBE, 0xA2, 0x00, 0x0D, 0x1B, 0x1C, 0x60,
+  0x3C, 0x84, 0x02, 0x01, 0xA7, 0xFF, 0xF3, 0x1B,
+  0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00,
+  0x08, 0x00, 0x09, 0x00, 0x01, 0x00, 0x05, 0x00,
+  0x00, 0x00, 0x1C, 0x00, 0x02, 0x00, 0x02, 0x00,
+  0x00, 0x00, 0x10, 0x1A, 0x1B, 0xA2, 0x00, 0x05,
+  0x02, 0xAC, 0x1B, 0x1A, 0xA1, 0x00, 0x05, 0x03,
+  0xAC, 0x04, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x09, 0x00, 0x0A, 0x00, 0x0B, 0x00, 0x01, 0x00,
+  0x05, 0x00, 0x00, 0x00, 0x11, 0x00, 0x02, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x05, 0x1A, 0x10, 0x0A,
+  0x68, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x00, 0x0C, 0x00, 0x0D, 0x00, 0x01, 0x00, 0x05,
+  0x00, 0x00, 0x00, 0x21, 0x00, 0x02, 0x00, 0x02,
+  0x00, 0x00, 0x00, 0x15, 0x1A, 0x9A, 0x00, 0x08,
+  0x10, 0x64, 0xA7, 0x00, 0x04, 0x1A, 0x2B, 0xBE,
+  0xA2, 0x00, 0x07, 0x04, 0xA7, 0x00, 0x04, 0x03,
+  0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/**
+ public class Remainder {
+    public static double frem(double aa, double bb)
+    { return (float)aa % (float)bb; }
+
+    public static double drem(double aa, double bb) { return aa % bb; }
+ } */
+unsigned char remainder_class[] = {
+  0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x34,
+  0x00, 0x09, 0x01, 0x00, 0x09, 0x52, 0x65, 0x6D,
+  0x61, 0x69, 0x6E, 0x64, 0x65, 0x72, 0x07, 0x00,
+  0x01, 0x01, 0x00, 0x10, 0x6A, 0x61, 0x76, 0x61,
+  0x2F, 0x6C, 0x61, 0x6E, 0x67, 0x2F, 0x4F, 0x62,
+  0x6A, 0x65, 0x63, 0x74, 0x07, 0x00, 0x03, 0x01,
+  0x00, 0x04, 0x43, 0x6F, 0x64, 0x65, 0x01, 0x00,
+  0x04, 0x66, 0x72, 0x65, 0x6D, 0x01, 0x00, 0x05,
+  0x28, 0x44, 0x44, 0x29, 0x44, 0x01, 0x00, 0x04,
+  0x64, 0x72, 0x65, 0x6D, 0x00, 0x21, 0x00, 0x02,
+  0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+  0x00, 0x09, 0x00, 0x06, 0x00, 0x07, 0x00, 0x01,
+  0x00, 0x05, 0x00, 0x00, 0x00, 0x13, 0x00, 0x03,
+  0x00, 0x04, 0x00, 0x00, 0x00, 0x07, 0x26, 0x90,
+  0x28, 0x90, 0x72, 0x8D, 0xAF, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x09, 0x00, 0x08, 0x00, 0x07, 0x00,
+  0x01, 0x00, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00,
+  0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04, 0x26,
+  0x28, 0x73, 0xAF, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00 };
+
 static int
 check_except(JNIEnv *env)
 {
@@ -142,25 +1133,19 @@ fail(JNIEnv *env, const char *format, ...)
   return EXIT_FAILURE;
 }
 
-int
-invoke(int argc, char **argv)
+static int
+create(JavaVM **jvm, JNIEnv **env)
 {
   int result = EXIT_SUCCESS;
   jint rc;
-  JavaVM *jvm = NULL;
-  JNIEnv *env = NULL;
   JavaVMInitArgs vm_args;
   JavaVMOption options[1];
-  jclass main_class;
-  jmethodID main_method;
-  jobjectArray args_array;
-  jclass string_class;
 
   memset(&vm_args, 0, sizeof(vm_args));
   vm_args.version = JNI_VERSION_1_8;
 
   if ((rc = JNI_GetDefaultJavaVMInitArgs(&vm_args)) < 0) {
-    result = fail(env, "JVM does not support Java 1.8: %d", rc);
+    result = fail(*env, "JVM does not support Java 1.8: %d", rc);
   } else {
     vm_args.nOptions = sizeof(options)/sizeof(*options);
     vm_args.options  = options;
@@ -169,12 +1154,28 @@ invoke(int argc, char **argv)
 
   if (rc < 0) {
   } else if ((rc = JNI_CreateJavaVM
-              (&jvm, (void**)&env, &vm_args)) < 0) {
-    result = fail(env, "failed to create JVM: %d", rc);
-  } else if (!env || !*env) {
-    result = fail(env, "got NULL for JNI environment");
-  } else if ((rc = (*env)->GetVersion(env)) < 0) {
-    result = fail(env, "failure from GetVersion (%d)", rc);
+              (jvm, (void**)env, &vm_args)) < 0) {
+    result = fail(*env, "failed to create JVM: %d", rc);
+  } else if (!*env || !**env) {
+    result = fail(*env, "got NULL for JNI environment");
+  } else if ((rc = (**env)->GetVersion(*env)) < 0) {
+    result = fail(*env, "failure from GetVersion (%d)", rc);
+  }
+  return result;
+}
+
+int
+invoke(int argc, char **argv)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass main_class;
+  jmethodID main_method;
+  jobjectArray args_array;
+  jclass string_class;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
   } else if (argc && !(main_class = (*env)->FindClass(env, argv[0]))) {
     result = fail(env, "failed to find class %s", argv[0]);
   } else if (!argc && !(main_class = (*env)->DefineClass
@@ -222,14 +1223,1982 @@ invoke(int argc, char **argv)
   return result;
 }
 
-int
-main(int argc, char **argv)
+struct loop_check {
+  const char *name;
+  const char *sig;
+  jint argument;
+  jlong expected;
+} loop_checks[] = {
+  { "factorial", "(I)I", 5, 120 },
+  { "factorial", "(I)I", 12, 479001600 },
+  { "nested",    "(I)I", 16, 896 },
+  { "fibonacci", "(I)J", 90, 2880067194370816120LL },
+  { "depth",     "(I)I", 1000, 1000 },
+  { "choose",    "(I)I", 2, 30 },
+  { "choose",    "(I)I", 9, -1 },
+  { "sparse",    "(I)I", -1000, 1000 },
+  { "sparse",    "(I)I", 100000, 4 },
+  { "sparse",    "(I)I", 8, 0 },
+  { "harmonic",  "(I)I", 1000, 7485 },
+};
+
+static jlong
+loop_call(JNIEnv *env, jclass loop, jmethodID method,
+          const char *sig, jint argument)
+{
+  return (sig[strlen(sig) - 1] == 'J') ?
+    (*env)->CallStaticLongMethod(env, loop, method, argument) :
+    (*env)->CallStaticIntMethod(env, loop, method, argument);
+}
+
+/**
+ * Run methods of the Loop class with the byte code interpreter and
+ * compare the results to expected values.  With a non-zero repeat
+ * count each call is also timed, which is useful for comparing
+ * interpreter dispatch strategies.
+ *
+ * @param repeat number of times to call each method for timing
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+loop(unsigned repeat)
 {
   int result = EXIT_SUCCESS;
-  if (argc < 2)
-    result = invoke(0, NULL);
-  else if (!strcmp("main", argv[1]))
-    result = invoke(argc - 2, argv + 2);
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass loop_class_object = NULL;
+  jfieldID count_field;
+  jmethodID depth_method;
+  unsigned ii, jj;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(loop_class_object = (*env)->DefineClass
+               (env, "Loop", NULL, loop_class, sizeof(loop_class)))) {
+    result = fail(env, "failed to define Loop class");
+  } else if (!(count_field = (*env)->GetStaticFieldID
+               (env, loop_class_object, "count", "I"))) {
+    result = fail(env, "failed to find Loop.count");
+  } else if (!(depth_method = (*env)->GetStaticMethodID
+               (env, loop_class_object, "depth", "(I)I"))) {
+    result = fail(env, "failed to find Loop.depth");
+  }
+
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < sizeof(loop_checks) / sizeof(*loop_checks)); ++ii) {
+    struct loop_check *check = &loop_checks[ii];
+    jmethodID method = (*env)->GetStaticMethodID
+      (env, loop_class_object, check->name, check->sig);
+    jlong value = 0;
+
+    if (!method) {
+      result = fail(env, "failed to find Loop.%s%s",
+                    check->name, check->sig);
+    } else if ((value = loop_call(env, loop_class_object, method,
+                                  check->sig, check->argument)),
+               (*env)->ExceptionCheck(env)) {
+      result = fail(env, "exception from Loop.%s(%d)",
+                    check->name, check->argument);
+    } else if (value != check->expected) {
+      result = fail(env, "Loop.%s(%d) returned %lld not %lld",
+                    check->name, check->argument, (long long)value,
+                    (long long)check->expected);
+    } else if (repeat) {
+      clock_t start = clock();
+
+      for (jj = 0; jj < repeat; ++jj)
+        loop_call(env, loop_class_object, method,
+                  check->sig, check->argument);
+      printf("Loop.%s(%d) x %u: %.3f seconds\n", check->name,
+             check->argument, repeat,
+             (double)(clock() - start) / CLOCKS_PER_SEC);
+    }
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if ((*env)->GetStaticIntField
+             (env, loop_class_object, count_field) < 1001) {
+    result = fail(env, "Loop.count is %d after recursion",
+                  (*env)->GetStaticIntField
+                  (env, loop_class_object, count_field));
+  } else {
+    (*env)->SetStaticIntField(env, loop_class_object, count_field, 0);
+    (*env)->CallStaticIntMethod
+      (env, loop_class_object, depth_method, 1000000);
+    if (!(*env)->ExceptionCheck(env))
+      result = fail(env, "expected stack overflow from Loop.depth");
+    else if ((*env)->ExceptionClear(env),
+             (*env)->GetStaticIntField
+             (env, loop_class_object, count_field) < 1000)
+      result = fail(env, "Loop.depth overflowed too soon");
+    else if ((*env)->CallStaticIntMethod
+             (env, loop_class_object, depth_method, 10) != 10)
+      result = fail(env, "Loop.depth failed after stack overflow");
+  }
+
+  if (env && *env)
+    (*env)->DeleteLocalRef(env, loop_class_object);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Create objects and call virtual methods on them, including an
+ * overridden method which calls the one it overrides.  Calling a
+ * method on null must throw an exception.
+ *
+ * @param repeat number of times to call each method for timing
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+animals(unsigned repeat)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass animal = NULL;
+  jclass bird = NULL;
+  jmethodID count_method;
+  jmethodID missing_method;
+  jint kind, value;
+  unsigned ii;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(animal = (*env)->DefineClass
+               (env, "Animal", NULL, animal_class,
+                sizeof(animal_class)))) {
+    result = fail(env, "failed to define Animal class");
+  } else if (!(bird = (*env)->DefineClass
+               (env, "Bird", NULL, bird_class, sizeof(bird_class)))) {
+    result = fail(env, "failed to define Bird class");
+  } else if (!(count_method = (*env)->GetStaticMethodID
+               (env, animal, "count", "(II)I"))) {
+    result = fail(env, "failed to find Animal.count");
+  } else if (!(missing_method = (*env)->GetStaticMethodID
+               (env, animal, "missing", "(I)I"))) {
+    result = fail(env, "failed to find Animal.missing");
+  }
+
+  for (kind = 0; (EXIT_SUCCESS == result) && (kind < 2); ++kind) {
+    jint expected = kind ? 2000 : 4000;
+
+    if ((value = (*env)->CallStaticIntMethod
+         (env, animal, count_method, kind, 1000)),
+        (*env)->ExceptionCheck(env)) {
+      result = fail(env, "exception from Animal.count(%d)", kind);
+    } else if (value != expected) {
+      result = fail(env, "Animal.count(%d, 1000) returned %d not %d",
+                    kind, value, expected);
+    } else if (repeat) {
+      clock_t start = clock();
+
+      for (ii = 0; ii < repeat; ++ii)
+        (*env)->CallStaticIntMethod(env, animal, count_method, kind, 1000);
+      printf("Animal.count(%d, 1000) x %u: %.3f seconds\n", kind,
+             repeat, (double)(clock() - start) / CLOCKS_PER_SEC);
+    }
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if ((*env)->CallStaticIntMethod
+             (env, animal, missing_method, 0),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "expected exception from Animal.missing");
+  } else (*env)->ExceptionClear(env);
+
+  if (env && *env) {
+    (*env)->DeleteLocalRef(env, bird);
+    (*env)->DeleteLocalRef(env, animal);
+  }
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Store values in fields of every type, including inherited ones,
+ * and read them back both through JNI and from byte code.  The values
+ * must survive a collection and fields must not overlap.
+ *
+ * @param count number of nodes for Node.chain() to create
+ * @param report print elapsed time when non-zero
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+fields(unsigned count, int report)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass node = NULL;
+  jclass leaf = NULL;
+  jclass system_class = NULL;
+  jmethodID chain_method;
+  jmethodID gc_method;
+  jfieldID tag, flag, letter, small, number, ratio, big, exact, next;
+  jfieldID extra, other;
+  jobject first = NULL;
+  jobject second = NULL;
+  jlong expected = 0;
+  jlong value = 0;
+  clock_t start;
+  unsigned ii;
+
+  for (ii = 0; ii < count; ++ii)
+    expected += 2 * (jlong)ii + (jbyte)ii;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(node = (*env)->DefineClass
+               (env, "Node", NULL, node_class, sizeof(node_class)))) {
+    result = fail(env, "failed to define Node class");
+  } else if (!(leaf = (*env)->DefineClass
+               (env, "Leaf", NULL, leaf_class, sizeof(leaf_class)))) {
+    result = fail(env, "failed to define Leaf class");
+  } else if (!(system_class = (*env)->FindClass
+               (env, "java/lang/System"))) {
+    result = fail(env, "failed to find java/lang/System");
+  } else if (!(gc_method = (*env)->GetStaticMethodID
+               (env, system_class, "gc", "()V"))) {
+    result = fail(env, "failed to find System.gc");
+  } else if (!(chain_method = (*env)->GetStaticMethodID
+               (env, node, "chain", "(I)J"))) {
+    result = fail(env, "failed to find Node.chain");
+  } else if (!(tag = (*env)->GetFieldID(env, leaf, "tag", "B")) ||
+             !(flag = (*env)->GetFieldID(env, leaf, "flag", "Z")) ||
+             !(letter = (*env)->GetFieldID(env, leaf, "letter", "C")) ||
+             !(small = (*env)->GetFieldID(env, leaf, "small", "S")) ||
+             !(number = (*env)->GetFieldID(env, leaf, "count", "I")) ||
+             !(ratio = (*env)->GetFieldID(env, leaf, "ratio", "F")) ||
+             !(big = (*env)->GetFieldID(env, leaf, "big", "J")) ||
+             !(exact = (*env)->GetFieldID(env, leaf, "exact", "D")) ||
+             !(next = (*env)->GetFieldID(env, leaf, "next", "LNode;")) ||
+             !(extra = (*env)->GetFieldID(env, leaf, "extra", "I")) ||
+             !(other = (*env)->GetFieldID
+               (env, leaf, "other", "LNode;"))) {
+    result = fail(env, "failed to find fields of Leaf");
+  } else if (!(first = (*env)->AllocObject(env, leaf)) ||
+             !(second = (*env)->AllocObject(env, node))) {
+    result = fail(env, "failed to allocate objects");
+  } else {
+    (*env)->SetByteField(env, first, tag, -5);
+    (*env)->SetBooleanField(env, first, flag, JNI_TRUE);
+    (*env)->SetCharField(env, first, letter, 0xfffe);
+    (*env)->SetShortField(env, first, small, -2);
+    (*env)->SetIntField(env, first, number, -123456);
+    (*env)->SetFloatField(env, first, ratio, 1.5f);
+    (*env)->SetLongField(env, first, big, -((jlong)1 << 40));
+    (*env)->SetDoubleField(env, first, exact, 0.25);
+    (*env)->SetObjectField(env, first, next, second);
+    (*env)->SetIntField(env, first, extra, 77);
+    (*env)->SetObjectField(env, first, other, first);
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if ((*env)->CallStaticVoidMethod
+             (env, system_class, gc_method),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from System.gc");
+  } else if (((*env)->GetByteField(env, first, tag) != -5) ||
+             ((*env)->GetBooleanField(env, first, flag) != JNI_TRUE) ||
+             ((*env)->GetCharField(env, first, letter) != 0xfffe) ||
+             ((*env)->GetShortField(env, first, small) != -2) ||
+             ((*env)->GetIntField(env, first, number) != -123456) ||
+             ((*env)->GetFloatField(env, first, ratio) != 1.5f) ||
+             ((*env)->GetLongField(env, first, big) !=
+              -((jlong)1 << 40)) ||
+             ((*env)->GetDoubleField(env, first, exact) != 0.25) ||
+             ((*env)->GetIntField(env, first, extra) != 77)) {
+    result = fail(env, "fields of Leaf lost their values");
+  } else if (((*env)->GetObjectField(env, first, next) != second) ||
+             ((*env)->GetObjectField(env, first, other) != first) ||
+             (*env)->GetObjectField(env, second, next)) {
+    result = fail(env, "reference fields of Leaf lost their values");
+  } else if (start = clock(),
+             (value = (*env)->CallStaticLongMethod
+              (env, node, chain_method, (jint)count)),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Node.chain(%u)", count);
+  } else if (value != expected) {
+    result = fail(env, "Node.chain(%u) returned %lld not %lld", count,
+                  (long long)value, (long long)expected);
+  } else if (report)
+    printf("Node.chain(%u): %.3f seconds\n", count,
+           (double)(clock() - start) / CLOCKS_PER_SEC);
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Build a long chain of nodes and check that the heap grows with the
+ * objects which are kept rather than with the number of allocation
+ * buffers handed out.  Every region must be used, so the heap should
+ * be within a small factor of what the last collection kept.
+ *
+ * @param mode value for WINJ_GC or NULL for the default collector
+ * @param count number of nodes for Node.chain() to create
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+footprint(const char *mode, unsigned count)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass node = NULL;
+  jmethodID chain_method;
+  WINJGCStats stats;
+  jlong expected = 0;
+  jlong value = 0;
+  unsigned ii;
+
+  for (ii = 0; ii < count; ++ii)
+    expected += 2 * (jlong)ii + (jbyte)ii;
+
+  if (mode ? setenv("WINJ_GC", mode, 1) : unsetenv("WINJ_GC")) {
+    result = fail(NULL, "failed to set WINJ_GC: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(node = (*env)->DefineClass
+               (env, "Node", NULL, node_class, sizeof(node_class)))) {
+    result = fail(env, "failed to define Node class");
+  } else if (!(chain_method = (*env)->GetStaticMethodID
+               (env, node, "chain", "(I)J"))) {
+    result = fail(env, "failed to find Node.chain");
+  } else if ((value = (*env)->CallStaticLongMethod
+              (env, node, chain_method, (jint)count)),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Node.chain(%u)", count);
+  } else if (value != expected) {
+    result = fail(env, "Node.chain(%u) returned %lld not %lld", count,
+                  (long long)value, (long long)expected);
+  } else if (JNI_OK != WINJ_GetGCStats(jvm, &stats)) {
+    result = fail(env, "failed to get collection statistics");
+  } else if (!stats.live_bytes) {
+    result = fail(env, "Node.chain(%u) caused no full collection", count);
+  } else if (stats.heap_bytes > 4 * stats.live_bytes) {
+    result = fail(env, "%s: heap of %ld bytes for %ld live bytes",
+                  mode ? mode : "default", (long)stats.heap_bytes,
+                  (long)stats.live_bytes);
+  }
+  unsetenv("WINJ_GC");
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Call methods on receivers of one, a few and many classes through
+ * both an interface and a class, so that call sites go through each
+ * kind of caching they support.
+ *
+ * @param count number of calls each site makes
+ * @param report print elapsed time when non-zero
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+shapes(unsigned count, int report)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  struct { const char *name; const unsigned char *bytes; size_t size; }
+  defines[] = {
+    { "Shape", shape_class, sizeof(shape_class) },
+    { "Triangle", triangle_class, sizeof(triangle_class) },
+    { "Square", square_class, sizeof(square_class) },
+    { "Pentagon", pentagon_class, sizeof(pentagon_class) },
+    { "Hexagon", hexagon_class, sizeof(hexagon_class) },
+    { "Cell", cell_class, sizeof(cell_class) },
+    { "Shapes", shapes_class, sizeof(shapes_class) } };
+  static const struct { const char *name; jint sides[5]; } methods[] = {
+    { "total", { 3, 4, 5, 6, 6 } },
+    { "edges", { 3, 4, 5, 6, 6 } },
+    { "corners", { 0, 0, 5, 6, 6 } } };
+  static const unsigned kinds[] = { 1, 3, 5 };
+  jclass triangle = NULL;
+  jclass cell = NULL;
+  jclass shapes_object = NULL;
+  jobject shape = NULL;
+  jmethodID method;
+  jint expected, value;
+  clock_t start;
+  unsigned ii, jj, kk;
+
+  result = create(&jvm, &env);
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < sizeof(defines) / sizeof(*defines)); ++ii)
+    if (!(shapes_object = (*env)->DefineClass
+          (env, defines[ii].name, NULL, defines[ii].bytes,
+           (jsize)defines[ii].size)))
+      result = fail(env, "failed to define %s class", defines[ii].name);
+    else if (ii == 1)
+      triangle = shapes_object;
+    else if (ii == 5)
+      cell = shapes_object;
+
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < sizeof(methods) / sizeof(*methods)); ++ii) {
+    if (!(method = (*env)->GetStaticMethodID
+          (env, shapes_object, methods[ii].name, "(II)I"))) {
+      result = fail(env, "failed to find Shapes.%s", methods[ii].name);
+      break;
+    }
+    for (jj = 0; (EXIT_SUCCESS == result) &&
+           (jj < sizeof(kinds) / sizeof(*kinds)); ++jj) {
+      for (expected = 0, kk = 0; kk < count; ++kk)
+        expected += methods[ii].sides[kk % kinds[jj]];
+      start = clock();
+      value = (*env)->CallStaticIntMethod
+        (env, shapes_object, method, (jint)count, (jint)kinds[jj]);
+      if ((*env)->ExceptionCheck(env))
+        result = fail(env, "exception from Shapes.%s(%u, %u)",
+                      methods[ii].name, count, kinds[jj]);
+      else if (value != expected)
+        result = fail(env, "Shapes.%s(%u, %u) returned %d not %d",
+                      methods[ii].name, count, kinds[jj], value, expected);
+      else if (report)
+        printf("Shapes.%s(%u, %u): %.3f seconds\n", methods[ii].name,
+               count, kinds[jj],
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+    }
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, shapes_object, "narrow",
+                "(Ljava/lang/Object;)LPentagon;"))) {
+    result = fail(env, "failed to find Shapes.narrow");
+  } else if (!(shape = (*env)->AllocObject(env, cell))) {
+    result = fail(env, "failed to allocate Cell");
+  } else if (((*env)->CallStaticObjectMethod
+              (env, shapes_object, method, shape) != shape) ||
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "Shapes.narrow refused a Cell");
+  } else if (!(shape = (*env)->AllocObject(env, triangle))) {
+    result = fail(env, "failed to allocate Triangle");
+  } else if ((*env)->CallStaticObjectMethod
+             (env, shapes_object, method, shape),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "Shapes.narrow accepted a Triangle");
+  } else if ((*env)->ExceptionClear(env),
+             !(*env)->IsInstanceOf(env, shape, triangle) ||
+             (*env)->IsInstanceOf(env, shape, cell)) {
+    result = fail(env, "IsInstanceOf confused Triangle and Cell");
+  }
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Create many arrays of assorted sizes, including some too large to
+ * share an allocation buffer and one larger than a heap region.
+ *
+ * @param count number of arrays to create
+ * @param report print elapsed time when non-zero
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+arrays(unsigned count, int report)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass object_class = NULL;
+  jobjectArray previous = NULL;
+  jobjectArray array = NULL;
+  clock_t start = clock();
+  unsigned ii;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(object_class = (*env)->FindClass
+               (env, "java/lang/Object"))) {
+    result = fail(env, "failed to find java/lang/Object");
+  } else for (ii = 0; (EXIT_SUCCESS == result) && (ii < count); ++ii) {
+      jsize length = (ii == count / 2) ? 300000 :
+        (ii % 100 == 99) ? 5000 : (jsize)(ii % 17);
+
+      if (!(array = (*env)->NewObjectArray
+            (env, length, object_class, previous)) ||
+          (*env)->ExceptionCheck(env)) {
+        result = fail(env, "failed to create array of %d", length);
+      } else if (length) {
+        (*env)->SetObjectArrayElement(env, array, length - 1, array);
+        if ((*env)->ExceptionCheck(env))
+          result = fail(env, "failed to set element %d", length - 1);
+      }
+      previous = array;
+    }
+
+  if ((EXIT_SUCCESS == result) && report)
+    printf("create %u arrays: %.3f seconds\n", count,
+           (double)(clock() - start) / CLOCKS_PER_SEC);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Create enough garbage to cause collections, both automatically and
+ * through System.gc(), while keeping some objects reachable through
+ * a local reference, a global reference and an array element.  Each
+ * array refers to the one before it, which only an array element
+ * keeps reachable, so the nursery must move it and update the
+ * reference.
+ *
+ * @param count number of arrays to create and discard
+ * @param report print collection statistics when non-zero
+ * @param mode value for the WINJ_GC environment variable
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+garbage(unsigned count, int report, const char *mode)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass object_class = NULL;
+  jclass system_class = NULL;
+  jmethodID gc_method;
+  jobjectArray kept = NULL;
+  jobjectArray global = NULL;
+  jobjectArray array = NULL;
+  jobjectArray previous = NULL;
+  WINJGCStats stats;
+  unsigned ii;
+
+  if (setenv("WINJ_GC", mode, 1)) {
+    result = fail(NULL, "failed to set WINJ_GC: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(object_class = (*env)->FindClass
+               (env, "java/lang/Object"))) {
+    result = fail(env, "failed to find java/lang/Object");
+  } else if (!(system_class = (*env)->FindClass
+               (env, "java/lang/System"))) {
+    result = fail(env, "failed to find java/lang/System");
+  } else if (!(gc_method = (*env)->GetStaticMethodID
+               (env, system_class, "gc", "()V"))) {
+    result = fail(env, "failed to find System.gc");
+  } else if (!(kept = (*env)->NewObjectArray
+               (env, 1, object_class, NULL))) {
+    result = fail(env, "failed to create kept array");
+  } else if (!(array = (*env)->NewObjectArray
+               (env, 1, object_class, kept))) {
+    result = fail(env, "failed to create global array");
+  } else if (!(global = (*env)->NewGlobalRef(env, array))) {
+    result = fail(env, "failed to create global reference");
+  } else (*env)->DeleteLocalRef(env, array);
+  unsetenv("WINJ_GC");
+
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < count); ++ii) {
+    if (!(array = (*env)->NewObjectArray
+          (env, 64, object_class, kept))) {
+      result = fail(env, "failed to create array %u", ii);
+    } else {
+      /* Only the newest array refers to the one before it. */
+      if ((previous = (*env)->GetObjectArrayElement(env, kept, 0))) {
+        (*env)->SetObjectArrayElement(env, array, 0, previous);
+        (*env)->SetObjectArrayElement(env, previous, 0, kept);
+        (*env)->DeleteLocalRef(env, previous);
+      }
+      (*env)->SetObjectArrayElement(env, kept, 0, array);
+      if (ii + 1 < count)
+        (*env)->DeleteLocalRef(env, array);
+    }
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if ((*env)->CallStaticVoidMethod
+             (env, system_class, gc_method),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from System.gc");
+  } else if (JNI_OK != WINJ_GetGCStats(jvm, &stats)) {
+    result = fail(env, "failed to get collection statistics");
+  } else if (stats.collections + stats.minor_collections < 2) {
+    result = fail(env, "expected collections but got %ld",
+                  (long)(stats.collections + stats.minor_collections));
+  } else if (stats.live_bytes > 64 * 1024) {
+    result = fail(env, "expected little to be live but got %ld bytes",
+                  (long)stats.live_bytes);
+  } else if ((*env)->GetObjectArrayElement(env, kept, 0) != array) {
+    result = fail(env, "last array was not kept");
+  } else if ((*env)->GetObjectArrayElement(env, array, 63) != kept) {
+    result = fail(env, "last array lost its contents");
+  } else if (!(previous = (*env)->GetObjectArrayElement
+               (env, array, 0))) {
+    result = fail(env, "last array lost the one before it");
+  } else if (((*env)->GetObjectArrayElement(env, previous, 0) != kept) ||
+             ((*env)->GetObjectArrayElement(env, previous, 63) != kept)) {
+    result = fail(env, "array before last lost its contents");
+  } else if ((*env)->GetObjectArrayElement(env, global, 0) != kept) {
+    result = fail(env, "global array lost its contents");
+  } else if (report)
+    printf("%s: %ld collections and %ld minor freed %ld bytes, "
+           "pauses %ld us total and %ld us at most, minor pauses "
+           "%ld us total and %ld us at most, heap %ld bytes\n", mode,
+           (long)stats.collections, (long)stats.minor_collections,
+           (long)stats.freed_bytes, (long)stats.pause_total,
+           (long)stats.pause_max, (long)stats.minor_pause_total,
+           (long)stats.minor_pause_max, (long)stats.heap_bytes);
+
+  if (env && *env && global)
+    (*env)->DeleteGlobalRef(env, global);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+static int
+write_file(const char *path, const unsigned char *bytes, size_t count)
+{
+  int result = EXIT_SUCCESS;
+  FILE *out = fopen(path, "wb");
+
+  if (!out)
+    result = fail(NULL, "failed to open %s: %s", path, strerror(errno));
+  else if (fwrite(bytes, 1, count, out) != count)
+    result = fail(NULL, "failed to write %s: %s", path, strerror(errno));
+  if (out && fclose(out))
+    result = fail(NULL, "failed to close %s: %s", path, strerror(errno));
+  return result;
+}
+
+/**
+ * Find the Animal and Bird classes using a particular WINJ_PATH and
+ * make sure they work.  Finding Bird requires loading Animal as well
+ * since that is its super class.
+ *
+ * @param winj_path value for the WINJ_PATH environment variable
+ * @param loop non-zero if the Loop class should also be found
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classpath_check(const char *winj_path, int loop)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass bird = NULL;
+  jclass animal = NULL;
+  jclass loop_class_object = NULL;
+  jmethodID method;
+  jint value;
+
+  if (setenv("WINJ_PATH", winj_path, 1)) {
+    result = fail(NULL, "failed to set WINJ_PATH: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(bird = (*env)->FindClass(env, "Bird"))) {
+    result = fail(env, "failed to find Bird in %s", winj_path);
+  } else if (!(animal = (*env)->FindClass(env, "Animal"))) {
+    result = fail(env, "failed to find Animal in %s", winj_path);
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, animal, "count", "(II)I"))) {
+    result = fail(env, "failed to find Animal.count");
+  } else if ((value = (*env)->CallStaticIntMethod
+              (env, animal, method, 1, 10)) != 20) {
+    result = fail(env, "Animal.count(1, 10) returned %d not 20", value);
+  } else if (!loop) {
+  } else if (!(loop_class_object = (*env)->FindClass(env, "Loop"))) {
+    result = fail(env, "failed to find Loop in %s", winj_path);
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, loop_class_object, "factorial", "(I)I"))) {
+    result = fail(env, "failed to find Loop.factorial");
+  } else if ((value = (*env)->CallStaticIntMethod
+              (env, loop_class_object, method, 5)) != 120) {
+    result = fail(env, "Loop.factorial(5) returned %d not 120", value);
+  }
+
+  if (env && *env) {
+    (*env)->DeleteLocalRef(env, loop_class_object);
+    (*env)->DeleteLocalRef(env, animal);
+    (*env)->DeleteLocalRef(env, bird);
+  }
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Make sure a class missing from WINJ_PATH stays missing for a
+ * virtual machine which already failed to find it, even after the
+ * class file appears, while a new virtual machine finds it.
+ *
+ * @param directory value for the WINJ_PATH environment variable
+ * @param loop_path where to write the Loop class file
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classpath_missing(const char *directory, const char *loop_path)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JavaVM *fresh = NULL;
+  JNIEnv *env = NULL;
+  JNIEnv *fresh_env = NULL;
+  jclass found = NULL;
+  unsigned ii;
+
+  if (setenv("WINJ_PATH", directory, 1)) {
+    result = fail(NULL, "failed to set WINJ_PATH: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else for (ii = 0; (EXIT_SUCCESS == result) && (ii < 3); ++ii)
+      if ((found = (*env)->FindClass(env, "Loop")))
+        result = fail(env, "found Loop before it was written");
+
+  if (EXIT_SUCCESS != result) {
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (loop_path, loop_class,
+                               sizeof(loop_class)))) {
+  } else if ((found = (*env)->FindClass(env, "Loop"))) {
+    result = fail(env, "found Loop after remembering it was missing");
+  } else if (EXIT_SUCCESS != (result = create(&fresh, &fresh_env))) {
+  } else if (!(found = (*fresh_env)->FindClass(fresh_env, "Loop"))) {
+    result = fail(fresh_env, "failed to find Loop in %s", directory);
+  } else (*fresh_env)->DeleteLocalRef(fresh_env, found);
+
+  if (fresh)
+    (*fresh)->DestroyJavaVM(fresh);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Make sure a class whose file has changed since a snapshot was
+ * recorded comes from the class path rather than the snapshot.
+ *
+ * @param directory value for the WINJ_PATH environment variable
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classpath_changed(const char *directory)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass bird = NULL;
+
+  if (setenv("WINJ_PATH", directory, 1)) {
+    result = fail(NULL, "failed to set WINJ_PATH: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if ((bird = (*env)->FindClass(env, "Bird"))) {
+    result = fail(env, "found Bird in snapshot after its file changed");
+  } else (*env)->ExceptionClear(env);
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Record a snapshot of the classes found in a directory, then make
+ * sure a new virtual machine uses it as long as each class file
+ * keeps its size and modification time.  Bird is overwritten with
+ * zeros of the same size and the same time, which only the snapshot
+ * can survive, and then given a new time so that the class path must
+ * be used.  Finally a file which is not a snapshot must be left as
+ * it is.
+ *
+ * @param directory value for the WINJ_PATH environment variable
+ * @param snapshot_path value for the WINJ_SNAPSHOT variable
+ * @param bird_path Bird class file to change
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classpath_snapshot(const char *directory, const char *snapshot_path,
+                   const char *bird_path)
+{
+  int result = EXIT_SUCCESS;
+  static const char other[] = "not a snapshot\n";
+  unsigned char zeros[sizeof(bird_class)] = {0};
+  char contents[sizeof(other)] = {0};
+  struct timespec times[2];
+  struct stat st;
+  FILE *in = NULL;
+
+  if (setenv("WINJ_SNAPSHOT", snapshot_path, 1)) {
+    result = fail(NULL, "failed to set WINJ_SNAPSHOT: %s",
+                  strerror(errno));
+  } else if (EXIT_SUCCESS != (result = classpath_check(directory, 0))) {
+  } else if (access(snapshot_path, R_OK)) {
+    result = fail(NULL, "failed to record %s: %s", snapshot_path,
+                  strerror(errno));
+  } else if (stat(bird_path, &st)) {
+    result = fail(NULL, "failed to stat %s: %s", bird_path,
+                  strerror(errno));
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (bird_path, zeros, sizeof(zeros)))) {
+  } else if (times[0] = st.st_atim, times[1] = st.st_mtim,
+             utimensat(AT_FDCWD, bird_path, times, 0)) {
+    result = fail(NULL, "failed to restore time of %s: %s", bird_path,
+                  strerror(errno));
+  } else if (EXIT_SUCCESS != (result = classpath_check(directory, 0))) {
+  } else if (++times[1].tv_sec,
+             utimensat(AT_FDCWD, bird_path, times, 0)) {
+    result = fail(NULL, "failed to change time of %s: %s", bird_path,
+                  strerror(errno));
+  } else if (EXIT_SUCCESS != (result = classpath_changed(directory))) {
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (bird_path, bird_class,
+                               sizeof(bird_class)))) {
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (snapshot_path,
+                               (const unsigned char *)other,
+                               sizeof(other) - 1))) {
+  } else if (EXIT_SUCCESS != (result = classpath_check(directory, 0))) {
+  } else if (!(in = fopen(snapshot_path, "rb")) ||
+             (fread(contents, 1, sizeof(contents), in) !=
+              sizeof(other) - 1) || strcmp(contents, other)) {
+    result = fail(NULL, "%s was replaced though not a snapshot",
+                  snapshot_path);
+  }
+  if (in)
+    fclose(in);
+  unsetenv("WINJ_SNAPSHOT");
+  return result;
+}
+
+/**
+ * Make sure an archive member whose central directory entry has the
+ * placeholder size that ZIP64 archives use is skipped rather than
+ * inflated into a buffer of the wrong size.  Other members of the
+ * archive must still be found.
+ *
+ * @param path where to write the damaged archive
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classpath_zip64(const char *path)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass found = NULL;
+  unsigned char jar[sizeof(animals_jar)];
+  unsigned char *entry = NULL;
+  size_t ii;
+
+  memcpy(jar, animals_jar, sizeof(jar));
+  for (ii = 0; !entry && (ii + 56 <= sizeof(jar)); ++ii)
+    if (!memcmp(jar + ii, "PK\x01\x02", 4) &&
+        !memcmp(jar + ii + 46, "Bird.class", 10))
+      entry = jar + ii;
+
+  if (!entry) {
+    result = fail(NULL, "no central directory entry for Bird.class");
+  } else if (memset(entry + 24, 0xFF, 4), /* uncompressed size */
+             EXIT_SUCCESS != (result = write_file
+                              (path, jar, sizeof(jar)))) {
+  } else if (setenv("WINJ_PATH", path, 1)) {
+    result = fail(NULL, "failed to set WINJ_PATH: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if ((found = (*env)->FindClass(env, "Bird"))) {
+    result = fail(env, "found Bird with a ZIP64 size in %s", path);
+  } else if ((*env)->ExceptionClear(env),
+             !(found = (*env)->FindClass(env, "Animal"))) {
+    result = fail(env, "failed to find Animal in %s", path);
+  } else (*env)->DeleteLocalRef(env, found);
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Load classes from files found using the WINJ_PATH environment
+ * variable, first from a directory and then from an archive.  A
+ * damaged archive must not break anything.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classpath(void)
+{
+  int result = EXIT_SUCCESS;
+  char directory[] = "/tmp/check-winj-XXXXXX";
+  char animal_path[sizeof(directory) + 16];
+  char bird_path[sizeof(directory) + 16];
+  char jar_path[sizeof(directory) + 16];
+  char loop_path[sizeof(directory) + 16];
+  char snapshot_path[sizeof(directory) + 16];
+  char zip64_path[sizeof(directory) + 16];
+  char winj_path[4 * sizeof(directory) + 32];
+
+  if (!mkdtemp(directory)) {
+    result = fail(NULL, "failed to create directory: %s",
+                  strerror(errno));
+    directory[0] = '\0';
+  } else {
+    snprintf(animal_path, sizeof(animal_path), "%s/Animal.class",
+             directory);
+    snprintf(bird_path, sizeof(bird_path), "%s/Bird.class", directory);
+    snprintf(jar_path, sizeof(jar_path), "%s/animals.jar", directory);
+    snprintf(loop_path, sizeof(loop_path), "%s/Loop.class", directory);
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s/classes.jsa",
+             directory);
+    snprintf(zip64_path, sizeof(zip64_path), "%s/zip64.jar", directory);
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (animal_path, animal_class,
+                               sizeof(animal_class)))) {
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (bird_path, bird_class,
+                               sizeof(bird_class)))) {
+  } else if (EXIT_SUCCESS != (result = write_file
+                              (jar_path, animals_jar,
+                               sizeof(animals_jar)))) {
+  } else if (EXIT_SUCCESS != (result = classpath_check
+                              (directory, 0))) {
+  } else {
+    /* The missing archive and directory must be skipped. */
+    snprintf(winj_path, sizeof(winj_path), "%s/missing.zip:%s/none:%s",
+             directory, directory, jar_path);
+    if (EXIT_SUCCESS != (result = classpath_check(winj_path, 1))) {
+    } else if (EXIT_SUCCESS != (result = classpath_zip64(zip64_path))) {
+    } else if (EXIT_SUCCESS != (result = classpath_missing
+                                (directory, loop_path))) {
+    } else result = classpath_snapshot
+             (directory, snapshot_path, bird_path);
+  }
+
+  if (directory[0]) {
+    unlink(zip64_path);
+    unlink(snapshot_path);
+    unlink(loop_path);
+    unlink(jar_path);
+    unlink(bird_path);
+    unlink(animal_path);
+    rmdir(directory);
+  }
+  return result;
+}
+
+/**
+ * Repeat the Loop, Animal and Shape checks with every method compiled
+ * on its first invocation, so that compiled code must produce the
+ * same results as the interpreter, including exceptions and stack
+ * overflow.  Where a compiler is available, confirm that it was used.
+ *
+ * @param repeat number of times to call each method for timing
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+jit(unsigned repeat)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass loop_class_object = NULL;
+  jmethodID method;
+  WINJJITStats stats;
+
+  if (repeat)
+    printf("compiled:\n");
+  if (setenv("WINJ_JIT", "1", 1)) {
+    result = fail(NULL, "failed to set WINJ_JIT: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = loop(repeat))) {
+  } else if (EXIT_SUCCESS != (result = animals(0))) {
+  } else if (EXIT_SUCCESS != (result = shapes(1000, 0))) {
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(loop_class_object = (*env)->DefineClass
+               (env, "Loop", NULL, loop_class, sizeof(loop_class)))) {
+    result = fail(env, "failed to define Loop class");
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, loop_class_object, "nested", "(I)I"))) {
+    result = fail(env, "failed to find Loop.nested");
+  } else if ((*env)->CallStaticIntMethod
+             (env, loop_class_object, method, 10),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Loop.nested");
+  } else if (WINJ_GetJITStats(jvm, &stats) != JNI_OK) {
+    result = fail(env, "failed to get compiler statistics");
+#if defined(__x86_64__) && !defined(WINJ_NO_JIT) && \
+  !defined(WINJ_PAIR_PROFILE)
+  } else if (!stats.compiled || !stats.code_bytes || !stats.entries) {
+    result = fail(env, "expected compiled code to run");
+#endif
+  }
+  unsetenv("WINJ_JIT");
+
+  if (env && *env)
+    (*env)->DeleteLocalRef(env, loop_class_object);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Define a class whose constant pool refers forward to entries not
+ * yet read, then the same class with a method reference whose class
+ * is a UTF8 constant.  The first must be accepted and the second
+ * rejected even though nothing ever resolves the reference.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+constants(void)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass cls = NULL;
+  unsigned char forward[] = {
+    0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x00, 0x00, 0x34, /* Java 8 */
+    0x00, 0x07,                   /* six constants */
+    0x07, 0x00, 0x02,             /* 1: class named by 2 */
+    0x01, 0x00, 0x07, 'F', 'o', 'r', 'w', 'a', 'r', 'd',
+    0x0A, 0x00, 0x04, 0x00, 0x05, /* 3: method of class 4, type 5 */
+    0x07, 0x00, 0x02,             /* 4: class named by 2 */
+    0x0C, 0x00, 0x06, 0x00, 0x06, /* 5: name and type both 6 */
+    0x01, 0x00, 0x01, 'm',
+    0x00, 0x21, 0x00, 0x01, 0x00, 0x00, /* public, this 1, no super */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  };
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(cls = (*env)->DefineClass
+               (env, "Forward", NULL, (const jbyte *)forward,
+                sizeof(forward)))) {
+    result = fail(env, "failed to define class with forward references");
+  }
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  jvm = NULL;
+
+  forward[25] = 0x06; /* method of class 6, which is UTF8 */
+  if (EXIT_SUCCESS != result) {
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if ((cls = (*env)->DefineClass
+              (env, "Forward", NULL, (const jbyte *)forward,
+               sizeof(forward)))) {
+    result = fail(env, "defined class with a method of a UTF8 constant");
+  } else (*env)->ExceptionClear(env);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Define a static method whose arguments fill all 255 local slots
+ * and call one with more arguments than fit on the stack buffer.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+arguments(void)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass many = NULL;
+  jmethodID sum_method = NULL;
+  jmethodID wide_method = NULL;
+  char wide_signature[132];
+  jint value;
+  unsigned ii;
+
+  wide_signature[0] = '(';
+  for (ii = 0; ii < 127; ++ii)
+    wide_signature[ii + 1] = 'J';
+  memcpy(wide_signature + 128, "I)I", 4);
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(many = (*env)->DefineClass
+               (env, "Many", NULL, (const jbyte *)many_class,
+                sizeof(many_class)))) {
+    result = fail(env, "failed to define class with 255 argument slots");
+  } else if (!(sum_method = (*env)->GetStaticMethodID
+               (env, many, "sum", "(IIIIIIIIII)I"))) {
+    result = fail(env, "failed to find Many.sum()");
+  } else if (!(wide_method = (*env)->GetStaticMethodID
+               (env, many, "wide", wide_signature))) {
+    result = fail(env, "failed to find Many.wide()");
+  } else if (55 != (value = (*env)->CallStaticIntMethod
+                    (env, many, sum_method, 1, 2, 3, 4, 5,
+                     6, 7, 8, 9, 10))) {
+    result = fail(env, "Many.sum() returned %d, expected 55", value);
+  }
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Send standard error to a temporary file until capture_find().
+ *
+ * @param saved stores a descriptor for the original standard error
+ * @return temporary file or NULL on failure */
+static FILE *
+capture_start(int *saved)
+{
+  FILE *capture = NULL;
+
+  fflush(stderr);
+  if (!(capture = tmpfile())) {
+  } else if ((*saved = dup(STDERR_FILENO)) < 0) {
+    fclose(capture);
+    capture = NULL;
+  } else if (dup2(fileno(capture), STDERR_FILENO) < 0) {
+    close(*saved);
+    fclose(capture);
+    capture = NULL;
+  }
+  return capture;
+}
+
+/**
+ * Restore standard error after capture_start() and search what was
+ * written in the meantime.  The temporary file is closed.
+ *
+ * @param capture temporary file from capture_start()
+ * @param saved descriptor from capture_start()
+ * @param text string to search for
+ * @return non-zero if some line of output contains text */
+static int
+capture_find(FILE *capture, int saved, const char *text)
+{
+  int found = 0;
+  char line[256];
+
+  fflush(stderr);
+  dup2(saved, STDERR_FILENO);
+  close(saved);
+  rewind(capture);
+  while (!found && fgets(line, sizeof(line), capture))
+    found = !!strstr(line, text);
+  fclose(capture);
+  return found;
+}
+
+/**
+ * Call a static method with a null array argument and report whether
+ * it throws NullPointerException.  The exception is cleared.
+ *
+ * @return non-zero if the expected exception was thrown */
+static int
+throws_null(JNIEnv *env, jclass cls, jmethodID method)
+{
+  int result = 0;
+  int saved = -1;
+  FILE *capture = NULL;
+
+  if ((capture = capture_start(&saved))) {
+    (*env)->CallStaticIntMethod(env, cls, method, NULL);
+    result = capture_find(capture, saved,
+                          "java/lang/NullPointerException") &&
+      (*env)->ExceptionCheck(env);
+    (*env)->ExceptionClear(env);
+  }
+  return result;
+}
+
+/**
+ * Run methods containing each sequence of instructions which the
+ * interpreter fuses into a single superinstruction.  A null array
+ * must still throw NullPointerException from arraylength and a branch
+ * into the middle of a fused sequence must run the rest of it.
+ * Exceptions have no objects yet, so the class thrown is found in
+ * what the virtual machine logs.
+ *
+ * @param mode value for WINJ_JIT, so that compiled code can be
+ *        tested as well as the interpreter
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+fused(const char *mode)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass cls = NULL;
+  jmethodID sum, order, scale, middle;
+  jintArray small = NULL, large = NULL;
+  jint value;
+
+  if (setenv("WINJ_JIT", mode, 1)) {
+    result = fail(NULL, "failed to set WINJ_JIT: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(cls = (*env)->DefineClass
+               (env, "Fused", NULL, (const jbyte *)fused_class,
+                sizeof(fused_class)))) {
+    result = fail(env, "failed to define Fused class");
+  } else if (!(sum = (*env)->GetStaticMethodID
+               (env, cls, "sum", "([I)I")) ||
+             !(order = (*env)->GetStaticMethodID
+               (env, cls, "order", "(II)I")) ||
+             !(scale = (*env)->GetStaticMethodID
+               (env, cls, "scale", "(I)I")) ||
+             !(middle = (*env)->GetStaticMethodID
+               (env, cls, "middle", "(I[I)I"))) {
+    result = fail(env, "failed to find Fused methods");
+  } else if (!(small = (*env)->NewIntArray(env, 3)) ||
+             !(large = (*env)->NewIntArray(env, 10000))) {
+    result = fail(env, "failed to create int arrays");
+  } else if (3 != (value = (*env)->CallStaticIntMethod
+                   (env, cls, sum, small))) {
+    result = fail(env, "Fused.sum() of three returned %d", value);
+  } else if (!throws_null(env, cls, sum)) {
+    result = fail(env, "expected NullPointerException from Fused.sum()");
+  } else if (49995000 != (value = (*env)->CallStaticIntMethod
+                          (env, cls, sum, large))) {
+    result = fail(env, "Fused.sum() of 10000 returned %d", value);
+  } else if ((*env)->CallStaticIntMethod(env, cls, order, 1, 2) != -1 ||
+             (*env)->CallStaticIntMethod(env, cls, order, 2, 2) != 0 ||
+             (*env)->CallStaticIntMethod(env, cls, order, 3, 2) != 1) {
+    result = fail(env, "Fused.order() compared incorrectly");
+  } else if (-70 != (value = (*env)->CallStaticIntMethod
+                     (env, cls, scale, -7))) {
+    result = fail(env, "Fused.scale(-7) returned %d", value);
+  } else if ((*env)->CallStaticIntMethod(env, cls, middle, 0, small) ||
+             !(*env)->CallStaticIntMethod(env, cls, middle, 2, small) ||
+             (*env)->CallStaticIntMethod(env, cls, middle, 5, small)) {
+    result = fail(env, "Fused.middle() mishandled a branch into a "
+                  "fused sequence");
+  } else if ((*env)->CallStaticIntMethod(env, cls, middle, 0, NULL),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "expected exception from Fused.middle()");
+  } else (*env)->ExceptionClear(env);
+
+  unsetenv("WINJ_JIT");
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Compute floating point remainders, which truncate the quotient
+ * like C rather than rounding it like IEEE 754.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+remainders(void)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass cls = NULL;
+  jmethodID frem, drem;
+  jdouble value;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(cls = (*env)->DefineClass
+               (env, "Remainder", NULL, (const jbyte *)remainder_class,
+                sizeof(remainder_class)))) {
+    result = fail(env, "failed to define Remainder class");
+  } else if (!(frem = (*env)->GetStaticMethodID
+               (env, cls, "frem", "(DD)D")) ||
+             !(drem = (*env)->GetStaticMethodID
+               (env, cls, "drem", "(DD)D"))) {
+    result = fail(env, "failed to find Remainder methods");
+  } else if (1.5 != (value = (*env)->CallStaticDoubleMethod
+                     (env, cls, frem, 5.5, 2.0))) {
+    result = fail(env, "Remainder.frem(5.5, 2) returned %g", value);
+  } else if (-1.0 != (value = (*env)->CallStaticDoubleMethod
+                      (env, cls, frem, -7.0, 3.0))) {
+    result = fail(env, "Remainder.frem(-7, 3) returned %g", value);
+  } else if (!isnan(value = (*env)->CallStaticDoubleMethod
+                    (env, cls, frem, 1.0, 0.0))) {
+    result = fail(env, "Remainder.frem(1, 0) returned %g", value);
+  } else if (1.5 != (value = (*env)->CallStaticDoubleMethod
+                     (env, cls, drem, 5.5, -2.0))) {
+    result = fail(env, "Remainder.drem(5.5, -2) returned %g", value);
+  } else if (-1.5 != (value = (*env)->CallStaticDoubleMethod
+                      (env, cls, drem, -5.5, 2.0))) {
+    result = fail(env, "Remainder.drem(-5.5, 2) returned %g", value);
+  } else if (3.0 != (value = (*env)->CallStaticDoubleMethod
+                     (env, cls, drem, 3.0, INFINITY))) {
+    result = fail(env, "Remainder.drem(3, Infinity) returned %g", value);
+  } else if (!isnan(value = (*env)->CallStaticDoubleMethod
+                    (env, cls, drem, INFINITY, 1.0))) {
+    result = fail(env, "Remainder.drem(Infinity, 1) returned %g", value);
+  } else if ((*env)->ExceptionCheck(env)) {
+    result = fail(env, "unexpected exception from Remainder");
+  }
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Call class library methods which are implemented in C rather than
+ * byte code.  Integer, Math and Arrays have no class files here so
+ * they exist only because of their intrinsics.  The Check class calls
+ * Integer.parseInt() from byte code.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+intrinsics(void)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass cls = NULL;
+  jclass string_class = NULL;
+  jclass builder_class = NULL;
+  jclass math_class = NULL;
+  jclass integer_class = NULL;
+  jclass system_class = NULL;
+  jclass arrays_class = NULL;
+  jmethodID method;
+  jmethodID append_string, append_int, to_string;
+  jfieldID field;
+  jobjectArray array = NULL;
+  jstring hello = NULL;
+  jstring other = NULL;
+  jobject builder = NULL;
+  const char *utf = NULL;
+  jint expected = 0;
+  unsigned ii;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(string_class = (*env)->FindClass
+               (env, "java/lang/String")) ||
+             !(builder_class = (*env)->FindClass
+               (env, "java/lang/StringBuilder")) ||
+             !(math_class = (*env)->FindClass(env, "java/lang/Math")) ||
+             !(integer_class = (*env)->FindClass
+               (env, "java/lang/Integer")) ||
+             !(system_class = (*env)->FindClass
+               (env, "java/lang/System")) ||
+             !(arrays_class = (*env)->FindClass
+               (env, "java/util/Arrays"))) {
+    result = fail(env, "failed to find class library classes");
+  } else if (!(cls = (*env)->DefineClass
+               (env, "Check", NULL, check_class, sizeof(check_class)))) {
+    result = fail(env, "failed to define Check class");
+  } else if (!(array = (*env)->NewObjectArray
+               (env, 2, string_class, NULL))) {
+    result = fail(env, "failed to create argument array");
+  } else if ((*env)->SetObjectArrayElement
+             (env, array, 0, (*env)->NewStringUTF(env, "-3")),
+             (*env)->SetObjectArrayElement
+             (env, array, 1, (*env)->NewStringUTF(env, "+10")),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "failed to fill argument array");
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, cls, "main", "([Ljava/lang/String;)V"))) {
+    result = fail(env, "failed to find Check.main");
+  } else if ((*env)->CallStaticVoidMethod(env, cls, method, array),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Check.main");
+  } else if (!(field = (*env)->GetStaticFieldID
+               (env, cls, "result", "I"))) {
+    result = fail(env, "failed to find Check.result");
+  } else if ((*env)->GetStaticIntField(env, cls, field) != 3628800) {
+    result = fail(env, "expected 10! but got %d",
+                  (*env)->GetStaticIntField(env, cls, field));
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, math_class, "max", "(II)I")) ||
+             ((*env)->CallStaticIntMethod(env, math_class, method,
+                                          -7, 3) != 3)) {
+    result = fail(env, "Math.max(-7, 3) should be 3");
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, math_class, "abs", "(I)I")) ||
+             ((*env)->CallStaticIntMethod(env, math_class, method,
+                                          INT32_MIN) != INT32_MIN)) {
+    result = fail(env, "Math.abs(MIN_VALUE) should be MIN_VALUE");
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, math_class, "sqrt", "(D)D")) ||
+             ((*env)->CallStaticDoubleMethod(env, math_class, method,
+                                             2.25) != 1.5)) {
+    result = fail(env, "Math.sqrt(2.25) should be 1.5");
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, math_class, "round", "(D)J")) ||
+             ((*env)->CallStaticLongMethod(env, math_class, method,
+                                           -2.5) != -2)) {
+    result = fail(env, "Math.round(-2.5) should be -2");
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, integer_class, "parseInt",
+                "(Ljava/lang/String;I)I")) ||
+             ((*env)->CallStaticIntMethod
+              (env, integer_class, method,
+               (*env)->NewStringUTF(env, "-80000000"), 16) !=
+              INT32_MIN)) {
+    result = fail(env, "Integer.parseInt should handle MIN_VALUE");
+  } else if ((*env)->CallStaticIntMethod
+             (env, integer_class, method,
+              (*env)->NewStringUTF(env, "80000000"), 16),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "Integer.parseInt should reject overflow");
+  } else (*env)->ExceptionClear(env);
+
+  if (EXIT_SUCCESS != result) {
+  } else if (!(hello = (*env)->NewStringUTF(env, "hello, world")) ||
+             !(other = (*env)->NewStringUTF(env, "hello, world"))) {
+    result = fail(env, "failed to create strings");
+  } else if (!(method = (*env)->GetMethodID
+               (env, string_class, "length", "()I")) ||
+             ((*env)->CallIntMethod(env, hello, method) != 12)) {
+    result = fail(env, "String.length() should be 12");
+  } else if (!(method = (*env)->GetMethodID
+               (env, string_class, "charAt", "(I)C")) ||
+             ((*env)->CallCharMethod(env, hello, method, 7) != 'w')) {
+    result = fail(env, "String.charAt(7) should be 'w'");
+  } else if ((*env)->CallCharMethod(env, hello, method, 12),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "String.charAt(12) should throw");
+  } else if ((*env)->ExceptionClear(env),
+             !(method = (*env)->GetMethodID
+               (env, string_class, "equals", "(Ljava/lang/Object;)Z")) ||
+             !(*env)->CallBooleanMethod(env, hello, method, other)) {
+    result = fail(env, "String.equals() should match a copy");
+  } else if (!(method = (*env)->GetMethodID
+               (env, string_class, "indexOf", "(Ljava/lang/String;)I")) ||
+             ((*env)->CallIntMethod
+              (env, hello, method,
+               (*env)->NewStringUTF(env, "world")) != 7)) {
+    result = fail(env, "String.indexOf(\"world\") should be 7");
+  } else if (!(method = (*env)->GetMethodID
+               (env, string_class, "indexOf", "(II)I")) ||
+             ((*env)->CallIntMethod(env, hello, method, 'o', 5) != 8)) {
+    result = fail(env, "String.indexOf('o', 5) should be 8");
+  } else if (!(method = (*env)->GetMethodID
+               (env, string_class, "hashCode", "()I"))) {
+    result = fail(env, "failed to find String.hashCode()");
+  } else {
+    for (ii = 0; ii < 12; ++ii)
+      expected = (jint)(31 * (uint32_t)expected +
+                        (unsigned char)"hello, world"[ii]);
+    for (ii = 0; (EXIT_SUCCESS == result) && (ii < 2); ++ii)
+      if ((*env)->CallIntMethod(env, hello, method) != expected)
+        result = fail(env, "String.hashCode() should be %d", expected);
+  }
+
+  /* Enough appends to grow the builder several times. */
+  if (EXIT_SUCCESS != result) {
+  } else if (!(append_string = (*env)->GetMethodID
+               (env, builder_class, "append",
+                "(Ljava/lang/String;)Ljava/lang/StringBuilder;")) ||
+             !(append_int = (*env)->GetMethodID
+               (env, builder_class, "append",
+                "(I)Ljava/lang/StringBuilder;")) ||
+             !(to_string = (*env)->GetMethodID
+               (env, builder_class, "toString",
+                "()Ljava/lang/String;"))) {
+    result = fail(env, "failed to find StringBuilder methods");
+  } else if (!(builder = (*env)->AllocObject(env, builder_class))) {
+    result = fail(env, "failed to create StringBuilder");
+  } else {
+    for (ii = 0; (EXIT_SUCCESS == result) && (ii < 100); ++ii) {
+      jobject same = (*env)->CallObjectMethod
+        (env, builder, append_string, (ii % 2) ? hello : NULL);
+
+      (*env)->DeleteLocalRef(env, same);
+      same = (*env)->CallObjectMethod
+        (env, builder, append_int, -(jint)ii);
+      (*env)->DeleteLocalRef(env, same);
+      if ((*env)->ExceptionCheck(env))
+        result = fail(env, "exception from StringBuilder.append()");
+    }
+    (*env)->DeleteLocalRef(env, other);
+    if ((EXIT_SUCCESS != result) ||
+        !(other = (*env)->CallObjectMethod(env, builder, to_string)) ||
+        !(utf = (*env)->GetStringUTFChars(env, other, NULL))) {
+      result = fail(env, "failed to convert StringBuilder");
+    } else if ((strlen(utf) != 50 * 4 + 50 * 12 + 10 + 90 * 2 + 99) ||
+               strncmp(utf, "null0hello, world-1null-2", 25) ||
+               strcmp(utf + strlen(utf) - 15, "hello, world-99")) {
+      result = fail(env, "unexpected StringBuilder result: %s", utf);
+    }
+    if (utf)
+      (*env)->ReleaseStringUTFChars(env, other, utf);
+  }
+
+  /* Shifting elements up by one overlaps source and destination. */
+  if (EXIT_SUCCESS != result) {
+  } else if (!(method = (*env)->GetStaticMethodID
+               (env, system_class, "arraycopy",
+                "(Ljava/lang/Object;ILjava/lang/Object;II)V"))) {
+    result = fail(env, "failed to find System.arraycopy");
+  } else if ((*env)->CallStaticVoidMethod
+             (env, system_class, method, array, 0, array, 1, 1),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from System.arraycopy");
+  } else if (!(other = (*env)->GetObjectArrayElement(env, array, 1)) ||
+             !(utf = (*env)->GetStringUTFChars(env, other, NULL)) ||
+             strcmp(utf, "-3")) {
+    result = fail(env, "System.arraycopy should copy \"-3\"");
+  } else if ((*env)->ReleaseStringUTFChars(env, other, utf),
+             (*env)->CallStaticVoidMethod
+             (env, system_class, method, array, 1, array, 0, 2),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "System.arraycopy should check bounds");
+  } else if ((*env)->ExceptionClear(env),
+             !(method = (*env)->GetStaticMethodID
+               (env, arrays_class, "fill",
+                "([Ljava/lang/Object;Ljava/lang/Object;)V"))) {
+    result = fail(env, "failed to find Arrays.fill");
+  } else if ((*env)->CallStaticVoidMethod
+             (env, arrays_class, method, array, builder),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "Arrays.fill should check element type");
+  } else if ((*env)->ExceptionClear(env),
+             (*env)->CallStaticVoidMethod
+             (env, arrays_class, method, array, hello),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Arrays.fill");
+  } else for (ii = 0; (EXIT_SUCCESS == result) && (ii < 2); ++ii) {
+      utf = NULL;
+      if (!(other = (*env)->GetObjectArrayElement(env, array, ii)) ||
+          !(utf = (*env)->GetStringUTFChars(env, other, NULL)) ||
+          strcmp(utf, "hello, world"))
+        result = fail(env, "Arrays.fill should set element %u", ii);
+      if (utf)
+        (*env)->ReleaseStringUTFChars(env, other, utf);
+    }
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Create strings which fit in Latin-1 and strings which need UTF-16
+ * and make sure both behave the same way through JNI and intrinsics.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+strings(void)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass string_class = NULL;
+  jmethodID equals, hash, index;
+  static const jchar smile[] = { 'h', 'i', ' ', 0x263A };
+  static const jchar cafe[] = { 'c', 'a', 'f', 0xE9 };
+  jstring wide = NULL, narrow = NULL, utf = NULL, plain = NULL;
+  const jchar *chars = NULL;
+  const char *text = NULL;
+  uint32_t expected = 0;
+  unsigned ii;
+
+  for (ii = 0; ii < 4; ++ii)
+    expected = 31 * expected + smile[ii];
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(string_class = (*env)->FindClass
+               (env, "java/lang/String")) ||
+             !(equals = (*env)->GetMethodID
+               (env, string_class, "equals", "(Ljava/lang/Object;)Z")) ||
+             !(hash = (*env)->GetMethodID
+               (env, string_class, "hashCode", "()I")) ||
+             !(index = (*env)->GetMethodID
+               (env, string_class, "indexOf", "(Ljava/lang/String;)I"))) {
+    result = fail(env, "failed to find String methods");
+  } else if (!(wide = (*env)->NewString(env, smile, 4)) ||
+             !(narrow = (*env)->NewString(env, cafe, 4)) ||
+             !(utf = (*env)->NewStringUTF(env, "caf\xC3\xA9")) ||
+             !(plain = (*env)->NewStringUTF(env, "hi"))) {
+    result = fail(env, "failed to create strings");
+  } else if (((*env)->GetStringLength(env, wide) != 4) ||
+             ((*env)->GetStringLength(env, utf) != 4)) {
+    result = fail(env, "strings should have four characters");
+  } else if (!(chars = (*env)->GetStringChars(env, wide, NULL)) ||
+             memcmp(chars, smile, sizeof(smile))) {
+    result = fail(env, "GetStringChars should return UTF-16");
+  } else if ((*env)->ReleaseStringChars(env, wide, chars),
+             !(*env)->CallBooleanMethod(env, narrow, equals, utf)) {
+    result = fail(env, "NewString and NewStringUTF should agree");
+  } else if ((*env)->CallBooleanMethod(env, narrow, equals, wide)) {
+    result = fail(env, "different strings should not be equal");
+  } else if ((uint32_t)(*env)->CallIntMethod(env, wide, hash) !=
+             expected) {
+    result = fail(env, "String.hashCode() should be %d", expected);
+  } else if (((*env)->CallIntMethod(env, wide, index, plain) != 0) ||
+             ((*env)->CallIntMethod(env, plain, index, wide) != -1)) {
+    result = fail(env, "String.indexOf() should mix encodings");
+  } else if ((*env)->GetStringUTFLength(env, utf) != 5) {
+    result = fail(env, "modified UTF-8 should need five bytes");
+  } else if (!(text = (*env)->GetStringUTFChars(env, narrow, NULL)) ||
+             strcmp(text, "caf\xC3\xA9")) {
+    result = fail(env, "GetStringUTFChars should encode Latin-1");
+  } else if ((*env)->ReleaseStringUTFChars(env, narrow, text),
+             !(text = (*env)->GetStringUTFChars(env, wide, NULL)) ||
+             strcmp(text, "hi \xE2\x98\xBA")) {
+    result = fail(env, "GetStringUTFChars should encode UTF-16");
+  }
+  if (text)
+    (*env)->ReleaseStringUTFChars(env, wide, text);
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Convert long runs of ASCII broken up by other characters between
+ * modified UTF-8 and strings in both directions.  The first pass uses
+ * only characters which fit in Latin-1 and the second adds a null
+ * character and a surrogate pair, which comes last in the text.
+ *
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+transcode(void)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass string_class = NULL;
+  jmethodID equals;
+  static const struct {
+    const char *utf;
+    unsigned count;
+    jchar units[2];
+  } pieces[] = {
+    { "\xC3\xA9", 1, { 0xE9 } },
+    { "\xE2\x98\xBA", 1, { 0x263A } },
+    { "\xC0\x80", 1, { 0 } },
+    { "\xED\xA0\xBD\xED\xB8\x80", 2, { 0xD83D, 0xDE00 } },
+  };
+  char utf[2048];
+  jchar expected[2048];
+  unsigned pass, ii, jj;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(string_class = (*env)->FindClass
+               (env, "java/lang/String")) ||
+             !(equals = (*env)->GetMethodID
+               (env, string_class, "equals", "(Ljava/lang/Object;)Z")))
+    result = fail(env, "failed to find String methods");
+
+  for (pass = 0; (EXIT_SUCCESS == result) && (pass < 2); ++pass) {
+    jstring decoded = NULL, encoded = NULL;
+    const jchar *chars = NULL;
+    const char *text = NULL;
+    unsigned length = 0;
+    unsigned count = 0;
+
+    for (ii = 0; ii < 24; ++ii) {
+      unsigned piece = pass ? (ii % 4) : 0;
+
+      for (jj = 0; jj < ii % 37 + 3 * ii; ++jj) {
+        utf[length++] = 'a' + jj % 26;
+        expected[count++] = 'a' + jj % 26;
+      }
+      strcpy(utf + length, pieces[piece].utf);
+      length += strlen(pieces[piece].utf);
+      for (jj = 0; jj < pieces[piece].count; ++jj)
+        expected[count++] = pieces[piece].units[jj];
+    }
+    utf[length] = '\0';
+
+    if (!(decoded = (*env)->NewStringUTF(env, utf)) ||
+        !(encoded = (*env)->NewString(env, expected, (jsize)count))) {
+      result = fail(env, "failed to create strings");
+    } else if ((*env)->GetStringLength(env, decoded) != (jsize)count) {
+      result = fail(env, "decoded string should have %u characters",
+                    count);
+    } else if (!(chars = (*env)->GetStringChars(env, decoded, NULL)) ||
+               memcmp(chars, expected, count * sizeof(*chars))) {
+      result = fail(env, "decoded string has wrong characters");
+    } else if (!(*env)->CallBooleanMethod(env, decoded, equals, encoded)) {
+      result = fail(env, "NewString and NewStringUTF should agree");
+    } else if ((*env)->GetStringUTFLength(env, encoded) !=
+               (jsize)length) {
+      result = fail(env, "modified UTF-8 should need %u bytes", length);
+    } else if (!(text = (*env)->GetStringUTFChars(env, encoded, NULL)) ||
+               strcmp(text, utf)) {
+      result = fail(env, "GetStringUTFChars should restore the text");
+    }
+    if (chars)
+      (*env)->ReleaseStringChars(env, decoded, chars);
+    if (text)
+      (*env)->ReleaseStringUTFChars(env, encoded, text);
+  }
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Create and delete many strings through JNI.  Nothing should keep
+ * their characters alive once the local references are gone.
+ *
+ * @param count number of strings of each kind to create
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+string_garbage(unsigned count)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass system_class = NULL;
+  jmethodID gc_method;
+  static const jchar smile[] = { 'h', 'i', ' ', 0x263A };
+  jstring string = NULL;
+  WINJGCStats stats;
+  unsigned ii;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(system_class = (*env)->FindClass
+               (env, "java/lang/System")) ||
+             !(gc_method = (*env)->GetStaticMethodID
+               (env, system_class, "gc", "()V")))
+    result = fail(env, "failed to find System.gc");
+
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < count); ++ii)
+    if (!(string = (*env)->NewStringUTF
+          (env, "a string long enough to fill a good part of a nursery "
+           "if its characters were never collected"))) {
+      result = fail(env, "failed to create string %u", ii);
+    } else {
+      (*env)->DeleteLocalRef(env, string);
+      if (!(string = (*env)->NewString(env, smile, 4)))
+        result = fail(env, "failed to create wide string %u", ii);
+      else (*env)->DeleteLocalRef(env, string);
+    }
+
+  if (EXIT_SUCCESS != result) {
+  } else if ((*env)->CallStaticVoidMethod
+             (env, system_class, gc_method),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from System.gc");
+  } else if (JNI_OK != WINJ_GetGCStats(jvm, &stats)) {
+    result = fail(env, "failed to get collection statistics");
+  } else if (stats.live_bytes > 64 * 1024) {
+    result = fail(env, "expected little to be live but got %ld bytes",
+                  (long)stats.live_bytes);
+  }
+
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Fill, copy, compare and hash primitive arrays using the bulk array
+ * operations chosen by the WINJ_SIMD environment variable.  Lengths
+ * are not multiples of any vector size so partial vectors at the end
+ * are covered too.
+ *
+ * @param mode value for WINJ_SIMD or NULL to use the best available
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+bulk(const char *mode)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  jclass arrays = NULL;
+  jclass system = NULL;
+  jmethodID fill, equals, mismatch, hash, copy;
+  jintArray aa = NULL, bb = NULL, cc = NULL;
+  jarray chars = NULL, doubles = NULL, other = NULL;
+  uint32_t expected = 1;
+  unsigned ii;
+
+  for (ii = 0; ii < 1003; ++ii)
+    expected = 31 * expected + 7;
+
+  if (mode ? setenv("WINJ_SIMD", mode, 1) : unsetenv("WINJ_SIMD")) {
+    result = fail(NULL, "failed to set WINJ_SIMD: %s", strerror(errno));
+  } else if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else if (!(arrays = (*env)->FindClass(env, "java/util/Arrays")) ||
+             !(system = (*env)->FindClass(env, "java/lang/System")) ||
+             !(fill = (*env)->GetStaticMethodID
+               (env, arrays, "fill", "([II)V")) ||
+             !(equals = (*env)->GetStaticMethodID
+               (env, arrays, "equals", "([I[I)Z")) ||
+             !(mismatch = (*env)->GetStaticMethodID
+               (env, arrays, "mismatch", "([I[I)I")) ||
+             !(hash = (*env)->GetStaticMethodID
+               (env, arrays, "hashCode", "([I)I")) ||
+             !(copy = (*env)->GetStaticMethodID
+               (env, system, "arraycopy",
+                "(Ljava/lang/Object;ILjava/lang/Object;II)V"))) {
+    result = fail(env, "failed to find bulk array methods");
+  } else if (!(aa = (*env)->NewIntArray(env, 1003)) ||
+             !(bb = (*env)->NewIntArray(env, 1003)) ||
+             !(cc = (*env)->NewIntArray(env, 10))) {
+    result = fail(env, "failed to create int arrays");
+  } else if ((*env)->CallStaticVoidMethod(env, arrays, fill, aa, 7),
+             (*env)->CallStaticVoidMethod(env, arrays, fill, bb, 7),
+             (*env)->CallStaticVoidMethod(env, arrays, fill, cc, 7),
+             (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Arrays.fill");
+  } else if (!(*env)->CallStaticBooleanMethod
+             (env, arrays, equals, aa, bb)) {
+    result = fail(env, "filled arrays should be equal");
+  } else if ((uint32_t)(*env)->CallStaticIntMethod
+             (env, arrays, hash, aa) != expected) {
+    result = fail(env, "Arrays.hashCode() should be %d", expected);
+  } else if ((*env)->CallStaticIntMethod
+             (env, arrays, mismatch, aa, cc) != 10) {
+    result = fail(env, "a prefix should mismatch at its length");
+  } else if ((*env)->CallStaticVoidMethod(env, arrays, fill, cc, 9),
+             (*env)->CallStaticVoidMethod
+             (env, system, copy, cc, 0, bb, 1001, 1),
+             (*env)->CallStaticIntMethod
+             (env, arrays, mismatch, aa, bb) != 1001) {
+    result = fail(env, "copied element should mismatch at 1001");
+  } else if ((*env)->CallStaticVoidMethod
+             (env, system, copy, bb, 0, bb, 1, 1002),
+             (*env)->CallStaticIntMethod
+             (env, arrays, mismatch, aa, bb) != 1002) {
+    result = fail(env, "overlapping copy should move element up");
+  } else if ((*env)->CallStaticBooleanMethod
+             (env, arrays, equals, aa, bb)) {
+    result = fail(env, "changed arrays should not be equal");
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (!(fill = (*env)->GetStaticMethodID
+               (env, arrays, "fill", "([CC)V")) ||
+             !(hash = (*env)->GetStaticMethodID
+               (env, arrays, "hashCode", "([C)I")) ||
+             !(chars = (*env)->NewCharArray(env, 37))) {
+    result = fail(env, "failed to create char array");
+  } else if ((*env)->CallStaticVoidMethod(env, arrays, fill, chars, 0xFFFF),
+             expected = 1, (*env)->ExceptionCheck(env)) {
+    result = fail(env, "exception from Arrays.fill");
+  } else {
+    for (ii = 0; ii < 37; ++ii)
+      expected = 31 * expected + 0xFFFF;
+    if ((uint32_t)(*env)->CallStaticIntMethod
+        (env, arrays, hash, chars) != expected)
+      result = fail(env, "Arrays.hashCode() for chars should be %d",
+                    expected);
+  }
+
+  /* Every NaN equals every other in Arrays.equals(). */
+  if (EXIT_SUCCESS != result) {
+  } else if (!(fill = (*env)->GetStaticMethodID
+               (env, arrays, "fill", "([DD)V")) ||
+             !(equals = (*env)->GetStaticMethodID
+               (env, arrays, "equals", "([D[D)Z")) ||
+             !(doubles = (*env)->NewDoubleArray(env, 5)) ||
+             !(other = (*env)->NewDoubleArray(env, 5))) {
+    result = fail(env, "failed to create double arrays");
+  } else if ((*env)->CallStaticVoidMethod(env, arrays, fill, doubles, NAN),
+             (*env)->CallStaticVoidMethod(env, arrays, fill, other, -NAN),
+             !(*env)->CallStaticBooleanMethod
+             (env, arrays, equals, doubles, other)) {
+    result = fail(env, "arrays of NaN should be equal");
+  } else if (!(equals = (*env)->GetStaticMethodID
+               (env, arrays, "equals", "([I[I)Z")),
+             (*env)->CallStaticBooleanMethod
+             (env, arrays, equals, aa, doubles),
+             !(*env)->ExceptionCheck(env)) {
+    result = fail(env, "arrays of different types should throw");
+  } else (*env)->ExceptionClear(env);
+
+  unsetenv("WINJ_SIMD");
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+/**
+ * Define many classes by renaming copies of the Loop class, then
+ * make sure each one can be found by name.
+ *
+ * @param count number of classes to define (at most 100000)
+ * @param report print elapsed time when non-zero
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+classes(unsigned count, int report)
+{
+  int result = EXIT_SUCCESS;
+  JavaVM *jvm = NULL;
+  JNIEnv *env = NULL;
+  unsigned char copy[sizeof(loop_class) + 2]; /* Loop -> L00000 */
+  char name[8];
+  clock_t start = clock();
+  unsigned ii, jj;
+
+  if (EXIT_SUCCESS != (result = create(&jvm, &env))) {
+  } else for (ii = 0; (EXIT_SUCCESS == result) && (ii < count); ++ii) {
+      jclass defined;
+
+      /* Every reference to the class uses the same constant so
+       * replacing the name bytes renames it everywhere. */
+      snprintf(name, sizeof(name), "L%05u", ii);
+      memcpy(copy, loop_class, sizeof(loop_class));
+      for (jj = 0; jj + 6 <= sizeof(loop_class); ++jj)
+        if (!memcmp(&copy[jj], "\x00\x04Loop", 6)) {
+          copy[jj + 1] = 6;
+          break;
+        }
+      if (jj + 6 > sizeof(loop_class)) {
+        result = fail(env, "failed to find Loop class name");
+        break;
+      }
+      /* Shift the rest of the class file to make room. */
+      memmove(&copy[jj + 8], &copy[jj + 6],
+              sizeof(loop_class) - jj - 6);
+      memcpy(&copy[jj + 2], name, 6);
+
+      if (!(defined = (*env)->DefineClass
+            (env, name, NULL, (const jbyte *)copy, sizeof(copy))))
+        result = fail(env, "failed to define class %s", name);
+      else (*env)->DeleteLocalRef(env, defined);
+    }
+
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < count); ++ii) {
+    jclass found;
+
+    snprintf(name, sizeof(name), "L%05u", ii);
+    if (!(found = (*env)->FindClass(env, name)))
+      result = fail(env, "failed to find class %s", name);
+    else (*env)->DeleteLocalRef(env, found);
+  }
+
+  if ((EXIT_SUCCESS == result) && report)
+    printf("define and find %u classes: %.3f seconds\n", count,
+           (double)(clock() - start) / CLOCKS_PER_SEC);
+  if (jvm)
+    (*jvm)->DestroyJavaVM(jvm);
+  return result;
+}
+
+int
+main(int argc, char **argv)
+{
+  int result = EXIT_SUCCESS;
+  if (argc < 2) {
+    if (EXIT_SUCCESS != (result = invoke(0, NULL))) {
+    } else if (EXIT_SUCCESS != (result = loop(0))) {
+    } else if (EXIT_SUCCESS != (result = jit(0))) {
+    } else if (EXIT_SUCCESS != (result = animals(0))) {
+    } else if (EXIT_SUCCESS != (result = fields(200000, 0))) {
+    } else if (EXIT_SUCCESS != (result = footprint(NULL, 1000000))) {
+    } else if (EXIT_SUCCESS != (result = footprint("marksweep", 1000000))) {
+#ifdef WINJ_COMPRESSED_REFS
+      /* Hundreds of megabytes must fit in the reserved range. */
+    } else if (EXIT_SUCCESS != (result = footprint(NULL, 12000000))) {
+#endif
+    } else if (EXIT_SUCCESS != (result = shapes(1000, 0))) {
+    } else if (EXIT_SUCCESS != (result = constants())) {
+    } else if (EXIT_SUCCESS != (result = arguments())) {
+    } else if (EXIT_SUCCESS != (result = fused("off"))) {
+    } else if (EXIT_SUCCESS != (result = fused("1"))) {
+    } else if (EXIT_SUCCESS != (result = remainders())) {
+    } else if (EXIT_SUCCESS != (result = intrinsics())) {
+    } else if (EXIT_SUCCESS != (result = strings())) {
+    } else if (EXIT_SUCCESS != (result = transcode())) {
+    } else if (EXIT_SUCCESS != (result = string_garbage(100000))) {
+    } else if (EXIT_SUCCESS != (result = bulk("off"))) {
+    } else if (EXIT_SUCCESS != (result = bulk("sse2"))) {
+    } else if (EXIT_SUCCESS != (result = bulk(NULL))) {
+    } else if (EXIT_SUCCESS != (result = classpath())) {
+    } else if (EXIT_SUCCESS != (result = arrays(2000, 0))) {
+    } else if (EXIT_SUCCESS != (result = garbage
+                                (50000, 0, "marksweep"))) {
+    } else if (EXIT_SUCCESS != (result = garbage
+                                (50000, 0, "generational"))) {
+    } else result = classes(1000, 0);
+  } else if (!strcmp("main", argv[1]))
+    result = invoke(argc - 2, argv + 2);
+  else if (!strcmp("bench", argv[1])) {
+    unsigned repeat = (argc > 2) ? (unsigned)atoi(argv[2]) : 1000;
+
+    if (EXIT_SUCCESS != (result = loop(repeat))) {
+    } else if (EXIT_SUCCESS != (result = jit(repeat))) {
+    } else if (EXIT_SUCCESS != (result = animals(repeat))) {
+    } else if (EXIT_SUCCESS != (result = fields(repeat * 1000, 1))) {
+    } else if (EXIT_SUCCESS != (result = shapes(repeat * 1000, 1))) {
+    } else if (EXIT_SUCCESS != (result = arrays(repeat * 100, 1))) {
+    } else if (EXIT_SUCCESS != (result = garbage
+                                (repeat * 1000, 1, "marksweep"))) {
+    } else if (EXIT_SUCCESS != (result = garbage
+                                (repeat * 1000, 1, "generational"))) {
+    } else result = classes(10000, 1);
+  }
   else result = fail(NULL, "unrecognized task \"%s\"", argv[1]);
   return result;
 }
@@ -33,12 +33,38 @@
  * After that it should be possible to invoke in a browser, after
  * an enormous amount of effort to backfill all the native methods. */
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <math.h>
 #include "ripple/config.h"
 #include "ripple/winj.h"
+#ifdef HAVE_MMAP
+#  include <limits.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+/* Hot methods are compiled to x86-64 machine code where executable
+ * pages can be mapped.  Define WINJ_NO_JIT to interpret everything.
+ * Builds which count opcode pairs always interpret. */
+#if defined(__x86_64__) && defined(HAVE_MMAP) && \
+  !defined(WINJ_NO_JIT) && !defined(WINJ_PAIR_PROFILE)
+#  define WINJ_JIT 1
+#endif
+
+/* Bulk array and text operations use SSE2, which every x86-64 has,
+ * and arrays use AVX2 when the processor supports it at run time.
+ * Define WINJ_NO_SIMD to use plain loops everywhere. */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(WINJ_NO_SIMD)
+#  define WINJ_SIMD 1
+#  include <immintrin.h>
+#endif
 
 typedef uint8_t  u1;
 typedef uint16_t u2;
@@ -49,6 +75,22 @@ const u4 WINJ_MAGIC = 0xcafebabe; /* stay classy, Java */
 const u2 WINJ_VERSION_LEAST = 45; /* smallest acceptable major version */
 const u2 WINJ_VERSION_MAJOR = 69; /* largest acceptable major version */
 const u2 WINJ_VERSION_MINOR = 0;  /* largest acceptable minor version */
+const unsigned WINJ_STACK_SIZE = 512 * 1024; /* default stack bytes */
+const unsigned WINJ_REGION_SIZE = 1024 * 1024; /* bytes in heap region */
+const unsigned WINJ_TLAB_SIZE = 32 * 1024; /* bytes a thread takes */
+const unsigned WINJ_GC_THRESHOLD = 8 * 1024 * 1024; /* least bytes
+                                                      * between collections */
+const unsigned WINJ_FREE_MINIMUM = 1024; /* smallest reused gap */
+const unsigned WINJ_NURSERY_REGIONS = 4; /* regions for young objects */
+const unsigned WINJ_CALL_MISSES = 16; /* inline cache misses allowed
+                                       * before a call site gives up */
+const unsigned WINJ_JIT_THRESHOLD = 1000; /* invocations and loop
+                                           * iterations before a
+                                           * method is compiled */
+
+/* Everything in the heap starts on a multiple of this, which also
+ * leaves room for a filler header in any gap between objects. */
+#define WINJ_HEAP_ALIGN(size) (((size) + 15) & ~(size_t)15)
 
 enum winj_opcode {
   WINJ_OPCODE_NOP             = 0x00,
@@ -258,6 +300,45 @@ enum winj_opcode {
   WINJ_OPCODE_IMPDEP2         = 0xff,
 };
 
+/* Internal opcodes which replace instructions in translated methods
+ * once their constant pool references have been resolved.  These use
+ * values which the specification leaves unassigned. */
+enum winj_quick_opcode {
+  WINJ_OPCODE_GETSTATIC_QUICK    = 0xcb,
+  WINJ_OPCODE_PUTSTATIC_QUICK    = 0xcc,
+  WINJ_OPCODE_INVOKESTATIC_QUICK = 0xcd, /* method has byte code */
+  WINJ_OPCODE_INVOKENATIVE_QUICK = 0xce, /* built in or native method */
+  WINJ_OPCODE_INVOKEVIRTUAL_QUICK = 0xcf, /* index is vtable slot */
+  WINJ_OPCODE_INVOKESPECIAL_QUICK = 0xd0, /* instance method, no lookup */
+  WINJ_OPCODE_NEW_QUICK          = 0xd1,
+  WINJ_OPCODE_GETFIELD_BYTE_QUICK    = 0xd2, /* value is field offset */
+  WINJ_OPCODE_GETFIELD_BOOLEAN_QUICK = 0xd3,
+  WINJ_OPCODE_GETFIELD_CHAR_QUICK    = 0xd4,
+  WINJ_OPCODE_GETFIELD_SHORT_QUICK   = 0xd5,
+  WINJ_OPCODE_GETFIELD_INT_QUICK     = 0xd6, /* int or float */
+  WINJ_OPCODE_GETFIELD_LONG_QUICK    = 0xd7, /* long or double */
+  WINJ_OPCODE_GETFIELD_OBJECT_QUICK  = 0xd8,
+  WINJ_OPCODE_PUTFIELD_BYTE_QUICK    = 0xd9,
+  WINJ_OPCODE_PUTFIELD_BOOLEAN_QUICK = 0xda,
+  WINJ_OPCODE_PUTFIELD_SHORT_QUICK   = 0xdb, /* char or short */
+  WINJ_OPCODE_PUTFIELD_INT_QUICK     = 0xdc, /* int or float */
+  WINJ_OPCODE_PUTFIELD_LONG_QUICK    = 0xdd, /* long or double */
+  WINJ_OPCODE_PUTFIELD_OBJECT_QUICK  = 0xde,
+  WINJ_OPCODE_INVOKECACHED_QUICK    = 0xdf, /* operand is inline cache */
+  WINJ_OPCODE_INVOKEINTERFACE_QUICK = 0xe0, /* megamorphic interface */
+  WINJ_OPCODE_CHECKCAST_QUICK       = 0xe1, /* class is resolved */
+  WINJ_OPCODE_INSTANCEOF_QUICK      = 0xe2,
+  /* superinstructions formed by winj_insns_fuse */
+  WINJ_OPCODE_ILOAD_ILOAD           = 0xe3,
+  WINJ_OPCODE_ILOAD_BIPUSH          = 0xe4,
+  WINJ_OPCODE_ILOAD_ILOAD_IF_ICMPGE = 0xe5,
+  WINJ_OPCODE_ILOAD_ILOAD_IF_ICMPLT = 0xe6,
+  WINJ_OPCODE_ILOAD_ALOAD_ARRAYLENGTH_IF_ICMPGE = 0xe7,
+  WINJ_OPCODE_IINC_GOTO             = 0xe8,
+  WINJ_OPCODE_IADD_ISTORE           = 0xe9,
+  WINJ_OPCODE_QUICK_END          = 0xea, /* first unused value */
+};
+
 /**
  * It's not an accident that some of these have the same value.
  * Duplicate values are applied differently depending on the context.
@@ -333,10 +414,27 @@ struct winj_cpool_version {
   { WINJ_CONST_PACKAGE,            53, 0 },
 };
 
+enum winj_bytes_storage {
+  winj_bytes_allocated = 0, /* released with winj_free */
+  winj_bytes_mapped,        /* read only file mapping */
+  winj_bytes_borrowed,      /* part of something that outlives it */
+};
+
 struct winj_bytes {
   unsigned count;
   unsigned offset;
   unsigned char *value;
+  enum winj_bytes_storage storage;
+};
+
+/* Names the class file or archive which held the bytes of a class,
+ * along with its size and modification time when they were read, so
+ * that a snapshot can tell whether the file has changed since. */
+struct winj_source {
+  char *path; /* NULL unless found on the class path */
+  u4 size;
+  u4 mtime;
+  u4 mtime_ns;
 };
 
 union winj_cpool_info {
@@ -444,9 +542,11 @@ struct winj_class_file {
    * consume two entries each.  To accomodate this, we have an array
    * of pointers (cpool) and an array of two byte index values
    * (cpool_idx).  To access a constant requires looking up the
-   * value of cpool[cpool_idx[index]].  Class definition should
-   * guarantee that all such entries are either zero or a valid
-   * position in the cpool array. */
+   * value of cpool[cpool_idx[index]].  Both arrays share a single
+   * allocation sized from cpool_count.  The last entry of cpool is
+   * never filled since entry zero is unused, so indexes which refer
+   * to no constant (such as the second half of a long) map to it and
+   * find a tag of zero. */
   u2 cpool_size;
   struct winj_cpool *cpool;
   u2 cpool_count;
@@ -469,6 +569,7 @@ struct winj_class_file {
   struct winj_attribute *attributes;
 
   struct winj_bytes bytes;
+  struct winj_source source;
 };
 
 enum winj_type {
@@ -484,43 +585,124 @@ enum winj_type {
   WINJ_TYPE_OBJECT  = 9,
 };
 
+/**
+ * Objects known to native code, which the garbage collector must
+ * keep.  Local frames are marked by NULL entries. */
+struct winj_reflist {
+  unsigned count;
+  unsigned capacity;
+  struct winj_object **refs;
+};
+
+/**
+ * A reference as stored in fields, array elements and stack slots.
+ * Normally this is simply the address of an object.  Building with
+ * WINJ_COMPRESSED_REFS places every heap region and class in a single
+ * reserved range of four gigabytes, so a reference becomes a 32-bit
+ * offset from the start of that range with zero for null.  Use
+ * winj_ref_decode and winj_ref_encode to convert.  References held
+ * by native code are always addresses. */
+#ifdef WINJ_COMPRESSED_REFS
+#  ifndef HAVE_MMAP
+#    error "WINJ_COMPRESSED_REFS requires mmap"
+#  endif
+typedef u4 winj_ref;
+#else
+typedef struct winj_object *winj_ref;
+#endif
+
+/**
+ * A single local variable or operand stack entry.  Slots are wide
+ * enough to hold a reference so that objects never need to be split
+ * across entries.  Category two values (long and double) still use
+ * two consecutive slots as the Java Virtual Machine Specification
+ * requires, so local variable indexes and stack depths from class
+ * files apply unchanged.  Slots are 64 bits wide unless references
+ * are compressed, and then the whole value lives in the first slot
+ * and the second is ignored, so moving one takes a single load and
+ * store.  Narrow slots split it with the high word first.  Use the
+ * winj_slots_* functions rather than depending on either layout. */
+#ifndef WINJ_COMPRESSED_REFS
+#  define WINJ_WIDE_SLOTS 1
+#endif
+
+typedef union winj_slot {
+  u4       u;
+  jint     i;
+  jfloat   f;
+  winj_ref l;
+#ifdef WINJ_WIDE_SLOTS
+  jlong    j;
+  jdouble  d;
+#endif
+} winj_slot;
+
+/**
+ * Each method invocation in progress has a frame.  Frames are carved
+ * out of the stack arena owned by a thread and laid out like this:
+ *
+ *     | locals (max_locals) | frame | operands (max_stack) |
+ *
+ * Arguments are placed at the top of the stack before a frame is
+ * pushed, so they become the first local variables without being
+ * copied.  Popping a frame returns everything above the first local
+ * variable to the arena. */
 struct winj_stack_frame {
   struct winj_class  *winj;
   struct winj_method *method;
+  struct winj_stack_frame *caller;
+  unsigned program_counter; /* index of next translated instruction */
+
+  winj_slot *locals;
+  winj_slot *operands; /* bottom of operand stack */
+  winj_slot *top;      /* next unused operand slot */
+  winj_slot *limit;    /* one past the last operand slot */
 };
 
+#define WINJ_FRAME_SLOTS                                              \
+  ((sizeof(struct winj_stack_frame) + sizeof(winj_slot) - 1) /        \
+   sizeof(winj_slot))
+
 enum winj_thread_flags {
   winj_thread_active    = 1<<0,
   winj_thread_daemon    = 1<<1,
   winj_thread_interrupt = 1<<2,
+  winj_thread_exception = 1<<3, /* thrown and not yet cleared */
 };
 
 /**
  * Represents a single thread of execution.
  *
- * Each thread has one operand stack and one local variable stack. */
+ * Each thread owns one contiguous stack arena which is allocated
+ * when the thread is created.  Frames, local variables and operand
+ * stacks are all carved from it so that calling methods and pushing
+ * operands never allocates.  Exhausting the arena is reported as a
+ * java.lang.StackOverflowError. */
 struct winj_thread {
   struct JNINativeInterface *jni_env; /* must be first */
   struct winj_vm *vm;
   unsigned flags;
-  unsigned program_counter;
 
   unsigned frame_count;
-  struct winj_stack_frame *frames;
+  struct winj_stack_frame *frame; /* innermost frame or NULL */
+
+  winj_slot *stack;       /* base of stack arena */
+  winj_slot *stack_limit; /* one past the end of stack arena */
 
-  unsigned operand_count;
-  u4 *operands;
+  u1 *tlab_top; /* next free byte of thread local allocation buffer */
+  u1 *tlab_end; /* one past the end of allocation buffer */
 
-  unsigned local_count;
-  u4 *locals;
+  struct winj_reflist locals; /* objects held by native code */
 };
 
 struct winj_field {
   unsigned name_len;
-  const char *name;
+  char    *name; /* name followed by descriptor, like methods */
+  u4 name_hash;
   u2 access_flags;
   enum winj_type type;
-  unsigned index;
+  unsigned index;  /* position among static fields */
+  unsigned offset; /* bytes from start of instance to instance field */
 };
 
 struct winj_vm_paras; /* parameters for system customization */
@@ -573,6 +755,8 @@ struct winj_vm_params {
                 const char *func, unsigned level,
                 const char *format, va_list args);
   struct winj_thread_params *thread_params;
+  unsigned stack_size; /* bytes in each thread stack (0 for default) */
+  unsigned class_read; /* non-zero to read class files, not map them */
 
   int (*find_class)(void *context, struct winj_vm_params *params,
                     size_t name_len, const char *name,
@@ -592,6 +776,24 @@ struct winj_argument {
   jvalue value;
 };
 
+/* Class files limit methods to this many argument slots, counting
+ * the receiver of instance methods. */
+#define WINJ_ARGUMENT_SLOTS 255
+
+/* Calls keep the arguments of most methods in a buffer of this many
+ * on the C stack and allocate one only for longer lists, so that
+ * each native to Java re-entry costs little stack. */
+#define WINJ_ARGUMENT_INLINE 8
+
+/* Method descriptor parsed when the method is stored in its class so
+ * that calls need not parse it again.  Arrays count as objects. */
+struct winj_signature {
+  unsigned count;             /* number of arguments */
+  unsigned slots;             /* operand stack slots for arguments */
+  enum winj_type return_type;
+  u1 *types;                  /* enum winj_type of each argument */
+};
+
 /* A method might be implemented in one of three ways:
  * - opcodes from a class file
  * - C code for built in methods of system classes
@@ -603,28 +805,193 @@ struct winj_argument {
 struct winj_method {
   unsigned name_len;
   char    *name;
+  u4 name_hash;
   u2 access_flags;
+  struct winj_class *cls;  /* class which declares this method */
+  unsigned vtable_index;   /* only meaningful for virtual methods */
 
   int (*call)(struct winj_thread *thread, struct winj_method *method,
               jvalue *result, jobject self, unsigned arg_count,
               struct winj_argument *args);
+  struct winj_signature signature;
   struct winj_method_file *method_file;
+  struct winj_insn *insns; /* translated when first executed */
+#ifdef WINJ_JIT
+  unsigned hotness; /* invocations and backward branches so far */
+  struct winj_jit_code *jit; /* compiled once hot enough */
+#endif
 };
 
-struct winj_objlist {
-  struct winj_object *head;
-  struct winj_object *tail;
-  unsigned count;
+/**
+ * Internal form of a byte code instruction.  Methods are translated
+ * to arrays of these so that operands are decoded only once.  Those
+ * which refer to the constant pool are quickened after resolution so
+ * that later executions use the resolved member directly. */
+struct winj_insn {
+  const void *handler; /* address of handler for threaded dispatch */
+  u1 opcode;           /* byte code or internal opcode */
+  u2 index;            /* local variable or constant pool index */
+  jint value;          /* immediate, increment, type or slot count */
+  union winj_insn_operand {
+    struct winj_insn *target; /* branch destination */
+    const jint *table;        /* switch table */
+    jlong j;
+    jdouble d;
+    jvalue *value;            /* static field storage */
+    struct winj_method *method;
+    struct winj_call_cache *cache;
+  } operand;
+  struct winj_class *cls; /* class of resolved method */
+};
+
+/* Receiver classes remembered by each call site. */
+#define WINJ_CALL_CACHE_SIZE 4
+
+/**
+ * Inline cache for a call site which selects a method by the class
+ * of its receiver.  Translation sets one aside for every
+ * invokevirtual and invokeinterface instruction.  Each entry pairs a
+ * receiver class with the method selected for it, so calls with a
+ * receiver seen before skip method selection entirely.  The first
+ * entry is checked by the interpreter itself.  Once every entry is
+ * used, entries after the first are replaced in turn.  A site which
+ * keeps missing is megamorphic, and selects a method for every call
+ * without caching. */
+struct winj_call_cache {
+  struct winj_method *method; /* named by the call site */
+  unsigned count;             /* entries in use */
+  unsigned misses;            /* since every entry was used */
+  struct winj_call_entry {
+    struct winj_class *cls;
+    struct winj_method *method;
+  } entries[WINJ_CALL_CACHE_SIZE];
+};
+
+#ifdef WINJ_JIT
+/**
+ * Machine code compiled from the instructions of a hot method.  Code
+ * can be entered at the start of the method or at the destination of
+ * any branch, and leaves at the first instruction it does not handle
+ * so that the interpreter continues from there.  The operand stack
+ * stays in the frame, so nothing needs translating either way. */
+struct winj_jit_code {
+  u1 *code;    /* executable pages, starting with the entry sequence */
+  size_t size; /* bytes mapped */
+  u4 *entries; /* code offset for each instruction or zero if none */
 };
 
+/**
+ * State passed between the interpreter and compiled code.  Compiled
+ * code updates the top of the stack and the index of the instruction
+ * at which the interpreter should continue. */
+struct winj_jit_frame {
+  winj_slot *locals;
+  winj_slot *sp;
+  u1 *base;    /* start of reserved range for compressed references */
+  unsigned pc; /* instruction index */
+};
+
+struct winj_jit {
+  unsigned threshold; /* hotness at which to compile or zero to never */
+  jlong compiled;     /* methods compiled so far */
+  jlong code_bytes;   /* bytes of machine code generated */
+  jlong entries;      /* times compiled code was entered */
+};
+#endif
+
+/**
+ * Header of every object in the heap.  Objects are never allocated
+ * individually, so anything an object needs (such as array elements)
+ * follows its header in the same block.  Gaps left in a region when
+ * a thread gives up its allocation buffer hold a filler object with
+ * no class so that regions can be walked from one object to the
+ * next using sizes alone.  Objects outside the heap, such as the one
+ * at the start of each class, have a size of zero. */
 struct winj_object {
-  struct winj_class *cls;
-  unsigned value_count;
-  jvalue  *values;
+  struct winj_class *cls; /* NULL for filler */
+  unsigned size;          /* bytes including header, plus flags */
+};
+
+/* Sizes are multiples of 16, which leaves the low bits for flags. */
+#define WINJ_OBJECT_MARKED     1u /* reached during a full collection */
+#define WINJ_OBJECT_FORWARDED  2u /* copied, with cls holding the copy */
+#define WINJ_OBJECT_OLD        4u /* outside the nursery */
+#define WINJ_OBJECT_REMEMBERED 8u /* in the remembered set */
+#define WINJ_OBJECT_FLAGS     15u
+
+/**
+ * Filler big enough to reuse, kept on a list in address order. */
+struct winj_free_chunk {
+  struct winj_object self; /* must be first */
+  struct winj_free_chunk *next;
+};
+
+/**
+ * Part of the old generation filled by a minor collection, which
+ * scans it for references to young objects that still need copying. */
+struct winj_gc_span {
+  u1 *begin;
+  u1 *end;
+};
+
+struct winj_gc {
+  int generational; /* objects start in the nursery */
+  unsigned born;    /* flags of objects allocated in buffers */
+  size_t allocated; /* old bytes given out since last full collection */
+  size_t threshold; /* old bytes to give out before next one */
+  jlong collections;
+  jlong pause_total;
+  jlong pause_last;
+  jlong pause_max;
+  jlong live_bytes;
+  jlong freed_bytes;
+  jlong minor_collections;
+  jlong minor_pause_total;
+  jlong minor_pause_max;
+  jlong promoted_bytes;
+
+  unsigned mark_count;
+  unsigned mark_capacity;
+  struct winj_object **marks; /* marked objects not yet traced */
+
+  u1 *promote_top; /* next free byte for objects leaving the nursery */
+  u1 *promote_end;
+  unsigned span_count;
+  unsigned span_capacity;
+  struct winj_gc_span *spans; /* last one ends at promote_top */
+};
+
+/**
+ * A large block from which threads take allocation buffers.  Storage
+ * begins after the header and is zero until it is first used. */
+struct winj_region {
+  struct winj_region *next;
+  size_t size; /* bytes of storage */
+  size_t used; /* bytes of storage given out */
+};
+
+#ifdef WINJ_COMPRESSED_REFS
+/* Bytes reserved for everything a compressed reference can reach. */
+#define WINJ_SPACE_SIZE ((size_t)1 << 32)
+
+/**
+ * Block given back to the reserved range, kept for reuse. */
+struct winj_space_block {
+  size_t size;
+  struct winj_space_block *next;
+};
 
-  struct winj_object *next;
-  struct winj_object *prev;
+/**
+ * Range of addresses reserved up front when references are
+ * compressed.  Heap regions and classes are carved from it in order,
+ * and blocks given back are reused first fit before the range grows.
+ * Nothing is committed until it is touched. */
+struct winj_space {
+  u1 *base;    /* start of range or NULL until first needed */
+  size_t used; /* bytes carved from the start of range */
+  struct winj_space_block *free;
 };
+#endif
 
 struct winj_array {
   struct winj_object self; /* must be first */
@@ -632,7 +999,7 @@ struct winj_array {
   enum winj_type type;
   struct winj_class *element_class;
   union winj_elements {
-    struct winj_object *jobject;
+    winj_ref *jobject;
     jbyte    *jbyte;
     jboolean *jboolean;
     jchar    *jchar;
@@ -641,32 +1008,131 @@ struct winj_array {
     jfloat   *jfloat;
     jlong    *jlong;
     jdouble  *jdouble;
-  } *elements;
+  } elements; /* inline after the array header */
+};
+
+enum winj_class_flags {
+  winj_class_initialized = 1<<0, /* static initializer has started */
 };
 
+/* Each class lists its ancestors by depth so that checking whether
+ * one class extends another needs only one comparison.  Interfaces
+ * and classes too deep for the display are kept in a short list of
+ * secondary supers instead, with the last one matched cached. */
+#define WINJ_DISPLAY_SIZE 8
+
 struct winj_class {
   struct winj_object self; /* must be first */
   struct winj_class *super;
+  unsigned flags;
+
+  unsigned depth; /* index in display or WINJ_DISPLAY_SIZE if none */
+  struct winj_class *display[WINJ_DISPLAY_SIZE];
+  unsigned secondary_count;
+  struct winj_class **secondaries; /* interfaces and deep ancestors */
+  struct winj_class *secondary_cache;
 
   char *name;
   unsigned name_len;
+  u4 name_hash; /* cached for the class table of the vm */
   u2 access_flags;
 
   unsigned field_count;
-  struct winj_field *fields;
+  unsigned field_capacity;
+  struct winj_field *fields; /* instance fields declared here */
+  unsigned instance_size;    /* bytes of header and all fields */
+  unsigned reference_count;
+  unsigned *references; /* offsets of reference fields, inherited too */
 
   unsigned method_count;
+  unsigned method_capacity;
   struct winj_method *methods;
+  unsigned vtable_count;
+  struct winj_method **vtable; /* virtual methods including inherited */
 
   unsigned static_field_count;
+  unsigned static_field_capacity;
   struct winj_field *static_fields;
+  jvalue *static_values; /* indexed by static field index */
 
   unsigned static_method_count;
+  unsigned static_method_capacity;
   struct winj_method *static_methods;
 
   struct winj_class_file *class_file;
 };
 
+/* Remembers where a file was found on the class path so that later
+ * requests go straight to the right entry.  Files missing from every
+ * entry are remembered too, which saves repeating a failed open for
+ * each entry whenever the same name is requested again. */
+#define WINJ_CLASSPATH_MISSING ((unsigned)-1)
+
+struct winj_classpath_lookup {
+  unsigned name_len;
+  char *name;       /* relative path of file */
+  u4 name_hash;
+  unsigned segment; /* index of entry or WINJ_CLASSPATH_MISSING */
+};
+
+struct winj_classpath {
+  char *path; /* value for which lookups are valid */
+
+  unsigned lookup_count;
+  unsigned lookup_capacity;
+  struct winj_classpath_lookup *lookups;
+};
+
+#define WINJ_SNAPSHOT_MAGIC  "WINJCDS2"
+#define WINJ_SNAPSHOT_HEADER 32
+#define WINJ_SNAPSHOT_ENTRY  40
+
+enum winj_snapshot_state {
+  winj_snapshot_unopened = 0,
+  winj_snapshot_loaded,    /* classes are defined from bytes */
+  winj_snapshot_recording, /* classes are written when destroyed */
+  winj_snapshot_disabled,
+};
+
+struct winj_snapshot {
+  enum winj_snapshot_state state;
+  unsigned stale; /* a loaded snapshot must be recorded again */
+  char *path;
+  struct winj_bytes bytes;
+};
+
+/* Strings keep their characters in a byte array as the Java class
+ * library does.  When every character fits in Latin-1 there is one
+ * byte for each; otherwise the bytes hold UTF-16 code units and the
+ * coder field says so.  Strings are made compact whenever possible,
+ * so two strings with different coders are never equal. */
+enum winj_coder {
+  WINJ_CODER_LATIN1 = 0,
+  WINJ_CODER_UTF16  = 1, /* also shift from characters to bytes */
+};
+
+/* Intrinsics reach into built in classes through the offsets of a
+ * few of their fields, which are found when the vm is created. */
+struct winj_offsets {
+  unsigned string_value;  /* byte[] holding String characters */
+  unsigned string_hash;   /* int caching String.hashCode() */
+  unsigned builder_value; /* char[] holding StringBuilder characters */
+  unsigned builder_count; /* int counting characters in use */
+  unsigned string_coder;  /* byte saying how String characters are kept */
+};
+
+#define WINJ_OFFSET(object, offset, type)                              \
+  (*(type *)((u1 *)(object) + (offset)))
+
+/* Bulk operations on array elements.  The best versions the
+ * processor supports are chosen when the vm is created. */
+struct winj_kernels {
+  void (*fill)(u1 *dst, size_t size, unsigned width, const void *value);
+  size_t (*mismatch)(const u1 *aa, const u1 *bb, size_t size);
+  u4 (*hash)(u4 hash, enum winj_type type, size_t count,
+             const void *elements);
+};
+
 struct winj_vm {
   struct JNIInvokeInterface *jni_invoke; /* must be first */
   struct JNIInvokeInterface table_invoke;
@@ -676,16 +1142,77 @@ struct winj_vm {
 
   struct winj_class *class_class;
   struct winj_class *class_array;
+  struct winj_class *class_string;
+  struct winj_class *class_builder;
+  struct winj_offsets offsets; /* of fields used by intrinsics */
+  struct winj_kernels kernels; /* bulk array operations */
 
   u4 class_count;
-  struct winj_class **classes;
-
-  struct winj_objlist objects;
+  u4 class_capacity; /* zero or a power of two */
+  struct winj_class **classes; /* open addressing by name hash */
+
+  struct winj_region *regions; /* region being carved up first */
+  struct winj_free_chunk *free_chunks;
+  struct winj_region *nursery; /* regions holding young objects */
+  struct winj_region *nursery_fill; /* next to give out buffers */
+  unsigned nursery_count;
+  struct winj_gc gc;
+  struct winj_reflist globals;
+  struct winj_reflist remembered; /* old objects with young referents */
+#ifdef WINJ_COMPRESSED_REFS
+  struct winj_space space; /* holds regions and classes */
+#endif
 
   u4 thread_count;
   struct winj_thread **threads;
+
+  unsigned archive_count;
+  struct winj_archive **archives; /* opened as class path needs them */
+  struct winj_classpath classpath;
+  struct winj_snapshot snapshot;
+#ifdef WINJ_JIT
+  struct winj_jit jit;
+#endif
+#ifdef WINJ_PAIR_PROFILE
+  u8 *pairs; /* times each opcode ran after each other, 256 by 256 */
+#endif
 };
 
+/**
+ * Find the object to which a stored reference refers.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param ref reference as stored in a field, element or slot
+ * @return object or NULL */
+static inline struct winj_object *
+winj_ref_decode(const struct winj_vm *vm, winj_ref ref)
+{
+#ifdef WINJ_COMPRESSED_REFS
+  return ref ? (struct winj_object *)(vm->space.base + ref) : NULL;
+#else
+  (void)vm;
+  return ref;
+#endif
+}
+
+/**
+ * Convert the address of an object into the form in which references
+ * are stored.  This reverses winj_ref_decode.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param object object to refer to or NULL
+ * @return stored form of reference */
+static inline winj_ref
+winj_ref_encode(const struct winj_vm *vm, struct winj_object *object)
+{
+#ifdef WINJ_COMPRESSED_REFS
+  return object ? (winj_ref)((u1 *)object - vm->space.base) : 0;
+#else
+  (void)vm;
+  return object;
+#endif
+}
+
 /**
  * Reallocate a block of memory.
  *
@@ -870,46 +1397,6 @@ winj_string_copy
     (params, aa_len, aa, 0, NULL, str_len, str_out);
 }
 
-static struct winj_object *
-winj_objlist_append
-(struct winj_objlist *list, struct winj_object *obj)
-{
-  if (!list) {
-  } else if (list->tail) {
-    obj->prev = list->tail;
-    obj->next = NULL;
-    list->tail = list->tail->next = obj;
-    list->count++;
-  } else {
-    obj->next = obj->prev = NULL;
-    list->head = list->tail = obj;
-  }
-  return obj;
-}
-
-static struct winj_object *
-winj_objlist_remove
-(struct winj_objlist *list, struct winj_object *obj)
-{
-  if (!list || !obj) {
-  } else {
-    if (list->head == obj) {
-      list->head = obj->next;
-      if (list->head)
-        list->head->prev = NULL;
-    }
-    if (list->tail == obj) {
-      list->tail = obj->prev;
-      if (list->tail)
-        list->tail->next = NULL;
-    }
-    list->count--;
-  }
-  if (obj)
-    obj->next = obj->prev = NULL;
-  return obj;
-}
-
 /**
  * Copy a collection of bytes
  *
@@ -937,12 +1424,120 @@ winj_bytes_copy
     dest->value = buffer;
     dest->count = src->count - src->offset;
     dest->offset = 0;
+    dest->storage = winj_bytes_allocated;
     buffer = NULL;
   }
   winj_free(params, buffer);
   return result;
 }
 
+/**
+ * Release the storage behind a collection of bytes, which may have
+ * been allocated or mapped from a file.  Borrowed bytes belong to
+ * something else so they are left alone.
+ *
+ * @param params parameters for system customization
+ * @param bytes collection to release, which is left empty */
+static void
+winj_bytes_cleanup(struct winj_vm_params *params, struct winj_bytes *bytes)
+{
+  if (!bytes) {
+  } else if (bytes->storage == winj_bytes_borrowed) {
+#ifdef HAVE_MMAP
+  } else if (bytes->storage == winj_bytes_mapped) {
+    if (bytes->value && munmap(bytes->value, bytes->count))
+      winj_warn(params, "munmap failed: %s", strerror(errno));
+#endif
+  } else winj_free(params, bytes->value);
+
+  if (bytes) {
+    bytes->value = NULL;
+    bytes->count = bytes->offset = 0;
+    bytes->storage = winj_bytes_allocated;
+  }
+}
+
+/**
+ * Take a zeroed block of memory for something to which references
+ * may refer, which is to say a heap region or a class.  With
+ * compressed references these come from the range reserved for the
+ * virtual machine, which is reserved on first use.
+ *
+ * @param vm virtual machine which needs memory
+ * @param size bytes needed
+ * @return zeroed block or NULL if there is no room */
+static void *
+winj_vm_space_take(struct winj_vm *vm, size_t size)
+{
+#ifdef WINJ_COMPRESSED_REFS
+  struct winj_space *space = &vm->space;
+  struct winj_space_block **link = &space->free;
+  struct winj_space_block *block = NULL;
+  void *result = NULL;
+  void *mapping = NULL;
+
+  size = WINJ_HEAP_ALIGN(size);
+  while ((block = *link) && (block->size < size))
+    link = &block->next;
+
+  if (block) {
+    if (block->size - size >= sizeof(*block)) {
+      struct winj_space_block *rest =
+        (struct winj_space_block *)((u1 *)block + size);
+      rest->size = block->size - size;
+      rest->next = block->next;
+      *link = rest;
+    } else *link = block->next;
+    memset(block, 0, size);
+    result = block;
+  } else if (!space->base && (MAP_FAILED == (mapping = mmap
+                                             (NULL, WINJ_SPACE_SIZE,
+                                              PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS |
+                                              MAP_NORESERVE, -1, 0)))) {
+    winj_error(&vm->params, "failed to reserve %lu bytes: %s",
+               (unsigned long)WINJ_SPACE_SIZE, strerror(errno));
+  } else {
+    if (mapping) { /* nothing lives at offset zero, which means null */
+      space->base = mapping;
+      space->used = WINJ_HEAP_ALIGN(1);
+    }
+    if (size <= WINJ_SPACE_SIZE - space->used) {
+      result = space->base + space->used;
+      space->used += size;
+    } else winj_error(&vm->params, "reserved range exhausted by %lu "
+                      "bytes", (unsigned long)size);
+  }
+  return result;
+#else
+  return winj_calloc(&vm->params, 1, size);
+#endif
+}
+
+/**
+ * Give back a block from winj_vm_space_take.
+ *
+ * @param vm virtual machine which took memory
+ * @param block memory to give back or NULL
+ * @param size bytes requested when block was taken */
+static void
+winj_vm_space_release(struct winj_vm *vm, void *block, size_t size)
+{
+#ifdef WINJ_COMPRESSED_REFS
+  struct winj_space_block *released = block;
+
+  if (released) {
+    size = WINJ_HEAP_ALIGN(size);
+    released->size = size;
+    released->next = vm->space.free;
+    vm->space.free = released;
+  }
+#else
+  (void)size;
+  winj_free(&vm->params, block);
+#endif
+}
+
 /**
  * Copy a single byte from a byte stream, advancing the offset.
  *
@@ -1107,7 +1702,7 @@ winj_utf8_encode
     } else (*position) += 3;
   } else if (codep_in <= 0x10FFFF) {
     if (buffer) {
-      buffer[(*position)++] = 0xE0 | (codep_in >> 16);
+      buffer[(*position)++] = 0xF0 | (codep_in >> 18);
       buffer[(*position)++] = 0x80 | (0x3F & (codep_in >> 12));
       buffer[(*position)++] = 0x80 | (0x3F & (codep_in >>  6));
       buffer[(*position)++] = 0x80 | (0x3F & (codep_in >>  0));
@@ -1180,16 +1775,16 @@ winj_utf8_decode
     winj_warn(params, "UTF-8 invalid code point (index=%u)", index);
   } else if ((src[index] & 0xF8) == 0xF0) { /* 11110xxx */
     codep = 0x07 & src[index++];
-    codep = (codep << 6) | (0xC0 & src[index++]);
-    codep = (codep << 6) | (0xC0 & src[index++]);
-    codep = (codep << 6) | (0xC0 & src[index++]);
+    codep = (codep << 6) | (0x3F & src[index++]);
+    codep = (codep << 6) | (0x3F & src[index++]);
+    codep = (codep << 6) | (0x3F & src[index++]);
   } else if ((src[index] & 0xF0) == 0xE0) { /* 1110xxxx */
     codep = 0x0F & src[index++];
-    codep = (codep << 6) | (0xC0 & src[index++]);
-    codep = (codep << 6) | (0xC0 & src[index++]);
+    codep = (codep << 6) | (0x3F & src[index++]);
+    codep = (codep << 6) | (0x3F & src[index++]);
   } else if ((src[index] & 0xE0) == 0xC0) { /* 110xxxxx */
     codep = 0x1F & src[index++];
-    codep = (codep << 6) | (0xC0 & src[index++]);
+    codep = (codep << 6) | (0x3F & src[index++]);
   } else result = winj_error
            (params, "UTF-8 too many bytes (index=%u)", index);
 
@@ -1265,7 +1860,7 @@ winj_utf8_java_decode
   } else if ((codep >= 0xD800) && (codep <= 0xDFFF)) {
     uint32_t codep_low = 0;
 
-    if (index + 3 >= length) {
+    if (index + 3 > length) {
       result = winj_error
         (params, "missing low surrogate (index=%u)", index);
     } else if (EXIT_SUCCESS !=
@@ -1288,6 +1883,313 @@ winj_utf8_java_decode
   return result;
 }
 
+/* Text is mostly ASCII, which modified UTF-8, Latin-1 and UTF-16
+ * encode the same way apart from width.  The transcoders below move
+ * runs of it sixteen bytes at a time and decode or encode one code
+ * point at a time only for whatever else turns up.  SSE2 is enough
+ * for this and every x86-64 processor has it. */
+
+/**
+ * Count the bytes at the start of some text which are ASCII other
+ * than NUL.  Modified UTF-8 and Latin-1 encode these identically.
+ *
+ * @param size number of bytes
+ * @param bytes text to check
+ * @return number of leading ASCII bytes */
+static size_t
+winj_ascii_length(size_t size, const u1 *bytes)
+{
+  size_t ii = 0;
+#ifdef WINJ_SIMD
+  const __m128i zero = _mm_setzero_si128();
+  unsigned mask = 0;
+
+  for (; !mask && (ii + 16 <= size); ii += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(bytes + ii));
+    mask = (unsigned)_mm_movemask_epi8
+      (_mm_or_si128(block, _mm_cmpeq_epi8(block, zero)));
+  }
+  if (mask) /* stop where the vector found something */
+    size = ii = ii - 16 + __builtin_ctz(mask);
+#endif
+  while ((ii < size) && bytes[ii] && !(bytes[ii] & 0x80))
+    ++ii;
+  return ii;
+}
+
+/**
+ * Count the UTF-16 code units at the start of some text which are
+ * ASCII other than NUL.
+ *
+ * @param count number of code units
+ * @param chars text to check
+ * @return number of leading ASCII code units */
+static size_t
+winj_ascii_units(size_t count, const jchar *chars)
+{
+  size_t ii = 0;
+#ifdef WINJ_SIMD
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i high = _mm_set1_epi16((short)0xFF80);
+  unsigned mask = 0xFFFF;
+
+  for (; (mask == 0xFFFF) && (ii + 8 <= count); ii += 8) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(chars + ii));
+    mask = (unsigned)_mm_movemask_epi8
+      (_mm_andnot_si128(_mm_cmpeq_epi16(block, zero), _mm_cmpeq_epi16
+                        (_mm_and_si128(block, high), zero)));
+  }
+  if (mask != 0xFFFF)
+    count = ii = ii - 8 + __builtin_ctz(~mask) / 2;
+#endif
+  while ((ii < count) && chars[ii] && (chars[ii] < 0x80))
+    ++ii;
+  return ii;
+}
+
+/**
+ * Count the UTF-16 code units at the start of some text which fit
+ * in Latin-1.
+ *
+ * @param count number of code units
+ * @param chars text to check
+ * @return number of leading Latin-1 code units */
+static size_t
+winj_latin1_units(size_t count, const jchar *chars)
+{
+  size_t ii = 0;
+#ifdef WINJ_SIMD
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i high = _mm_set1_epi16((short)0xFF00);
+  unsigned mask = 0xFFFF;
+
+  for (; (mask == 0xFFFF) && (ii + 8 <= count); ii += 8)
+    mask = (unsigned)_mm_movemask_epi8
+      (_mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128
+                                     ((const __m128i *)(chars + ii)),
+                                     high), zero));
+  if (mask != 0xFFFF)
+    count = ii = ii - 8 + __builtin_ctz(~mask) / 2;
+#endif
+  while ((ii < count) && (chars[ii] <= 0xFF))
+    ++ii;
+  return ii;
+}
+
+/**
+ * Widen Latin-1 characters into UTF-16 code units.
+ *
+ * @param count number of characters
+ * @param bytes characters to widen
+ * @param chars destination for code units */
+static void
+winj_bytes_widen(size_t count, const u1 *bytes, jchar *chars)
+{
+  size_t ii = 0;
+#ifdef WINJ_SIMD
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; ii + 16 <= count; ii += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(bytes + ii));
+    _mm_storeu_si128((__m128i *)(chars + ii),
+                     _mm_unpacklo_epi8(block, zero));
+    _mm_storeu_si128((__m128i *)(chars + ii + 8),
+                     _mm_unpackhi_epi8(block, zero));
+  }
+#endif
+  for (; ii < count; ++ii)
+    chars[ii] = bytes[ii];
+}
+
+/**
+ * Narrow UTF-16 code units which all fit in Latin-1 into bytes.
+ *
+ * @param count number of code units
+ * @param chars code units to narrow
+ * @param bytes destination for characters */
+static void
+winj_chars_narrow(size_t count, const jchar *chars, u1 *bytes)
+{
+  size_t ii = 0;
+#ifdef WINJ_SIMD
+  for (; ii + 16 <= count; ii += 16)
+    _mm_storeu_si128((__m128i *)(bytes + ii), _mm_packus_epi16
+                     (_mm_loadu_si128((const __m128i *)(chars + ii)),
+                      _mm_loadu_si128((const __m128i *)(chars + ii + 8))));
+#endif
+  for (; ii < count; ++ii)
+    bytes[ii] = (u1)chars[ii];
+}
+
+/**
+ * Check some modified UTF-8, as used by class files and JNI, and
+ * find how many UTF-16 code units it holds.  Characters outside the
+ * Basic Multilingual Plane count as two for their surrogate pair.
+ *
+ * @param params paramters for system customization
+ * @param length number of bytes to check
+ * @param src bytes from which to decode
+ * @param count_out destination for number of code units
+ * @param coder_out destination for narrowest encoding which can
+ *        hold every character
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_utf8_java_count
+(struct winj_vm_params *params, unsigned length, const u1 *src,
+ unsigned *count_out, enum winj_coder *coder_out)
+{
+  int result = EXIT_SUCCESS;
+  enum winj_coder coder = WINJ_CODER_LATIN1;
+  unsigned position = 0;
+  unsigned count = 0;
+  uint32_t codep = 0;
+
+  while ((EXIT_SUCCESS == result) && (position < length)) {
+    unsigned run = (unsigned)winj_ascii_length
+      (length - position, src + position);
+
+    position += run;
+    count    += run;
+    if (position >= length) {
+    } else if (EXIT_SUCCESS == (result = winj_utf8_java_decode
+                                (params, length, src, &position,
+                                 &codep))) {
+      count += (codep >= 0x10000) ? 2 : 1;
+      if (codep > 0xFF)
+        coder = WINJ_CODER_UTF16;
+    }
+  }
+
+  if (EXIT_SUCCESS == result) {
+    *count_out = count;
+    *coder_out = coder;
+  }
+  return result;
+}
+
+/**
+ * Convert modified UTF-8 into the characters of a string.  Use
+ * winj_utf8_java_count first to check the text and choose an
+ * encoding which can hold all of it.
+ *
+ * @param params paramters for system customization
+ * @param length number of bytes to convert
+ * @param src bytes from which to decode
+ * @param coder encoding in which to store characters
+ * @param bytes destination for characters
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_utf8_java_chars
+(struct winj_vm_params *params, unsigned length, const u1 *src,
+ enum winj_coder coder, u1 *bytes)
+{
+  int result = EXIT_SUCCESS;
+  jchar *chars = (jchar *)bytes;
+  unsigned position = 0;
+  unsigned count = 0;
+  uint32_t codep = 0;
+
+  while ((EXIT_SUCCESS == result) && (position < length)) {
+    unsigned run = (unsigned)winj_ascii_length
+      (length - position, src + position);
+
+    if (coder)
+      winj_bytes_widen(run, src + position, chars + count);
+    else memcpy(bytes + count, src + position, run);
+    position += run;
+    count    += run;
+    if (position >= length) {
+    } else if (EXIT_SUCCESS != (result = winj_utf8_java_decode
+                                (params, length, src, &position,
+                                 &codep))) {
+    } else if (!coder && (codep > 0xFF)) {
+      result = winj_error
+        (params, "character %04x is not Latin-1", codep);
+    } else if (!coder) {
+      bytes[count++] = (u1)codep;
+    } else if (codep >= 0x10000) {
+      chars[count++] = 0xD800 | (0x3FF & ((codep - 0x10000) >> 10));
+      chars[count++] = 0xDC00 | (0x3FF & (codep - 0x10000));
+    } else chars[count++] = (jchar)codep;
+  }
+  return result;
+}
+
+/**
+ * Convert UTF-16 code units into modified UTF-8, which encodes null
+ * characters with two bytes and each half of a surrogate pair on its
+ * own.  No terminator is written.
+ *
+ * @param count number of code units
+ * @param chars code units to convert
+ * @param buffer optional destination for encoded bytes
+ * @return number of bytes in encoded form */
+static unsigned
+winj_utf8_java_bytes(unsigned count, const jchar *chars, char *buffer)
+{
+  unsigned result = 0;
+  unsigned ii = 0;
+
+  while (ii < count) {
+    unsigned run = (unsigned)winj_ascii_units(count - ii, chars + ii);
+    jchar unit;
+
+    if (buffer)
+      winj_chars_narrow(run, chars + ii, (u1 *)buffer + result);
+    ii     += run;
+    result += run;
+    if (ii >= count) {
+    } else if ((unit = chars[ii++]) < 0x800) {
+      if (buffer) {
+        buffer[result]     = (char)(0xC0 | (unit >> 6));
+        buffer[result + 1] = (char)(0x80 | (0x3F & unit));
+      }
+      result += 2;
+    } else {
+      if (buffer) {
+        buffer[result]     = (char)(0xE0 | (unit >> 12));
+        buffer[result + 1] = (char)(0x80 | (0x3F & (unit >> 6)));
+        buffer[result + 2] = (char)(0x80 | (0x3F & unit));
+      }
+      result += 3;
+    }
+  }
+  return result;
+}
+
+/**
+ * Convert Latin-1 characters into modified UTF-8.  No terminator is
+ * written.
+ *
+ * @param count number of characters
+ * @param bytes characters to convert
+ * @param buffer optional destination for encoded bytes
+ * @return number of bytes in encoded form */
+static unsigned
+winj_utf8_latin1_bytes(unsigned count, const u1 *bytes, char *buffer)
+{
+  unsigned result = 0;
+  unsigned ii = 0;
+
+  while (ii < count) {
+    unsigned run = (unsigned)winj_ascii_length(count - ii, bytes + ii);
+
+    if (buffer)
+      memcpy(buffer + result, bytes + ii, run);
+    ii     += run;
+    result += run;
+    if (ii < count) {
+      if (buffer) {
+        buffer[result]     = (char)(0xC0 | (bytes[ii] >> 6));
+        buffer[result + 1] = (char)(0x80 | (0x3F & bytes[ii]));
+      }
+      result += 2;
+      ++ii;
+    }
+  }
+  return result;
+}
+
 const char *
 winj_strnchr(const char *str, int cc, unsigned size)
 {
@@ -1344,8 +2246,7 @@ winj_class_file_cleanup
   if (class_file) {
     unsigned ii;
 
-    winj_free(params, class_file->cpool_idx);
-    winj_free(params, class_file->cpool);
+    winj_free(params, class_file->cpool); /* includes cpool_idx */
     winj_free(params, class_file->ifaces);
 
     for (ii = 0; ii < class_file->fields_count; ++ii)
@@ -1362,39 +2263,109 @@ winj_class_file_cleanup
     winj_free(params, class_file->methods);
 
     winj_free(params, class_file->attributes);
-    winj_free(params, class_file->bytes.value);
+    winj_bytes_cleanup(params, &class_file->bytes);
+    winj_free(params, class_file->source.path);
+  }
+}
+
+#ifdef WINJ_JIT
+/**
+ * Unmap the machine code compiled for a method.
+ *
+ * @param params parameters for system customization
+ * @param jit compiled code or NULL */
+static void
+winj_jit_code_cleanup(struct winj_vm_params *params,
+                      struct winj_jit_code *jit)
+{
+  if (jit) {
+    if (jit->code && munmap(jit->code, jit->size))
+      winj_warn(params, "munmap failed: %s", strerror(errno));
+    winj_free(params, jit);
   }
 }
+#endif
 
 /**
  * Reclaim resources used by a class.
  *
- * @param params paramaters for system customization
+ * @param vm virtual machine from which class memory was taken
  * @param cls class to reclaim */
 void
-winj_class_cleanup
-(struct winj_vm_params *params, struct winj_class *cls)
+winj_class_cleanup(struct winj_vm *vm, struct winj_class *cls)
 {
+  struct winj_vm_params *params = vm ? &vm->params : NULL;
+
   if (cls) {
     unsigned ii;
 
-    for (ii = 0; ii < cls->method_count; ++ii)
+    for (ii = 0; ii < cls->method_capacity; ++ii) {
       winj_free(params, cls->methods[ii].name);
+      winj_free(params, cls->methods[ii].insns);
+      winj_free(params, cls->methods[ii].signature.types);
+#ifdef WINJ_JIT
+      winj_jit_code_cleanup(params, cls->methods[ii].jit);
+#endif
+    }
     winj_free(params, cls->methods);
-    for (ii = 0; ii < cls->static_method_count; ++ii)
+    winj_free(params, cls->vtable);
+    winj_free(params, cls->secondaries);
+    for (ii = 0; ii < cls->static_method_capacity; ++ii) {
       winj_free(params, cls->static_methods[ii].name);
+      winj_free(params, cls->static_methods[ii].insns);
+      winj_free(params, cls->static_methods[ii].signature.types);
+#ifdef WINJ_JIT
+      winj_jit_code_cleanup(params, cls->static_methods[ii].jit);
+#endif
+    }
     winj_free(params, cls->static_methods);
+    for (ii = 0; ii < cls->static_field_capacity; ++ii)
+      winj_free(params, cls->static_fields[ii].name);
+    winj_free(params, cls->static_fields);
+    winj_free(params, cls->static_values);
+    for (ii = 0; ii < cls->field_capacity; ++ii)
+      winj_free(params, cls->fields[ii].name);
+    winj_free(params, cls->fields);
+    winj_free(params, cls->references);
     winj_free(params, cls->name);
     winj_class_file_cleanup(params, cls->class_file);
+
+    /* A class file, if any, shares the block taken for its class. */
+    winj_vm_space_release(vm, cls, sizeof(*cls) + (cls->class_file ?
+                                                   sizeof(*cls->class_file) :
+                                                   0));
   }
-  winj_free(params, cls);
 }
 
+/**
+ * Check that a constant pool reference names a constant of the
+ * expected type.
+ *
+ * @param params parameters for system customization
+ * @param class_file class with constant pool
+ * @param index reference to check, already known to be in range
+ * @param tag type of constant expected
+ * @param tag_name type of constant making the reference
+ * @param index_name purpose of reference
+ * @return EXIT_SUCCESS unless the reference is wrong */
 static int
-winj_cpool_unpack_index
-(struct winj_vm_params *params, struct winj_bytes *bytes,
- u1 tag, const char *tag_name, const char *index_name,
- struct winj_class_file *class_file, u2 *index_out)
+winj_cpool_check_index
+(struct winj_vm_params *params, struct winj_class_file *class_file,
+ u2 index, u1 tag, const char *tag_name, const char *index_name)
+{
+  u1 found = index ? class_file->cpool[class_file->cpool_idx[index]].tag :
+    0;
+
+  return (found == tag) ? EXIT_SUCCESS : winj_error
+    (params, "at index %hu constant is %u but should be %u for %s %s",
+     index, found, tag, tag_name, index_name);
+}
+
+static int
+winj_cpool_unpack_index
+(struct winj_vm_params *params, struct winj_bytes *bytes,
+ u1 tag, const char *tag_name, const char *index_name,
+ struct winj_class_file *class_file, u2 *index_out)
 {
   int result = EXIT_SUCCESS;
   u2 index = 0;
@@ -1402,10 +2373,11 @@ winj_cpool_unpack_index
   if (EXIT_SUCCESS != (result = winj_bytes_unpack_u2
                        (params, bytes, &index, "no bytes for %s %s",
                         tag_name, index_name))) {
-  } else if (index > class_file->cpool_count) {
+  } else if (index >= class_file->cpool_count) {
     result = winj_error(params, "invalid index %hu for %s %s",
                          index, tag_name, index_name);
-  } else if (tag && index &&
+  } else if (tag && index && /* forward references are checked later */
+             class_file->cpool[class_file->cpool_idx[index]].tag &&
              (tag != class_file->cpool
               [class_file->cpool_idx[index]].tag)) {
     result = winj_error
@@ -1427,7 +2399,7 @@ winj_cpool_get
   if ((index == 0) || (index >= class_file->cpool_count)) {
     result = winj_error
       (params, "invalid constant pool index %hu", index);
-  } else if (class_file->cpool_idx[index] > class_file->cpool_size) {
+  } else if (class_file->cpool_idx[index] >= class_file->cpool_count) {
     result = winj_error
       (params, "out-of-bounds constant pool index %hu -> %hu",
        index, class_file->cpool_idx[index]);
@@ -1475,8 +2447,15 @@ winj_cpool_utf8
     uint32_t codep;
 
     while ((result == EXIT_SUCCESS) && (ii < length)) {
-      if (EXIT_SUCCESS != (result = winj_utf8_java_decode
-                           (params, length, src, &ii, &codep))) {
+      unsigned run = (unsigned)winj_ascii_length(length - ii, src + ii);
+
+      if (buffer)
+        memcpy(buffer + count, src + ii, run);
+      ii    += run;
+      count += run;
+      if (ii >= length) {
+      } else if (EXIT_SUCCESS != (result = winj_utf8_java_decode
+                                  (params, length, src, &ii, &codep))) {
       } else result = winj_utf8_encode(params, codep, &count, buffer);
     }
   }
@@ -1512,37 +2491,46 @@ winj_cpool_get_class_name
   return result;
 }
 
+/**
+ * Unpack the constant pool of a class file.  Storage for every entry
+ * is allocated at once based on the constant count, which is an
+ * upper bound since long and double constants use two indexes but
+ * only one entry.  UTF8 constants refer to the class file bytes
+ * rather than copies, so those must be kept as long as the class.
+ *
+ * @param params parameters for system customization
+ * @param bytes class file contents positioned after the count
+ * @param class_file destination with cpool_count already set
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
 winj_cpool_create
 (struct winj_vm_params *params, struct winj_bytes *bytes,
  struct winj_class_file *class_file)
 {
   int result = EXIT_SUCCESS;
+  unsigned count = class_file->cpool_count;
+  unsigned size = count * (sizeof(*class_file->cpool) +
+                           sizeof(*class_file->cpool_idx));
   unsigned ii;
 
-  for (ii = 1; (result == EXIT_SUCCESS) &&
-         (ii < class_file->cpool_count); ++ii) {
-    struct winj_cpool *next = NULL;
-    struct winj_cpool *entry = NULL;
-    union winj_cpool_info *info = NULL;
+  if (!(class_file->cpool = winj_calloc(params, 1, size))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for cpool", size);
+  } else {
+    class_file->cpool_idx = (u2 *)&class_file->cpool[count];
+    for (ii = 0; ii < count; ++ii)
+      class_file->cpool_idx[ii] = count - 1; /* empty entry */
+    class_file->cpool_size = 0;
+  }
 
-    if (!(next = winj_realloc
-          (params, class_file->cpool, sizeof(*class_file->cpool) *
-           (class_file->cpool_size + 1)))) {
-      result = winj_error
-        (params, "failed to allocate %u bytes for cpool",
-         sizeof(*class_file->cpool) * (class_file->cpool_size + 1));
-    } else {
-      class_file->cpool = next;
-      class_file->cpool_idx[ii] = class_file->cpool_size;
-      entry = &class_file->cpool[class_file->cpool_size++];
-      info = &entry->info;
-    }
+  for (ii = 1; (result == EXIT_SUCCESS) && (ii < count); ++ii) {
+    struct winj_cpool *entry = &class_file->cpool[class_file->cpool_size];
+    union winj_cpool_info *info = &entry->info;
 
-    if ((EXIT_SUCCESS != result) ||
-        (EXIT_SUCCESS != (result = winj_bytes_unpack_u1
-                          (params, bytes, &entry->tag,
-                           "cpool no byte for tag"))))
+    class_file->cpool_idx[ii] = class_file->cpool_size++;
+    if (EXIT_SUCCESS != (result = winj_bytes_unpack_u1
+                         (params, bytes, &entry->tag,
+                          "cpool no byte for tag")))
       break;
 
     switch (entry->tag) {
@@ -1754,6 +2742,103 @@ winj_cpool_create
                            (unsigned)entry->tag, (unsigned)entry->tag);
     }
   }
+
+  /* References may point forward, so types are checked here. */
+  for (ii = 0; (result == EXIT_SUCCESS) &&
+         (ii < class_file->cpool_size); ++ii) {
+    union winj_cpool_info *info = &class_file->cpool[ii].info;
+
+    switch (class_file->cpool[ii].tag) {
+    case WINJ_CONST_CLASS:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_class, WINJ_CONST_UTF8,
+         "class", "name");
+      break;
+    case WINJ_CONST_FIELDREF:
+      if (EXIT_SUCCESS == (result = winj_cpool_check_index
+                           (params, class_file,
+                            info->const_fieldref.class_index,
+                            WINJ_CONST_CLASS, "fieldref", "class")))
+        result = winj_cpool_check_index
+          (params, class_file, info->const_fieldref.nameandtype_index,
+           WINJ_CONST_NAMEANDTYPE, "fieldref", "nameandtype");
+      break;
+    case WINJ_CONST_METHODREF:
+      if (EXIT_SUCCESS == (result = winj_cpool_check_index
+                           (params, class_file,
+                            info->const_methodref.class_index,
+                            WINJ_CONST_CLASS, "methodref", "class")))
+        result = winj_cpool_check_index
+          (params, class_file, info->const_methodref.nameandtype_index,
+           WINJ_CONST_NAMEANDTYPE, "methodref", "nameandtype");
+      break;
+    case WINJ_CONST_INTERFACEMETHODREF:
+      if (EXIT_SUCCESS == (result = winj_cpool_check_index
+                           (params, class_file,
+                            info->const_interfacemethodref.class_index,
+                            WINJ_CONST_CLASS, "interfacemethodref",
+                            "class")))
+        result = winj_cpool_check_index
+          (params, class_file,
+           info->const_interfacemethodref.nameandtype_index,
+           WINJ_CONST_NAMEANDTYPE, "interfacemethodref", "nameandtype");
+      break;
+    case WINJ_CONST_STRING:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_string, WINJ_CONST_UTF8,
+         "string", "index");
+      break;
+    case WINJ_CONST_NAMEANDTYPE:
+      if (EXIT_SUCCESS == (result = winj_cpool_check_index
+                           (params, class_file,
+                            info->const_nameandtype.name_index,
+                            WINJ_CONST_UTF8, "nameandtype", "name")))
+        result = winj_cpool_check_index
+          (params, class_file, info->const_nameandtype.descriptor_index,
+           WINJ_CONST_UTF8, "nameandtype", "descriptor");
+      break;
+    case WINJ_CONST_METHODHANDLE: {
+      u2 index = info->const_methodhandle.reference_index;
+      u2 kind = info->const_methodhandle.reference_kind;
+      u1 tag = (kind <= 4) ? WINJ_CONST_FIELDREF :
+        (kind == 9) ? WINJ_CONST_INTERFACEMETHODREF : WINJ_CONST_METHODREF;
+
+      /* invokestatic and invokespecial may name interface methods */
+      if (((kind == 6) || (kind == 7)) && index &&
+          (WINJ_CONST_INTERFACEMETHODREF ==
+           class_file->cpool[class_file->cpool_idx[index]].tag))
+        tag = WINJ_CONST_INTERFACEMETHODREF;
+      result = winj_cpool_check_index
+        (params, class_file, index, tag, "methodhandle", "reference");
+    } break;
+    case WINJ_CONST_METHODTYPE:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_methodtype, WINJ_CONST_UTF8,
+         "methodtype", "descriptor");
+      break;
+    case WINJ_CONST_DYNAMIC:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_dynamic.nameandtype_index,
+         WINJ_CONST_NAMEANDTYPE, "dynamic", "nameandtype");
+      break;
+    case WINJ_CONST_INVOKEDYNAMIC:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_invokedynamic.nameandtype_index,
+         WINJ_CONST_NAMEANDTYPE, "invokedynamic", "nameandtype");
+      break;
+    case WINJ_CONST_MODULE:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_module, WINJ_CONST_UTF8,
+         "module", "name");
+      break;
+    case WINJ_CONST_PACKAGE:
+      result = winj_cpool_check_index
+        (params, class_file, info->const_package, WINJ_CONST_UTF8,
+         "package", "name");
+      break;
+    default: break;
+    }
+  }
   return result;
 }
 
@@ -2517,14 +3602,8 @@ winj_class_file_create
                "not enough bytes for cpool count"))) {
   } else if (!defined.cpool_count) {
     result = winj_error(params, "invalid constant pool count (zero)");
-  } else if (!(defined.cpool_idx = winj_calloc
-               (params, defined.cpool_count,
-                sizeof(*defined.cpool_idx)))) {
-    result = winj_error
-      (params, "failed to allocate %u bytes for constant pool indices",
-       sizeof(*defined.cpool_idx) * defined.cpool_count);
-  } else if (EXIT_SUCCESS != winj_cpool_create
-             (params, bytes, &defined)) {
+  } else if (EXIT_SUCCESS != (result = winj_cpool_create
+                              (params, bytes, &defined))) {
   } else if (EXIT_SUCCESS !=
              (result = winj_bytes_unpack_u2
               (params, bytes, &defined.access_flags,
@@ -2600,39 +3679,28 @@ winj_class_file_create
 
 
 /**
- * Generic binary search implementation.  Checks whether the current
- * entry name matches the goal.  If so, the match pointer is set to
- * the current entry.  If not, the index, top and bottom values are
- * adjusted to the next place it makes sense to search.  A search ends
- * without a match when top is no longer greater than bottom.  Each
- * comparison rules out half of the array entries due to the
- * assumption that the array is arranged in sorted order so the
- * number of steps should be proportional to the base two logarithm
- * of the number of array entries (scaling is O(ln(n))). */
-unsigned
-winj_binary_search_step
-(unsigned goal_len, const char *goal, unsigned index,
- unsigned name_len, const char *name, void *current, 
- unsigned *top, unsigned *bottom, void **match)
+ * Compute a hash of a name using the FNV-1a algorithm.
+ *
+ * @param name_len number of bytes in name
+ * @param name bytes to hash
+ * @return hash value */
+static u4
+winj_name_hash(unsigned name_len, const char *name)
 {
-  if (current) {
-    unsigned minimum = (goal_len < name_len) ? goal_len : name_len;
-    int cmp;
-    if ((cmp = strncmp(goal, name, minimum)) == 0)
-      cmp = (goal_len < name_len) ? -1 :
-        (goal_len > name_len) ? 1 : 0;
+  u4 result = 2166136261u;
+  unsigned ii;
 
-    if (cmp == 0) {
-      *top = *bottom;
-      *match = current;
-    } else if (cmp < 0) {
-      *top = index;
-    } else *bottom = index + 1;
-  }
-  return *bottom + (*top - *bottom) / 2;
+  for (ii = 0; ii < name_len; ++ii)
+    result = (result ^ (u1)name[ii]) * 16777619u;
+  return result;
 }
 
-#define WINJ_BINARY_SEARCH(parent, child, sibling)                     \
+/* Generates functions to search and store named members of a class
+ * which are kept in open addressing hash tables.  Unused entries have
+ * a NULL name.  Tables double in size when they become three quarters
+ * full, which moves entries, so pointers to members must not be kept
+ * until the class has been completely defined. */
+#define WINJ_HASH_TABLE(parent, child, sibling)                        \
   static int winj_##parent##_##sibling##_search                        \
   (struct winj_##parent *src_##parent,                                 \
    unsigned name_len, const char *name,                                \
@@ -2640,20 +3708,21 @@ winj_binary_search_step
   {                                                                    \
     struct winj_##child *found = NULL;                                 \
     struct winj_##child *current = NULL;                               \
-    u4 top = src_##parent->sibling##_count;                            \
-    u4 bottom = 0;                                                     \
-    u4 index = 0;                                                      \
+    u4 mask = src_##parent->sibling##_capacity - 1;                    \
+    u4 hash;                                                           \
+    u4 index;                                                          \
     if (name && !name_len)                                             \
       name_len = strlen(name);                                         \
-    while (top > bottom) {                                             \
-      index = winj_binary_search_step                                  \
-        (name_len, name, index,                                        \
-         current ? current->name_len : 0,                              \
-         current ? current->name : NULL, current,                      \
-         &top, &bottom, (void**)&found);                               \
-      if (index < top)                                                 \
-        current = &src_##parent->sibling##s[index];                    \
-    }                                                                  \
+    hash = winj_name_hash(name_len, name);                             \
+    for (index = hash; src_##parent->sibling##_capacity &&             \
+           (current = &src_##parent->sibling##s[index & mask])->name;  \
+         ++index)                                                      \
+      if ((current->name_hash == hash) &&                              \
+          (current->name_len == name_len) &&                           \
+          !memcmp(current->name, name, name_len)) {                    \
+        found = current;                                               \
+        break;                                                         \
+      }                                                                \
     if (child##_out)                                                   \
       *child##_out = found;                                            \
     return EXIT_SUCCESS;                                               \
@@ -2665,49 +3734,188 @@ winj_binary_search_step
    struct winj_##child *child##_in)                                    \
   {                                                                    \
     int result = EXIT_SUCCESS;                                         \
-    struct winj_##child *next;                                         \
+    struct winj_##child *next = NULL;                                  \
     struct winj_##child *found = NULL;                                 \
-    struct winj_##child *current = NULL;                               \
-    u4 top = src_##parent->sibling##_count;                            \
-    u4 bottom = 0;                                                     \
-    u4 index = 0;                                                      \
+    u4 capacity = src_##parent->sibling##_capacity;                    \
+    u4 index;                                                          \
+    u4 ii;                                                             \
     if (!child##_in)                                                   \
-      result = winj_error(params, "missing ##child pointer");          \
-    while (top > bottom) {                                             \
-      index = winj_binary_search_step                                  \
-        (src_##parent->name_len, src_##parent->name, index,            \
-         current ? current->name_len : 0,                              \
-         current ? current->name : 0, current,                         \
-         &top, &bottom, (void**)&found);                               \
-      if (index < top)                                                 \
-        current = &src_##parent->sibling##s[index];                    \
-    };                                                                 \
+      result = winj_error(params, "missing " #child " pointer");       \
+    else winj_##parent##_##sibling##_search                            \
+           (src_##parent, child##_in->name_len, child##_in->name,      \
+            &found);                                                   \
     if (EXIT_SUCCESS != result) {                                      \
     } else if (found) {                                                \
       result = winj_error                                              \
-        (params, "refusing to store ##child that already exists: "     \
+        (params, "refusing to store " #child " that already exists: "  \
          "%.*s", child##_in->name_len, child##_in->name);              \
-    } else if (!(next = winj_realloc                                   \
-                 (params, src_##parent->sibling##s,                    \
-                  sizeof(*src_##parent->sibling##s) *                  \
-                  (src_##parent->sibling##_count + 1)))) {             \
+    } else if (((src_##parent->sibling##_count + 1) * 4 >              \
+                capacity * 3) &&                                       \
+               !(next = winj_calloc                                    \
+                 (params, capacity = capacity ? (capacity * 2) : 8,    \
+                  sizeof(*next)))) {                                   \
       result = winj_error                                              \
-        (params, "failed to allocate %u bytes for ##child",            \
-         sizeof(*src_##parent->sibling##s) *                           \
-         (src_##parent->sibling##_count + 1));                         \
+        (params, "failed to allocate %u bytes for " #child,            \
+         sizeof(*next) * capacity);                                    \
     } else {                                                           \
-      src_##parent->sibling##s = next;                                 \
-      memmove(&src_##parent->sibling##s[index + 1],                    \
-              &src_##parent->sibling##s[index],                        \
-              sizeof(*src_##parent->sibling##s) *                      \
-              (src_##parent->sibling##_count++ - index));              \
-      src_##parent->sibling##s[index] = *child##_in;                   \
+      if (next) {                                                      \
+        for (ii = 0; ii < src_##parent->sibling##_capacity; ++ii)      \
+          if (src_##parent->sibling##s[ii].name) {                     \
+            for (index = src_##parent->sibling##s[ii].name_hash;       \
+                 next[index & (capacity - 1)].name; ++index)           \
+              ; /* linear probing */                                   \
+            next[index & (capacity - 1)] =                             \
+              src_##parent->sibling##s[ii];                            \
+          }                                                            \
+        winj_free(params, src_##parent->sibling##s);                   \
+        src_##parent->sibling##s = next;                               \
+        src_##parent->sibling##_capacity = capacity;                   \
+      }                                                                \
+      child##_in->name_hash = winj_name_hash                           \
+        (child##_in->name_len, child##_in->name);                      \
+      for (index = child##_in->name_hash;                              \
+           src_##parent->sibling##s[index & (capacity - 1)].name;      \
+           ++index)                                                    \
+        ; /* linear probing */                                         \
+      src_##parent->sibling##s[index & (capacity - 1)] = *child##_in;  \
+      src_##parent->sibling##_count++;                                 \
     }                                                                  \
     return result;                                                     \
   }
 
-WINJ_BINARY_SEARCH(class, method, static_method);
-WINJ_BINARY_SEARCH(class, method, method);
+WINJ_HASH_TABLE(class, method, static_method);
+WINJ_HASH_TABLE(class, method, method);
+WINJ_HASH_TABLE(class, field, static_field);
+WINJ_HASH_TABLE(class, field, field);
+
+/**
+ * Determine the type of a value from the first character of a field
+ * descriptor.  Arrays are references so they are objects as far as
+ * the interpreter is concerned.
+ *
+ * @param desc_len number of bytes in descriptor
+ * @param desc field descriptor such as <code>I</code>
+ * @return type of value described */
+static enum winj_type
+winj_descriptor_type(unsigned desc_len, const char *desc)
+{
+  enum winj_type result = WINJ_TYPE_VOID;
+
+  if (desc && desc_len) {
+    switch (*desc) {
+    case 'Z': result = WINJ_TYPE_BOOLEAN; break;
+    case 'B': result = WINJ_TYPE_BYTE;    break;
+    case 'C': result = WINJ_TYPE_CHAR;    break;
+    case 'S': result = WINJ_TYPE_SHORT;   break;
+    case 'I': result = WINJ_TYPE_INT;     break;
+    case 'J': result = WINJ_TYPE_LONG;    break;
+    case 'F': result = WINJ_TYPE_FLOAT;   break;
+    case 'D': result = WINJ_TYPE_DOUBLE;  break;
+    case 'L': case '[': result = WINJ_TYPE_OBJECT; break;
+    default: break;
+    }
+  }
+  return result;
+}
+
+/**
+ * Determine how many bytes an instance field of some type occupies.
+ * Each field is aligned to a multiple of its own size.
+ *
+ * @param type type of field
+ * @return bytes of storage */
+static unsigned
+winj_type_size(enum winj_type type)
+{
+  unsigned result = 0;
+
+  switch (type) {
+  case WINJ_TYPE_BOOLEAN: case WINJ_TYPE_BYTE:  result = 1; break;
+  case WINJ_TYPE_CHAR:    case WINJ_TYPE_SHORT: result = 2; break;
+  case WINJ_TYPE_INT:     case WINJ_TYPE_FLOAT: result = 4; break;
+  case WINJ_TYPE_LONG:    case WINJ_TYPE_DOUBLE: result = 8; break;
+  case WINJ_TYPE_OBJECT: result = sizeof(winj_ref); break;
+  default: break;
+  }
+  return result;
+}
+
+/**
+ * Parse the descriptor of a method once, when the method is stored
+ * in its class, so that calls need not parse it again.  Long and
+ * double arguments count as two slots.
+ *
+ * @param params parameters for system customization
+ * @param method method whose name includes its descriptor
+ * @return EXIT_SUCCESS unless descriptor is invalid */
+static int
+winj_method_signature
+(struct winj_vm_params *params, struct winj_method *method)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_signature *signature = &method->signature;
+  const char *desc = method->name;
+  unsigned desc_len = method->name_len;
+  const char *next = NULL;
+  const char *close = NULL;
+  const char *open = NULL;
+  unsigned pass;
+
+  memset(signature, 0, sizeof(*signature));
+  if (!(open = winj_strnchr(desc, '(', desc_len))) {
+    result = winj_error(params, "missing open parenthesis");
+  } else if (!(close = winj_strnchr
+               (open, ')', desc_len - (open - desc)))) {
+    result = winj_error(params, "missing close parenthesis");
+  }
+
+  /* The first pass counts arguments and the second records them. */
+  for (pass = 0; (EXIT_SUCCESS == result) && (pass < 2); ++pass) {
+    signature->count = signature->slots = 0;
+    for (next = open + 1; (EXIT_SUCCESS == result) && (next < close);
+         ++next) {
+      enum winj_type type = winj_descriptor_type(close - next, next);
+
+      while (*next == '[')
+        ++next;
+      if ((*next == 'L') && !(next = winj_strnchr
+                              (next, ';', close - next)))
+        result = winj_error(params, "missing object terminator");
+      else if (type == WINJ_TYPE_VOID)
+        result = winj_error(params, "invalid argument type: %c",
+                            *next);
+      else {
+        if (signature->types)
+          signature->types[signature->count] = (u1)type;
+        signature->count++;
+        signature->slots += ((type == WINJ_TYPE_LONG) ||
+                             (type == WINJ_TYPE_DOUBLE)) ? 2 : 1;
+      }
+    }
+
+    if (EXIT_SUCCESS != result) {
+    } else if (signature->slots + ((method->access_flags &
+                                    WINJ_ACCESS_STATIC) ? 0 : 1) >
+               WINJ_ARGUMENT_SLOTS) {
+      result = winj_error(params, "too many arguments: %.*s",
+                          method->name_len, method->name);
+    } else if (!pass && signature->count &&
+               !(signature->types = winj_malloc
+                 (params, signature->count))) {
+      result = winj_error(params, "failed to allocate %u bytes",
+                          signature->count);
+    }
+  }
+
+  if (EXIT_SUCCESS == result)
+    signature->return_type = winj_descriptor_type
+      (desc_len - (close + 1 - desc), close + 1);
+  else {
+    winj_free(params, signature->types);
+    signature->types = NULL;
+  }
+  return result;
+}
 
 /**
  * Used for classes defined by class files to stitch things together.
@@ -2736,6 +3944,7 @@ winj_class_class_file
     struct winj_method method;
     memset(&method, 0, sizeof(method));
     method.method_file = method_file;
+    method.access_flags = method_file->access_flags;
 
     if (EXIT_SUCCESS !=
         (result = winj_cpool_get
@@ -2752,6 +3961,8 @@ winj_class_class_file
                  desc_info->const_utf8.length,
                  (const char *)desc_info->const_utf8.bytes,
                  &method.name_len, &method.name))) {
+    } else if (EXIT_SUCCESS !=
+               (result = winj_method_signature(params, &method))) {
     } else if ((method_file->access_flags & WINJ_ACCESS_STATIC) &&
                (EXIT_SUCCESS !=
                 (result = winj_class_static_method_store
@@ -2764,10 +3975,57 @@ winj_class_class_file
       memset(&method, 0, sizeof(method));
     }
     winj_free(params, method.name);
+    winj_free(params, method.signature.types);
+  }
+
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < class_file->fields_count); ++ii) {
+    u1 tag_utf8 = WINJ_CONST_UTF8;
+    union winj_cpool_info *name_info = NULL;
+    union winj_cpool_info *desc_info = NULL;
+    struct winj_field_file *field_file = &class_file->fields[ii];
+    struct winj_field field;
+    memset(&field, 0, sizeof(field));
+    field.access_flags = field_file->access_flags;
+
+    if (EXIT_SUCCESS !=
+        (result = winj_cpool_get
+         (params, class_file, field_file->name_index,
+          &tag_utf8, &name_info))) {
+    } else if (EXIT_SUCCESS !=
+               (result = winj_cpool_get
+                (params, class_file, field_file->descriptor_index,
+                 &tag_utf8, &desc_info))) {
+    } else if (EXIT_SUCCESS !=
+               (result = winj_string_concat
+                (params, name_info->const_utf8.length,
+                 (const char *)name_info->const_utf8.bytes,
+                 desc_info->const_utf8.length,
+                 (const char *)desc_info->const_utf8.bytes,
+                 &field.name_len, &field.name))) {
+    } else {
+      field.type = winj_descriptor_type
+        (desc_info->const_utf8.length,
+         (const char *)desc_info->const_utf8.bytes);
+      field.index = cls->static_field_count;
+      if (field_file->access_flags & WINJ_ACCESS_STATIC)
+        result = winj_class_static_field_store(params, cls, &field);
+      else result = winj_class_field_store(params, cls, &field);
+      if (EXIT_SUCCESS == result)
+        memset(&field, 0, sizeof(field));
+    }
+    winj_free(params, field.name);
   }
 
-  /* TODO: create fields */
-  /* TODO: create static fields */
+  if (EXIT_SUCCESS != result) {
+  } else if (cls->static_field_count &&
+             !(cls->static_values = winj_calloc
+               (params, cls->static_field_count,
+                sizeof(*cls->static_values)))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for static fields",
+       cls->static_field_count * sizeof(*cls->static_values));
+  }
 
   if (EXIT_SUCCESS != result) {
   } else if (EXIT_SUCCESS !=
@@ -2777,7 +4035,7 @@ winj_class_class_file
   } else if (EXIT_SUCCESS !=
              (result = winj_string_copy
               (params, name_len, name, &cls->name_len, &cls->name))) {
-  }
+  } else cls->access_flags = class_file->access_flags;
   return result;
 }
 
@@ -2797,16 +4055,268 @@ winj_class_file_validate
   return result;
 }
 
-int
-winj_class_instance(struct winj_class *cls, struct winj_object *obj)
+/**
+ * Determine whether one class is the same as or a subtype of
+ * another.  Classes within the display are found by a single
+ * comparison, while interfaces and deep classes need a scan of the
+ * secondary supers unless they match the last one found.
+ *
+ * @param cls class to check
+ * @param target class or interface which may be a super type
+ * @return EXIT_SUCCESS unless cls is not assignable to target */
+static int
+winj_class_assignable(struct winj_class *cls, struct winj_class *target)
 {
   int result = EXIT_FAILURE;
-  struct winj_class *current = obj ? obj->cls : NULL;
+  unsigned ii;
 
-  for (; (result != EXIT_SUCCESS) && current;
-       current = current->super)
-    if (current == cls)
+  if (target->depth < WINJ_DISPLAY_SIZE) {
+    if (cls->display[target->depth] == target)
       result = EXIT_SUCCESS;
+  } else if (cls->secondary_cache == target) {
+    result = EXIT_SUCCESS;
+  } else for (ii = 0; (result != EXIT_SUCCESS) &&
+                (ii < cls->secondary_count); ++ii)
+      if (cls->secondaries[ii] == target) {
+        cls->secondary_cache = target;
+        result = EXIT_SUCCESS;
+      }
+  return result;
+}
+
+int
+winj_class_instance(struct winj_class *cls, struct winj_object *obj)
+{
+  return obj ? winj_class_assignable(obj->cls, cls) : EXIT_FAILURE;
+}
+
+/**
+ * Determine whether a method is selected by the class of the object
+ * on which it is invoked.  Constructors, static and private methods
+ * are always called directly.
+ *
+ * @param method method to check
+ * @return non-zero if method belongs in a virtual method table */
+static int
+winj_method_virtual(const struct winj_method *method)
+{
+  return !(method->access_flags &
+           (WINJ_ACCESS_STATIC | WINJ_ACCESS_PRIVATE)) &&
+    method->name_len && (method->name[0] != '<');
+}
+
+/**
+ * Find the virtual method a class inherits with a given name and
+ * descriptor, starting the search with the class itself.
+ *
+ * @param cls class from which to start searching
+ * @param name_len number of bytes in name (or 0 for strlen)
+ * @param name method name followed by descriptor
+ * @param method_out destination for method or NULL if not found
+ * @return EXIT_SUCCESS */
+static int
+winj_class_virtual_search
+(struct winj_class *cls, unsigned name_len, const char *name,
+ struct winj_method **method_out)
+{
+  struct winj_method *found = NULL;
+
+  for (; cls && !found; cls = cls->super)
+    if ((EXIT_SUCCESS == winj_class_method_search
+         (cls, name_len, name, &found)) &&
+        found && !winj_method_virtual(found))
+      found = NULL;
+  *method_out = found;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Give each instance field of a class an offset after those it
+ * inherits.  Small fields first fill any gap before the next multiple
+ * of eight bytes, then the rest go largest first so that each is
+ * aligned to its own size with little padding.  Offsets of reference
+ * fields, inherited ones included, are collected for the garbage
+ * collector.
+ *
+ * @param params parameters for system customization
+ * @param cls class with all instance fields stored
+ * @param super super class or NULL for java/lang/Object
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_class_layout
+(struct winj_vm_params *params, struct winj_class *cls,
+ struct winj_class *super)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_field *field = NULL;
+  unsigned size = super ? super->instance_size :
+    offsetof(struct winj_object, size) + sizeof(unsigned);
+  unsigned count = super ? super->reference_count : 0;
+  unsigned gap = (size + 7) & ~7u;
+  unsigned width;
+  unsigned ii;
+
+  for (width = 4; width; width /= 2)
+    for (ii = 0; ii < cls->field_capacity; ++ii)
+      if ((field = &cls->fields[ii])->name && !field->offset &&
+          (winj_type_size(field->type) == width) &&
+          (((size + width - 1) & ~(width - 1)) + width <= gap)) {
+        field->offset = (size + width - 1) & ~(width - 1);
+        size = field->offset + width;
+      }
+  for (width = 8; width; width /= 2)
+    for (ii = 0; ii < cls->field_capacity; ++ii)
+      if ((field = &cls->fields[ii])->name && !field->offset &&
+          (winj_type_size(field->type) == width)) {
+        field->offset = (size + width - 1) & ~(width - 1);
+        size = field->offset + width;
+      }
+  for (ii = 0; ii < cls->field_capacity; ++ii)
+    if (cls->fields[ii].name && (cls->fields[ii].type == WINJ_TYPE_OBJECT))
+      count++;
+  cls->instance_size = size;
+
+  if (count && !(cls->references = winj_calloc
+                 (params, count, sizeof(*cls->references)))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for reference offsets",
+       count * sizeof(*cls->references));
+  } else if (count) {
+    if (super && super->reference_count)
+      memcpy(cls->references, super->references,
+             super->reference_count * sizeof(*cls->references));
+    cls->reference_count = super ? super->reference_count : 0;
+    for (ii = 0; ii < cls->field_capacity; ++ii)
+      if (cls->fields[ii].name &&
+          (cls->fields[ii].type == WINJ_TYPE_OBJECT))
+        cls->references[cls->reference_count++] = cls->fields[ii].offset;
+  }
+  return result;
+}
+
+/**
+ * Record the super types of a class for constant time type checks.
+ * The display is copied from the super class with the class itself
+ * added at its depth.  Secondary supers gather those of the super
+ * class and of each direct interface, the interfaces themselves and
+ * the class too when it is an interface or deeper than the display.
+ *
+ * @param params parameters for system customization
+ * @param cls class to connect
+ * @param super super class or NULL for java/lang/Object
+ * @param iface_count number of interfaces cls implements directly
+ * @param ifaces interfaces cls implements directly
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_class_supers
+(struct winj_vm_params *params, struct winj_class *cls,
+ struct winj_class *super, unsigned iface_count,
+ struct winj_class **ifaces)
+{
+  int result = EXIT_SUCCESS;
+  unsigned capacity = (super ? super->secondary_count : 0) + 1;
+  unsigned ii, jj;
+
+  if (super)
+    memcpy(cls->display, super->display, sizeof(cls->display));
+  cls->depth = super ? super->depth + 1 : 0;
+  if (super && (super->depth >= WINJ_DISPLAY_SIZE))
+    cls->depth = WINJ_DISPLAY_SIZE;
+  if (cls->access_flags & WINJ_ACCESS_INTERFACE)
+    cls->depth = WINJ_DISPLAY_SIZE;
+  if (cls->depth < WINJ_DISPLAY_SIZE)
+    cls->display[cls->depth] = cls;
+
+  for (ii = 0; ii < iface_count; ++ii)
+    capacity += ifaces[ii]->secondary_count;
+  if (!(cls->secondaries = winj_calloc
+        (params, capacity, sizeof(*cls->secondaries)))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for super types",
+       capacity * sizeof(*cls->secondaries));
+  } else {
+    struct winj_class **next = cls->secondaries;
+
+    if (cls->depth >= WINJ_DISPLAY_SIZE)
+      *next++ = cls;
+    if (super && super->secondary_count) {
+      memcpy(next, super->secondaries,
+             super->secondary_count * sizeof(*next));
+      next += super->secondary_count;
+    }
+    for (ii = 0; ii < iface_count; ++ii)
+      for (jj = 0; jj < ifaces[ii]->secondary_count; ++jj) {
+        struct winj_class **seen = cls->secondaries;
+
+        while ((seen < next) && (*seen != ifaces[ii]->secondaries[jj]))
+          ++seen;
+        if (seen == next)
+          *next++ = ifaces[ii]->secondaries[jj];
+      }
+    cls->secondary_count = (unsigned)(next - cls->secondaries);
+  }
+  return result;
+}
+
+/**
+ * Connect a class to its super class and interfaces, lay out its
+ * instance fields and build the virtual method table.  Methods which
+ * override an inherited method take over its slot so that
+ * invokevirtual can select an implementation by index.  Must be
+ * called after all members have been stored since pointers to
+ * methods are kept in the table.
+ *
+ * @param params parameters for system customization
+ * @param cls class to link
+ * @param super super class or NULL for java/lang/Object
+ * @param iface_count number of interfaces cls implements directly
+ * @param ifaces interfaces cls implements directly
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_class_link
+(struct winj_vm_params *params, struct winj_class *cls,
+ struct winj_class *super, unsigned iface_count,
+ struct winj_class **ifaces)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_method *inherited = NULL;
+  unsigned count = super ? super->vtable_count : 0;
+  unsigned ii;
+
+  cls->super = super;
+  for (ii = 0; ii < cls->static_method_capacity; ++ii)
+    cls->static_methods[ii].cls = cls;
+  for (ii = 0; ii < cls->method_capacity; ++ii) {
+    struct winj_method *method = &cls->methods[ii];
+
+    method->cls = cls;
+    if (!method->name || !winj_method_virtual(method)) {
+    } else if (EXIT_SUCCESS == winj_class_virtual_search
+               (super, method->name_len, method->name, &inherited) &&
+               inherited) {
+      method->vtable_index = inherited->vtable_index;
+    } else method->vtable_index = count++;
+  }
+
+  if (EXIT_SUCCESS != (result = winj_class_layout(params, cls, super))) {
+  } else if (EXIT_SUCCESS != (result = winj_class_supers
+                              (params, cls, super, iface_count,
+                               ifaces))) {
+  } else if (count && !(cls->vtable = winj_calloc
+                        (params, count, sizeof(*cls->vtable)))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for virtual methods",
+       count * sizeof(*cls->vtable));
+  } else if (count) {
+    if (super && super->vtable_count)
+      memcpy(cls->vtable, super->vtable,
+             super->vtable_count * sizeof(*cls->vtable));
+    for (ii = 0; ii < cls->method_capacity; ++ii)
+      if (cls->methods[ii].name &&
+          winj_method_virtual(&cls->methods[ii]))
+        cls->vtable[cls->methods[ii].vtable_index] = &cls->methods[ii];
+    cls->vtable_count = count;
+  }
   return result;
 }
 
@@ -3141,2062 +4651,9481 @@ winj_bytes_from_file
   return result;
 }
 
+/**
+ * Fetch the contents of a file by path.  Where possible the file is
+ * mapped read only so that nothing is copied and the page cache can
+ * share class bytes between virtual machines.  Otherwise the file is
+ * read into allocated memory.  Missing files are not an error.
+ *
+ * @param params parameters for system customization
+ * @param path file system path of file to fetch
+ * @param bytes_out destination for contents of file
+ * @param found_out set to non-zero if the file exists
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_bytes_from_environ_path
-(struct winj_vm_params *params, const char *environ_variable,
- const char *filename, struct winj_bytes *bytes_out)
+winj_bytes_from_path
+(struct winj_vm_params *params, const char *path,
+ struct winj_bytes *bytes_out, unsigned *found_out)
 {
   int result = EXIT_SUCCESS;
-  unsigned filename_length = strlen(filename);
-  unsigned prefix_length = 0;
+  FILE *ff = NULL;
   unsigned found = 0;
-  const char *prefix = NULL;
-  const char *winjpath = NULL;
+  unsigned done = 0;
+#ifdef HAVE_MMAP
+  int fd = -1;
+  struct stat st;
+  void *mapping = MAP_FAILED;
+
+  if (params && params->class_read) {
+  } else if ((fd = open(path, O_RDONLY)) < 0) {
+    done = 1; /* reading would fail the same way */
+  } else if (fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+             (st.st_size <= 0) || (st.st_size >= (off_t)UINT_MAX)) {
+    /* read anything that cannot be mapped */
+  } else if (MAP_FAILED != (mapping = mmap
+                            (NULL, (size_t)st.st_size, PROT_READ,
+                             MAP_PRIVATE, fd, 0))) {
+    bytes_out->value  = mapping;
+    bytes_out->count  = (unsigned)st.st_size;
+    bytes_out->offset = 0;
+    bytes_out->storage = winj_bytes_mapped;
+    found = done = 1;
+  }
+  if (fd >= 0)
+    close(fd);
+#endif
+
+  if (done) {
+  } else if (!(ff = fopen(path, "rb"))) {
+    done = 1;
+  } else if (EXIT_SUCCESS ==
+             (result = winj_bytes_from_file(params, ff, bytes_out))) {
+    found = 1;
+  }
 
-  if (params && params->getenv)
-    winjpath = params->getenv(params->context, environ_variable);
-  else winjpath = getenv(environ_variable);
+  /* Completely ignore missing files, but log other reasons. */
+  if (!found && done && (errno != ENOENT))
+    winj_warn(params, "failed to open \"%s\": %s",
+              path, strerror(errno));
+  if (ff)
+    fclose(ff);
+  if (found_out)
+    *found_out = found;
+  return result;
+}
 
-  if (!winjpath)
-    winjpath = ".";
+/**
+ * Record the size and modification time of a file.  Only systems
+ * with memory mapping provide these, so elsewhere nothing is found.
+ *
+ * @param source names the file and receives its attributes
+ * @return non-zero if the file exists */
+static int
+winj_source_stat(struct winj_source *source)
+{
+  int result = 0;
+#ifdef HAVE_MMAP
+  struct stat st;
+
+  if (source->path && !stat(source->path, &st)) {
+    source->size  = (u4)st.st_size;
+    source->mtime = (u4)st.st_mtime;
+#  ifdef HAVE_STRUCT_STAT_ST_MTIM
+    source->mtime_ns = (u4)st.st_mtim.tv_nsec;
+#  else
+    source->mtime_ns = 0;
+#  endif
+    result = 1;
+  }
+#endif
+  return result;
+}
 
-  while ((result == EXIT_SUCCESS) && !found &&
-         (prefix = winj_path_next(&winjpath, ':', &prefix_length))) {
-    FILE *ff = NULL;
-    char *path = NULL;
-    unsigned separate = 0;
-    unsigned length = filename_length + prefix_length;
-    struct winj_bytes bytes = {0};
+/* === Archives
+ * Class path entries ending in .jar or .zip are archives.  The
+ * central directory of each is read once into a hash table of
+ * member names.  Stored members are used in place while deflated
+ * ones are inflated into an allocation of exactly the right size. */
 
-    if (prefix && prefix_length > 0 &&
-        (prefix[prefix_length - 1] != '/')) {
-      separate = 1;
-      length += 1;
-    }
+static u2
+winj_le_u2(const u1 *value)
+{ return (u2)(value[0] | (value[1] << 8)); }
 
-    if (!(path = winj_malloc(params, length + 1))) {
-      result = winj_error
-        (params, "failed to allocate %u bytes for path", length + 1);
-    } else {
-      strcpy(path, prefix);
-      if (separate)
-        path[prefix_length] = '/';
-      strcpy(path + prefix_length + (separate ? 1 : 0), filename);
-      path[length] = '\0';
-    }
+static u4
+winj_le_u4(const u1 *value)
+{
+  return (u4)value[0] | ((u4)value[1] << 8) |
+    ((u4)value[2] << 16) | ((u4)value[3] << 24);
+}
+
+struct winj_inflate {
+  const u1 *src;
+  unsigned src_len;
+  unsigned src_pos;
+  u4 bits;
+  unsigned bit_count;
+  u1 *dest;
+  unsigned dest_len;
+  unsigned dest_pos;
+};
 
-    if (result != EXIT_SUCCESS) {
-    } else if (!(ff = fopen(path, "rb"))) {
-      /* Completely ignore missing files, but log other reasons.
-       * Either way keep going to try the next WINJ_PATH entry */
-      if (errno != ENOENT)
-        winj_warn(params, "failed to open \"%s\": %s",
-                   path, strerror(errno));
-    } else if (EXIT_SUCCESS !=
-               (result = winj_bytes_from_file(params, ff, &bytes))) {
-    } else found = 1;
+struct winj_huffman {
+  u2 counts[16];   /* number of codes of each length */
+  u2 symbols[288]; /* symbols ordered by code */
+};
 
-    if (found && bytes_out) {
-      *bytes_out = bytes;
-      bytes.value = NULL;
+/**
+ * Take bits from compressed data, least significant first.
+ *
+ * @param state decompression state
+ * @param need number of bits to take (at most 24)
+ * @param value_out destination for bits
+ * @return EXIT_SUCCESS unless compressed data ran out */
+static int
+winj_inflate_bits
+(struct winj_inflate *state, unsigned need, unsigned *value_out)
+{
+  u4 value = state->bits;
+
+  while (state->bit_count < need) {
+    if (state->src_pos >= state->src_len)
+      return EXIT_FAILURE;
+    value |= (u4)state->src[state->src_pos++] << state->bit_count;
+    state->bit_count += 8;
+  }
+  state->bits = value >> need;
+  state->bit_count -= need;
+  *value_out = value & ((1u << need) - 1);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Create canonical Huffman decoding tables from code lengths.
+ *
+ * @param huffman destination for tables
+ * @param lengths code length of each symbol (zero if unused)
+ * @param count number of symbols
+ * @return EXIT_SUCCESS unless lengths are over subscribed */
+static int
+winj_huffman_build
+(struct winj_huffman *huffman, const u1 *lengths, unsigned count)
+{
+  u2 offsets[16];
+  int left = 1;
+  unsigned ii;
+
+  memset(huffman->counts, 0, sizeof(huffman->counts));
+  for (ii = 0; ii < count; ++ii)
+    huffman->counts[lengths[ii]]++;
+  for (ii = 1; (left >= 0) && (ii < 16); ++ii)
+    left = (left << 1) - huffman->counts[ii];
+  if (left < 0)
+    return EXIT_FAILURE;
+
+  offsets[1] = 0;
+  for (ii = 1; ii < 15; ++ii)
+    offsets[ii + 1] = offsets[ii] + huffman->counts[ii];
+  for (ii = 0; ii < count; ++ii)
+    if (lengths[ii])
+      huffman->symbols[offsets[lengths[ii]]++] = (u2)ii;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Decode one symbol one bit at a time, which is slow but needs no
+ * lookup tables beyond those made by winj_huffman_build.
+ *
+ * @param state decompression state
+ * @param huffman tables to decode with
+ * @param symbol_out destination for decoded symbol
+ * @return EXIT_SUCCESS unless data is invalid or truncated */
+static int
+winj_inflate_symbol
+(struct winj_inflate *state, const struct winj_huffman *huffman,
+ unsigned *symbol_out)
+{
+  int code = 0;
+  int first = 0;
+  int index = 0;
+  unsigned length;
+  unsigned bit;
+
+  for (length = 1; length < 16; ++length) {
+    if (EXIT_SUCCESS != winj_inflate_bits(state, 1, &bit))
+      return EXIT_FAILURE;
+    code |= bit;
+    if (code - huffman->counts[length] < first) {
+      *symbol_out = huffman->symbols[index + (code - first)];
+      return EXIT_SUCCESS;
     }
-    if (ff)
-      fclose(ff);
-    winj_free(params, path);
-    winj_free(params, bytes.value);
+    index += huffman->counts[length];
+    first = (first + huffman->counts[length]) << 1;
+    code <<= 1;
   }
+  return EXIT_FAILURE;
+}
 
-  if (!found && bytes_out && (result == EXIT_SUCCESS)) {
-    bytes_out->value = NULL;
-    bytes_out->count = bytes_out->offset = 0;
+/**
+ * Decode literals and back references until the end of a block.
+ *
+ * @param state decompression state
+ * @param lengths tables for literals and lengths
+ * @param distances tables for distances
+ * @return EXIT_SUCCESS unless data is invalid or truncated */
+static int
+winj_inflate_codes
+(struct winj_inflate *state, const struct winj_huffman *lengths,
+ const struct winj_huffman *distances)
+{
+  static const u2 length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+  static const u1 length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+  static const u2 distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577 };
+  static const u1 distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+  unsigned symbol = 0;
+  unsigned length, distance, extra;
+
+  while (symbol != 256) {
+    if (EXIT_SUCCESS != winj_inflate_symbol(state, lengths, &symbol))
+      return EXIT_FAILURE;
+    else if (symbol < 256) {
+      if (state->dest_pos >= state->dest_len)
+        return EXIT_FAILURE;
+      state->dest[state->dest_pos++] = (u1)symbol;
+    } else if (symbol > 256) {
+      symbol -= 257;
+      if ((symbol >= 29) || (EXIT_SUCCESS != winj_inflate_bits
+                             (state, length_extra[symbol], &extra)))
+        return EXIT_FAILURE;
+      length = length_base[symbol] + extra;
+
+      if ((EXIT_SUCCESS != winj_inflate_symbol
+           (state, distances, &symbol)) || (symbol >= 30) ||
+          (EXIT_SUCCESS != winj_inflate_bits
+           (state, distance_extra[symbol], &extra)))
+        return EXIT_FAILURE;
+      distance = distance_base[symbol] + extra;
+
+      if ((distance > state->dest_pos) ||
+          (length > state->dest_len - state->dest_pos))
+        return EXIT_FAILURE;
+      for (; length; --length, ++state->dest_pos)
+        state->dest[state->dest_pos] =
+          state->dest[state->dest_pos - distance];
+      symbol = 0;
+    }
   }
-  return result;
+  return EXIT_SUCCESS;
 }
 
 /**
- * Attempt to fetch a named class using the default mechanism.  This
- * is available in case a custom <code>find_class</code>
- * implementation wants to supplement rather than entirely replace the
- * default mechanims.  This routine grabs the contents of the
- * <code>WINJ_PATH</code> environment variable (using replacement
- * <code>getenv</code> if provided) and tries prepending each
- * colon-separated segment to build a file system path implied by the
- * fully qualified class name.
+ * Read the code lengths which describe a dynamic Huffman block and
+ * build decoding tables from them.
  *
- * So for example, if <code>WINJ_PATH</code> is
- * <code>/lib:/tmp/classes</code> and the name is
- * <code>java.lang.Object</code> this routine will attempt to open
- * <code>/lib/java/lang/Object.class</code> and
- * <code>/tmp/classes/java/lang/Object.class</code> before giving up.
+ * @param state decompression state
+ * @param lengths destination for literal and length tables
+ * @param distances destination for distance tables
+ * @return EXIT_SUCCESS unless data is invalid or truncated */
+static int
+winj_inflate_dynamic
+(struct winj_inflate *state, struct winj_huffman *lengths,
+ struct winj_huffman *distances)
+{
+  static const u1 order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+  u1 code_lengths[286 + 30];
+  unsigned nlen, ndist, ncode;
+  unsigned index, symbol, repeat;
+  u1 previous;
+
+  memset(code_lengths, 0, sizeof(code_lengths));
+  if ((EXIT_SUCCESS != winj_inflate_bits(state, 5, &nlen)) ||
+      (EXIT_SUCCESS != winj_inflate_bits(state, 5, &ndist)) ||
+      (EXIT_SUCCESS != winj_inflate_bits(state, 4, &ncode)))
+    return EXIT_FAILURE;
+  nlen += 257;
+  ndist += 1;
+  ncode += 4;
+  if ((nlen > 286) || (ndist > 30))
+    return EXIT_FAILURE;
+
+  for (index = 0; index < ncode; ++index)
+    if (EXIT_SUCCESS != winj_inflate_bits(state, 3, &symbol))
+      return EXIT_FAILURE;
+    else code_lengths[order[index]] = (u1)symbol;
+  if (EXIT_SUCCESS != winj_huffman_build(lengths, code_lengths, 19))
+    return EXIT_FAILURE;
+
+  memset(code_lengths, 0, 19);
+  for (index = 0; index < nlen + ndist; ) {
+    if (EXIT_SUCCESS != winj_inflate_symbol(state, lengths, &symbol))
+      return EXIT_FAILURE;
+    else if (symbol < 16) {
+      code_lengths[index++] = (u1)symbol;
+      continue;
+    } else if (symbol == 16) {
+      if (!index || (EXIT_SUCCESS != winj_inflate_bits
+                     (state, 2, &repeat)))
+        return EXIT_FAILURE;
+      previous = code_lengths[index - 1];
+      repeat += 3;
+    } else if (symbol == 17) {
+      if (EXIT_SUCCESS != winj_inflate_bits(state, 3, &repeat))
+        return EXIT_FAILURE;
+      previous = 0;
+      repeat += 3;
+    } else {
+      if (EXIT_SUCCESS != winj_inflate_bits(state, 7, &repeat))
+        return EXIT_FAILURE;
+      previous = 0;
+      repeat += 11;
+    }
+    if (index + repeat > nlen + ndist)
+      return EXIT_FAILURE;
+    while (repeat--)
+      code_lengths[index++] = previous;
+  }
+
+  if (!code_lengths[256] ||
+      (EXIT_SUCCESS != winj_huffman_build(lengths, code_lengths, nlen)) ||
+      (EXIT_SUCCESS != winj_huffman_build
+       (distances, code_lengths + nlen, ndist)))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Decompress raw deflate data as described by RFC 1951 into a buffer
+ * which must be exactly the size of the uncompressed data.
  *
  * @param params parameters for system customization
- * @param name_len fully qualified class name to fetch
- * @param name fully qualified class name to fetch
- * @param bytes destination to place allocated bytes
- * @return EXIT_SUCCESS unless something went wrong */
+ * @param src compressed data
+ * @param src_len number of bytes of compressed data
+ * @param dest destination for uncompressed data
+ * @param dest_len number of bytes of uncompressed data
+ * @return EXIT_SUCCESS unless data is invalid or truncated */
 static int
-winj_find_class_default
-(struct winj_vm_params *params, unsigned name_len, const char *name,
- struct winj_bytes *bytes)
+winj_inflate
+(struct winj_vm_params *params, const u1 *src, unsigned src_len,
+ u1 *dest, unsigned dest_len)
 {
   int result = EXIT_SUCCESS;
-  char *path = NULL;
+  struct winj_inflate state;
+  struct winj_huffman lengths;
+  struct winj_huffman distances;
+  unsigned last = 0;
+  unsigned type = 0;
+
+  memset(&state, 0, sizeof(state));
+  state.src = src;
+  state.src_len = src_len;
+  state.dest = dest;
+  state.dest_len = dest_len;
+
+  while ((EXIT_SUCCESS == result) && !last) {
+    if ((EXIT_SUCCESS != (result = winj_inflate_bits
+                          (&state, 1, &last))) ||
+        (EXIT_SUCCESS != (result = winj_inflate_bits
+                          (&state, 2, &type)))) {
+    } else if (type == 0) { /* stored */
+      unsigned length;
+
+      state.bits = 0;
+      state.bit_count = 0;
+      if (state.src_len - state.src_pos < 4) {
+        result = EXIT_FAILURE;
+      } else if ((length = winj_le_u2(src + state.src_pos)) !=
+                 (~winj_le_u2(src + state.src_pos + 2) & 0xffff)) {
+        result = EXIT_FAILURE;
+      } else if ((state.src_len - state.src_pos - 4 < length) ||
+                 (state.dest_len - state.dest_pos < length)) {
+        result = EXIT_FAILURE;
+      } else {
+        memcpy(dest + state.dest_pos, src + state.src_pos + 4, length);
+        state.src_pos += 4 + length;
+        state.dest_pos += length;
+      }
+    } else if (type == 1) { /* fixed Huffman codes */
+      u1 fixed[288];
+      unsigned ii;
 
-  if (EXIT_SUCCESS != (result = winj_class_get_path
-                       (params, name_len, name, &path))) {
-  } else if (EXIT_SUCCESS != (result = winj_bytes_from_environ_path
-                              (params, "WINJ_PATH", path, bytes))) {
+      for (ii = 0; ii < 288; ++ii)
+        fixed[ii] = (ii < 144) ? 8 : (ii < 256) ? 9 : (ii < 280) ? 7 : 8;
+      winj_huffman_build(&lengths, fixed, 288);
+      memset(fixed, 5, 30);
+      winj_huffman_build(&distances, fixed, 30);
+      result = winj_inflate_codes(&state, &lengths, &distances);
+    } else if (type == 2) { /* dynamic Huffman codes */
+      if (EXIT_SUCCESS == (result = winj_inflate_dynamic
+                           (&state, &lengths, &distances)))
+        result = winj_inflate_codes(&state, &lengths, &distances);
+    } else result = EXIT_FAILURE;
   }
-  winj_free(params, path);
+
+  if (EXIT_SUCCESS != result)
+    result = winj_error(params, "invalid deflate data at byte %u",
+                        state.src_pos);
+  else if (state.dest_pos != dest_len)
+    result = winj_error(params, "inflated %u bytes but expected %u",
+                        state.dest_pos, dest_len);
   return result;
 }
 
+struct winj_archive_member {
+  unsigned name_len;
+  const char *name; /* refers to central directory */
+  u4 name_hash;
+  u2 method;        /* zero when stored and eight when deflated */
+  u4 compressed;
+  u4 size;
+  u4 offset;        /* position of local file header */
+};
+
+struct winj_archive {
+  char *path;
+  struct winj_bytes bytes; /* entire archive */
+
+  unsigned member_count;
+  unsigned member_capacity;
+  struct winj_archive_member *members;
+};
+
+WINJ_HASH_TABLE(archive, archive_member, member);
+
+static void
+winj_archive_cleanup
+(struct winj_vm_params *params, struct winj_archive *archive)
+{
+  if (archive) {
+    winj_free(params, archive->members);
+    winj_bytes_cleanup(params, &archive->bytes);
+    winj_free(params, archive->path);
+  }
+  winj_free(params, archive);
+}
+
 /**
- * Populate a pointer with the class corresponding to a fully qualified
- * class name if one exists or with NULL otherwise.  Either of these
- * conditions is considered success with respect to the return code.
+ * Read the central directory of a ZIP archive into the member table.
+ * ZIP64 extensions and archives split across files are not supported.
+ * Members whose sizes or offset are the placeholder which ZIP64 puts
+ * in the central directory are left out.
  *
- * @param vm virtual machine to search
- * @param name_len number of bytes in length (or 0 for strlen)
- * @param name name to look for, such as <code>java.lang.Object</code>
- * @param class_out destination in which to store class pointer or NULL
- * @return EXIT_SUCCESS unless something went wrong. */
+ * @param params parameters for system customization
+ * @param archive archive with bytes already loaded
+ * @return EXIT_SUCCESS unless the archive could not be understood */
 static int
-winj_vm_class_lookup
-(struct winj_vm *vm, unsigned name_len, const char *name,
- struct winj_class **class_out)
+winj_archive_index
+(struct winj_vm_params *params, struct winj_archive *archive)
 {
   int result = EXIT_SUCCESS;
-  struct winj_class *found = NULL;
-  struct winj_class *current = NULL;
-  u4 top = vm->class_count;
-  u4 bottom = 0;
-  u4 index = 0;
-
-  if (!name_len)
-    name_len = strlen(name);
+  const u1 *value = archive->bytes.value;
+  unsigned count = archive->bytes.count;
+  unsigned end = count;
+  unsigned position = 0;
+  unsigned entries = 0;
+  unsigned ii;
 
-  while (top > bottom) {
-    index = winj_binary_search_step
-      (name_len, name, index, current ? current->name_len : 0,
-       current ? current->name : NULL, current,
-       &top, &bottom, (void**)&found);
-    if (index < top)
-      current = vm->classes[index];
+  /* The end of central directory record is at least 22 bytes and may
+   * be followed by a comment of up to 65535 bytes. */
+  while ((end >= 22) && (count - end <= 65535) &&
+         (winj_le_u4(value + end - 22) != 0x06054b50))
+    --end;
+  if ((end < 22) || (count - end > 65535)) {
+    result = winj_error(params, "%s: missing end of central directory",
+                        archive->path);
+  } else if ((position = winj_le_u4(value + end - 22 + 16)) >
+             end - 22) {
+    result = winj_error(params, "%s: invalid central directory",
+                        archive->path);
+  } else entries = winj_le_u2(value + end - 22 + 10);
+
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < entries); ++ii) {
+    struct winj_archive_member member;
+    struct winj_archive_member *found = NULL;
+
+    memset(&member, 0, sizeof(member));
+    if ((end - 22 - position < 46) ||
+        (winj_le_u4(value + position) != 0x02014b50)) {
+      result = winj_error(params, "%s: invalid central directory "
+                          "entry %u", archive->path, ii);
+    } else {
+      member.method     = winj_le_u2(value + position + 10);
+      member.compressed = winj_le_u4(value + position + 20);
+      member.size       = winj_le_u4(value + position + 24);
+      member.name_len   = winj_le_u2(value + position + 28);
+      member.offset     = winj_le_u4(value + position + 42);
+      member.name       = (const char *)value + position + 46;
+      position += 46 + member.name_len +
+        winj_le_u2(value + position + 30) +
+        winj_le_u2(value + position + 32);
+
+      if (position > end - 22) {
+        result = winj_error(params, "%s: truncated central directory",
+                            archive->path);
+      } else if (!member.name_len ||
+                 (member.name[member.name_len - 1] == '/')) {
+        /* directories are not interesting */
+      } else if ((member.compressed == 0xFFFFFFFF) ||
+                 (member.size == 0xFFFFFFFF) ||
+                 (member.offset == 0xFFFFFFFF)) {
+        winj_warn(params, "%s: skipping %.*s which needs unsupported "
+                  "ZIP64 extensions", archive->path, member.name_len,
+                  member.name);
+      } else if (winj_archive_member_search
+                 (archive, member.name_len, member.name, &found),
+                 found) {
+        /* first entry wins, as with the Java launcher */
+      } else result = winj_archive_member_store
+               (params, archive, &member);
+    }
   }
-
-  if (class_out)
-    *class_out = found;
   return result;
 }
 
 /**
- * Add a class to the list maintained by a virtual machine.
- * This routine maintains the sorted order by class name so that
- * subsequent attempts to look up a class can use binary search.
+ * Open an archive and index its members.  Archives which cannot be
+ * read or understood are kept with no members so that they are not
+ * tried again.
  *
- * @param vm virtual machine to add to
- * @param loaded class to store
- * @return EXIT_SUCCESS unles something went wrong */
+ * @param params parameters for system customization
+ * @param path_len number of bytes in path
+ * @param path file system path of archive
+ * @param archive_out destination for archive
+ * @return EXIT_SUCCESS unless memory could not be allocated */
 static int
-winj_vm_class_store(struct winj_vm *vm, struct winj_class *cls)
+winj_archive_open
+(struct winj_vm_params *params, unsigned path_len, const char *path,
+ struct winj_archive **archive_out)
 {
   int result = EXIT_SUCCESS;
-  struct winj_vm_params *params = vm ? &vm->params : NULL;
-  struct winj_class **next;
-  struct winj_class *found = NULL;
-  struct winj_class *current = NULL;
-  u4 top = vm->class_count;
-  u4 bottom = 0;
-  u4 index = 0;
-
-  if (!cls)
-    result = winj_error(params, "missing class pointer");
+  struct winj_archive *archive = NULL;
+  unsigned found = 0;
 
-  while (top > bottom) {
-    index = winj_binary_search_step
-      (cls->name_len, cls->name, index,
-       current ? current->name_len : 0,
-       current ? current->name : NULL,
-       current, &top, &bottom, (void**)&found);
-    if (index < top)
-      current = vm->classes[index];
+  if (!(archive = winj_calloc(params, 1, sizeof(*archive)))) {
+    result = winj_error(params, "failed to allocate %u bytes for "
+                        "archive", sizeof(*archive));
+  } else if (EXIT_SUCCESS != (result = winj_string_copy
+                              (params, path_len, path,
+                               NULL, &archive->path))) {
+  } else if (EXIT_SUCCESS != winj_bytes_from_path
+             (params, archive->path, &archive->bytes, &found)) {
+  } else if (found && (EXIT_SUCCESS != winj_archive_index
+                       (params, archive))) {
+    winj_free(params, archive->members);
+    archive->members = NULL;
+    archive->member_count = archive->member_capacity = 0;
   }
 
-  if (EXIT_SUCCESS != result) {
-  } else if (found) {
-    result = winj_error
-      (params, "refusing to store class that already exists: "
-       "%.*s", cls->name_len, cls->name);
-  } else if (!(next = winj_realloc
-               (params, vm->classes, sizeof(*vm->classes) *
-                (vm->class_count + 1)))) {
-    result = winj_error
-      (params, "failed to allocate %u bytes for class pointers",
-       sizeof(*vm->classes) * (vm->class_count + 1));
-  } else {
-    vm->classes = next;
-    memmove(&vm->classes[index + 1], &vm->classes[index],
-            sizeof(*vm->classes) * (vm->class_count++ - index));
-    vm->classes[index] = cls;
+  if (EXIT_SUCCESS == result) {
+    *archive_out = archive;
+    archive = NULL;
   }
+  winj_archive_cleanup(params, archive);
   return result;
 }
 
+/**
+ * Fetch the contents of an archive member.  Stored members refer to
+ * the archive bytes directly.
+ *
+ * @param params parameters for system customization
+ * @param archive archive to search
+ * @param filename name of member
+ * @param bytes_out destination for contents of member
+ * @param found_out set to non-zero if the member exists
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_thread_oom(struct winj_thread *thread)
-{
-  /* TODO: throw a preallocated java.lang.OutOfMemoryError instance */
-  return EXIT_FAILURE;
-}
-
-static int
-winj_thread_throw(struct winj_thread *thread, unsigned throwable_len,
-                  const char *throwable_name, const char *format, ...)
+winj_archive_fetch
+(struct winj_vm_params *params, struct winj_archive *archive,
+ const char *filename, struct winj_bytes *bytes_out,
+ unsigned *found_out)
 {
   int result = EXIT_SUCCESS;
-  va_list args;
-
-  /* TODO: lookup throwable_name */
-  va_start(args, format);
-  /* TODO: pack formatted string */
-  /* TODO: create instance of exception winj */
-  if (throwable_name && !throwable_len)
-    throwable_len = strlen(throwable_name);
-  winj_error(&thread->vm->params, "Exception %.*s",
-             throwable_len, throwable_name);
-  winj_vlog(&thread->vm->params, WINJ_LEVEL_ERROR,
-            format, args); /* FIXME */
-  va_end(args);
+  struct winj_archive_member *member = NULL;
+  const u1 *value = archive->bytes.value;
+  unsigned position = 0;
+  u1 *inflated = NULL;
+
+  winj_archive_member_search(archive, 0, filename, &member);
+  if (!member) {
+  } else if ((member->offset > archive->bytes.count) ||
+             (archive->bytes.count - member->offset < 30) ||
+             (winj_le_u4(value + member->offset) != 0x04034b50)) {
+    result = winj_error(params, "%s: invalid local header for %s",
+                        archive->path, filename);
+  } else if ((position = member->offset + 30 +
+              winj_le_u2(value + member->offset + 26) +
+              winj_le_u2(value + member->offset + 28)),
+             (position > archive->bytes.count) ||
+             (archive->bytes.count - position < member->compressed)) {
+    result = winj_error(params, "%s: truncated member %s",
+                        archive->path, filename);
+  } else if (member->method == 0) {
+    if (member->compressed != member->size)
+      result = winj_error(params, "%s: invalid stored size for %s",
+                          archive->path, filename);
+    else {
+      bytes_out->value   = (u1 *)value + position;
+      bytes_out->count   = member->size;
+      bytes_out->offset  = 0;
+      bytes_out->storage = winj_bytes_borrowed;
+    }
+  } else if (member->method != 8) {
+    result = winj_error(params, "%s: unsupported compression %u for %s",
+                        archive->path, member->method, filename);
+  } else if (!(inflated = winj_malloc
+                 (params, (size_t)member->size + 1))) {
+    result = winj_error(params, "failed to allocate %u bytes for %s",
+                        member->size, filename);
+  } else if (EXIT_SUCCESS == (result = winj_inflate
+                              (params, value + position,
+                               member->compressed, inflated,
+                               member->size))) {
+    bytes_out->value   = inflated;
+    bytes_out->count   = member->size;
+    bytes_out->offset  = 0;
+    bytes_out->storage = winj_bytes_allocated;
+    inflated = NULL;
+  }
 
-  /* TODO: check for suitable handler in each frame */
+  if (found_out)
+    *found_out = (EXIT_SUCCESS == result) && member;
+  winj_free(params, inflated);
   return result;
 }
 
 /**
- * Create a synthetic class that has no corresponding class file.
+ * Find the archive for a class path entry, opening it the first time
+ * it is needed.
  *
- * @param vm virtual machine instance in which to define class
- * @param name_len optional length of class name
- * @param name class name
- * @param field_count number of fields
- * @param field_specs specification for each field
- * @param method_count number of methods
- * @param methods specification for each method
- * @param class_out optional destination for defined class
- * */
+ * @param vm virtual machine which keeps open archives
+ * @param path_len number of bytes in path
+ * @param path file system path of archive
+ * @param archive_out destination for archive
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_vm_class_synthetic
-(struct winj_vm *vm, unsigned name_len, const char *name,
- unsigned field_count, struct winj_field *fields,
- unsigned method_count, struct winj_method *methods,
- struct winj_class **class_out)
+winj_vm_archive
+(struct winj_vm *vm, unsigned path_len, const char *path,
+ struct winj_archive **archive_out)
 {
   int result = EXIT_SUCCESS;
-  struct winj_vm_params *params = vm ? &vm->params : NULL;
-  struct winj_class *cls = NULL;
+  struct winj_vm_params *params = &vm->params;
+  struct winj_archive **archives = NULL;
+  struct winj_archive *archive = NULL;
   unsigned ii;
 
-  for (ii = 0; (EXIT_SUCCESS == result) && (ii < field_count); ++ii) {
-    /* TODO: establish fields methods */
-  }
-  for (ii = 0; (EXIT_SUCCESS == result) && (ii < method_count); ++ii) {
-    /* TODO: establish methods */
-  }
-  /* TODO: create link to parent class */
+  for (ii = 0; !archive && (ii < vm->archive_count); ++ii)
+    if (!strncmp(vm->archives[ii]->path, path, path_len) &&
+        !vm->archives[ii]->path[path_len])
+      archive = vm->archives[ii];
 
-  if (!(cls = winj_calloc(params, 1, sizeof(*cls)))) {
-    result = winj_error(params, "failed to allocate %u bytes "
-                        "for class definition", sizeof(*cls));
-  } else if (EXIT_SUCCESS != (result = winj_string_copy
-                              (params, name_len, name,
-                               &cls->name_len, &cls->name))) {
-  } else if (EXIT_SUCCESS != (result = winj_vm_class_store(vm, cls))) {
+  if (archive) {
+  } else if (!(archives = winj_realloc
+               (params, vm->archives, sizeof(*archives) *
+                (vm->archive_count + 1)))) {
+    result = winj_error(params, "failed to allocate %u bytes for "
+                        "archives", sizeof(*archives) *
+                        (vm->archive_count + 1));
   } else {
-    if (class_out)
-      *class_out = cls;
-    cls->access_flags |= WINJ_ACCESS_SYNTHETIC;
-    cls = NULL; /* already stored */
+    vm->archives = archives;
+    if (EXIT_SUCCESS == (result = winj_archive_open
+                         (params, path_len, path, &archive)))
+      vm->archives[vm->archive_count++] = archive;
   }
-  winj_class_cleanup(params, cls);
+
+  if (EXIT_SUCCESS == result)
+    *archive_out = archive;
   return result;
 }
 
+WINJ_HASH_TABLE(classpath, classpath_lookup, lookup);
+
+static void
+winj_classpath_cleanup
+(struct winj_vm_params *params, struct winj_classpath *classpath)
+{
+  unsigned ii;
+
+  for (ii = 0; ii < classpath->lookup_capacity; ++ii)
+    winj_free(params, classpath->lookups[ii].name);
+  winj_free(params, classpath->lookups);
+  winj_free(params, classpath->path);
+  memset(classpath, 0, sizeof(*classpath));
+}
+
 /**
- * Create, validate and store a class.
+ * Make sure remembered lookups apply to the current value of the
+ * class path, forgetting all of them when the value has changed.
  *
- * @param thread place to throw exceptions if things go wrong
- * @param bytes contents of class to steal on success
- * @params loader class loader to associate define class with
- * @params class_out detination for defined class on success
+ * @param params parameters for system customization
+ * @param classpath lookups to check
+ * @param path current value of class path
  * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_thread_class_define
-(struct winj_thread *thread, struct winj_bytes *bytes,
- struct winj_object *loader, struct winj_class **class_out)
+winj_classpath_reset
+(struct winj_vm_params *params, struct winj_classpath *classpath,
+ const char *path)
 {
   int result = EXIT_SUCCESS;
-  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
-  struct winj_class *cls = NULL;
-
-  if (!thread) {
-    result = winj_error(params, "missing thread %p", thread);
-  } else if (!bytes || !bytes->value || !bytes->count) {
-    result = winj_error
-      (params, "missing bytes %p(%u/%p)", bytes,
-       bytes ? bytes->count : 0, bytes ? bytes->value : NULL);
-  } else if (!(cls = winj_malloc
-               (params, sizeof(*cls) + sizeof(*cls->class_file)))) {
-    result = winj_error
-      (params, "failed to allocate %u bytes for class",
-       sizeof(*cls) + sizeof(*cls->class_file));
-  } else { /* single allocation for class and class file */
-    memset(cls, 0, sizeof(*cls));
-    cls->self.cls = thread->vm->class_class;
-    cls->class_file = (struct winj_class_file *)(&cls[1]);
-    memset(cls->class_file, 0, sizeof(*cls->class_file));
-  }
 
-  if (EXIT_SUCCESS != result) {
-  } else if (EXIT_SUCCESS !=
-             (result = winj_class_file_create
-              (params, bytes, cls->class_file))) {
-    winj_thread_throw(thread, 0, "java/lang/ClassFormatError",
-                      "more detail here would be nice");
-  } else if (EXIT_SUCCESS !=
-             (result = winj_class_file_validate
-              (thread, cls->class_file))) {
-  } else if (EXIT_SUCCESS !=
-             (result = winj_class_class_file
-              (params, cls, cls->class_file))) {
-    winj_thread_throw(thread, 0, "java/lang/InternalError",
-                      "failed to connect class and class file");
-  } else if (EXIT_SUCCESS != (result = winj_vm_class_store
-                              (thread->vm, cls))) {
-  } else if (class_out) {
-    *class_out = cls;
-    cls = NULL;
+  if (!classpath->path || strcmp(classpath->path, path)) {
+    winj_classpath_cleanup(params, classpath);
+    result = winj_string_copy
+      (params, strlen(path), path, NULL, &classpath->path);
   }
-  winj_class_cleanup(params, cls);
   return result;
 }
 
 /**
- * Attempt to find a class specified by a fully qualified name.  If
- * the class in question has already been loaded the existing instance
- * will be found.  If not either the <code>find_class</code> supplied
- * by parameters will be called or the default class loading routine
- * will search for class files according to the WINJ_PATH environment
- * variable.
+ * Remember where a file was found on the class path, or that it was
+ * not found at all.
  *
- * @param thread virtual machine thread on which to find class
- * @param name_len optional length of class name (0 for strlen)
- * @param name fully qualified class name
- * @param class_out set to the class if found or NULL if not
- * @return EXIT_SUCCESS unless something went wrong. */
+ * @param params parameters for system customization
+ * @param classpath lookups to update
+ * @param filename relative path of file
+ * @param segment index of entry or WINJ_CLASSPATH_MISSING
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_thread_class_find
-(struct winj_thread *thread, unsigned name_len, const char *name,
- struct winj_class **class_out)
+winj_classpath_remember
+(struct winj_vm_params *params, struct winj_classpath *classpath,
+ const char *filename, unsigned segment)
 {
   int result = EXIT_SUCCESS;
-  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
-  struct winj_bytes bytes = {0};
-  struct winj_class *found = NULL;
-
-  if (name && !name_len)
-    name_len = strlen(name);
-
-  if (!name) {
-    result = winj_error
-      (params, "missing arguments (name=%p/%u)", name, name_len);
-  } else if (EXIT_SUCCESS != winj_vm_class_lookup
-             (thread->vm, name_len, name, &found)) {
-  } else if (found) { /* requested class already loaded? */
-  } else if (params->find_class && EXIT_SUCCESS !=
-             (result = params->find_class
-              (params->context, params, name_len, name, &bytes))) {
-    winj_debug(params, "failed find_class: %.*s", name_len, name);
-  } else if (!bytes.count && EXIT_SUCCESS !=
-             (result = winj_find_class_default
-              (params, name_len, name, &bytes))) {
-    winj_debug(params, "failed find default: %.*s", name_len, name);
-  } else if (!bytes.count) { /* no class found */
-  } else if (EXIT_SUCCESS !=
-             (result = winj_thread_class_define
-              (thread, &bytes, NULL, &found))) {
-  }
+  struct winj_classpath_lookup *found = NULL;
+  struct winj_classpath_lookup lookup = {0};
 
-  if ((EXIT_SUCCESS == result) && class_out) {
-    *class_out = found;
-    found = NULL;
+  winj_classpath_lookup_search(classpath, 0, filename, &found);
+  if (found) {
+    found->segment = segment;
+  } else if (EXIT_SUCCESS != (result = winj_string_copy
+                              (params, strlen(filename), filename,
+                               &lookup.name_len, &lookup.name))) {
+  } else {
+    lookup.segment = segment;
+    if (EXIT_SUCCESS == (result = winj_classpath_lookup_store
+                         (params, classpath, &lookup)))
+      lookup.name = NULL;
   }
-  winj_class_cleanup(params, found);
-  winj_free(params, bytes.value);
+  winj_free(params, lookup.name);
   return result;
 }
 
+/**
+ * Search each entry of a colon separated path held by an environment
+ * variable for a file.  Entries which end in .jar or .zip are
+ * archives to search for a member with the name of the file.  The
+ * entry where each file was found, or the fact that it was not
+ * found, is remembered so later requests for the same file skip
+ * entries known not to have it until the variable changes.
+ *
+ * @param vm virtual machine which keeps open archives
+ * @param environ_variable name of environment variable
+ * @param filename relative path of file to fetch
+ * @param bytes_out destination for contents of file
+ * @param source_out optional destination for path of the file or
+ *        archive which held the contents, which caller must free
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_operand_push
-(struct winj_vm *vm, struct winj_thread *thread, u4 thing)
+winj_bytes_from_environ_path
+(struct winj_vm *vm, const char *environ_variable,
+ const char *filename, struct winj_bytes *bytes_out, char **source_out)
 {
   int result = EXIT_SUCCESS;
-  u4 *next;
+  struct winj_vm_params *params = &vm->params;
+  unsigned filename_length = strlen(filename);
+  unsigned prefix_length = 0;
+  unsigned found = 0;
+  unsigned segment = 0;
+  const char *prefix = NULL;
+  const char *winjpath = NULL;
+  struct winj_classpath_lookup *lookup = NULL;
 
-  if (!thread) {
-    result = winj_error(&vm->params, "missing thread argument");
-  } else if (!(next = winj_realloc
-               (&vm->params, thread->operands,
-                sizeof(*thread->operands) *
-                (thread->operand_count + 1)))) {
-    winj_thread_oom(thread);
-    result = EXIT_FAILURE;
-  } else {
-    thread->operands = next;
-    thread->operands[thread->operand_count++] = thing;
+  if (params && params->getenv)
+    winjpath = params->getenv(params->context, environ_variable);
+  else winjpath = getenv(environ_variable);
+
+  if (!winjpath)
+    winjpath = ".";
+
+  if (EXIT_SUCCESS != (result = winj_classpath_reset
+                       (params, &vm->classpath, winjpath))) {
+  } else if (EXIT_SUCCESS != (result = winj_classpath_lookup_search
+                              (&vm->classpath, filename_length,
+                               filename, &lookup))) {
+  } else if (lookup && (lookup->segment == WINJ_CLASSPATH_MISSING))
+    winjpath = NULL;
+
+  while ((result == EXIT_SUCCESS) && !found && winjpath &&
+         (prefix = winj_path_next(&winjpath, ':', &prefix_length))) {
+    char *path = NULL;
+    unsigned separate = 0;
+    unsigned length = filename_length + prefix_length;
+    struct winj_bytes bytes = {0};
+    struct winj_archive *archive = NULL;
+
+    if (lookup && (segment < lookup->segment)) {
+      ++segment; /* known not to have file */
+      continue;
+    } else if ((prefix_length > 4) &&
+               (!memcmp(prefix + prefix_length - 4, ".jar", 4) ||
+                !memcmp(prefix + prefix_length - 4, ".zip", 4))) {
+      if (EXIT_SUCCESS != (result = winj_vm_archive
+                           (vm, prefix_length, prefix, &archive))) {
+      } else if (EXIT_SUCCESS != (result = winj_archive_fetch
+                                  (params, archive, filename,
+                                   &bytes, &found))) {
+      } else if (found && bytes_out) {
+        *bytes_out = bytes;
+        bytes.value = NULL;
+      }
+      if ((EXIT_SUCCESS == result) && found && source_out)
+        result = winj_string_copy
+          (params, prefix_length, prefix, NULL, source_out);
+      winj_bytes_cleanup(params, &bytes);
+      segment += found ? 0 : 1;
+      continue;
+    }
+
+    if (prefix && prefix_length > 0 &&
+        (prefix[prefix_length - 1] != '/')) {
+      separate = 1;
+      length += 1;
+    }
+
+    if (!(path = winj_malloc(params, length + 1))) {
+      result = winj_error
+        (params, "failed to allocate %u bytes for path", length + 1);
+    } else {
+      memcpy(path, prefix, prefix_length);
+      if (separate)
+        path[prefix_length] = '/';
+      strcpy(path + prefix_length + (separate ? 1 : 0), filename);
+      path[length] = '\0';
+    }
+
+    /* Missing files are ignored so that the next WINJ_PATH entry
+     * can be tried. */
+    if (result != EXIT_SUCCESS) {
+    } else if (EXIT_SUCCESS != (result = winj_bytes_from_path
+                                (params, path, &bytes, &found))) {
+    } else if (found && bytes_out) {
+      *bytes_out = bytes;
+      bytes.value = NULL;
+    }
+    if ((EXIT_SUCCESS == result) && found && source_out) {
+      *source_out = path;
+      path = NULL;
+    }
+    winj_free(params, path);
+    winj_bytes_cleanup(params, &bytes);
+    segment += found ? 0 : 1;
+  }
+
+  if (result != EXIT_SUCCESS) {
+  } else if (lookup && (lookup->segment == (found ? segment :
+                                             WINJ_CLASSPATH_MISSING))) {
+  } else result = winj_classpath_remember
+           (params, &vm->classpath, filename,
+            found ? segment : WINJ_CLASSPATH_MISSING);
+
+  if (!found && bytes_out && (result == EXIT_SUCCESS)) {
+    bytes_out->value = NULL;
+    bytes_out->count = bytes_out->offset = 0;
+    bytes_out->storage = winj_bytes_allocated;
   }
   return result;
 }
 
+/**
+ * Attempt to fetch a named class using the default mechanism.  This
+ * is available in case a custom <code>find_class</code>
+ * implementation wants to supplement rather than entirely replace the
+ * default mechanims.  This routine grabs the contents of the
+ * <code>WINJ_PATH</code> environment variable (using replacement
+ * <code>getenv</code> if provided) and tries prepending each
+ * colon-separated segment to build a file system path implied by the
+ * fully qualified class name.
+ *
+ * So for example, if <code>WINJ_PATH</code> is
+ * <code>/lib:/tmp/classes</code> and the name is
+ * <code>java.lang.Object</code> this routine will attempt to open
+ * <code>/lib/java/lang/Object.class</code> and
+ * <code>/tmp/classes/java/lang/Object.class</code> before giving up.
+ *
+ * Segments which end in <code>.jar</code> or <code>.zip</code> are
+ * archives which are searched for a member named
+ * <code>java/lang/Object.class</code> instead.
+ *
+ * Each virtual machine remembers which segment held each class and
+ * which classes were not found anywhere for as long as
+ * <code>WINJ_PATH</code> keeps the same value.  Files added to the
+ * path later are therefore not noticed by a virtual machine which
+ * has already failed to find them.
+ *
+ * @param vm virtual machine which keeps open archives and lookups
+ * @param name_len fully qualified class name to fetch
+ * @param name fully qualified class name to fetch
+ * @param bytes destination to place allocated bytes
+ * @param source destination for the file or archive which held the
+ *        class, for recording in a snapshot
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_operand_pop
-(struct winj_vm *vm, struct winj_thread *thread, u4 *thing)
+winj_find_class_default
+(struct winj_vm *vm, unsigned name_len, const char *name,
+ struct winj_bytes *bytes, struct winj_source *source)
 {
   int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = &vm->params;
+  char *path = NULL;
 
-  if (!thread) {
-    result = winj_error
-      (&vm->params, "missing thread argument");
-  } else if (!thread->operand_count) {
-    result = winj_error
-      (&vm->params, "operand stack underflow (thread=%p)", thread);
-  } else if (thing) {
-    *thing = thread->operands[--thread->operand_count];
+  if (EXIT_SUCCESS != (result = winj_class_get_path
+                       (params, name_len, name, &path))) {
+  } else if (EXIT_SUCCESS != (result = winj_bytes_from_environ_path
+                              (vm, "WINJ_PATH", path, bytes,
+                               &source->path))) {
+  } else if (source->path && !winj_source_stat(source)) {
+    winj_free(params, source->path); /* cannot tell if it changes */
+    source->path = NULL;
   }
+  winj_free(params, path);
   return result;
 }
 
-int
-winj_nyi(struct winj_vm *vm, struct winj_thread *thread)
+/* === Snapshots
+ * A snapshot holds the bytes of every class which a virtual machine
+ * loaded from the class path, along with a hash table to find them
+ * by name.  When the WINJ_SNAPSHOT environment variable names a file
+ * that exists the file is mapped and classes are defined from it
+ * without searching the class path.  Otherwise the file is written
+ * when the virtual machine is destroyed.  Raw class bytes are kept,
+ * so classes are still parsed; what a snapshot saves is finding and
+ * reading them.  Every position in a snapshot is an offset from its
+ * start so the file can be mapped anywhere.  All numbers are four
+ * byte little endian values:
+ *
+ *   "WINJCDS2", class count, table capacity (a power of two),
+ *   offset of WINJ_PATH value, length of WINJ_PATH value, file size,
+ *   reserved, then one entry per table slot made of name hash,
+ *   name offset (zero for unused slots), name length, class offset,
+ *   class length, source offset, source length, source size and
+ *   source modification time in seconds and nanoseconds.
+ *
+ * The source is the class file or archive which held a class, and
+ * its path is followed by a NUL.  A class whose source is missing or
+ * has a different size or modification time is found on the class
+ * path instead and the snapshot is recorded again.  A snapshot made
+ * with a different WINJ_PATH value or by another version is
+ * replaced, but a file which is not a snapshot at all is left
+ * alone. */
+
+static void
+winj_le_set_u4(u1 *value, u4 number)
 {
-  return winj_error(&vm->params, "opcode not yet implemented");
+  value[0] = (u1)number;
+  value[1] = (u1)(number >> 8);
+  value[2] = (u1)(number >> 16);
+  value[3] = (u1)(number >> 24);
 }
 
-/* static FIXME */ int
-winj_thread_step(struct winj_vm *vm, struct winj_thread *thread)
+/**
+ * Check that a snapshot header makes sense and was made for the
+ * current class path.  Table entries are checked as they are used.
+ *
+ * @param bytes contents of snapshot
+ * @param winjpath current value of class path
+ * @return non-zero if the snapshot can be used */
+static int
+winj_snapshot_valid(const struct winj_bytes *bytes, const char *winjpath)
+{
+  const u1 *value = bytes->value;
+  u4 capacity = 0;
+  u4 path_offset = 0;
+  u4 path_len = 0;
+
+  if ((bytes->count < WINJ_SNAPSHOT_HEADER) ||
+      memcmp(value, WINJ_SNAPSHOT_MAGIC, 8))
+    return 0;
+  capacity = winj_le_u4(value + 12);
+  path_offset = winj_le_u4(value + 16);
+  path_len = winj_le_u4(value + 20);
+  return capacity && !(capacity & (capacity - 1)) &&
+    (capacity <= (bytes->count - WINJ_SNAPSHOT_HEADER) /
+     WINJ_SNAPSHOT_ENTRY) &&
+    (winj_le_u4(value + 24) == bytes->count) &&
+    (path_offset <= bytes->count) &&
+    (path_len <= bytes->count - path_offset) &&
+    (path_len == strlen(winjpath)) &&
+    !memcmp(value + path_offset, winjpath, path_len);
+}
+
+/**
+ * Open the snapshot named by the WINJ_SNAPSHOT environment variable
+ * the first time a class is needed.  A snapshot which is missing or
+ * was made for another class path is recorded when the virtual
+ * machine is destroyed.  A file without the snapshot magic is never
+ * replaced, so snapshots are disabled with a warning instead.
+ *
+ * @param vm virtual machine which keeps the snapshot
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_snapshot_open(struct winj_vm *vm)
 {
   int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = &vm->params;
+  struct winj_snapshot *snapshot = &vm->snapshot;
+  const char *path = NULL;
+  const char *winjpath = NULL;
+  unsigned found = 0;
 
-  u1 opcode = 0x00;
-  /* TODO: find current opcode from thread pc */
-
-  switch (opcode) {
-  case WINJ_OPCODE_NOP: /* that was easy */ break;
-  case WINJ_OPCODE_ACONST_NULL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ICONST_M1:
-    winj_operand_push(vm, thread, (u4)-1); break;
-  case WINJ_OPCODE_ICONST_0:
-    winj_operand_push(vm, thread, 0); break;
-  case WINJ_OPCODE_ICONST_1:
-    winj_operand_push(vm, thread, 1); break;
-  case WINJ_OPCODE_ICONST_2:
-    winj_operand_push(vm, thread, 2); break;
-  case WINJ_OPCODE_ICONST_3:
-    winj_operand_push(vm, thread, 3); break;
-  case WINJ_OPCODE_ICONST_4:
-    winj_operand_push(vm, thread, 4); break;
-  case WINJ_OPCODE_ICONST_5:
-    winj_operand_push(vm, thread, 5); break;
-  case WINJ_OPCODE_LCONST_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LCONST_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FCONST_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FCONST_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FCONST_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DCONST_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DCONST_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_BIPUSH: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_SIPUSH: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LDC: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LDC_W: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LDC2_W: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ILOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LLOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FLOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DLOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ILOAD_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ILOAD_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ILOAD_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ILOAD_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LLOAD_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LLOAD_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LLOAD_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LLOAD_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FLOAD_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FLOAD_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FLOAD_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FLOAD_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DLOAD_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DLOAD_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DLOAD_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DLOAD_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ALOAD_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ALOAD_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ALOAD_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ALOAD_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_AALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_BALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_CALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_SALOAD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FSTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DSTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISTORE_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISTORE_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISTORE_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISTORE_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSTORE_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSTORE_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSTORE_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSTORE_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FSTORE_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FSTORE_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FSTORE_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FSTORE_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DSTORE_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DSTORE_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DSTORE_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DSTORE_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ASTORE_0: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ASTORE_1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ASTORE_2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ASTORE_3: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_AASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_BASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_CASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_SASTORE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_POP: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_POP2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DUP: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DUP_X1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DUP_X2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DUP2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DUP2_X1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DUP2_X2: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_SWAP: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IADD: {
-    u4 term1;
-    u4 term2;
-
-    if (EXIT_SUCCESS != (result = winj_operand_pop
-                         (vm, thread, &term2))) {
-    } else if (EXIT_SUCCESS != (result = winj_operand_pop
-                                (vm, thread, &term1))) {
-    } else {
-      result = winj_operand_push(vm, thread, term1 + term2);
-    }
-  } break;
-  case WINJ_OPCODE_LADD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FADD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DADD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISUB: {
-    u4 term1;
-    u4 term2;
-
-    if (EXIT_SUCCESS != (result = winj_operand_pop
-                         (vm, thread, &term2))) {
-    } else if (EXIT_SUCCESS != (result = winj_operand_pop
-                                (vm, thread, &term1))) {
-    } else {
-        result = winj_operand_push(vm, thread, term1 - term2);
-    }
-  } break;
-  case WINJ_OPCODE_LSUB: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FSUB: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DSUB: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IMUL: {
-    u4 factor1;
-    u4 factor2;
-
-    if (EXIT_SUCCESS != (result = winj_operand_pop
-                         (vm, thread, &factor2))) {
-    } else if (EXIT_SUCCESS != (result = winj_operand_pop
-                                (vm, thread, &factor1))) {
-    } else {
-      result = winj_operand_push(vm, thread, factor1 * factor2);
-    }
-    } break;
-  case WINJ_OPCODE_LMUL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FMUL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DMUL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IDIV: {
-    u4 numerator;
-    u4 denominator;
-
-    if (EXIT_SUCCESS != (result = winj_operand_pop
-                         (vm, thread, &denominator))) {
-    } else if (EXIT_SUCCESS != (result = winj_operand_pop
-                                (vm, thread, &numerator))) {
-    } else if (denominator == 0) {
-      winj_thread_throw
-        (thread, 0, "java/lang/ArithmeticException",
-         "division by zero: %u / %u", numerator, denominator);
+  if (params->getenv) {
+    path = params->getenv(params->context, "WINJ_SNAPSHOT");
+    winjpath = params->getenv(params->context, "WINJ_PATH");
+  } else {
+    path = getenv("WINJ_SNAPSHOT");
+    winjpath = getenv("WINJ_PATH");
+  }
+  if (!winjpath)
+    winjpath = ".";
+
+  snapshot->state = winj_snapshot_disabled;
+  if (!path || !*path) {
+  } else if (EXIT_SUCCESS != (result = winj_string_copy
+                              (params, strlen(path), path,
+                               NULL, &snapshot->path))) {
+  } else if (EXIT_SUCCESS != (result = winj_bytes_from_path
+                              (params, snapshot->path,
+                               &snapshot->bytes, &found))) {
+  } else if (found && winj_snapshot_valid(&snapshot->bytes, winjpath)) {
+    snapshot->state = winj_snapshot_loaded;
+  } else {
+    if (!found) {
+      snapshot->state = winj_snapshot_recording;
+    } else if ((snapshot->bytes.count < 8) ||
+               memcmp(snapshot->bytes.value, WINJ_SNAPSHOT_MAGIC, 7)) {
+      winj_warn(params, "%s is not a snapshot so it will be left alone",
+                snapshot->path);
     } else {
-      result = winj_operand_push
-        (vm, thread, numerator / denominator);
+      winj_debug(params, "replacing snapshot %s", snapshot->path);
+      snapshot->state = winj_snapshot_recording;
     }
-  } break;
-  case WINJ_OPCODE_LDIV: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FDIV: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DDIV: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IREM: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LREM: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FREM: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DREM: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INEG: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LNEG: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FNEG: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DNEG: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISHL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSHL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ISHR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LSHR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IUSHR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LUSHR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IAND: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LAND: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IOR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LOR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IXOR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LXOR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IINC: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_I2L: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_I2F: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_I2D: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_L2I: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_L2F: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_L2D: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_F2I: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_F2L: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_F2D: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_D2I: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_D2L: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_D2F: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_I2B: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_I2C: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_I2S: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LCMP: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FCMPL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FCMPG: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DCMPL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DCMPG: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFEQ: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFNE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFLT: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFGE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFGT: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFLE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ICMPEQ: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ICMPNE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ICMPLT: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ICMPGE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ICMPGT: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ICMPLE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ACMPEQ: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IF_ACMPNE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_GOTO: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_JSR: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_RET: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_TABLESWITCH: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LOOKUPSWITCH: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IRETURN: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_LRETURN: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_FRETURN: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_DRETURN: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ARETURN: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_RETURN: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_GETSTATIC: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_PUTSTATIC: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_GETFIELD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_PUTFIELD: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INVOKEVIRTUAL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INVOKESPECIAL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INVOKESTATIC: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INVOKEINTERFACE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INVOKEDYNAMIC: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_NEW: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_NEWARRAY: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ANEWARRAY: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ARRAYLENGTH: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_ATHROW: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_CHECKCAST: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_INSTANCEOF: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_MONITORENTER: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_MONITOREXIT: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_WIDE: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_MULTIANEWARRAY: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFNULL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IFNONNULL: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_GOTO_W: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_JSR_W: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_BREAKPOINT: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IMPDEP1: winj_nyi(vm, thread); break;
-  case WINJ_OPCODE_IMPDEP2: winj_nyi(vm, thread); break;
-  default: winj_nyi(vm, thread); break;
+    winj_bytes_cleanup(params, &snapshot->bytes);
+    memset(&snapshot->bytes, 0, sizeof(snapshot->bytes));
   }
   return result;
 }
 
-void
-winj_vm_object_cleanup(struct winj_vm *vm, struct winj_object *obj)
+/**
+ * Fetch the bytes of a class from the snapshot, if there is one.
+ * The bytes returned are part of the snapshot mapping.  A class
+ * whose source has changed since it was recorded is left for the
+ * class path to find.
+ *
+ * @param vm virtual machine which keeps the snapshot
+ * @param name_len number of bytes in name
+ * @param name fully qualified class name
+ * @param bytes_out destination for class bytes (unchanged if absent)
+ * @param source_out destination for source of class (unchanged if
+ *        absent), which caller must clean up
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_snapshot_fetch
+(struct winj_vm *vm, unsigned name_len, const char *name,
+ struct winj_bytes *bytes_out, struct winj_source *source_out)
 {
-  struct winj_vm_params *params = vm ? &vm->params : NULL;
-
-  if (obj) {
-    if (obj->cls == vm->class_array) {
-      struct winj_array *array = (struct winj_array *)obj;
-      winj_free(params, array->elements);
+  int result = EXIT_SUCCESS;
+  struct winj_snapshot *snapshot = &vm->snapshot;
+  struct winj_source source = {0};
+  const u1 *value = NULL;
+  const u1 *entry = NULL;
+  u4 hash = winj_name_hash(name_len, name);
+  u4 capacity = 0;
+  u4 name_offset = 0;
+  u4 offset = 0;
+  u4 count = 0;
+  u4 source_offset = 0;
+  u4 source_len = 0;
+  u4 ii;
+
+  if (snapshot->state == winj_snapshot_unopened)
+    result = winj_vm_snapshot_open(vm);
+
+  if ((EXIT_SUCCESS == result) &&
+      (snapshot->state == winj_snapshot_loaded)) {
+    value = snapshot->bytes.value;
+    capacity = winj_le_u4(value + 12);
+    for (ii = 0; ii < capacity; ++ii) {
+      entry = value + WINJ_SNAPSHOT_HEADER + WINJ_SNAPSHOT_ENTRY *
+        ((hash + ii) & (capacity - 1));
+      if (!(name_offset = winj_le_u4(entry + 4)))
+        break;
+      else if ((winj_le_u4(entry) != hash) ||
+               (winj_le_u4(entry + 8) != name_len)) {
+      } else if ((name_offset > snapshot->bytes.count) ||
+                 (name_len > snapshot->bytes.count - name_offset) ||
+                 ((offset = winj_le_u4(entry + 12)) >
+                  snapshot->bytes.count) ||
+                 ((count = winj_le_u4(entry + 16)) >
+                  snapshot->bytes.count - offset) ||
+                 ((source_offset = winj_le_u4(entry + 20)) >
+                  snapshot->bytes.count) ||
+                 ((source_len = winj_le_u4(entry + 24)) >=
+                  snapshot->bytes.count - source_offset) ||
+                 value[source_offset + source_len]) {
+        result = winj_error(&vm->params, "%s: invalid entry in slot %u",
+                            snapshot->path, (hash + ii) & (capacity - 1));
+        break;
+      } else if (memcmp(value + name_offset, name, name_len)) {
+      } else if ((source.path = (char *)value + source_offset),
+                 !winj_source_stat(&source) ||
+                 (source.size     != winj_le_u4(entry + 28)) ||
+                 (source.mtime    != winj_le_u4(entry + 32)) ||
+                 (source.mtime_ns != winj_le_u4(entry + 36))) {
+        winj_debug(&vm->params, "%s: %.*s changed since snapshot",
+                   snapshot->path, name_len, name);
+        snapshot->stale = 1;
+        break;
+      } else if (EXIT_SUCCESS == (result = winj_string_copy
+                                  (&vm->params, source_len,
+                                   source.path, NULL,
+                                   &source_out->path))) {
+        source_out->size     = source.size;
+        source_out->mtime    = source.mtime;
+        source_out->mtime_ns = source.mtime_ns;
+        bytes_out->value   = (u1 *)value + offset;
+        bytes_out->count   = count;
+        bytes_out->offset  = 0;
+        bytes_out->storage = winj_bytes_borrowed;
+        break;
+      } else break;
     }
-    winj_free(params, obj);
   }
+  return result;
 }
 
+/**
+ * Write a snapshot of every class loaded from the class path if the
+ * virtual machine is recording one or found that the one it loaded
+ * is out of date.  The snapshot is written to a temporary file first
+ * so that other processes never map one which is incomplete.
+ *
+ * @param vm virtual machine with classes to record
+ * @return EXIT_SUCCESS unless something went wrong */
 static int
-winj_type_parse
-(struct winj_vm_params *params,
- unsigned desc_len, const char *desc, const char **next_out,
- struct winj_argument *argument_out)
+winj_vm_snapshot_save(struct winj_vm *vm)
 {
   int result = EXIT_SUCCESS;
-  const char *next = NULL;
-  struct winj_argument argument = {0};
+  struct winj_vm_params *params = &vm->params;
+  struct winj_snapshot *snapshot = &vm->snapshot;
+  const char *winjpath = NULL;
+  u4 path_len = 0;
+  u4 class_count = 0;
+  u4 capacity = 8;
+  u4 size = WINJ_SNAPSHOT_HEADER;
+  u4 position = 0;
+  u1 *image = NULL;
+  char *temporary = NULL;
+  unsigned temporary_len = 0;
+  FILE *ff = NULL;
+  unsigned ii;
 
-  if (desc && !desc_len)
-    desc_len = strlen(desc);
-  if (!desc || !desc_len || !*desc) {
-    result = winj_error(params, "empty type descriptor");
-  } else {
-    next = desc + 1;
+  if ((snapshot->state != winj_snapshot_recording) &&
+      !((snapshot->state == winj_snapshot_loaded) && snapshot->stale))
+    return result;
 
-    switch (*desc) {
-    case 'V': argument.argtype = WINJ_TYPE_VOID;    break;
-    case 'Z': argument.argtype = WINJ_TYPE_BOOLEAN; break;
-    case 'B': argument.argtype = WINJ_TYPE_BYTE;    break;
-    case 'C': argument.argtype = WINJ_TYPE_CHAR;    break;
-    case 'S': argument.argtype = WINJ_TYPE_SHORT;   break;
-    case 'I': argument.argtype = WINJ_TYPE_INT;     break;
-    case 'J': argument.argtype = WINJ_TYPE_LONG;    break;
-    case 'F': argument.argtype = WINJ_TYPE_FLOAT;   break;
-    case 'D': argument.argtype = WINJ_TYPE_DOUBLE;  break;
-    case 'L': {
-      const char *end = NULL;
-      if (!(end = winj_strnchr(desc + 1, ';', desc_len - 1))) {
-        result = winj_error(params, "missing object terminator");
-      } else {
-        next = end + 1;
-        argument.argtype = WINJ_TYPE_OBJECT;
-        argument.class_name = desc + 1;
-        argument.class_name_len = desc_len - 1 - (end - desc);
-      }
-    } break;
-    case '[': {
-      if (EXIT_SUCCESS !=
-          (result = winj_type_parse
-           (params, desc_len - 1, desc + 1, &next, &argument))) {
-      } else argument.array_count++;
-    } break;
-    default:
-      result = winj_error
-        (params, "unrecognized type descriptor: %c (%u)",
-         *desc, (unsigned)*desc);
+  if (params->getenv)
+    winjpath = params->getenv(params->context, "WINJ_PATH");
+  else winjpath = getenv("WINJ_PATH");
+  if (!winjpath)
+    winjpath = ".";
+  path_len = strlen(winjpath);
+  size += path_len;
+
+  for (ii = 0; ii < vm->class_capacity; ++ii) {
+    struct winj_class *cls = vm->classes[ii];
+    if (cls && cls->class_file && cls->class_file->bytes.value &&
+        cls->class_file->source.path) {
+      ++class_count;
+      size += cls->name_len + cls->class_file->bytes.count +
+        strlen(cls->class_file->source.path) + 1;
     }
   }
+  while (capacity < 2 * class_count)
+    capacity *= 2;
+  size += capacity * WINJ_SNAPSHOT_ENTRY;
 
-  if (EXIT_SUCCESS == result) {
-    if (argument_out)
-      *argument_out = argument;
-    if (next_out)
-      *next_out = next;
+  if (!(image = winj_calloc(params, 1, size))) {
+    result = winj_error(params, "failed to allocate %u bytes for "
+                        "snapshot", size);
+  } else if (EXIT_SUCCESS != (result = winj_string_concat
+                              (params, strlen(snapshot->path),
+                               snapshot->path, 4, ".tmp",
+                               &temporary_len, &temporary))) {
+  } else {
+    memcpy(image, WINJ_SNAPSHOT_MAGIC, 8);
+    winj_le_set_u4(image + 8, class_count);
+    winj_le_set_u4(image + 12, capacity);
+    position = WINJ_SNAPSHOT_HEADER + capacity * WINJ_SNAPSHOT_ENTRY;
+    winj_le_set_u4(image + 16, position);
+    winj_le_set_u4(image + 20, path_len);
+    winj_le_set_u4(image + 24, size);
+    memcpy(image + position, winjpath, path_len);
+    position += path_len;
+
+    for (ii = 0; ii < vm->class_capacity; ++ii) {
+      struct winj_class *cls = vm->classes[ii];
+      struct winj_bytes *bytes = NULL;
+      struct winj_source *source = NULL;
+      u1 *entry = NULL;
+      u4 index;
+
+      if (!cls || !cls->class_file || !cls->class_file->bytes.value ||
+          !cls->class_file->source.path)
+        continue;
+      bytes = &cls->class_file->bytes;
+      source = &cls->class_file->source;
+      for (index = winj_name_hash(cls->name_len, cls->name);
+           winj_le_u4((entry = image + WINJ_SNAPSHOT_HEADER +
+                       WINJ_SNAPSHOT_ENTRY * (index & (capacity - 1)))
+                      + 4); ++index)
+        ; /* linear probing */
+      winj_le_set_u4(entry, winj_name_hash(cls->name_len, cls->name));
+      winj_le_set_u4(entry + 4, position);
+      winj_le_set_u4(entry + 8, cls->name_len);
+      memcpy(image + position, cls->name, cls->name_len);
+      position += cls->name_len;
+      winj_le_set_u4(entry + 12, position);
+      winj_le_set_u4(entry + 16, bytes->count);
+      memcpy(image + position, bytes->value, bytes->count);
+      position += bytes->count;
+      winj_le_set_u4(entry + 20, position);
+      winj_le_set_u4(entry + 24, strlen(source->path));
+      winj_le_set_u4(entry + 28, source->size);
+      winj_le_set_u4(entry + 32, source->mtime);
+      winj_le_set_u4(entry + 36, source->mtime_ns);
+      strcpy((char *)image + position, source->path);
+      position += strlen(source->path) + 1;
+    }
+
+    if (!(ff = fopen(temporary, "wb"))) {
+      result = winj_error(params, "failed to create \"%s\": %s",
+                          temporary, strerror(errno));
+    } else if (fwrite(image, 1, size, ff) != size) {
+      result = winj_error(params, "failed to write \"%s\": %s",
+                          temporary, strerror(errno));
+    }
+    if (ff && fclose(ff) && (EXIT_SUCCESS == result))
+      result = winj_error(params, "failed to write \"%s\": %s",
+                          temporary, strerror(errno));
+
+    if (EXIT_SUCCESS != result) {
+      remove(temporary);
+    } else if (rename(temporary, snapshot->path)) {
+      result = winj_error(params, "failed to rename \"%s\": %s",
+                          temporary, strerror(errno));
+      remove(temporary);
+    }
   }
+  winj_free(params, temporary);
+  winj_free(params, image);
   return result;
 }
 
-int
-winj_arguments_parse
-(struct winj_vm_params *params,
- unsigned desc_len, const char *desc, enum winj_type *return_type,
- unsigned *argument_count_out, struct winj_argument **arguments_out)
+/**
+ * Populate a pointer with the class corresponding to a fully qualified
+ * class name if one exists or with NULL otherwise.  Either of these
+ * conditions is considered success with respect to the return code.
+ *
+ * @param vm virtual machine to search
+ * @param name_len number of bytes in length (or 0 for strlen)
+ * @param name name to look for, such as <code>java.lang.Object</code>
+ * @param class_out destination in which to store class pointer or NULL
+ * @return EXIT_SUCCESS unless something went wrong. */
+static int
+winj_vm_class_lookup
+(struct winj_vm *vm, unsigned name_len, const char *name,
+ struct winj_class **class_out)
 {
   int result = EXIT_SUCCESS;
-  unsigned count = 0;
-  struct winj_argument *argarray = NULL;
-  const char *open = NULL;
-  const char *close = NULL;
+  struct winj_class *found = NULL;
+  struct winj_class *current = NULL;
+  u4 hash;
+  u4 index;
 
-  if (desc && !desc_len)
-    desc_len = strlen(desc);
+  if (!name_len)
+    name_len = strlen(name);
+  hash = winj_name_hash(name_len, name);
+
+  for (index = hash; vm->class_capacity &&
+         (current = vm->classes[index & (vm->class_capacity - 1)]);
+       ++index)
+    if ((current->name_hash == hash) &&
+        (current->name_len == name_len) &&
+        !memcmp(current->name, name, name_len)) {
+      found = current;
+      break;
+    }
 
-  if (!(open = winj_strnchr(desc, '(', desc_len))) {
-    result = winj_error(params, "missing open parenthesis");
-  } else if (!(close = winj_strnchr
-               (open, ')', desc_len - (open - desc)))) {
-    result = winj_error(params, "missing close parenthesis");
+  if (class_out)
+    *class_out = found;
+  return result;
+}
+
+/**
+ * Add a class to the hash table maintained by a virtual machine.
+ * The table is doubled in size whenever it becomes three quarters
+ * full, so storing classes takes amortized constant time.
+ *
+ * @param vm virtual machine to add to
+ * @param loaded class to store
+ * @return EXIT_SUCCESS unles something went wrong */
+static int
+winj_vm_class_store(struct winj_vm *vm, struct winj_class *cls)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = vm ? &vm->params : NULL;
+  struct winj_class **next = NULL;
+  struct winj_class *found = NULL;
+  u4 capacity = vm->class_capacity;
+  u4 index;
+  u4 ii;
+
+  if (!cls) {
+    result = winj_error(params, "missing class pointer");
+  } else if (EXIT_SUCCESS != (result = winj_vm_class_lookup
+                              (vm, cls->name_len, cls->name, &found))) {
+  } else if (found) {
+    result = winj_error
+      (params, "refusing to store class that already exists: "
+       "%.*s", cls->name_len, cls->name);
+  } else if (((vm->class_count + 1) * 4 > capacity * 3) &&
+             !(next = winj_calloc
+               (params, capacity = capacity ? (capacity * 2) : 64,
+                sizeof(*next)))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for class pointers",
+       sizeof(*next) * capacity);
   } else {
-    const char *next = open + 1;
+    if (next) {
+      for (ii = 0; ii < vm->class_capacity; ++ii)
+        if (vm->classes[ii]) {
+          for (index = vm->classes[ii]->name_hash;
+               next[index & (capacity - 1)]; ++index)
+            ; /* linear probing */
+          next[index & (capacity - 1)] = vm->classes[ii];
+        }
+      winj_free(params, vm->classes);
+      vm->classes = next;
+      vm->class_capacity = capacity;
+    }
 
-    while ((EXIT_SUCCESS == result) && (next < close)) {
-      struct winj_argument *argnext = NULL;
-      struct winj_argument argument;
+    cls->name_hash = winj_name_hash(cls->name_len, cls->name);
+    for (index = cls->name_hash;
+         vm->classes[index & (capacity - 1)]; ++index)
+      ; /* linear probing */
+    vm->classes[index & (capacity - 1)] = cls;
+    vm->class_count++;
+  }
+  return result;
+}
 
-      if (EXIT_SUCCESS !=
-          (result = winj_type_parse
-           (params, close - next, next, &next, &argument))) {
-      } else if (!(argnext = winj_realloc
-                   (params, argarray, (count + 1) *
-                    sizeof(*argarray)))) {
-        result = winj_error(params, "failed to allocate %u bytes",
-                            (count + 1) * sizeof(*argarray));
-      } else {
-        argarray = argnext;
-        argarray[count++] = argument;
-      }
+static int
+winj_thread_throw(struct winj_thread *thread, unsigned throwable_len,
+                  const char *throwable_name, const char *format, ...)
+{
+  int result = EXIT_SUCCESS;
+  va_list args;
+
+  /* TODO: lookup throwable_name */
+  va_start(args, format);
+  /* TODO: pack formatted string */
+  /* TODO: create instance of exception winj */
+  if (throwable_name && !throwable_len)
+    throwable_len = strlen(throwable_name);
+  winj_error(&thread->vm->params, "Exception %.*s",
+             throwable_len, throwable_name);
+  winj_vlog(&thread->vm->params, WINJ_LEVEL_ERROR,
+            format, args); /* FIXME */
+  va_end(args);
+  thread->flags |= winj_thread_exception;
+
+  /* TODO: check for suitable handler in each frame */
+  return result;
+}
+
+static int
+winj_class_intrinsics
+(struct winj_vm_params *params, struct winj_class *cls,
+ unsigned name_len, const char *name, int declare);
+static int
+winj_vm_class_intrinsic
+(struct winj_vm *vm, unsigned name_len, const char *name,
+ struct winj_class **class_out);
+
+/**
+ * Create a synthetic class that has no corresponding class file.
+ * Intrinsics registered for the class are declared as methods too.
+ *
+ * @param vm virtual machine instance in which to define class
+ * @param name_len optional length of class name
+ * @param name class name
+ * @param parent name of super class or NULL for none
+ * @param field_count number of instance fields
+ * @param field_specs specification for each field
+ * @param method_count number of methods
+ * @param methods specification for each method
+ * @param class_out optional destination for defined class
+ * */
+static int
+winj_vm_class_synthetic
+(struct winj_vm *vm, unsigned name_len, const char *name,
+ const char *parent, unsigned field_count, struct winj_field *fields,
+ unsigned method_count, struct winj_method *methods,
+ struct winj_class **class_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = vm ? &vm->params : NULL;
+  struct winj_class *cls = NULL;
+  struct winj_class *super = NULL;
+  unsigned ii;
+
+  if (!(cls = winj_vm_space_take(vm, sizeof(*cls)))) {
+    result = winj_error(params, "failed to allocate %u bytes "
+                        "for class definition", sizeof(*cls));
+  } else if (parent && (EXIT_SUCCESS != (result = winj_vm_class_lookup
+                                         (vm, 0, parent, &super)))) {
+  } else if (parent && !super) {
+    result = winj_error(params, "missing parent class %s", parent);
+  }
+
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < field_count); ++ii) {
+    struct winj_field field = fields[ii];
+    field.name = NULL;
+
+    if (field.access_flags & WINJ_ACCESS_STATIC) {
+      result = winj_error(params, "synthetic static field: %s",
+                          fields[ii].name);
+    } else if (EXIT_SUCCESS != (result = winj_string_copy
+                                (params, fields[ii].name_len,
+                                 fields[ii].name, &field.name_len,
+                                 &field.name))) {
+    } else if (EXIT_SUCCESS != (result = winj_class_field_store
+                                (params, cls, &field))) {
+    } else field.name = NULL;
+    winj_free(params, field.name);
+  }
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < method_count); ++ii) {
+    struct winj_method method = methods[ii];
+    method.name = NULL;
+
+    if (EXIT_SUCCESS != (result = winj_string_copy
+                         (params, methods[ii].name_len, methods[ii].name,
+                          &method.name_len, &method.name))) {
+    } else if (EXIT_SUCCESS != (result = winj_method_signature
+                                (params, &method))) {
+    } else if ((method.access_flags & WINJ_ACCESS_STATIC) &&
+               (EXIT_SUCCESS != (result = winj_class_static_method_store
+                                 (params, cls, &method)))) {
+    } else if (!(method.access_flags & WINJ_ACCESS_STATIC) &&
+               (EXIT_SUCCESS != (result = winj_class_method_store
+                                 (params, cls, &method)))) {
+    } else {
+      method.name = NULL;
+      method.signature.types = NULL;
     }
+    winj_free(params, method.name);
+    winj_free(params, method.signature.types);
   }
 
-  if (EXIT_SUCCESS == result) {
-    if (arguments_out) {
-      *arguments_out = argarray;
-      argarray = NULL;
+  if (EXIT_SUCCESS != result) {
+  } else if (EXIT_SUCCESS != (result = winj_class_intrinsics
+                              (params, cls, name_len, name, 1))) {
+  } else if (EXIT_SUCCESS != (result = winj_string_copy
+                              (params, name_len, name,
+                               &cls->name_len, &cls->name))) {
+  } else if (EXIT_SUCCESS != (result = winj_class_link
+                              (params, cls, super, 0, NULL))) {
+  } else if (EXIT_SUCCESS != (result = winj_vm_class_store(vm, cls))) {
+  } else {
+    if (class_out)
+      *class_out = cls;
+    cls->access_flags |= WINJ_ACCESS_SYNTHETIC;
+    cls->self.cls = vm->class_class; /* NULL while creating the vm */
+    cls = NULL; /* already stored */
+  }
+  winj_class_cleanup(vm, cls);
+  return result;
+}
+
+/**
+ * Create, validate and store a class.
+ *
+ * @param thread place to throw exceptions if things go wrong
+ * @param bytes contents of class to steal on success
+ * @params loader class loader to associate define class with
+ * @params class_out detination for defined class on success
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_thread_class_find
+(struct winj_thread *thread, unsigned name_len, const char *name,
+ struct winj_class **class_out);
+
+static int
+winj_thread_class_define
+(struct winj_thread *thread, struct winj_bytes *bytes,
+ struct winj_object *loader, struct winj_class **class_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
+  struct winj_class *cls = NULL;
+  struct winj_class *super = NULL;
+  struct winj_class **ifaces = NULL;
+  const char *super_name = NULL;
+  unsigned super_name_len = 0;
+  unsigned ii;
+
+  if (!thread) {
+    result = winj_error(params, "missing thread %p", thread);
+  } else if (!bytes || !bytes->value || !bytes->count) {
+    result = winj_error
+      (params, "missing bytes %p(%u/%p)", bytes,
+       bytes ? bytes->count : 0, bytes ? bytes->value : NULL);
+  } else if (!(cls = winj_vm_space_take
+               (thread->vm, sizeof(*cls) + sizeof(*cls->class_file)))) {
+    result = winj_error
+      (params, "failed to allocate %u bytes for class",
+       sizeof(*cls) + sizeof(*cls->class_file));
+  } else { /* single allocation for class and class file */
+    cls->self.cls = thread->vm->class_class;
+    cls->class_file = (struct winj_class_file *)(&cls[1]);
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (EXIT_SUCCESS !=
+             (result = winj_class_file_create
+              (params, bytes, cls->class_file))) {
+    winj_thread_throw(thread, 0, "java/lang/ClassFormatError",
+                      "more detail here would be nice");
+  } else if (EXIT_SUCCESS !=
+             (result = winj_class_file_validate
+              (thread, cls->class_file))) {
+  } else if (EXIT_SUCCESS !=
+             (result = winj_class_class_file
+              (params, cls, cls->class_file))) {
+    winj_thread_throw(thread, 0, "java/lang/InternalError",
+                      "failed to connect class and class file");
+  } else if (EXIT_SUCCESS != (result = winj_class_intrinsics
+                              (params, cls, cls->name_len, cls->name,
+                               0))) {
+  } else if (!cls->class_file->super_class) {
+  } else if (EXIT_SUCCESS !=
+             (result = winj_cpool_get_class_name
+              (params, cls->class_file, cls->class_file->super_class,
+               &super_name_len, &super_name))) {
+    winj_thread_throw(thread, 0, "java/lang/ClassFormatError",
+                      "invalid super class for %.*s",
+                      cls->name_len, cls->name);
+  } else if (EXIT_SUCCESS != (result = winj_thread_class_find
+                              (thread, super_name_len, super_name,
+                               &super))) {
+  } else if (!super) {
+    winj_thread_throw(thread, 0, "java/lang/NoClassDefFoundError",
+                      "%.*s", super_name_len, super_name);
+    result = EXIT_FAILURE;
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (cls->class_file->iface_count &&
+             !(ifaces = winj_calloc(params, cls->class_file->iface_count,
+                                    sizeof(*ifaces)))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate interfaces of %.*s",
+                      cls->name_len, cls->name);
+    result = EXIT_FAILURE;
+  }
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < cls->class_file->iface_count); ++ii) {
+    const char *iface_name = NULL;
+    unsigned iface_name_len = 0;
+
+    if (EXIT_SUCCESS != (result = winj_cpool_get_class_name
+                         (params, cls->class_file,
+                          cls->class_file->ifaces[ii],
+                          &iface_name_len, &iface_name))) {
+      winj_thread_throw(thread, 0, "java/lang/ClassFormatError",
+                        "invalid interface for %.*s",
+                        cls->name_len, cls->name);
+    } else if (EXIT_SUCCESS != (result = winj_thread_class_find
+                                (thread, iface_name_len, iface_name,
+                                 &ifaces[ii]))) {
+    } else if (!ifaces[ii]) {
+      winj_thread_throw(thread, 0, "java/lang/NoClassDefFoundError",
+                        "%.*s", iface_name_len, iface_name);
+      result = EXIT_FAILURE;
+    } else if (!(ifaces[ii]->access_flags & WINJ_ACCESS_INTERFACE)) {
+      winj_thread_throw(thread, 0,
+                        "java/lang/IncompatibleClassChangeError",
+                        "%.*s is not an interface",
+                        iface_name_len, iface_name);
+      result = EXIT_FAILURE;
     }
-    if (argument_count_out)
-      *argument_count_out = count;
   }
-  winj_free(params, argarray);
+
+  if (EXIT_SUCCESS != result) {
+  } else if (EXIT_SUCCESS != (result = winj_class_link
+                              (params, cls, super,
+                               cls->class_file->iface_count, ifaces))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to link %.*s", cls->name_len, cls->name);
+  } else if (EXIT_SUCCESS != (result = winj_vm_class_store
+                              (thread->vm, cls))) {
+  } else if (class_out) {
+    *class_out = cls;
+    cls = NULL;
+  }
+  winj_free(params, ifaces);
+  winj_class_cleanup(thread ? thread->vm : NULL, cls);
+  return result;
+}
+
+/**
+ * Attempt to find a class specified by a fully qualified name.  If
+ * the class in question has already been loaded the existing instance
+ * will be found.  If not any <code>find_class</code> supplied by
+ * parameters is called first, so that an embedder always decides
+ * before anything recorded.  Then the snapshot named by the
+ * WINJ_SNAPSHOT environment variable is checked, and then the
+ * default class loading routine searches for class files according
+ * to the WINJ_PATH environment variable.  Failing all of those, a
+ * class is made from any intrinsics registered for it.
+ *
+ * @param thread virtual machine thread on which to find class
+ * @param name_len optional length of class name (0 for strlen)
+ * @param name fully qualified class name
+ * @param class_out set to the class if found or NULL if not
+ * @return EXIT_SUCCESS unless something went wrong. */
+static int
+winj_thread_class_find
+(struct winj_thread *thread, unsigned name_len, const char *name,
+ struct winj_class **class_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
+  struct winj_bytes bytes = {0};
+  struct winj_source source = {0};
+  struct winj_class *found = NULL;
+
+  if (name && !name_len)
+    name_len = strlen(name);
+
+  if (!name) {
+    result = winj_error
+      (params, "missing arguments (name=%p/%u)", name, name_len);
+  } else if (EXIT_SUCCESS != winj_vm_class_lookup
+             (thread->vm, name_len, name, &found)) {
+  } else if (found) { /* requested class already loaded? */
+  } else if (params->find_class && EXIT_SUCCESS !=
+             (result = params->find_class
+              (params->context, params, name_len, name, &bytes))) {
+    winj_debug(params, "failed find_class: %.*s", name_len, name);
+  } else if (!bytes.count && EXIT_SUCCESS !=
+             (result = winj_vm_snapshot_fetch
+              (thread->vm, name_len, name, &bytes, &source))) {
+  } else if (!bytes.count && EXIT_SUCCESS !=
+             (result = winj_find_class_default
+              (thread->vm, name_len, name, &bytes, &source))) {
+    winj_debug(params, "failed find default: %.*s", name_len, name);
+  } else if (!bytes.count) { /* only intrinsics, if any */
+    result = winj_vm_class_intrinsic(thread->vm, name_len, name, &found);
+  } else if (EXIT_SUCCESS !=
+             (result = winj_thread_class_define
+              (thread, &bytes, NULL, &found))) {
+  } else if (found->class_file) {
+    found->class_file->source = source;
+    source.path = NULL;
+  }
+
+  if ((EXIT_SUCCESS == result) && class_out) {
+    *class_out = found;
+    found = NULL;
+  }
+  winj_class_cleanup(thread->vm, found);
+  winj_bytes_cleanup(params, &bytes);
+  winj_free(params, source.path);
+  return result;
+}
+
+/**
+ * Number of stack slots needed to hold a value of some type.
+ *
+ * @param type type of value
+ * @return two for long and double, zero for void, one otherwise */
+static inline unsigned
+winj_type_slots(enum winj_type type)
+{
+  return ((type == WINJ_TYPE_LONG) || (type == WINJ_TYPE_DOUBLE)) ? 2 :
+    (type == WINJ_TYPE_VOID) ? 0 : 1;
+}
+
+static inline jlong
+winj_slots_long(const winj_slot *slots)
+{
+#ifdef WINJ_WIDE_SLOTS
+  return slots[0].j;
+#else
+  return (jlong)(((u8)slots[0].u << 32) | slots[1].u);
+#endif
+}
+
+static inline void
+winj_slots_set_long(winj_slot *slots, jlong value)
+{
+#ifdef WINJ_WIDE_SLOTS
+  slots[0].j = value;
+#else
+  slots[0].u = (u4)((u8)value >> 32);
+  slots[1].u = (u4)value;
+#endif
+}
+
+static inline jdouble
+winj_slots_double(const winj_slot *slots)
+{
+#ifdef WINJ_WIDE_SLOTS
+  return slots[0].d;
+#else
+  u8 wide = ((u8)slots[0].u << 32) | slots[1].u;
+  jdouble result;
+  memcpy(&result, &wide, sizeof(result));
+  return result;
+#endif
+}
+
+static inline void
+winj_slots_set_double(winj_slot *slots, jdouble value)
+{
+#ifdef WINJ_WIDE_SLOTS
+  slots[0].d = value;
+#else
+  u8 wide;
+  memcpy(&wide, &value, sizeof(wide));
+  slots[0].u = (u4)(wide >> 32);
+  slots[1].u = (u4)wide;
+#endif
+}
+
+/**
+ * Copy a category two value from one pair of slots to another.
+ *
+ * @param dest destination slots
+ * @param src source slots */
+static inline void
+winj_slots_copy2(winj_slot *dest, const winj_slot *src)
+{
+  dest[0] = src[0];
+#ifndef WINJ_WIDE_SLOTS
+  dest[1] = src[1];
+#endif
+}
+
+/**
+ * Copy a value into stack slots, using two slots for long and double
+ * values as the Java Virtual Machine Specification requires.
+ *
+ * @param vm virtual machine in which references are stored
+ * @param type type of value
+ * @param value value to copy
+ * @param slots destination slots
+ * @return number of slots used */
+static unsigned
+winj_slots_store(const struct winj_vm *vm, enum winj_type type,
+                 const jvalue *value, winj_slot *slots)
+{
+  switch (type) {
+  case WINJ_TYPE_BOOLEAN: slots->i = value->z; break;
+  case WINJ_TYPE_BYTE:    slots->i = value->b; break;
+  case WINJ_TYPE_CHAR:    slots->i = value->c; break;
+  case WINJ_TYPE_SHORT:   slots->i = value->s; break;
+  case WINJ_TYPE_INT:     slots->i = value->i; break;
+  case WINJ_TYPE_FLOAT:   slots->f = value->f; break;
+  case WINJ_TYPE_OBJECT:  slots->l = winj_ref_encode(vm, value->l); break;
+  case WINJ_TYPE_LONG:   winj_slots_set_long(slots, value->j);   break;
+  case WINJ_TYPE_DOUBLE: winj_slots_set_double(slots, value->d); break;
+  default: break;
+  }
+  return winj_type_slots(type);
+}
+
+/**
+ * Copy a value out of stack slots.  This reverses winj_slots_store.
+ *
+ * @param vm virtual machine in which references are stored
+ * @param type type of value
+ * @param slots source slots
+ * @param value destination for value
+ * @return number of slots used */
+static unsigned
+winj_slots_load(const struct winj_vm *vm, enum winj_type type,
+                const winj_slot *slots, jvalue *value)
+{
+  switch (type) {
+  case WINJ_TYPE_BOOLEAN: value->z = (jboolean)slots->i; break;
+  case WINJ_TYPE_BYTE:    value->b = (jbyte)slots->i;    break;
+  case WINJ_TYPE_CHAR:    value->c = (jchar)slots->i;    break;
+  case WINJ_TYPE_SHORT:   value->s = (jshort)slots->i;   break;
+  case WINJ_TYPE_INT:     value->i = slots->i; break;
+  case WINJ_TYPE_FLOAT:   value->f = slots->f; break;
+  case WINJ_TYPE_OBJECT:  value->l = winj_ref_decode(vm, slots->l); break;
+  case WINJ_TYPE_LONG:   value->j = winj_slots_long(slots);   break;
+  case WINJ_TYPE_DOUBLE: value->d = winj_slots_double(slots); break;
+  default: break;
+  }
+  return winj_type_slots(type);
+}
+
+/**
+ * Find the first unused slot in the stack arena of a thread.  This
+ * is the top of the operand stack of the innermost frame, or the base
+ * of the arena when no frames are active.
+ *
+ * @param thread thread which owns the stack arena
+ * @return first unused slot */
+static winj_slot *
+winj_thread_stack_top(struct winj_thread *thread)
+{
+  return thread->frame ? thread->frame->top : thread->stack;
+}
+
+/**
+ * Make sure that a number of slots beyond the top of the stack arena
+ * are available, for example to hold arguments for a frame that is
+ * about to be pushed.  Nothing is allocated.
+ *
+ * @param thread thread which owns the stack arena
+ * @param count number of slots required
+ * @param slots_out optional destination for first available slot
+ * @return EXIT_SUCCESS unless the arena has been exhausted */
+static int
+winj_thread_stack_reserve
+(struct winj_thread *thread, unsigned count, winj_slot **slots_out)
+{
+  int result = EXIT_SUCCESS;
+  winj_slot *top = winj_thread_stack_top(thread);
+
+  if (count > (unsigned)(thread->stack_limit - top)) {
+    winj_thread_throw(thread, 0, "java/lang/StackOverflowError",
+                      "%u slots requested but %u available", count,
+                      (unsigned)(thread->stack_limit - top));
+    result = EXIT_FAILURE;
+  } else if (slots_out)
+    *slots_out = top;
+  return result;
+}
+
+/**
+ * Carve a frame for a method out of the stack arena of a thread.
+ * The caller must already have placed arguments in the first
+ * arg_slots slots beyond the top of the stack (for frames created by
+ * the interpreter that means popping them from the operand stack of
+ * the calling frame).  Local variables that are not arguments are
+ * cleared.  Sizes come from the max_locals and max_stack values of
+ * the code attribute, so methods without one (native and built in
+ * methods) get only their arguments.
+ *
+ * @param thread thread which owns the stack arena
+ * @param cls class to which method belongs
+ * @param method method being invoked
+ * @param arg_slots number of slots used by arguments
+ * @param frame_out optional destination for new frame
+ * @return EXIT_SUCCESS unless the arena has been exhausted */
+static int
+winj_thread_frame_push
+(struct winj_thread *thread, struct winj_class *cls,
+ struct winj_method *method, unsigned arg_slots,
+ struct winj_stack_frame **frame_out)
+{
+  int result = EXIT_SUCCESS;
+  winj_slot *base = winj_thread_stack_top(thread);
+  unsigned max_locals = arg_slots;
+  unsigned max_stack = 0;
+
+  if (method && method->method_file &&
+      method->method_file->code.code.value) {
+    if (method->method_file->code.max_locals > max_locals)
+      max_locals = method->method_file->code.max_locals;
+    max_stack = method->method_file->code.max_stack;
+  }
+  /* Slots narrower than a pointer may leave the frame misaligned. */
+  while ((uintptr_t)&base[max_locals] % sizeof(void *))
+    max_locals++;
+
+  if (EXIT_SUCCESS != (result = winj_thread_stack_reserve
+                       (thread, max_locals + WINJ_FRAME_SLOTS +
+                        max_stack, NULL))) {
+  } else {
+    struct winj_stack_frame *frame =
+      (struct winj_stack_frame *)&base[max_locals];
+
+    memset(&base[arg_slots], 0,
+           sizeof(*base) * (max_locals - arg_slots));
+    frame->winj     = cls;
+    frame->method   = method;
+    frame->caller   = thread->frame;
+    frame->program_counter = 0;
+    frame->locals   = base;
+    frame->operands = &base[max_locals + WINJ_FRAME_SLOTS];
+    frame->top      = frame->operands;
+    frame->limit    = frame->operands + max_stack;
+
+    thread->frame = frame;
+    thread->frame_count++;
+    if (frame_out)
+      *frame_out = frame;
+  }
+  return result;
+}
+
+/**
+ * Return the innermost frame of a thread to the stack arena.  The
+ * top of the calling frame's operand stack is restored to the first
+ * local variable, which is where arguments were placed.
+ *
+ * @param thread thread which owns the stack arena */
+static void
+winj_thread_frame_pop(struct winj_thread *thread)
+{
+  struct winj_stack_frame *frame = thread->frame;
+
+  if (frame) {
+    thread->frame = frame->caller;
+    thread->frame_count--;
+    if (thread->frame)
+      thread->frame->top = frame->locals;
+  }
+}
+
+static int
+winj_type_parse
+(struct winj_vm_params *params,
+ unsigned desc_len, const char *desc, const char **next_out,
+ struct winj_argument *argument_out)
+{
+  int result = EXIT_SUCCESS;
+  const char *next = NULL;
+  struct winj_argument argument = {0};
+
+  if (desc && !desc_len)
+    desc_len = strlen(desc);
+  if (!desc || !desc_len || !*desc) {
+    result = winj_error(params, "empty type descriptor");
+  } else {
+    next = desc + 1;
+
+    switch (*desc) {
+    case 'V': argument.argtype = WINJ_TYPE_VOID;    break;
+    case 'Z': argument.argtype = WINJ_TYPE_BOOLEAN; break;
+    case 'B': argument.argtype = WINJ_TYPE_BYTE;    break;
+    case 'C': argument.argtype = WINJ_TYPE_CHAR;    break;
+    case 'S': argument.argtype = WINJ_TYPE_SHORT;   break;
+    case 'I': argument.argtype = WINJ_TYPE_INT;     break;
+    case 'J': argument.argtype = WINJ_TYPE_LONG;    break;
+    case 'F': argument.argtype = WINJ_TYPE_FLOAT;   break;
+    case 'D': argument.argtype = WINJ_TYPE_DOUBLE;  break;
+    case 'L': {
+      const char *end = NULL;
+      if (!(end = winj_strnchr(desc + 1, ';', desc_len - 1))) {
+        result = winj_error(params, "missing object terminator");
+      } else {
+        next = end + 1;
+        argument.argtype = WINJ_TYPE_OBJECT;
+        argument.class_name = desc + 1;
+        argument.class_name_len = desc_len - 1 - (end - desc);
+      }
+    } break;
+    case '[': {
+      if (EXIT_SUCCESS !=
+          (result = winj_type_parse
+           (params, desc_len - 1, desc + 1, &next, &argument))) {
+      } else argument.array_count++;
+    } break;
+    default:
+      result = winj_error
+        (params, "unrecognized type descriptor: %c (%u)",
+         *desc, (unsigned)*desc);
+    }
+  }
+
+  if (EXIT_SUCCESS == result) {
+    if (argument_out)
+      *argument_out = argument;
+    if (next_out)
+      *next_out = next;
+  }
+  return result;
+}
+
+int
+winj_arguments_parse
+(struct winj_vm_params *params,
+ unsigned desc_len, const char *desc, enum winj_type *return_type,
+ unsigned *argument_count_out, struct winj_argument **arguments_out)
+{
+  int result = EXIT_SUCCESS;
+  unsigned count = 0;
+  struct winj_argument *argarray = NULL;
+  const char *open = NULL;
+  const char *close = NULL;
+
+  if (desc && !desc_len)
+    desc_len = strlen(desc);
+
+  if (!(open = winj_strnchr(desc, '(', desc_len))) {
+    result = winj_error(params, "missing open parenthesis");
+  } else if (!(close = winj_strnchr
+               (open, ')', desc_len - (open - desc)))) {
+    result = winj_error(params, "missing close parenthesis");
+  } else {
+    const char *next = open + 1;
+
+    while ((EXIT_SUCCESS == result) && (next < close)) {
+      struct winj_argument *argnext = NULL;
+      struct winj_argument argument;
+
+      if (EXIT_SUCCESS !=
+          (result = winj_type_parse
+           (params, close - next, next, &next, &argument))) {
+      } else if (!(argnext = winj_realloc
+                   (params, argarray, (count + 1) *
+                    sizeof(*argarray)))) {
+        result = winj_error(params, "failed to allocate %u bytes",
+                            (count + 1) * sizeof(*argarray));
+      } else {
+        argarray = argnext;
+        argarray[count++] = argument;
+      }
+    }
+  }
+
+  if ((EXIT_SUCCESS == result) && return_type) {
+    struct winj_argument argument;
+
+    if (EXIT_SUCCESS == (result = winj_type_parse
+                         (params, desc_len - (close + 1 - desc),
+                          close + 1, NULL, &argument)))
+      *return_type = argument.array_count ?
+        WINJ_TYPE_OBJECT : argument.argtype;
+  }
+
+  if (EXIT_SUCCESS == result) {
+    if (arguments_out) {
+      *arguments_out = argarray;
+      argarray = NULL;
+    }
+    if (argument_count_out)
+      *argument_count_out = count;
+  }
+  winj_free(params, argarray);
+  return result;
+}
+
+int
+winj_arguments_values
+(struct winj_vm_params *params, jvalue *values,
+ unsigned argument_count, struct winj_argument *arguments)
+{
+  int result = EXIT_SUCCESS;
+  unsigned ii;
+
+  for (ii = 0; ii < argument_count; ++ii)
+    arguments[ii].value = values[ii];
+  return result;
+}
+
+int
+winj_arguments_varargs
+(struct winj_vm_params *params, va_list args,
+ unsigned argument_count, struct winj_argument *arguments)
+{
+  int result = EXIT_SUCCESS;
+  unsigned ii;
+
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < argument_count); ++ii) {
+    struct winj_argument *argument = &arguments[ii];
+    if (argument->array_count)
+      argument->value.l = va_arg(args, jobject);
+    else switch (argument->argtype) {
+    case WINJ_TYPE_BOOLEAN:
+      argument->value.z = va_arg(args, jint); break;
+    case WINJ_TYPE_BYTE:
+      argument->value.b = va_arg(args, jint); break;
+    case WINJ_TYPE_CHAR:
+      argument->value.c = va_arg(args, jint); break;
+    case WINJ_TYPE_SHORT:
+      argument->value.s = va_arg(args, jint); break;
+    case WINJ_TYPE_INT:
+      argument->value.i = va_arg(args, jint); break;
+    case WINJ_TYPE_LONG:
+      argument->value.j = va_arg(args, jlong); break;
+    case WINJ_TYPE_FLOAT:
+      argument->value.f = va_arg(args, jdouble); break;
+    case WINJ_TYPE_DOUBLE:
+      argument->value.d = va_arg(args, jdouble); break;
+    case WINJ_TYPE_OBJECT:
+      argument->value.l = va_arg(args, jobject); break;
+    default:
+      result = winj_error
+        (params, "unknown type: %u", argument->argtype);
+    }
+  }
+  return result;
+}
+
+/**
+ * Prepare a buffer of arguments, usually on the C stack, to receive
+ * values for a call to a method with the given signature.  This is
+ * what avoids parsing the descriptor for each call.
+ *
+ * @param signature parsed descriptor of the method to call
+ * @param arguments buffer with room for each argument */
+static void
+winj_signature_arguments
+(const struct winj_signature *signature, struct winj_argument *arguments)
+{
+  unsigned ii;
+
+  for (ii = 0; ii < signature->count; ++ii) {
+    arguments[ii].argtype = (enum winj_type)signature->types[ii];
+    arguments[ii].class_name = NULL;
+    arguments[ii].class_name_len = 0;
+    arguments[ii].array_count = 0;
+  }
+}
+
+/**
+ * Find room for the arguments of a call and prepare it to receive
+ * their values.  Release the result with winj_thread_arguments_free.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param signature parsed descriptor of the method to call
+ * @param buffer room for WINJ_ARGUMENT_INLINE arguments
+ * @return buffer, an allocation or NULL if an exception was thrown */
+static struct winj_argument *
+winj_thread_arguments
+(struct winj_thread *thread, const struct winj_signature *signature,
+ struct winj_argument *buffer)
+{
+  struct winj_argument *result = buffer;
+
+  if ((signature->count > WINJ_ARGUMENT_INLINE) &&
+      !(result = winj_malloc(&thread->vm->params, signature->count *
+                             sizeof(*result))))
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %u arguments",
+                      signature->count);
+  if (result)
+    winj_signature_arguments(signature, result);
+  return result;
+}
+
+static void
+winj_thread_arguments_free
+(struct winj_thread *thread, struct winj_argument *arguments,
+ struct winj_argument *buffer)
+{
+  if (arguments != buffer)
+    winj_free(&thread->vm->params, arguments);
+}
+
+/**
+ * Place argument values into consecutive stack slots using two slots
+ * for each long or double value.  Call with NULL slots to find out
+ * how many slots are required.
+ *
+ * @param vm virtual machine in which references are stored
+ * @param argument_count number of arguments
+ * @param arguments values to place
+ * @param slots optional destination for argument values
+ * @param slot_count_out optional destination for number of slots used
+ * @return EXIT_SUCCESS unless something went wrong */
+int
+winj_arguments_slots
+(struct winj_vm *vm, unsigned argument_count,
+ struct winj_argument *arguments, winj_slot *slots,
+ unsigned *slot_count_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = &vm->params;
+  unsigned count = 0;
+  unsigned ii;
+
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < argument_count); ++ii) {
+    struct winj_argument *argument = &arguments[ii];
+    enum winj_type type = argument->array_count ?
+      WINJ_TYPE_OBJECT : argument->argtype;
+
+    if (!winj_type_slots(type)) {
+      result = winj_error
+        (params, "unknown type: %u", argument->argtype);
+    } else if (slots) {
+      count += winj_slots_store
+        (vm, type, &argument->value, &slots[count]);
+    } else count += winj_type_slots(type);
+  }
+
+  if ((EXIT_SUCCESS == result) && slot_count_out)
+    *slot_count_out = count;
+  return result;
+}
+
+/**
+ * Push a frame for a method called from native code.  Arguments are
+ * copied to the top of the stack arena, preceded by the object when
+ * a method is not static, and become the first local variables.
+ *
+ * @param thread thread on which to push frame
+ * @param cls class to which method belongs
+ * @param method method being invoked
+ * @param self object for instance methods or NULL for static ones
+ * @param argument_count number of arguments
+ * @param arguments values of arguments
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_thread_frame_enter
+(struct winj_thread *thread, struct winj_class *cls,
+ struct winj_method *method, jobject self,
+ unsigned argument_count, struct winj_argument *arguments)
+{
+  int result = EXIT_SUCCESS;
+  unsigned self_count = self ? 1 : 0;
+  unsigned slot_count = method->signature.slots;
+  winj_slot *slots = NULL;
+
+  if (EXIT_SUCCESS != (result = winj_thread_stack_reserve
+                       (thread, self_count + slot_count, &slots))) {
+  } else if (EXIT_SUCCESS != (result = winj_arguments_slots
+                              (thread->vm, argument_count, arguments,
+                               slots + self_count, NULL))) {
+  } else {
+    if (self)
+      slots[0].l = winj_ref_encode(thread->vm, self);
+    result = winj_thread_frame_push
+      (thread, cls, method, self_count + slot_count, NULL);
+  }
+  return result;
+}
+
+
+static int
+winj_thread_interpret(struct winj_thread *thread, winj_slot *result);
+
+/**
+ * Call a method with arguments which have already been converted.
+ * Built in and native methods are called directly while methods
+ * with byte code get a frame and are interpreted until they return.
+ *
+ * @param thread thread on which to call method
+ * @param cls class to which method belongs
+ * @param method method to call
+ * @param self object for instance methods or NULL for static ones
+ * @param argument_count number of arguments
+ * @param arguments values of arguments
+ * @param value_out optional destination for return value
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_invoke
+(struct winj_thread *thread, struct winj_class *cls,
+ struct winj_method *method, jobject self,
+ unsigned argument_count, struct winj_argument *arguments,
+ jvalue *value_out)
+{
+  int result = EXIT_SUCCESS;
+  winj_slot returned[2];
+
+  if (method->call) {
+    unsigned local_count = thread->locals.count;
+
+    /* Local references made by the method end when it returns. */
+    result = method->call(thread, method, value_out,
+                          self ? self : &cls->self,
+                          argument_count, arguments);
+    thread->locals.count = local_count;
+  } else if (!method->method_file ||
+             !method->method_file->code.code.value) {
+    winj_thread_throw(thread, 0, "java/lang/UnsatisfiedLinkError",
+                      "%.*s.%.*s", cls->name_len, cls->name,
+                      method->name_len, method->name);
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS != (result = winj_thread_frame_enter
+                              (thread, cls, method, self,
+                               argument_count, arguments))) {
+  } else {
+    if ((EXIT_SUCCESS == (result = winj_thread_interpret
+                          (thread, returned))) && value_out)
+      winj_slots_load(thread->vm, method->signature.return_type,
+                      returned, value_out);
+    winj_thread_frame_pop(thread);
+  }
+  return result;
+}
+
+/**
+ * Run the static initializer of a class unless that has already
+ * been started.  Initialization is marked as started before the
+ * initializer runs so that it may refer to its own class.
+ *
+ * @param thread thread on which to run initializer
+ * @param cls class to initialize
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_class_init(struct winj_thread *thread, struct winj_class *cls)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_method *clinit = NULL;
+
+  if (!(cls->flags & winj_class_initialized)) {
+    cls->flags |= winj_class_initialized;
+    if (cls->super && (EXIT_SUCCESS != (result = winj_thread_class_init
+                                        (thread, cls->super)))) {
+    } else if (EXIT_SUCCESS == winj_class_static_method_search
+               (cls, 0, "<clinit>()V", &clinit) && clinit) {
+      result = winj_thread_invoke
+        (thread, cls, clinit, NULL, 0, NULL, NULL);
+    }
+  }
+  return result;
+}
+
+/**
+ * Find the class named by a field, method or interface method
+ * reference in the constant pool of a class, along with the name of
+ * the member joined to its descriptor the same way member names are
+ * stored in classes.  The class found is initialized.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class with constant pool containing reference
+ * @param index constant pool index of reference
+ * @param target_out destination for referenced class
+ * @param member_len_out destination for length of member name
+ * @param member_out destination for member name (caller must free)
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_member_resolve
+(struct winj_thread *thread, struct winj_class *cls, u2 index,
+ struct winj_class **target_out, unsigned *member_len_out,
+ char **member_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = &thread->vm->params;
+  struct winj_class_file *class_file = cls->class_file;
+  union winj_cpool_info *ref = NULL;
+  union winj_cpool_info *nat = NULL;
+  union winj_cpool_info *name = NULL;
+  union winj_cpool_info *desc = NULL;
+  u1 tag_any = 0;
+  u1 tag_nat = WINJ_CONST_NAMEANDTYPE;
+  u1 tag_utf8 = WINJ_CONST_UTF8;
+  const char *class_name = NULL;
+  unsigned class_name_len = 0;
+  struct winj_class *target = NULL;
+
+  if (!class_file) {
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS != (result = winj_cpool_get
+                              (params, class_file, index,
+                               &tag_any, &ref))) {
+  } else if ((tag_any != WINJ_CONST_FIELDREF) &&
+             (tag_any != WINJ_CONST_METHODREF) &&
+             (tag_any != WINJ_CONST_INTERFACEMETHODREF)) {
+    result = winj_error(params, "constant %hu is not a reference "
+                        "(tag=%u)", index, tag_any);
+  } else if (EXIT_SUCCESS != (result = winj_cpool_get_class_name
+                              (params, class_file,
+                               ref->const_methodref.class_index,
+                               &class_name_len, &class_name))) {
+  } else if (EXIT_SUCCESS != (result = winj_cpool_get
+                              (params, class_file,
+                               ref->const_methodref.nameandtype_index,
+                               &tag_nat, &nat))) {
+  } else if (EXIT_SUCCESS != (result = winj_cpool_get
+                              (params, class_file,
+                               nat->const_nameandtype.name_index,
+                               &tag_utf8, &name))) {
+  } else if (EXIT_SUCCESS != (result = winj_cpool_get
+                              (params, class_file,
+                               nat->const_nameandtype.descriptor_index,
+                               &tag_utf8, &desc))) {
+  }
+
+  if (EXIT_SUCCESS != result) {
+    winj_thread_throw(thread, 0, "java/lang/VerifyError",
+                      "invalid reference %hu in %.*s", index,
+                      cls->name_len, cls->name);
+  } else if (EXIT_SUCCESS != (result = winj_thread_class_find
+                              (thread, class_name_len, class_name,
+                               &target))) {
+  } else if (!target) {
+    winj_thread_throw(thread, 0, "java/lang/NoClassDefFoundError",
+                      "%.*s", class_name_len, class_name);
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS != (result = winj_thread_class_init
+                              (thread, target))) {
+  } else if (EXIT_SUCCESS != (result = winj_string_concat
+                              (params, name->const_utf8.length,
+                               (const char *)name->const_utf8.bytes,
+                               desc->const_utf8.length,
+                               (const char *)desc->const_utf8.bytes,
+                               member_len_out, member_out))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate member name");
+  } else *target_out = target;
+  return result;
+}
+
+/**
+ * Resolve a static method reference from the constant pool of a class.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class with constant pool containing reference
+ * @param index constant pool index of method reference
+ * @param target_out destination for class which declares method
+ * @param method_out destination for method
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_static_method_resolve
+(struct winj_thread *thread, struct winj_class *cls, u2 index,
+ struct winj_class **target_out, struct winj_method **method_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_class *target = NULL;
+  struct winj_method *method = NULL;
+  unsigned member_len = 0;
+  char *member = NULL;
+
+  if (EXIT_SUCCESS != (result = winj_thread_member_resolve
+                       (thread, cls, index, &target,
+                        &member_len, &member))) {
+  } else if (EXIT_SUCCESS != (result = winj_class_static_method_search
+                              (target, member_len, member, &method))) {
+  } else if (!method) {
+    winj_thread_throw(thread, 0, "java/lang/NoSuchMethodError",
+                      "%.*s.%.*s", target->name_len, target->name,
+                      member_len, member);
+    result = EXIT_FAILURE;
+  } else {
+    *target_out = target;
+    *method_out = method;
+  }
+  winj_free(&thread->vm->params, member);
+  return result;
+}
+
+/**
+ * Resolve a static field reference from the constant pool of a class.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class with constant pool containing reference
+ * @param index constant pool index of field reference
+ * @param target_out destination for class which declares field
+ * @param field_out destination for field
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_static_field_resolve
+(struct winj_thread *thread, struct winj_class *cls, u2 index,
+ struct winj_class **target_out, struct winj_field **field_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_class *target = NULL;
+  struct winj_field *field = NULL;
+  unsigned member_len = 0;
+  char *member = NULL;
+
+  if (EXIT_SUCCESS != (result = winj_thread_member_resolve
+                       (thread, cls, index, &target,
+                        &member_len, &member))) {
+  } else if (EXIT_SUCCESS != (result = winj_class_static_field_search
+                              (target, member_len, member, &field))) {
+  } else if (!field) {
+    winj_thread_throw(thread, 0, "java/lang/NoSuchFieldError",
+                      "%.*s.%.*s", target->name_len, target->name,
+                      member_len, member);
+    result = EXIT_FAILURE;
+  } else {
+    *target_out = target;
+    *field_out = field;
+  }
+  winj_free(&thread->vm->params, member);
+  return result;
+}
+
+/**
+ * Find an instance field declared by a class or inherited by it.
+ *
+ * @param cls class in which to start looking
+ * @param name_len number of bytes in name (or 0 for strlen)
+ * @param name field name followed by descriptor
+ * @param field_out destination for field or NULL if not found
+ * @return EXIT_SUCCESS */
+static int
+winj_class_field_find
+(struct winj_class *cls, unsigned name_len, const char *name,
+ struct winj_field **field_out)
+{
+  struct winj_field *found = NULL;
+
+  for (; cls && !found; cls = cls->super)
+    winj_class_field_search(cls, name_len, name, &found);
+  *field_out = found;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Resolve an instance field reference from the constant pool of a
+ * class.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class with constant pool containing reference
+ * @param index constant pool index of field reference
+ * @param field_out destination for field
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_field_resolve
+(struct winj_thread *thread, struct winj_class *cls, u2 index,
+ struct winj_field **field_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_class *target = NULL;
+  struct winj_field *field = NULL;
+  unsigned member_len = 0;
+  char *member = NULL;
+
+  if (EXIT_SUCCESS != (result = winj_thread_member_resolve
+                       (thread, cls, index, &target,
+                        &member_len, &member))) {
+  } else if (EXIT_SUCCESS != (result = winj_class_field_find
+                              (target, member_len, member, &field))) {
+  } else if (!field) {
+    winj_thread_throw(thread, 0, "java/lang/NoSuchFieldError",
+                      "%.*s.%.*s", target->name_len, target->name,
+                      member_len, member);
+    result = EXIT_FAILURE;
+  } else *field_out = field;
+  winj_free(&thread->vm->params, member);
+  return result;
+}
+
+/**
+ * Resolve an instance method reference from the constant pool of a
+ * class.  Methods are searched for in the referenced class and then
+ * in each of its super classes.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class with constant pool containing reference
+ * @param index constant pool index of method reference
+ * @param method_out destination for method
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_method_resolve
+(struct winj_thread *thread, struct winj_class *cls, u2 index,
+ struct winj_method **method_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_class *target = NULL;
+  struct winj_class *current = NULL;
+  struct winj_method *method = NULL;
+  unsigned member_len = 0;
+  char *member = NULL;
+
+  if (EXIT_SUCCESS != (result = winj_thread_member_resolve
+                       (thread, cls, index, &target,
+                        &member_len, &member))) {
+  } else {
+    for (current = target; current && !method; current = current->super)
+      winj_class_method_search(current, member_len, member, &method);
+    if (method) {
+      *method_out = method;
+    } else {
+      winj_thread_throw(thread, 0, "java/lang/NoSuchMethodError",
+                        "%.*s.%.*s", target->name_len, target->name,
+                        member_len, member);
+      result = EXIT_FAILURE;
+    }
+  }
+  winj_free(&thread->vm->params, member);
+  return result;
+}
+
+/**
+ * Select the method which an instance call invokes on a receiver of
+ * some class.  Methods of classes come from the virtual method table.
+ * Interface methods are looked up by name in the receiver class and
+ * its super classes, and a default method in the interface itself is
+ * used when nothing is found.  Receivers which do not implement the
+ * interface at all are refused.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class of receiver
+ * @param method resolved method named by call
+ * @param callee_out destination for method to invoke
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_method_select
+(struct winj_thread *thread, struct winj_class *cls,
+ struct winj_method *method, struct winj_method **callee_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_method *callee = NULL;
+
+  if (!(method->cls->access_flags & WINJ_ACCESS_INTERFACE)) {
+    if (method->vtable_index < cls->vtable_count)
+      callee = cls->vtable[method->vtable_index];
+  } else if (EXIT_SUCCESS != winj_class_assignable(cls, method->cls)) {
+  } else if ((EXIT_SUCCESS == winj_class_virtual_search
+              (cls, method->name_len, method->name, &callee)) &&
+             !callee && !(method->access_flags & WINJ_ACCESS_ABSTRACT))
+    callee = method;
+
+  if (!callee) {
+    winj_thread_throw(thread, 0, "java/lang/IncompatibleClassChangeError",
+                      "%.*s has no %.*s", cls->name_len, cls->name,
+                      method->name_len, method->name);
+    result = EXIT_FAILURE;
+  } else if (callee->access_flags & WINJ_ACCESS_ABSTRACT) {
+    winj_thread_throw(thread, 0, "java/lang/AbstractMethodError",
+                      "%.*s.%.*s", cls->name_len, cls->name,
+                      method->name_len, method->name);
+    result = EXIT_FAILURE;
+  } else *callee_out = callee;
+  return result;
+}
+
+/**
+ * Find the method which a call site invokes on a receiver whose class
+ * does not match the first entry of its inline cache, remembering the
+ * selection for next time.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cache inline cache of call site
+ * @param cls class of receiver
+ * @param callee_out destination for method to invoke
+ * @param megamorphic_out set non-zero if site should stop caching
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_call_miss
+(struct winj_thread *thread, struct winj_call_cache *cache,
+ struct winj_class *cls, struct winj_method **callee_out,
+ int *megamorphic_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_call_entry *entry = NULL;
+  unsigned ii;
+
+  for (ii = 1; !entry && (ii < cache->count); ++ii)
+    if (cache->entries[ii].cls == cls)
+      entry = &cache->entries[ii];
+
+  if (entry) {
+    *callee_out = entry->method;
+  } else if (EXIT_SUCCESS != (result = winj_thread_method_select
+                              (thread, cls, cache->method, callee_out))) {
+  } else if (cache->count < WINJ_CALL_CACHE_SIZE) {
+    entry = &cache->entries[cache->count++];
+    entry->cls = cls;
+    entry->method = *callee_out;
+  } else if (++cache->misses < WINJ_CALL_MISSES) {
+    entry = &cache->entries[1 + cache->misses %
+                            (WINJ_CALL_CACHE_SIZE - 1)];
+    entry->cls = cls;
+    entry->method = *callee_out;
+  } else *megamorphic_out = 1;
+  return result;
+}
+
+/**
+ * Resolve a class reference from the constant pool of a class.  The
+ * class found is initialized.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class with constant pool containing reference
+ * @param index constant pool index of class reference
+ * @param target_out destination for referenced class
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_class_resolve
+(struct winj_thread *thread, struct winj_class *cls, u2 index,
+ struct winj_class **target_out)
+{
+  int result = EXIT_SUCCESS;
+  const char *class_name = NULL;
+  unsigned class_name_len = 0;
+  struct winj_class *target = NULL;
+
+  if (!cls->class_file || (EXIT_SUCCESS != winj_cpool_get_class_name
+                           (&thread->vm->params, cls->class_file, index,
+                            &class_name_len, &class_name))) {
+    winj_thread_throw(thread, 0, "java/lang/VerifyError",
+                      "invalid class reference %hu in %.*s", index,
+                      cls->name_len, cls->name);
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS != (result = winj_thread_class_find
+                              (thread, class_name_len, class_name,
+                               &target))) {
+  } else if (!target) {
+    winj_thread_throw(thread, 0, "java/lang/NoClassDefFoundError",
+                      "%.*s", class_name_len, class_name);
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS != (result = winj_thread_class_init
+                              (thread, target))) {
+  } else *target_out = target;
+  return result;
+}
+
+/* === Heap
+ * Objects live in large regions.  Each thread takes an allocation
+ * buffer and bumps a pointer through it, so most allocations touch
+ * nothing shared.  Unless generations are disabled, buffers come
+ * from a small nursery which minor collections empty by copying
+ * survivors into the regions of the old generation.  Otherwise they
+ * come from the old generation directly.  Objects too big to share a
+ * buffer always come straight from an old region.  Regions are
+ * allocated zeroed, while space reclaimed by the garbage collector is
+ * cleared when it is given out again. */
+
+/**
+ * Take a block of storage from the current old region, starting a
+ * new region if it lacks room.  Blocks bigger than half a region get
+ * a region of their own which goes after the current one so that the
+ * space left in the current one is not abandoned.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param size bytes needed (a multiple of the heap alignment)
+ * @param block_out destination for storage
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_heap_take(struct winj_vm *vm, size_t size, u1 **block_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_region *region = vm->regions;
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(*region));
+  size_t capacity = (size > WINJ_REGION_SIZE / 2) ?
+    size : WINJ_REGION_SIZE;
+
+  if (region && (region->size - region->used >= size)) {
+  } else if (!(region = winj_vm_space_take(vm, offset + capacity))) {
+    result = winj_error(&vm->params, "failed to allocate %lu bytes "
+                        "for heap region", (unsigned long)(offset +
+                                                          capacity));
+  } else {
+    region->size = capacity;
+    if (vm->regions && (size > WINJ_REGION_SIZE / 2)) {
+      region->next = vm->regions->next;
+      vm->regions->next = region;
+    } else {
+      region->next = vm->regions;
+      vm->regions = region;
+    }
+  }
+
+  if (EXIT_SUCCESS == result) {
+    *block_out = (u1 *)region + offset + region->used;
+    region->used += size;
+    vm->gc.allocated += size;
+  }
+  return result;
+}
+
+/**
+ * Take a zeroed block of the old generation big enough for an
+ * allocation buffer, preferring space which the garbage collector
+ * reclaimed over a fresh part of a region.  Reclaimed chunks too
+ * small for the object being allocated are dropped until the next
+ * full collection finds them again.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param size bytes needed for the object being allocated
+ * @param block_out destination for storage
+ * @param length_out destination for bytes of storage
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_old_take
+(struct winj_vm *vm, size_t size, u1 **block_out, size_t *length_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_free_chunk *chunk = NULL;
+  size_t length = WINJ_TLAB_SIZE;
+  u1 *block = NULL;
+
+  while ((chunk = vm->free_chunks) && (chunk->self.size < size))
+    vm->free_chunks = chunk->next;
+
+  if (chunk) {
+    vm->free_chunks = chunk->next;
+    length = chunk->self.size;
+    if (length >= WINJ_TLAB_SIZE + WINJ_FREE_MINIMUM) {
+      struct winj_free_chunk *rest =
+        (struct winj_free_chunk *)((u1 *)chunk + WINJ_TLAB_SIZE);
+      rest->self.cls = NULL;
+      rest->self.size = length - WINJ_TLAB_SIZE;
+      rest->next = vm->free_chunks;
+      vm->free_chunks = rest;
+      length = WINJ_TLAB_SIZE;
+    }
+    block = (u1 *)chunk;
+    memset(block, 0, length);
+    vm->gc.allocated += length;
+  } else result = winj_vm_heap_take(vm, length, &block);
+
+  if (EXIT_SUCCESS == result) {
+    *block_out = block;
+    *length_out = length;
+  }
+  return result;
+}
+
+/**
+ * Take an allocation buffer from the nursery, adding regions until
+ * it reaches its full size.  When that is exhausted the block given
+ * back is NULL and a minor collection must empty the nursery.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param block_out destination for storage or NULL
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_nursery_take(struct winj_vm *vm, u1 **block_out)
+{
+  int result = EXIT_SUCCESS;
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(struct winj_region));
+  struct winj_region *region = NULL;
+
+  while ((region = vm->nursery_fill) &&
+         (region->size - region->used < WINJ_TLAB_SIZE))
+    vm->nursery_fill = region->next;
+
+  if (region || (vm->nursery_count >= WINJ_NURSERY_REGIONS)) {
+  } else if (!(region = winj_vm_space_take
+                         (vm, offset + WINJ_REGION_SIZE))) {
+    result = winj_error(&vm->params, "failed to allocate %lu bytes "
+                        "for nursery region", (unsigned long)
+                        (offset + WINJ_REGION_SIZE));
+  } else {
+    region->size = WINJ_REGION_SIZE;
+    region->next = vm->nursery;
+    vm->nursery = vm->nursery_fill = region;
+    vm->nursery_count++;
+  }
+
+  *block_out = NULL;
+  if ((EXIT_SUCCESS == result) && region) {
+    *block_out = (u1 *)region + offset + region->used;
+    region->used += WINJ_TLAB_SIZE;
+  }
+  return result;
+}
+
+/**
+ * Give up what remains of the allocation buffer of a thread, leaving
+ * a filler object in its place.
+ *
+ * @param thread thread which owns allocation buffer */
+static void
+winj_thread_tlab_retire(struct winj_thread *thread)
+{
+  if (thread->tlab_top < thread->tlab_end) {
+    struct winj_object *filler = (struct winj_object *)thread->tlab_top;
+    filler->cls = NULL;
+    filler->size = thread->tlab_end - thread->tlab_top;
+  }
+  thread->tlab_top = thread->tlab_end = NULL;
+}
+
+/**
+ * Replace the allocation buffer of a thread.  When the nursery is
+ * full the thread is left without a buffer.
+ *
+ * @param thread thread which needs an allocation buffer
+ * @param size bytes needed for the object being allocated
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_thread_tlab_refill(struct winj_thread *thread, size_t size)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm *vm = thread->vm;
+  size_t length = WINJ_TLAB_SIZE;
+  u1 *block = NULL;
+
+  winj_thread_tlab_retire(thread);
+  if (vm->gc.generational)
+    result = winj_vm_nursery_take(vm, &block);
+  else result = winj_vm_old_take(vm, size, &block, &length);
+
+  if ((EXIT_SUCCESS == result) && block) {
+    thread->tlab_top = block;
+    thread->tlab_end = block + length;
+  }
+  return result;
+}
+
+/**
+ * Add an object to a list of references.  NULL marks a local frame.
+ *
+ * @param params parameters for system customization
+ * @param list list to extend
+ * @param object object to add
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_reflist_append
+(struct winj_vm_params *params, struct winj_reflist *list,
+ struct winj_object *object)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_object **refs = NULL;
+  unsigned capacity = list->capacity ? list->capacity * 2 : 32;
+
+  if (list->count < list->capacity) {
+  } else if (!(refs = winj_realloc
+               (params, list->refs, capacity * sizeof(*refs)))) {
+    result = winj_error(params, "failed to allocate %u bytes for "
+                        "references", capacity * sizeof(*refs));
+  } else {
+    list->refs = refs;
+    list->capacity = capacity;
+  }
+  if (EXIT_SUCCESS == result)
+    list->refs[list->count++] = object;
+  return result;
+}
+
+/**
+ * Remove the most recent occurrence of an object from a list of
+ * references without looking past the start of the current frame.
+ *
+ * @param list list to search
+ * @param object object to remove */
+static void
+winj_reflist_remove(struct winj_reflist *list, struct winj_object *object)
+{
+  unsigned ii;
+
+  for (ii = list->count; object && (ii > 0) && list->refs[ii - 1]; --ii)
+    if (list->refs[ii - 1] == object) {
+      list->refs[ii - 1] = list->refs[--list->count];
+      break;
+    }
+}
+
+/**
+ * Keep an object which has been handed to native code alive until
+ * the native code releases it or returns.
+ *
+ * @param thread thread running native code
+ * @param object object to keep (may be NULL)
+ * @return the object, or NULL if it could not be kept */
+static struct winj_object *
+winj_thread_local_ref(struct winj_thread *thread, struct winj_object *object)
+{
+  if (object && object->size && (EXIT_SUCCESS != winj_reflist_append
+                                 (&thread->vm->params,
+                                  &thread->locals, object))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate local reference");
+    object = NULL;
+  }
+  return object;
+}
+
+/* === Garbage collection
+ * A minor collection copies every young object reachable from the
+ * old generation into old regions and then empties the nursery.  A
+ * full collection first runs a minor one and then marks every object
+ * reachable from roots and sweeps each old region, turning each run
+ * of unmarked objects into a single filler.  Fillers big enough to be
+ * worth reusing go on a free list from which the old generation is
+ * refilled before carving up new regions, and regions with nothing
+ * left alive are released.
+ *
+ * References held by static fields and arrays are exact.  Stack
+ * slots carry no type information, so any slot which happens to hold
+ * the address of an object keeps that object alive.  Only objects
+ * found in the heap are taken from stack slots, which makes it safe
+ * for a slot to hold an integer instead.  Neither such slots nor the
+ * references handed to native code can be updated when an object
+ * moves, so a nursery region holding an object they refer to joins
+ * the old generation in place instead of being emptied.
+ *
+ * Old objects which refer to young ones are found through a
+ * remembered set.  Every store of a reference into an object goes
+ * through winj_vm_gc_remember, which adds the object to the set the
+ * first time it gets a young referent. */
+
+/**
+ * Mark an object and remember to trace it, unless that has already
+ * happened or the object is not part of the heap.
+ *
+ * @param vm virtual machine being collected
+ * @param object object to mark (may be NULL)
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_mark(struct winj_vm *vm, struct winj_object *object)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_gc *gc = &vm->gc;
+  struct winj_object **marks = NULL;
+  unsigned capacity = gc->mark_capacity ? gc->mark_capacity * 2 : 256;
+
+  if (!object || !object->size || (object->size & WINJ_OBJECT_MARKED)) {
+  } else if ((gc->mark_count == gc->mark_capacity) &&
+             !(marks = winj_realloc(&vm->params, gc->marks,
+                                    capacity * sizeof(*marks)))) {
+    result = winj_error(&vm->params, "failed to allocate %u bytes for "
+                        "marks", capacity * sizeof(*marks));
+  } else {
+    if (marks) {
+      gc->marks = marks;
+      gc->mark_capacity = capacity;
+    }
+    object->size |= WINJ_OBJECT_MARKED;
+    gc->marks[gc->mark_count++] = object;
+  }
+  return result;
+}
+
+/**
+ * Record that an object is about to hold a reference.  Old objects
+ * which get a young referent join the remembered set so that the next
+ * minor collection treats them as roots.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param holder object in which reference is stored
+ * @param value reference being stored (may be NULL)
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_remember
+(struct winj_vm *vm, struct winj_object *holder, struct winj_object *value)
+{
+  int result = EXIT_SUCCESS;
+
+  if (!value || !value->size || (value->size & WINJ_OBJECT_OLD) ||
+      ((holder->size & (WINJ_OBJECT_OLD | WINJ_OBJECT_REMEMBERED)) !=
+       WINJ_OBJECT_OLD)) {
+  } else if (EXIT_SUCCESS == (result = winj_reflist_append
+                              (&vm->params, &vm->remembered, holder)))
+    holder->size |= WINJ_OBJECT_REMEMBERED;
+  return result;
+}
+
+/**
+ * Record that an object is about to hold a run of references.  This
+ * costs one check when the holder is young or already remembered and
+ * otherwise stops at the first young referent, so bulk stores need
+ * not pass each reference through the write barrier.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param holder object in which references are stored
+ * @param count number of references
+ * @param refs references being stored
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_remember_refs
+(struct winj_vm *vm, struct winj_object *holder,
+ size_t count, const winj_ref *refs)
+{
+  int result = EXIT_SUCCESS;
+  size_t ii;
+
+  if ((holder->size & (WINJ_OBJECT_OLD | WINJ_OBJECT_REMEMBERED)) ==
+      WINJ_OBJECT_OLD)
+    for (ii = 0; ii < count; ++ii) {
+      struct winj_object *value = winj_ref_decode(vm, refs[ii]);
+
+      if (value && value->size && !(value->size & WINJ_OBJECT_OLD)) {
+        result = winj_vm_gc_remember(vm, holder, value);
+        break;
+      }
+    }
+  return result;
+}
+
+static int
+winj_gc_address_compare(const void *aa, const void *bb)
+{
+  uintptr_t left = (uintptr_t)*(void *const *)aa;
+  uintptr_t right = (uintptr_t)*(void *const *)bb;
+  return (left > right) - (left < right);
+}
+
+/**
+ * Gather the addresses held by stack slots of every thread, sorted so
+ * that objects can be looked up among them.  References held by
+ * native code can be included as well.
+ *
+ * @param vm virtual machine being collected
+ * @param native non-zero to include JNI references
+ * @param candidates_out destination for addresses (caller must free)
+ * @param count_out destination for number of addresses
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_candidates
+(struct winj_vm *vm, int native, void ***candidates_out,
+ size_t *count_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_thread *thread = NULL;
+  void **candidates = NULL;
+  size_t count = native ? vm->globals.count : 0;
+  winj_slot *slot;
+  unsigned ii, jj;
+
+  /* The innermost frame of a thread ends beyond everything that the
+   * thread has on its stack, whatever frames below it hold. */
+  for (ii = 0; ii < vm->thread_count; ++ii) {
+    thread = vm->threads[ii];
+    if (thread->frame)
+      count += thread->frame->limit - thread->stack;
+    if (native)
+      count += thread->locals.count;
+  }
+
+  if (!count) {
+  } else if (!(candidates = winj_malloc
+               (&vm->params, count * sizeof(*candidates)))) {
+    result = winj_error(&vm->params, "failed to allocate %lu bytes "
+                        "for stack roots", (unsigned long)
+                        (count * sizeof(*candidates)));
+  } else {
+    count = 0;
+    for (ii = 0; ii < vm->thread_count; ++ii) {
+      thread = vm->threads[ii];
+      if (thread->frame)
+        for (slot = thread->stack; slot < thread->frame->limit; ++slot)
+          if (slot->l)
+            candidates[count++] = winj_ref_decode(vm, slot->l);
+      for (jj = 0; native && (jj < thread->locals.count); ++jj)
+        if (thread->locals.refs[jj])
+          candidates[count++] = thread->locals.refs[jj];
+    }
+    for (ii = 0; native && (ii < vm->globals.count); ++ii)
+      candidates[count++] = vm->globals.refs[ii];
+    qsort(candidates, count, sizeof(*candidates),
+          winj_gc_address_compare);
+  }
+
+  if (EXIT_SUCCESS == result) {
+    *candidates_out = candidates;
+    *count_out = count;
+  }
+  return result;
+}
+
+/**
+ * Mark every object in the old generation whose address appears in
+ * a stack slot of some thread.
+ *
+ * @param vm virtual machine being collected
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_stacks(struct winj_vm *vm)
+{
+  int result = EXIT_SUCCESS;
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(struct winj_region));
+  struct winj_region *region = NULL;
+  struct winj_object *object = NULL;
+  void **candidates = NULL;
+  size_t count = 0;
+  size_t position;
+
+  if (EXIT_SUCCESS != (result = winj_vm_gc_candidates
+                       (vm, 0, &candidates, &count))) {
+  } else if (count) {
+    for (region = vm->regions; (EXIT_SUCCESS == result) && region;
+         region = region->next)
+      for (position = 0; (EXIT_SUCCESS == result) &&
+             (position < region->used); position += object->size &
+             ~WINJ_OBJECT_FLAGS) {
+        object = (struct winj_object *)((u1 *)region + offset + position);
+        if (object->cls && bsearch(&object, candidates, count,
+                                   sizeof(*candidates),
+                                   winj_gc_address_compare))
+          result = winj_vm_gc_mark(vm, object);
+      }
+  }
+  winj_free(&vm->params, candidates);
+  return result;
+}
+
+/**
+ * Mark every object reachable from a root.
+ *
+ * @param vm virtual machine being collected
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_trace(struct winj_vm *vm)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_thread *thread = NULL;
+  struct winj_class *cls = NULL;
+  struct winj_field *field = NULL;
+  struct winj_object *object = NULL;
+  struct winj_array *array = NULL;
+  unsigned ii, jj;
+
+  result = winj_vm_gc_stacks(vm);
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < vm->thread_count); ++ii)
+    for (thread = vm->threads[ii], jj = 0; (EXIT_SUCCESS == result) &&
+           (jj < thread->locals.count); ++jj)
+      result = winj_vm_gc_mark(vm, thread->locals.refs[jj]);
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < vm->globals.count); ++ii)
+    result = winj_vm_gc_mark(vm, vm->globals.refs[ii]);
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < vm->class_capacity); ++ii)
+    for (cls = vm->classes[ii], jj = 0; cls && (EXIT_SUCCESS == result) &&
+           (jj < cls->static_field_capacity); ++jj)
+      if ((field = &cls->static_fields[jj])->name &&
+          (field->type == WINJ_TYPE_OBJECT))
+        result = winj_vm_gc_mark(vm, cls->static_values[field->index].l);
+
+  while ((EXIT_SUCCESS == result) && vm->gc.mark_count) {
+    object = vm->gc.marks[--vm->gc.mark_count];
+    array = (struct winj_array *)object;
+    if ((object->cls == vm->class_array) &&
+        (array->type == WINJ_TYPE_OBJECT))
+      for (ii = 0; (EXIT_SUCCESS == result) && (ii < array->count); ++ii)
+        result = winj_vm_gc_mark
+          (vm, winj_ref_decode(vm, array->elements.jobject[ii]));
+    else for (ii = 0; (EXIT_SUCCESS == result) &&
+                (ii < object->cls->reference_count); ++ii)
+        result = winj_vm_gc_mark
+          (vm, winj_ref_decode(vm, *(winj_ref *)
+                               ((u1 *)object +
+                                object->cls->references[ii])));
+  }
+  vm->gc.mark_count = 0;
+  return result;
+}
+
+/**
+ * Turn each run of unmarked objects into filler and clear marks.
+ * Regions without any marked object are released.  When marking
+ * failed everything is kept and only the marks are cleared.
+ *
+ * @param vm virtual machine being collected
+ * @param keep non-zero to keep unmarked objects
+ * @param live_out destination for bytes in objects kept
+ * @param freed_out destination for bytes in objects reclaimed */
+static void
+winj_vm_gc_sweep
+(struct winj_vm *vm, int keep, size_t *live_out, size_t *freed_out)
+{
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(struct winj_region));
+  struct winj_region **link = &vm->regions;
+  struct winj_region *region = NULL;
+  struct winj_free_chunk **tail = &vm->free_chunks;
+  struct winj_free_chunk **region_tail = NULL;
+  struct winj_object *object = NULL;
+  struct winj_object *run = NULL;
+  size_t live = 0;
+  size_t freed = 0;
+  size_t position;
+  unsigned size;
+  int alive;
+
+  vm->free_chunks = NULL;
+  while ((region = *link)) {
+    region_tail = tail;
+    alive = 0;
+    run = NULL;
+    for (position = 0; position <= region->used; position += size) {
+      object = (struct winj_object *)((u1 *)region + offset + position);
+      size = (position < region->used) ?
+        (object->size & ~WINJ_OBJECT_FLAGS) : 0;
+
+      if (size && (keep || (object->size & WINJ_OBJECT_MARKED))) {
+        object->size &= ~WINJ_OBJECT_MARKED;
+        live += object->cls ? size : 0;
+        alive = 1;
+      } else if (size) {
+        freed += object->cls ? size : 0;
+        if (!run)
+          run = object;
+        continue;
+      }
+
+      /* The run of unmarked objects (if any) ends here. */
+      if (run) {
+        run->cls = NULL;
+        run->size = (u1 *)object - (u1 *)run;
+        if (run->size >= WINJ_FREE_MINIMUM) {
+          *tail = (struct winj_free_chunk *)run;
+          (*tail)->next = NULL;
+          tail = &(*tail)->next;
+        }
+        run = NULL;
+      }
+      if (!size)
+        break;
+    }
+
+    if (alive || !region->used) {
+      link = &region->next;
+    } else {
+      *link = region->next;
+      *region_tail = NULL;
+      tail = region_tail;
+      winj_vm_space_release(vm, region, offset + region->size);
+    }
+  }
+  *live_out = live;
+  *freed_out = freed;
+}
+
+
+/**
+ * Mark everything in a nursery region as old so that the region can
+ * join the old generation without anything in it moving.  Objects
+ * which were already copied are left behind as filler.  When copying
+ * failed part way through, references may still point at such an
+ * object, so instead it gets its class back and lives on beside its
+ * copy.
+ *
+ * @param vm virtual machine being collected
+ * @param region region taken off the nursery list
+ * @param restore non-zero to restore copied objects */
+static void
+winj_vm_gc_tenure
+(struct winj_vm *vm, struct winj_region *region, int restore)
+{
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(*region));
+  struct winj_object *object = NULL;
+  size_t position;
+
+  for (position = 0; position < region->used;
+       position += object->size & ~WINJ_OBJECT_FLAGS) {
+    object = (struct winj_object *)((u1 *)region + offset + position);
+    if (!(object->size & WINJ_OBJECT_FORWARDED)) {
+    } else if (restore) {
+      object->cls = ((struct winj_object *)object->cls)->cls;
+      object->size &= ~WINJ_OBJECT_FORWARDED;
+    } else object->cls = NULL;
+    if (object->cls)
+      object->size |= WINJ_OBJECT_OLD;
+    else object->size &= ~WINJ_OBJECT_FLAGS;
+  }
+  vm->gc.allocated += region->used;
+}
+
+/**
+ * Add regions to the old generation after the one being carved up.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param regions list of regions to add */
+static void
+winj_vm_gc_adopt(struct winj_vm *vm, struct winj_region *regions)
+{
+  struct winj_region *region = NULL;
+
+  while ((region = regions)) {
+    regions = region->next;
+    if (vm->regions) {
+      region->next = vm->regions->next;
+      vm->regions->next = region;
+    } else {
+      region->next = NULL;
+      vm->regions = region;
+    }
+  }
+}
+
+/**
+ * Give up what remains of the block into which a minor collection
+ * copies objects, leaving a filler object in its place.
+ *
+ * @param vm virtual machine being collected */
+static void
+winj_vm_gc_promote_retire(struct winj_vm *vm)
+{
+  struct winj_gc *gc = &vm->gc;
+
+  if (gc->promote_top < gc->promote_end) {
+    struct winj_object *filler = (struct winj_object *)gc->promote_top;
+    filler->cls = NULL;
+    filler->size = gc->promote_end - gc->promote_top;
+  }
+  if (gc->span_count)
+    gc->spans[gc->span_count - 1].end = gc->promote_top;
+  gc->promote_top = gc->promote_end = NULL;
+}
+
+/**
+ * Take storage in the old generation for an object leaving the
+ * nursery.  Each new block becomes a span to scan for references.
+ *
+ * @param vm virtual machine being collected
+ * @param size bytes needed (at most half an allocation buffer)
+ * @param block_out destination for storage
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_promote_take(struct winj_vm *vm, size_t size, u1 **block_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_gc *gc = &vm->gc;
+  struct winj_gc_span *spans = NULL;
+  unsigned capacity = gc->span_capacity ? gc->span_capacity * 2 : 16;
+  size_t length = 0;
+  u1 *block = NULL;
+
+  if (size <= (size_t)(gc->promote_end - gc->promote_top)) {
+  } else if ((gc->span_count == gc->span_capacity) &&
+             !(spans = winj_realloc(&vm->params, gc->spans,
+                                    capacity * sizeof(*spans)))) {
+    result = winj_error(&vm->params, "failed to allocate %u bytes for "
+                        "spans", capacity * sizeof(*spans));
+  } else {
+    if (spans) {
+      gc->spans = spans;
+      gc->span_capacity = capacity;
+    }
+    winj_vm_gc_promote_retire(vm);
+    if (EXIT_SUCCESS == (result = winj_vm_old_take
+                         (vm, size, &block, &length))) {
+      gc->spans[gc->span_count].begin = block;
+      gc->spans[gc->span_count].end = block + length;
+      gc->span_count++;
+      gc->promote_top = block;
+      gc->promote_end = block + length;
+    }
+  }
+
+  if (EXIT_SUCCESS == result) {
+    *block_out = gc->promote_top;
+    gc->promote_top += size;
+    gc->promoted_bytes += size;
+  }
+  return result;
+}
+
+/**
+ * Copy a young object into the old generation unless that already
+ * happened, and update a reference to point at the copy.
+ *
+ * @param vm virtual machine being collected
+ * @param ref reference to update
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_evacuate(struct winj_vm *vm, struct winj_object **ref)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_object *object = *ref;
+  struct winj_array *array = (struct winj_array *)object;
+  u1 *block = NULL;
+  size_t size = 0;
+
+  if (!object || !object->size || (object->size & WINJ_OBJECT_OLD)) {
+  } else if (object->size & WINJ_OBJECT_FORWARDED) {
+    *ref = (struct winj_object *)object->cls;
+  } else if (EXIT_SUCCESS == (result = winj_vm_gc_promote_take
+                              (vm, size = object->size &
+                               ~WINJ_OBJECT_FLAGS, &block))) {
+    memcpy(block, object, size);
+    ((struct winj_object *)block)->size = size | WINJ_OBJECT_OLD;
+    if (object->cls == vm->class_array) /* elements are inline */
+      ((struct winj_array *)block)->elements.jobject = (winj_ref *)
+        (block + ((u1 *)array->elements.jobject - (u1 *)array));
+    object->cls = (struct winj_class *)block;
+    object->size |= WINJ_OBJECT_FORWARDED;
+    *ref = (struct winj_object *)block;
+  }
+  return result;
+}
+
+/**
+ * Evacuate the object to which a stored reference refers.
+ *
+ * @param vm virtual machine being collected
+ * @param ref reference to update
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_evacuate_ref(struct winj_vm *vm, winj_ref *ref)
+{
+  struct winj_object *object = winj_ref_decode(vm, *ref);
+  int result = winj_vm_gc_evacuate(vm, &object);
+
+  *ref = winj_ref_encode(vm, object);
+  return result;
+}
+
+/**
+ * Copy the young objects to which an object refers.
+ *
+ * @param vm virtual machine being collected
+ * @param object object to scan
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_scan(struct winj_vm *vm, struct winj_object *object)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_array *array = (struct winj_array *)object;
+  unsigned ii;
+
+  if ((object->cls == vm->class_array) &&
+      (array->type == WINJ_TYPE_OBJECT))
+    for (ii = 0; (EXIT_SUCCESS == result) && (ii < array->count); ++ii)
+      result = winj_vm_gc_evacuate_ref(vm, &array->elements.jobject[ii]);
+  else for (ii = 0; (EXIT_SUCCESS == result) &&
+              (ii < object->cls->reference_count); ++ii)
+      result = winj_vm_gc_evacuate_ref(vm, (winj_ref *)
+                                       ((u1 *)object +
+                                        object->cls->references[ii]));
+  return result;
+}
+
+/**
+ * Find whether any object in a region appears among sorted addresses.
+ *
+ * @param region region to walk
+ * @param candidates sorted addresses
+ * @param count number of addresses
+ * @return non-zero if some object was found */
+static int
+winj_region_pinned
+(struct winj_region *region, void **candidates, size_t count)
+{
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(*region));
+  struct winj_object *object = NULL;
+  size_t position;
+  int result = 0;
+
+  for (position = 0; count && !result && (position < region->used);
+       position += object->size & ~WINJ_OBJECT_FLAGS) {
+    object = (struct winj_object *)((u1 *)region + offset + position);
+    result = object->cls && bsearch(&object, candidates, count,
+                                    sizeof(*candidates),
+                                    winj_gc_address_compare);
+  }
+  return result;
+}
+
+/**
+ * Copy every young object reachable from the old generation into it,
+ * treating the objects in regions about to be tenured as old.  Each
+ * block that objects are copied into is scanned in turn, so copying
+ * proceeds breadth first without any stack.
+ *
+ * @param vm virtual machine being collected
+ * @param pinned regions being tenured
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_gc_copy(struct winj_vm *vm, struct winj_region *pinned)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_gc *gc = &vm->gc;
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(struct winj_region));
+  struct winj_region *region = NULL;
+  struct winj_object *object = NULL;
+  struct winj_class *cls = NULL;
+  struct winj_field *field = NULL;
+  size_t position;
+  u1 *scan = NULL;
+  unsigned ii, jj;
+
+  for (region = pinned; (EXIT_SUCCESS == result) && region;
+       region = region->next)
+    for (position = 0; (EXIT_SUCCESS == result) &&
+           (position < region->used); position += object->size &
+           ~WINJ_OBJECT_FLAGS) {
+      object = (struct winj_object *)((u1 *)region + offset + position);
+      if (object->cls)
+        result = winj_vm_gc_scan(vm, object);
+    }
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < vm->class_capacity); ++ii)
+    for (cls = vm->classes[ii], jj = 0; cls && (EXIT_SUCCESS == result) &&
+           (jj < cls->static_field_capacity); ++jj)
+      if ((field = &cls->static_fields[jj])->name &&
+          (field->type == WINJ_TYPE_OBJECT))
+        result = winj_vm_gc_evacuate
+          (vm, &cls->static_values[field->index].l);
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < vm->remembered.count); ++ii)
+    result = winj_vm_gc_scan(vm, vm->remembered.refs[ii]);
+
+  /* The last span keeps growing while it is scanned. */
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < gc->span_count); ++ii)
+    for (scan = gc->spans[ii].begin; (EXIT_SUCCESS == result) &&
+           (scan < ((ii + 1 < gc->span_count) ? gc->spans[ii].end :
+                    gc->promote_top)); scan += object->size &
+           ~WINJ_OBJECT_FLAGS) {
+      object = (struct winj_object *)scan;
+      result = winj_vm_gc_scan(vm, object);
+    }
+  return result;
+}
+
+/**
+ * Empty the nursery.  Regions holding an object to which a stack slot
+ * or native code refers join the old generation as they are, while
+ * young objects elsewhere survive by being copied.  Should copying
+ * fail, the whole nursery joins the old generation.
+ *
+ * @param vm virtual machine to collect
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_collect_minor(struct winj_vm *vm)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_gc *gc = &vm->gc;
+  size_t offset = WINJ_HEAP_ALIGN(sizeof(struct winj_region));
+  struct winj_region **link = &vm->nursery;
+  struct winj_region *region = NULL;
+  struct winj_region *pinned = NULL;
+  clock_t start = clock();
+  void **candidates = NULL;
+  size_t count = 0;
+  jlong promoted = gc->promoted_bytes;
+  jlong pause;
+  unsigned ii;
+
+  for (ii = 0; ii < vm->thread_count; ++ii)
+    winj_thread_tlab_retire(vm->threads[ii]);
+  result = winj_vm_gc_candidates(vm, 1, &candidates, &count);
+  while ((EXIT_SUCCESS == result) && (region = *link)) {
+    if (winj_region_pinned(region, candidates, count)) {
+      *link = region->next;
+      vm->nursery_count--;
+      winj_vm_gc_tenure(vm, region, 0);
+      region->next = pinned;
+      pinned = region;
+    } else link = &region->next;
+  }
+  winj_free(&vm->params, candidates);
+
+  if (EXIT_SUCCESS == result)
+    result = winj_vm_gc_copy(vm, pinned);
+  winj_vm_gc_promote_retire(vm);
+  gc->span_count = 0;
+  winj_vm_gc_adopt(vm, pinned);
+
+  if (EXIT_SUCCESS == result) {
+    for (region = vm->nursery; region; region = region->next) {
+      memset((u1 *)region + offset, 0, region->used);
+      region->used = 0;
+    }
+  } else {
+    for (region = vm->nursery; region; region = region->next)
+      winj_vm_gc_tenure(vm, region, 1);
+    winj_vm_gc_adopt(vm, vm->nursery);
+    vm->nursery = NULL;
+    vm->nursery_count = 0;
+  }
+  vm->nursery_fill = vm->nursery;
+
+  /* Nothing young is left for old objects to refer to. */
+  for (ii = 0; ii < vm->remembered.count; ++ii)
+    vm->remembered.refs[ii]->size &= ~WINJ_OBJECT_REMEMBERED;
+  vm->remembered.count = 0;
+
+  pause = (jlong)(clock() - start) * 1000000 / CLOCKS_PER_SEC;
+  gc->minor_collections++;
+  gc->minor_pause_total += pause;
+  if (pause > gc->minor_pause_max)
+    gc->minor_pause_max = pause;
+  winj_debug(&vm->params, "promoted %lu bytes in %ld us", (unsigned long)
+             (gc->promoted_bytes - promoted), (long)pause);
+  return result;
+}
+
+/**
+ * Reclaim objects which can no longer be reached.
+ *
+ * @param vm virtual machine to collect
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_collect(struct winj_vm *vm)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_gc *gc = &vm->gc;
+  clock_t start = clock();
+  size_t live = 0;
+  size_t freed = 0;
+  jlong pause;
+  unsigned ii;
+
+  if (gc->generational)
+    result = winj_vm_collect_minor(vm);
+  for (ii = 0; ii < vm->thread_count; ++ii)
+    winj_thread_tlab_retire(vm->threads[ii]);
+  if (EXIT_SUCCESS == result)
+    result = winj_vm_gc_trace(vm);
+  winj_vm_gc_sweep(vm, EXIT_SUCCESS != result, &live, &freed);
+
+  pause = (jlong)(clock() - start) * 1000000 / CLOCKS_PER_SEC;
+  gc->collections++;
+  gc->pause_total += pause;
+  gc->pause_last = pause;
+  if (pause > gc->pause_max)
+    gc->pause_max = pause;
+  gc->live_bytes = live;
+  gc->freed_bytes += freed;
+  gc->allocated = 0;
+  gc->threshold = (live > WINJ_GC_THRESHOLD) ? live : WINJ_GC_THRESHOLD;
+  winj_debug(&vm->params, "collected %lu bytes leaving %lu in %ld us",
+             (unsigned long)freed, (unsigned long)live, (long)pause);
+  return result;
+}
+
+/**
+ * Allocate zeroed storage for an object.  The common case takes the
+ * next bytes of the allocation buffer of the thread.  A full
+ * collection happens first when enough has been allocated in the old
+ * generation since the last one, and a minor one when the nursery
+ * has no buffer left to give.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class of new object
+ * @param size bytes needed, including object header (at most half
+ *        of the range of an unsigned integer)
+ * @param object_out destination for new object
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_allocate
+(struct winj_thread *thread, struct winj_class *cls, size_t size,
+ struct winj_object **object_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm *vm = thread->vm;
+  unsigned flags = vm->gc.born;
+  u1 *block = NULL;
+
+  size = WINJ_HEAP_ALIGN(size);
+  if (size <= (size_t)(thread->tlab_end - thread->tlab_top)) {
+    block = thread->tlab_top;
+    thread->tlab_top += size;
+  } else if (size > (unsigned)-1 / 2) {
+    result = EXIT_FAILURE; /* too big for object header */
+  } else if ((vm->gc.allocated >= vm->gc.threshold) &&
+             (EXIT_SUCCESS != (result = winj_vm_collect(vm)))) {
+  } else if (size > WINJ_TLAB_SIZE / 2) {
+    flags = WINJ_OBJECT_OLD;
+    result = winj_vm_heap_take(vm, size, &block);
+  } else if (EXIT_SUCCESS != (result = winj_thread_tlab_refill
+                              (thread, size))) {
+  } else if (!thread->tlab_top &&
+             ((EXIT_SUCCESS != (result = winj_vm_collect_minor(vm))) ||
+              (EXIT_SUCCESS != (result = winj_thread_tlab_refill
+                                (thread, size))))) {
+  } else if (!thread->tlab_top) {
+    result = EXIT_FAILURE;
+  } else {
+    block = thread->tlab_top;
+    thread->tlab_top += size;
+  }
+
+  if (EXIT_SUCCESS != result) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %lu bytes for %.*s",
+                      (unsigned long)size, cls->name_len, cls->name);
+  } else {
+    *object_out = (struct winj_object *)block;
+    (*object_out)->cls = cls;
+    (*object_out)->size = size | flags;
+  }
+  return result;
+}
+
+/**
+ * Create an instance of a class.  Constructors are not called.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class of which to create an instance
+ * @param object_out destination for new object
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_object_new
+(struct winj_thread *thread, struct winj_class *cls,
+ jobject *object_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_object *object = NULL;
+
+  if (cls->access_flags & (WINJ_ACCESS_ABSTRACT | WINJ_ACCESS_INTERFACE)) {
+    winj_thread_throw(thread, 0, "java/lang/InstantiationError",
+                      "%.*s", cls->name_len, cls->name);
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS == (result = winj_thread_allocate
+                              (thread, cls, cls->instance_size, &object)))
+    *object_out = object;
+  return result;
+}
+
+/**
+ * Create an array with every element zero or null.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param type type of elements
+ * @param element_class class of elements for object arrays
+ * @param count number of elements
+ * @param array_out destination for new array
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_array_new
+(struct winj_thread *thread, enum winj_type type,
+ struct winj_class *element_class, jint count,
+ struct winj_array **array_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_object *object = NULL;
+  struct winj_array *array = NULL;
+  size_t header = WINJ_HEAP_ALIGN(sizeof(*array));
+  unsigned width = winj_type_size(type);
+
+  if (count < 0) {
+    winj_thread_throw(thread, 0, "java/lang/NegativeArraySizeException",
+                      "%d", count);
+    result = EXIT_FAILURE;
+  } else if (!width) {
+    winj_thread_throw(thread, 0, "java/lang/InternalError",
+                      "invalid array type %u", (unsigned)type);
+    result = EXIT_FAILURE;
+  } else if ((unsigned)count > ((unsigned)-1 / 2 - header) / width) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "array too large: %d", count);
+    result = EXIT_FAILURE;
+  } else if (EXIT_SUCCESS == (result = winj_thread_allocate
+                              (thread, thread->vm->class_array, header +
+                               (size_t)count * width, &object))) {
+    /* Elements follow the array header in the same block. */
+    array = (struct winj_array *)object;
+    array->count = count;
+    array->type = type;
+    array->element_class = element_class;
+    array->elements.jobject = (winj_ref *)((u1 *)array + header);
+    *array_out = array;
+  }
+  return result;
+}
+
+/**
+ * Find the byte array which holds the characters of a string.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param string a java/lang/String
+ * @return array of bytes or NULL for an empty string */
+static inline struct winj_array *
+winj_string_value(const struct winj_vm *vm, struct winj_object *string)
+{
+  return (struct winj_array *)winj_ref_decode
+    (vm, WINJ_OFFSET(string, vm->offsets.string_value, winj_ref));
+}
+
+/**
+ * Find the characters of a string along with how many there are and
+ * how they are encoded.  A string made without a constructor has no
+ * array and is empty.
+ *
+ * @param vm virtual machine which owns the heap
+ * @param string a java/lang/String
+ * @param count_out destination for number of characters
+ * @param coder_out destination for encoding of characters
+ * @return bytes holding characters or NULL when there are none */
+static inline const u1 *
+winj_string_bytes(const struct winj_vm *vm, struct winj_object *string,
+                  unsigned *count_out, enum winj_coder *coder_out)
+{
+  struct winj_array *value = winj_string_value(vm, string);
+  enum winj_coder coder = (enum winj_coder)WINJ_OFFSET
+    (string, vm->offsets.string_coder, jbyte);
+
+  *coder_out = coder;
+  *count_out = value ? (value->count >> coder) : 0;
+  return value ? (const u1 *)value->elements.jbyte : NULL;
+}
+
+static inline jchar
+winj_string_unit(const u1 *bytes, enum winj_coder coder, unsigned index)
+{
+  return coder ? ((const jchar *)bytes)[index] : bytes[index];
+}
+
+/**
+ * Create a string which takes ownership of a byte array.  The array
+ * is kept as a local reference only while the string is allocated,
+ * so that it cannot move, and afterward lives as long as the string.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param value byte array to hold the characters of the string
+ * @param coder encoding of characters in value
+ * @param string_out destination for new string
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_string_wrap
+(struct winj_thread *thread, struct winj_array *value,
+ enum winj_coder coder, struct winj_object **string_out)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm *vm = thread->vm;
+  struct winj_object *string = NULL;
+
+  if (!winj_thread_local_ref(thread, &value->self)) {
+    result = EXIT_FAILURE;
+  } else {
+    if (EXIT_SUCCESS != (result = winj_thread_allocate
+                         (thread, vm->class_string,
+                          vm->class_string->instance_size, &string))) {
+    } else if (EXIT_SUCCESS != (result = winj_vm_gc_remember
+                                (vm, string, &value->self))) {
+      winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                        "failed to remember string");
+    } else {
+      WINJ_OFFSET(string, vm->offsets.string_value, winj_ref) =
+        winj_ref_encode(vm, &value->self);
+      WINJ_OFFSET(string, vm->offsets.string_coder, jbyte) =
+        (jbyte)coder;
+      *string_out = string;
+    }
+    winj_reflist_remove(&thread->locals, &value->self);
+  }
+  return result;
+}
+
+/**
+ * Make a byte array for the characters of a new string.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param count number of characters
+ * @param coder encoding of characters
+ * @param value_out destination for new array
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_string_value
+(struct winj_thread *thread, unsigned count, enum winj_coder coder,
+ struct winj_array **value_out)
+{
+  int result = EXIT_SUCCESS;
+
+  if (count > ((unsigned)INT32_MAX >> coder)) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "string too long: %u", count);
+    result = EXIT_FAILURE;
+  } else result = winj_thread_array_new
+           (thread, WINJ_TYPE_BYTE, NULL, (jint)(count << coder),
+            value_out);
+  return result;
+}
+
+/**
+ * Choose the encoding for a string made from UTF-16 code units.
+ *
+ * @param count number of code units
+ * @param chars code units to check
+ * @return Latin-1 if every code unit fits and UTF-16 otherwise */
+static enum winj_coder
+winj_chars_coder(unsigned count, const jchar *chars)
+{
+  return (winj_latin1_units(count, chars) < count) ?
+    WINJ_CODER_UTF16 : WINJ_CODER_LATIN1;
+}
+
+/**
+ * Copy UTF-16 code units into the bytes of a string.
+ *
+ * @param count number of code units
+ * @param chars code units to copy
+ * @param coder encoding chosen for the string
+ * @param bytes destination for characters */
+static void
+winj_chars_store
+(unsigned count, const jchar *chars, enum winj_coder coder, u1 *bytes)
+{
+  if (coder)
+    memcpy(bytes, chars, (size_t)count * sizeof(*chars));
+  else winj_chars_narrow(count, chars, bytes);
+}
+
+/**
+ * Create a string holding a copy of some UTF-16 code units, using
+ * Latin-1 if it can.  The code units must not be in the heap, since
+ * allocating the string can move anything not pinned.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param count number of code units
+ * @param chars code units to copy
+ * @param string_out destination for new string
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_string_new
+(struct winj_thread *thread, unsigned count, const jchar *chars,
+ struct winj_object **string_out)
+{
+  int result = EXIT_SUCCESS;
+  enum winj_coder coder = winj_chars_coder(count, chars);
+  struct winj_array *value = NULL;
+
+  if (EXIT_SUCCESS == (result = winj_thread_string_value
+                       (thread, count, coder, &value))) {
+    winj_chars_store(count, chars, coder, (u1 *)value->elements.jbyte);
+    result = winj_thread_string_wrap(thread, value, coder, string_out);
+  }
+  return result;
+}
+
+/**
+ * Call a built in or native method using arguments taken from stack
+ * slots, as happens when byte code invokes such a method.
+ *
+ * @param thread thread on which to call method
+ * @param cls class to which method belongs
+ * @param method method to call
+ * @param self object for instance methods or NULL for static ones
+ * @param slots arguments as they appear on the operand stack
+ * @param return_type_out destination for type of value returned
+ * @param value_out destination for value returned
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_invoke_slots
+(struct winj_thread *thread, struct winj_class *cls,
+ struct winj_method *method, jobject self, const winj_slot *slots,
+ enum winj_type *return_type_out, jvalue *value_out)
+{
+  int result = EXIT_FAILURE;
+  struct winj_argument buffer[WINJ_ARGUMENT_INLINE];
+  struct winj_argument *arguments = winj_thread_arguments
+    (thread, &method->signature, buffer);
+  unsigned ii;
+
+  *return_type_out = method->signature.return_type;
+  if (arguments) {
+    for (ii = 0; ii < method->signature.count; ++ii)
+      slots += winj_slots_load
+        (thread->vm, arguments[ii].argtype, slots, &arguments[ii].value);
+    result = winj_thread_invoke(thread, cls, method, self,
+                                method->signature.count, arguments,
+                                value_out);
+    winj_thread_arguments_free(thread, arguments, buffer);
+  }
+  return result;
+}
+
+/* Operands are big endian and follow the opcode. */
+#define WINJ_U2_AT(p) ((u2)(((p)[0] << 8) | (p)[1]))
+#define WINJ_S2_AT(p) ((int16_t)WINJ_U2_AT(p))
+#define WINJ_S4_AT(p)                                                 \
+  ((jint)(((u4)(p)[0] << 24) | ((u4)(p)[1] << 16) |                   \
+          ((u4)(p)[2] << 8) | (u4)(p)[3]))
+
+/**
+ * Determine the length of the byte code instruction at an offset.
+ * Switch instructions are padded so that their tables are aligned
+ * relative to the start of the code.
+ *
+ * @param code byte code of a method
+ * @param offset position of instruction in code
+ * @param code_length number of bytes of code
+ * @return number of bytes in instruction or zero if invalid */
+static unsigned
+winj_insn_length(const u1 *code, unsigned offset, unsigned code_length)
+{
+  unsigned result = 0;
+  unsigned table = (offset + 4) & ~3u; /* after padding */
+
+  switch (code[offset]) {
+  case WINJ_OPCODE_BIPUSH: case WINJ_OPCODE_LDC:
+  case WINJ_OPCODE_ILOAD:  case WINJ_OPCODE_LLOAD:
+  case WINJ_OPCODE_FLOAD:  case WINJ_OPCODE_DLOAD:
+  case WINJ_OPCODE_ALOAD:  case WINJ_OPCODE_ISTORE:
+  case WINJ_OPCODE_LSTORE: case WINJ_OPCODE_FSTORE:
+  case WINJ_OPCODE_DSTORE: case WINJ_OPCODE_ASTORE:
+  case WINJ_OPCODE_RET:    case WINJ_OPCODE_NEWARRAY:
+    result = 2; break;
+  case WINJ_OPCODE_SIPUSH:    case WINJ_OPCODE_LDC_W:
+  case WINJ_OPCODE_LDC2_W:    case WINJ_OPCODE_IINC:
+  case WINJ_OPCODE_IFEQ:      case WINJ_OPCODE_IFNE:
+  case WINJ_OPCODE_IFLT:      case WINJ_OPCODE_IFGE:
+  case WINJ_OPCODE_IFGT:      case WINJ_OPCODE_IFLE:
+  case WINJ_OPCODE_IF_ICMPEQ: case WINJ_OPCODE_IF_ICMPNE:
+  case WINJ_OPCODE_IF_ICMPLT: case WINJ_OPCODE_IF_ICMPGE:
+  case WINJ_OPCODE_IF_ICMPGT: case WINJ_OPCODE_IF_ICMPLE:
+  case WINJ_OPCODE_IF_ACMPEQ: case WINJ_OPCODE_IF_ACMPNE:
+  case WINJ_OPCODE_GOTO:      case WINJ_OPCODE_JSR:
+  case WINJ_OPCODE_GETSTATIC: case WINJ_OPCODE_PUTSTATIC:
+  case WINJ_OPCODE_GETFIELD:  case WINJ_OPCODE_PUTFIELD:
+  case WINJ_OPCODE_INVOKEVIRTUAL: case WINJ_OPCODE_INVOKESPECIAL:
+  case WINJ_OPCODE_INVOKESTATIC:  case WINJ_OPCODE_NEW:
+  case WINJ_OPCODE_ANEWARRAY: case WINJ_OPCODE_CHECKCAST:
+  case WINJ_OPCODE_INSTANCEOF:
+  case WINJ_OPCODE_IFNULL:    case WINJ_OPCODE_IFNONNULL:
+    result = 3; break;
+  case WINJ_OPCODE_MULTIANEWARRAY:
+    result = 4; break;
+  case WINJ_OPCODE_INVOKEINTERFACE: case WINJ_OPCODE_INVOKEDYNAMIC:
+  case WINJ_OPCODE_GOTO_W:          case WINJ_OPCODE_JSR_W:
+    result = 5; break;
+  case WINJ_OPCODE_WIDE:
+    if (offset + 1 < code_length)
+      result = (code[offset + 1] == WINJ_OPCODE_IINC) ? 6 : 4;
+    break;
+  case WINJ_OPCODE_TABLESWITCH:
+    if (table + 12 <= code_length) {
+      jint low  = WINJ_S4_AT(code + table + 4);
+      jint high = WINJ_S4_AT(code + table + 8);
+
+      if ((high >= low) && ((u4)high - (u4)low < code_length))
+        result = table + 12 + 4 * ((u4)high - (u4)low + 1) - offset;
+    }
+    break;
+  case WINJ_OPCODE_LOOKUPSWITCH:
+    if (table + 8 <= code_length) {
+      jint npairs = WINJ_S4_AT(code + table + 4);
+
+      if ((npairs >= 0) && ((u4)npairs < code_length))
+        result = table + 8 + 8 * (u4)npairs - offset;
+    }
+    break;
+  default:
+    if (code[offset] < WINJ_OPCODE_BREAKPOINT)
+      result = 1;
+  }
+  return (offset + result <= code_length) ? result : 0;
+}
+
+/**
+ * Find the internal instruction which corresponds to the destination
+ * of a branch.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param insns instructions being translated
+ * @param offsets one more than the instruction index at each offset
+ * @param code_length number of bytes of code
+ * @param offset position of branch instruction in code
+ * @param delta branch offset relative to branch instruction
+ * @param target_out destination for branch target
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_insn_branch
+(struct winj_thread *thread, struct winj_insn *insns,
+ const unsigned *offsets, unsigned code_length, unsigned offset,
+ jint delta, struct winj_insn **target_out)
+{
+  int result = EXIT_SUCCESS;
+  u4 target = (u4)offset + (u4)delta;
+
+  if ((target >= code_length) || !offsets[target]) {
+    winj_thread_throw(thread, 0, "java/lang/VerifyError",
+                      "invalid branch from %u to %d",
+                      offset, (int)target);
+    result = EXIT_FAILURE;
+  } else *target_out = &insns[offsets[target] - 1];
+  return result;
+}
+
+#ifndef WINJ_PAIR_PROFILE
+/**
+ * Sequences of instructions which are replaced by superinstructions,
+ * longest first.  These were chosen from opcode pair counts gathered
+ * by a WINJ_PAIR_PROFILE build running the test suite: loop tests
+ * comparing two locals or a local and an array length, increments
+ * followed by a jump back and arithmetic stored straight to a local. */
+static const struct winj_fusion {
+  u1 fused;
+  u1 count;
+  u1 opcodes[4];
+} winj_fusions[] = {
+  { WINJ_OPCODE_ILOAD_ALOAD_ARRAYLENGTH_IF_ICMPGE, 4,
+    { WINJ_OPCODE_ILOAD, WINJ_OPCODE_ALOAD,
+      WINJ_OPCODE_ARRAYLENGTH, WINJ_OPCODE_IF_ICMPGE } },
+  { WINJ_OPCODE_ILOAD_ILOAD_IF_ICMPGE, 3,
+    { WINJ_OPCODE_ILOAD, WINJ_OPCODE_ILOAD, WINJ_OPCODE_IF_ICMPGE } },
+  { WINJ_OPCODE_ILOAD_ILOAD_IF_ICMPLT, 3,
+    { WINJ_OPCODE_ILOAD, WINJ_OPCODE_ILOAD, WINJ_OPCODE_IF_ICMPLT } },
+  { WINJ_OPCODE_ILOAD_ILOAD, 2,
+    { WINJ_OPCODE_ILOAD, WINJ_OPCODE_ILOAD } },
+  { WINJ_OPCODE_ILOAD_BIPUSH, 2,
+    { WINJ_OPCODE_ILOAD, WINJ_OPCODE_BIPUSH } },
+  { WINJ_OPCODE_IINC_GOTO, 2,
+    { WINJ_OPCODE_IINC, WINJ_OPCODE_GOTO } },
+  { WINJ_OPCODE_IADD_ISTORE, 2,
+    { WINJ_OPCODE_IADD, WINJ_OPCODE_ISTORE } },
+};
+
+/**
+ * Replace the first instruction of each common sequence with a
+ * superinstruction that does the work of the whole sequence in one
+ * dispatch.  The rest of the sequence is left alone, both to supply
+ * operands to the superinstruction and so that branches into the
+ * middle of a sequence still find ordinary instructions.
+ *
+ * @param insns translated instructions of a method
+ * @param insn_count number of instructions */
+static void
+winj_insns_fuse(struct winj_insn *insns, unsigned insn_count)
+{
+  unsigned index = 0;
+
+  while (index < insn_count) {
+    const struct winj_fusion *fusion = NULL;
+    unsigned ii, jj;
+
+    for (ii = 0; !fusion &&
+           (ii < sizeof(winj_fusions) / sizeof(*winj_fusions)); ++ii) {
+      for (jj = 0; (jj < winj_fusions[ii].count) &&
+             (index + jj < insn_count) &&
+             (insns[index + jj].opcode ==
+              winj_fusions[ii].opcodes[jj]); ++jj)
+        ;
+      if (jj == winj_fusions[ii].count)
+        fusion = &winj_fusions[ii];
+    }
+    if (fusion) {
+      insns[index].opcode = fusion->fused;
+      index += fusion->count;
+    } else ++index;
+  }
+}
+#endif
+
+/**
+ * Translate the byte code of a method into internal instructions.
+ * Operands are decoded, local variable shortcuts and wide variants
+ * are folded into their general forms, constants are loaded and
+ * branch offsets become pointers to instructions.  Constant pool
+ * references are left for the interpreter to resolve the first time
+ * each instruction executes, after which the instruction is replaced
+ * by an internal opcode that uses the resolved member directly.
+ * Common sequences are then fused into superinstructions.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param cls class to which method belongs
+ * @param method method with byte code to translate
+ * @param handlers table of handler addresses for threaded dispatch
+ *        or NULL when the interpreter uses a switch statement
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_method_translate
+(struct winj_thread *thread, struct winj_class *cls,
+ struct winj_method *method, const void *const *handlers)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = &thread->vm->params;
+  struct winj_class_file *class_file = cls->class_file;
+  const u1 *code = method->method_file->code.code.value;
+  unsigned code_length = method->method_file->code.code.count;
+  unsigned *offsets = NULL; /* one more than instruction index */
+  struct winj_insn *insns = NULL;
+  struct winj_call_cache *caches = NULL;
+  jint *tables = NULL;
+  unsigned insn_count = 0;
+  unsigned cache_count = 0;
+  unsigned table_count = 0;
+  unsigned offset = 0;
+  unsigned length = 0;
+
+  if (!(offsets = winj_calloc(params, code_length + 1,
+                              sizeof(*offsets)))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %u offsets", code_length);
+    result = EXIT_FAILURE;
+  } else for (offset = 0; (EXIT_SUCCESS == result) &&
+                (offset < code_length); offset += length) {
+      const u1 *table = code + ((offset + 4) & ~3u);
+
+      if (!(length = winj_insn_length(code, offset, code_length))) {
+        winj_thread_throw(thread, 0, "java/lang/VerifyError",
+                          "invalid instruction 0x%02x at %u in "
+                          "%.*s.%.*s", code[offset], offset,
+                          cls->name_len, cls->name,
+                          method->name_len, method->name);
+        result = EXIT_FAILURE;
+      } else if (code[offset] == WINJ_OPCODE_TABLESWITCH)
+        table_count += 3 + (unsigned)(WINJ_S4_AT(table + 8) -
+                                      WINJ_S4_AT(table + 4)) + 1;
+      else if (code[offset] == WINJ_OPCODE_LOOKUPSWITCH)
+        table_count += 2 + 2 * (unsigned)WINJ_S4_AT(table + 4);
+      else if ((code[offset] == WINJ_OPCODE_INVOKEVIRTUAL) ||
+               (code[offset] == WINJ_OPCODE_INVOKEINTERFACE))
+        cache_count++;
+      offsets[offset] = ++insn_count;
+    }
+
+  /* Inline caches and then switch tables are stored after the
+   * instructions, which end with an extra instruction that catches
+   * execution running off the end of the code. */
+  if (EXIT_SUCCESS != result) {
+  } else if (!(insns = winj_calloc
+               (params, 1, (insn_count + 1) * sizeof(*insns) +
+                cache_count * sizeof(*caches) +
+                table_count * sizeof(*tables)))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %u instructions", insn_count);
+    result = EXIT_FAILURE;
+  } else {
+    caches = (struct winj_call_cache *)&insns[insn_count + 1];
+    tables = (jint *)&caches[cache_count];
+  }
+
+#define WINJ_BRANCH(insn, delta)                                      \
+  winj_insn_branch(thread, insns, offsets, code_length, offset,       \
+                   (delta), &(insn))
+
+  for (offset = 0; (EXIT_SUCCESS == result) && (offset < code_length);
+       offset += winj_insn_length(code, offset, code_length)) {
+    struct winj_insn *insn = &insns[offsets[offset] - 1];
+    const u1 *operands = code + offset + 1;
+    const u1 *table = code + ((offset + 4) & ~3u);
+    struct winj_cpool *constant = NULL;
+    u1 opcode = code[offset];
+    jint ii;
+
+    insn->opcode = opcode;
+    switch (opcode) {
+    case WINJ_OPCODE_ICONST_M1: case WINJ_OPCODE_ICONST_0:
+    case WINJ_OPCODE_ICONST_1:  case WINJ_OPCODE_ICONST_2:
+    case WINJ_OPCODE_ICONST_3:  case WINJ_OPCODE_ICONST_4:
+    case WINJ_OPCODE_ICONST_5:
+      insn->opcode = WINJ_OPCODE_BIPUSH;
+      insn->value = (jint)opcode - WINJ_OPCODE_ICONST_0;
+      break;
+    case WINJ_OPCODE_BIPUSH:
+      insn->value = (jbyte)operands[0]; break;
+    case WINJ_OPCODE_SIPUSH:
+      insn->opcode = WINJ_OPCODE_BIPUSH;
+      insn->value = WINJ_S2_AT(operands);
+      break;
+    case WINJ_OPCODE_LDC: case WINJ_OPCODE_LDC_W:
+    case WINJ_OPCODE_LDC2_W:
+      insn->index = (opcode == WINJ_OPCODE_LDC) ? operands[0] :
+        WINJ_U2_AT(operands);
+      if (!insn->index || (insn->index >= class_file->cpool_count)) {
+        winj_thread_throw(thread, 0, "java/lang/VerifyError",
+                          "invalid constant index %u at %u",
+                          insn->index, offset);
+        result = EXIT_FAILURE;
+        break;
+      }
+      constant = &class_file->cpool[class_file->cpool_idx[insn->index]];
+      switch (constant->tag) {
+      case WINJ_CONST_INTEGER:
+        insn->opcode = WINJ_OPCODE_LDC;
+        insn->value = constant->info.const_int;
+        break;
+      case WINJ_CONST_FLOAT:
+        insn->opcode = WINJ_OPCODE_LDC;
+        memcpy(&insn->value, &constant->info.const_float,
+               sizeof(insn->value));
+        break;
+      case WINJ_CONST_LONG:
+        insn->opcode = WINJ_OPCODE_LDC2_W;
+        insn->operand.j = constant->info.const_long;
+        break;
+      case WINJ_CONST_DOUBLE:
+        insn->opcode = WINJ_OPCODE_LDC2_W;
+        insn->operand.d = constant->info.const_double;
+        break;
+      default: /* TODO: strings, classes, method handles */
+        insn->opcode = WINJ_OPCODE_LDC_W;
+      }
+      break;
+
+    case WINJ_OPCODE_ILOAD:  case WINJ_OPCODE_LLOAD:
+    case WINJ_OPCODE_FLOAD:  case WINJ_OPCODE_DLOAD:
+    case WINJ_OPCODE_ALOAD:  case WINJ_OPCODE_ISTORE:
+    case WINJ_OPCODE_LSTORE: case WINJ_OPCODE_FSTORE:
+    case WINJ_OPCODE_DSTORE: case WINJ_OPCODE_ASTORE:
+      insn->index = operands[0]; break;
+    case WINJ_OPCODE_ILOAD_0: case WINJ_OPCODE_ILOAD_1:
+    case WINJ_OPCODE_ILOAD_2: case WINJ_OPCODE_ILOAD_3:
+    case WINJ_OPCODE_LLOAD_0: case WINJ_OPCODE_LLOAD_1:
+    case WINJ_OPCODE_LLOAD_2: case WINJ_OPCODE_LLOAD_3:
+    case WINJ_OPCODE_FLOAD_0: case WINJ_OPCODE_FLOAD_1:
+    case WINJ_OPCODE_FLOAD_2: case WINJ_OPCODE_FLOAD_3:
+    case WINJ_OPCODE_DLOAD_0: case WINJ_OPCODE_DLOAD_1:
+    case WINJ_OPCODE_DLOAD_2: case WINJ_OPCODE_DLOAD_3:
+    case WINJ_OPCODE_ALOAD_0: case WINJ_OPCODE_ALOAD_1:
+    case WINJ_OPCODE_ALOAD_2: case WINJ_OPCODE_ALOAD_3:
+      insn->opcode = WINJ_OPCODE_ILOAD +
+        (opcode - WINJ_OPCODE_ILOAD_0) / 4;
+      insn->index = (opcode - WINJ_OPCODE_ILOAD_0) % 4;
+      break;
+    case WINJ_OPCODE_ISTORE_0: case WINJ_OPCODE_ISTORE_1:
+    case WINJ_OPCODE_ISTORE_2: case WINJ_OPCODE_ISTORE_3:
+    case WINJ_OPCODE_LSTORE_0: case WINJ_OPCODE_LSTORE_1:
+    case WINJ_OPCODE_LSTORE_2: case WINJ_OPCODE_LSTORE_3:
+    case WINJ_OPCODE_FSTORE_0: case WINJ_OPCODE_FSTORE_1:
+    case WINJ_OPCODE_FSTORE_2: case WINJ_OPCODE_FSTORE_3:
+    case WINJ_OPCODE_DSTORE_0: case WINJ_OPCODE_DSTORE_1:
+    case WINJ_OPCODE_DSTORE_2: case WINJ_OPCODE_DSTORE_3:
+    case WINJ_OPCODE_ASTORE_0: case WINJ_OPCODE_ASTORE_1:
+    case WINJ_OPCODE_ASTORE_2: case WINJ_OPCODE_ASTORE_3:
+      insn->opcode = WINJ_OPCODE_ISTORE +
+        (opcode - WINJ_OPCODE_ISTORE_0) / 4;
+      insn->index = (opcode - WINJ_OPCODE_ISTORE_0) % 4;
+      break;
+    case WINJ_OPCODE_IINC:
+      insn->index = operands[0];
+      insn->value = (jbyte)operands[1];
+      break;
+    case WINJ_OPCODE_WIDE:
+      insn->opcode = operands[0];
+      insn->index = WINJ_U2_AT(operands + 1);
+      if (operands[0] == WINJ_OPCODE_IINC)
+        insn->value = WINJ_S2_AT(operands + 3);
+      else if ((operands[0] < WINJ_OPCODE_ILOAD) ||
+               ((operands[0] > WINJ_OPCODE_ALOAD) &&
+                (operands[0] < WINJ_OPCODE_ISTORE)) ||
+               (operands[0] > WINJ_OPCODE_ASTORE)) {
+        winj_thread_throw(thread, 0, "java/lang/VerifyError",
+                          "invalid wide opcode 0x%02x at %u",
+                          operands[0], offset);
+        result = EXIT_FAILURE;
+      }
+      break;
+
+    case WINJ_OPCODE_IFEQ:      case WINJ_OPCODE_IFNE:
+    case WINJ_OPCODE_IFLT:      case WINJ_OPCODE_IFGE:
+    case WINJ_OPCODE_IFGT:      case WINJ_OPCODE_IFLE:
+    case WINJ_OPCODE_IF_ICMPEQ: case WINJ_OPCODE_IF_ICMPNE:
+    case WINJ_OPCODE_IF_ICMPLT: case WINJ_OPCODE_IF_ICMPGE:
+    case WINJ_OPCODE_IF_ICMPGT: case WINJ_OPCODE_IF_ICMPLE:
+    case WINJ_OPCODE_IF_ACMPEQ: case WINJ_OPCODE_IF_ACMPNE:
+    case WINJ_OPCODE_IFNULL:    case WINJ_OPCODE_IFNONNULL:
+    case WINJ_OPCODE_GOTO:
+      result = WINJ_BRANCH(insn->operand.target, WINJ_S2_AT(operands));
+      break;
+    case WINJ_OPCODE_GOTO_W:
+      insn->opcode = WINJ_OPCODE_GOTO;
+      result = WINJ_BRANCH(insn->operand.target, WINJ_S4_AT(operands));
+      break;
+
+    /* Tables hold instruction indexes rather than byte offsets:
+     *   tableswitch:  low, high, default, targets...
+     *   lookupswitch: npairs, default, (match, target)... */
+    case WINJ_OPCODE_TABLESWITCH: {
+      jint low  = WINJ_S4_AT(table + 4);
+      jint high = WINJ_S4_AT(table + 8);
+      struct winj_insn *target = NULL;
+
+      insn->operand.table = tables;
+      *tables++ = low;
+      *tables++ = high;
+      for (ii = -1; (EXIT_SUCCESS == result) &&
+             (ii <= (jint)((u4)high - (u4)low)); ++ii)
+        if (EXIT_SUCCESS == (result = WINJ_BRANCH
+                             (target, WINJ_S4_AT
+                              (table + ((ii < 0) ? 0 : 12 + 4 * ii)))))
+          *tables++ = (jint)(target - insns);
+    } break;
+    case WINJ_OPCODE_LOOKUPSWITCH: {
+      jint npairs = WINJ_S4_AT(table + 4);
+      struct winj_insn *target = NULL;
+
+      insn->operand.table = tables;
+      *tables++ = npairs;
+      if (EXIT_SUCCESS == (result = WINJ_BRANCH
+                           (target, WINJ_S4_AT(table))))
+        *tables++ = (jint)(target - insns);
+      for (ii = 0; (EXIT_SUCCESS == result) && (ii < npairs); ++ii) {
+        *tables++ = WINJ_S4_AT(table + 8 + 8 * ii);
+        if (EXIT_SUCCESS == (result = WINJ_BRANCH
+                             (target, WINJ_S4_AT(table + 12 + 8 * ii))))
+          *tables++ = (jint)(target - insns);
+      }
+    } break;
+
+    case WINJ_OPCODE_GETSTATIC:    case WINJ_OPCODE_PUTSTATIC:
+    case WINJ_OPCODE_GETFIELD:     case WINJ_OPCODE_PUTFIELD:
+    case WINJ_OPCODE_INVOKEVIRTUAL: case WINJ_OPCODE_INVOKESPECIAL:
+    case WINJ_OPCODE_INVOKESTATIC: case WINJ_OPCODE_NEW:
+    case WINJ_OPCODE_ANEWARRAY:    case WINJ_OPCODE_CHECKCAST:
+    case WINJ_OPCODE_INSTANCEOF:   case WINJ_OPCODE_MULTIANEWARRAY:
+    case WINJ_OPCODE_INVOKEINTERFACE: case WINJ_OPCODE_INVOKEDYNAMIC:
+      insn->index = WINJ_U2_AT(operands);
+      if (opcode == WINJ_OPCODE_MULTIANEWARRAY)
+        insn->value = operands[2];
+      else if ((opcode == WINJ_OPCODE_INVOKEVIRTUAL) ||
+               (opcode == WINJ_OPCODE_INVOKEINTERFACE))
+        insn->operand.cache = caches++;
+      break;
+    case WINJ_OPCODE_NEWARRAY:
+      insn->value = operands[0]; break;
+    default: /* no operands or not yet implemented */ break;
+    }
+  }
+#undef WINJ_BRANCH
+
+  if (EXIT_SUCCESS == result) {
+    unsigned index;
+
+    insns[insn_count].opcode = WINJ_OPCODE_BREAKPOINT;
+#ifndef WINJ_PAIR_PROFILE
+    winj_insns_fuse(insns, insn_count);
+#endif
+    for (index = 0; handlers && (index <= insn_count); ++index)
+      insns[index].handler = handlers[insns[index].opcode];
+    method->insns = insns;
+    insns = NULL;
+  }
+  winj_free(params, insns);
+  winj_free(params, offsets);
+  return result;
+}
+
+#undef WINJ_U2_AT
+#undef WINJ_S2_AT
+#undef WINJ_S4_AT
+
+/**
+ * Find the method named by a quickened call instruction.
+ *
+ * @param insn call instruction
+ * @return resolved method */
+static struct winj_method *
+winj_insn_method(const struct winj_insn *insn)
+{
+  return (insn->opcode == WINJ_OPCODE_INVOKECACHED_QUICK) ?
+    insn->operand.cache->method : insn->operand.method;
+}
+
+#ifdef WINJ_JIT
+/* === Template compiler for x86-64 */
+
+/* Compiled code keeps the next unused operand slot in rbx, the local
+ * variables in r12 and the winj_jit_frame in r13, all of which the
+ * System V calling convention preserves.  The value on top of the
+ * operand stack may also be cached in rax, in which case it has not
+ * been stored yet and rbx points at the slot where it belongs.  Each
+ * instruction has a fixed template which caches, flushes or consumes
+ * that value as it needs.  Nothing is cached at any branch
+ * destination or when leaving compiled code, so the operand stack in
+ * memory is always exactly what the interpreter expects. */
+typedef void (*winj_jit_entry)(struct winj_jit_frame *state,
+                               const u1 *target);
+
+/* REX prefixes for moving whole slots, without and with r12 as the
+ * base register.  A prefix with no bits set changes nothing. */
+#define WINJ_JIT_REX  ((sizeof(winj_slot) == 8) ? 0x48 : 0x40)
+#define WINJ_JIT_REXB ((sizeof(winj_slot) == 8) ? 0x49 : 0x41)
+#define WINJ_JIT_SLOT ((u1)sizeof(winj_slot))
+#define WINJ_JIT_STATE(member) ((u1)offsetof(struct winj_jit_frame, member))
+
+/* Append machine code given as a list of bytes. */
+#define WINJ_JIT_EMIT(buffer, ...)                                    \
+  winj_jit_emit((buffer), sizeof((const u1[]){ __VA_ARGS__ }),        \
+                (const u1[]){ __VA_ARGS__ })
+
+/**
+ * A jump whose displacement is filled in once everything has been
+ * emitted.  Branches go to the code for another instruction.  Exits
+ * go to a stub placed after the method that leaves compiled code so
+ * the interpreter can run an instruction which found a problem, for
+ * example to throw an exception. */
+struct winj_jit_patch {
+  size_t at;      /* offset of 32-bit displacement */
+  unsigned insn;  /* instruction to branch to or leave at */
+  int exit;       /* leave compiled code instead of branching */
+  int cached;     /* top of stack is in rax at an exit */
+};
+
+struct winj_jit_buffer {
+  struct winj_vm_params *params;
+  int failed;     /* ran out of memory */
+  size_t count;
+  size_t capacity;
+  u1 *code;
+  size_t leave;   /* offset of sequence that returns to interpreter */
+
+  unsigned patch_count;
+  unsigned patch_capacity;
+  struct winj_jit_patch *patches;
+};
+
+/* Condition codes for ifeq, ifne, iflt, ifge, ifgt and ifle, in
+ * order, after comparing with zero or with another value. */
+static const u1 winj_jit_conditions[] = {
+  0x84, 0x85, 0x8c, 0x8d, 0x8f, 0x8e };
+
+static void
+winj_jit_emit(struct winj_jit_buffer *buffer, unsigned count,
+              const u1 *bytes)
+{
+  if (!buffer->failed && (buffer->count + count > buffer->capacity)) {
+    size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+    u1 *code = NULL;
+
+    while (capacity < buffer->count + count)
+      capacity *= 2;
+    if (!(code = winj_realloc(buffer->params, buffer->code, capacity)))
+      buffer->failed = 1;
+    else {
+      buffer->code = code;
+      buffer->capacity = capacity;
+    }
+  }
+  if (!buffer->failed) {
+    memcpy(buffer->code + buffer->count, bytes, count);
+    buffer->count += count;
+  }
+}
+
+static void
+winj_jit_u4(struct winj_jit_buffer *buffer, u4 value)
+{
+  WINJ_JIT_EMIT(buffer, (u1)value, (u1)(value >> 8),
+                (u1)(value >> 16), (u1)(value >> 24));
+}
+
+/**
+ * Emit a jump or conditional jump to be patched later.
+ *
+ * @param buffer code being generated
+ * @param condition second byte of a jcc opcode or zero for jmp
+ * @param insn instruction to branch to or leave at
+ * @param exit non-zero to leave compiled code rather than branch
+ * @param cached non-zero if rax holds the top of the stack */
+static void
+winj_jit_jump(struct winj_jit_buffer *buffer, u1 condition,
+              unsigned insn, int exit, int cached)
+{
+  struct winj_jit_patch *patches = NULL;
+
+  if (condition)
+    WINJ_JIT_EMIT(buffer, 0x0f, condition);
+  else WINJ_JIT_EMIT(buffer, 0xe9);
+  winj_jit_u4(buffer, 0);
+
+  if (buffer->failed) {
+  } else if ((buffer->patch_count >= buffer->patch_capacity) &&
+             !(patches = winj_realloc
+               (buffer->params, buffer->patches,
+                (buffer->patch_capacity ? 2 * buffer->patch_capacity :
+                 16) * sizeof(*patches)))) {
+    buffer->failed = 1;
+  } else {
+    if (patches) {
+      buffer->patches = patches;
+      buffer->patch_capacity = buffer->patch_capacity ?
+        2 * buffer->patch_capacity : 16;
+    }
+    patches = &buffer->patches[buffer->patch_count++];
+    patches->at = buffer->count - 4;
+    patches->insn = insn;
+    patches->exit = exit;
+    patches->cached = cached;
+  }
+}
+
+/* Store a cached top of stack value. */
+static void
+winj_jit_flush(struct winj_jit_buffer *buffer, int *cached)
+{
+  if (*cached) {
+    WINJ_JIT_EMIT(buffer, WINJ_JIT_REX, 0x89, 0x03, /* mov [rbx], rax */
+                  0x48, 0x83, 0xc3, WINJ_JIT_SLOT); /* add rbx, slot */
+    *cached = 0;
+  }
+}
+
+/* Make sure the top of stack value is cached. */
+static void
+winj_jit_top(struct winj_jit_buffer *buffer, int *cached)
+{
+  if (!*cached) {
+    WINJ_JIT_EMIT(buffer, 0x48, 0x83, 0xeb, WINJ_JIT_SLOT, /* sub rbx */
+                  WINJ_JIT_REX, 0x8b, 0x03);        /* mov rax, [rbx] */
+    *cached = 1;
+  }
+}
+
+/* Pop the slot below a cached top of stack value so that rbx points
+ * at it, ready for an instruction with two operands. */
+static void
+winj_jit_second(struct winj_jit_buffer *buffer, int *cached)
+{
+  winj_jit_top(buffer, cached);
+  WINJ_JIT_EMIT(buffer, 0x48, 0x83, 0xeb, WINJ_JIT_SLOT);
+}
+
+/* Move a whole slot between rax and a local variable, using opcode
+ * 0x8b to load and 0x89 to store. */
+static void
+winj_jit_local(struct winj_jit_buffer *buffer, u1 opcode,
+               unsigned index)
+{
+  WINJ_JIT_EMIT(buffer, WINJ_JIT_REXB, opcode, 0x84, 0x24);
+  winj_jit_u4(buffer, index * sizeof(winj_slot));
+}
+
+/* Leave compiled code so that the interpreter continues with an
+ * instruction. */
+static void
+winj_jit_exit(struct winj_jit_buffer *buffer, unsigned insn,
+              int *cached)
+{
+  winj_jit_flush(buffer, cached);
+  WINJ_JIT_EMIT(buffer, 0x41, 0xc7, 0x45, WINJ_JIT_STATE(pc));
+  winj_jit_u4(buffer, insn);                   /* mov [r13 + pc], insn */
+  WINJ_JIT_EMIT(buffer, 0xe9);                 /* jmp leave */
+  winj_jit_u4(buffer, (u4)(buffer->leave - (buffer->count + 4)));
+}
+
+/**
+ * Find the instruction a superinstruction stands in for first.  The
+ * rest of the sequence follows unchanged, so compiling that alone
+ * is enough.
+ *
+ * @param opcode internal opcode
+ * @return opcode with superinstructions replaced */
+static u1
+winj_jit_unfused(u1 opcode)
+{
+  u1 result = opcode;
+  unsigned ii;
+
+  for (ii = 0; ii < sizeof(winj_fusions) / sizeof(*winj_fusions); ++ii)
+    if (winj_fusions[ii].fused == opcode)
+      result = winj_fusions[ii].opcodes[0];
+  return result;
+}
+
+/**
+ * Compile the translated instructions of a hot method into x86-64
+ * machine code in executable pages.  Each instruction the compiler
+ * understands becomes a fixed template of machine code.  Anything
+ * else, including method calls, returns, floating point and long
+ * arithmetic, becomes an exit that leaves compiled code at that
+ * instruction so the interpreter can carry on from there.  So do
+ * instructions that would throw exceptions, after checking that
+ * they will.  Failure is not an exception: the method is simply
+ * interpreted.
+ *
+ * @param thread thread on which method became hot
+ * @param method method with translated instructions
+ * @return EXIT_SUCCESS unless method was not compiled */
+static int
+winj_method_compile(struct winj_thread *thread,
+                    struct winj_method *method)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_vm *vm = thread->vm;
+  struct winj_vm_params *params = &vm->params;
+  struct winj_insn *insns = method->insns;
+  struct winj_jit_buffer buffer;
+  struct winj_jit_code *jit = NULL;
+  u1 *labels = NULL; /* non-zero for branch destinations */
+  unsigned insn_count = 0;
+  size_t size = 0;
+  unsigned ii;
+  int cached = 0;
+
+  memset(&buffer, 0, sizeof(buffer));
+  buffer.params = params;
+  while (insns && (insns[insn_count].opcode != WINJ_OPCODE_BREAKPOINT))
+    insn_count++;
+
+  if (!vm->jit.threshold || !insns || method->jit) {
+    result = EXIT_FAILURE;
+  } else if (!(labels = winj_calloc(params, insn_count + 1,
+                                    sizeof(*labels))) ||
+             !(jit = winj_calloc(params, 1, sizeof(*jit) +
+                                 (insn_count + 1) *
+                                 sizeof(*jit->entries)))) {
+    result = winj_error(params, "failed to allocate compiler state "
+                        "for %u instructions", insn_count);
+  } else {
+    jit->entries = (u4 *)&jit[1];
+    labels[0] = 1;
+    for (ii = 0; ii < insn_count; ++ii)
+      switch (winj_jit_unfused(insns[ii].opcode)) {
+      case WINJ_OPCODE_IFEQ:      case WINJ_OPCODE_IFNE:
+      case WINJ_OPCODE_IFLT:      case WINJ_OPCODE_IFGE:
+      case WINJ_OPCODE_IFGT:      case WINJ_OPCODE_IFLE:
+      case WINJ_OPCODE_IF_ICMPEQ: case WINJ_OPCODE_IF_ICMPNE:
+      case WINJ_OPCODE_IF_ICMPLT: case WINJ_OPCODE_IF_ICMPGE:
+      case WINJ_OPCODE_IF_ICMPGT: case WINJ_OPCODE_IF_ICMPLE:
+      case WINJ_OPCODE_IF_ACMPEQ: case WINJ_OPCODE_IF_ACMPNE:
+      case WINJ_OPCODE_IFNULL:    case WINJ_OPCODE_IFNONNULL:
+      case WINJ_OPCODE_GOTO:
+        labels[insns[ii].operand.target - insns] = 1;
+        break;
+      default: break;
+      }
+
+    /* Entry saves registers, loads state and jumps to a target:
+     *   push rbx; push r12; push r13; mov r13, rdi;
+     *   mov rbx, [rdi + sp]; mov r12, [rdi + locals]; jmp rsi
+     * Leaving stores the stack top and returns:
+     *   mov [r13 + sp], rbx; pop r13; pop r12; pop rbx; ret */
+    WINJ_JIT_EMIT(&buffer, 0x53, 0x41, 0x54, 0x41, 0x55, 0x49, 0x89,
+                  0xfd, 0x48, 0x8b, 0x5f, WINJ_JIT_STATE(sp), 0x4c,
+                  0x8b, 0x67, WINJ_JIT_STATE(locals), 0xff, 0xe6);
+    buffer.leave = buffer.count;
+    WINJ_JIT_EMIT(&buffer, 0x49, 0x89, 0x5d, WINJ_JIT_STATE(sp), 0x41,
+                  0x5d, 0x41, 0x5c, 0x5b, 0xc3);
+  }
+
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii <= insn_count); ++ii) {
+    struct winj_insn *insn = &insns[ii];
+    u1 opcode = winj_jit_unfused(insn->opcode);
+
+    if (labels[ii]) {
+      winj_jit_flush(&buffer, &cached);
+      jit->entries[ii] = (u4)buffer.count;
+    }
+
+    switch (opcode) {
+    case WINJ_OPCODE_NOP: break;
+    case WINJ_OPCODE_ACONST_NULL:
+      winj_jit_flush(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x31, 0xc0);       /* xor eax, eax */
+      cached = 1;
+      break;
+    case WINJ_OPCODE_BIPUSH: case WINJ_OPCODE_LDC:
+      winj_jit_flush(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0xb8);             /* mov eax, value */
+      winj_jit_u4(&buffer, (u4)insn->value);
+      cached = 1;
+      break;
+    case WINJ_OPCODE_ILOAD: case WINJ_OPCODE_FLOAD:
+    case WINJ_OPCODE_ALOAD:
+      winj_jit_flush(&buffer, &cached);
+      winj_jit_local(&buffer, 0x8b, insn->index);
+      cached = 1;
+      break;
+    case WINJ_OPCODE_ISTORE: case WINJ_OPCODE_FSTORE:
+    case WINJ_OPCODE_ASTORE:
+      winj_jit_top(&buffer, &cached);
+      winj_jit_local(&buffer, 0x89, insn->index);
+      cached = 0;
+      break;
+    case WINJ_OPCODE_IINC:                      /* add [r12 + x], y */
+      WINJ_JIT_EMIT(&buffer, 0x41, 0x81, 0x84, 0x24);
+      winj_jit_u4(&buffer, insn->index * sizeof(winj_slot));
+      winj_jit_u4(&buffer, (u4)insn->value);
+      break;
+
+    case WINJ_OPCODE_POP:
+      if (cached)
+        cached = 0;
+      else WINJ_JIT_EMIT(&buffer, 0x48, 0x83, 0xeb, WINJ_JIT_SLOT);
+      break;
+    case WINJ_OPCODE_POP2:
+      winj_jit_flush(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x48, 0x83, 0xeb, 2 * WINJ_JIT_SLOT);
+      break;
+    case WINJ_OPCODE_DUP: /* store a copy and keep it cached */
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, WINJ_JIT_REX, 0x89, 0x03,
+                    0x48, 0x83, 0xc3, WINJ_JIT_SLOT);
+      break;
+    case WINJ_OPCODE_SWAP: /* mov rcx, [rbx - slot]; mov [rbx - slot],
+                            * rax; mov rax, rcx */
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, WINJ_JIT_REX, 0x8b, 0x4b,
+                    (u1)-WINJ_JIT_SLOT, WINJ_JIT_REX, 0x89, 0x43,
+                    (u1)-WINJ_JIT_SLOT, 0x48, 0x89, 0xc8);
+      break;
+
+    /* Results stay cached in eax with the second operand at rbx. */
+    case WINJ_OPCODE_IADD:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x03, 0x03);       /* add eax, [rbx] */
+      break;
+    case WINJ_OPCODE_IMUL:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x0f, 0xaf, 0x03); /* imul eax, [rbx] */
+      break;
+    case WINJ_OPCODE_IAND:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x23, 0x03);       /* and eax, [rbx] */
+      break;
+    case WINJ_OPCODE_IOR:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x0b, 0x03);       /* or eax, [rbx] */
+      break;
+    case WINJ_OPCODE_IXOR:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x33, 0x03);       /* xor eax, [rbx] */
+      break;
+    case WINJ_OPCODE_ISUB: case WINJ_OPCODE_ISHL:
+    case WINJ_OPCODE_ISHR: case WINJ_OPCODE_IUSHR:
+      winj_jit_second(&buffer, &cached);  /* mov ecx, eax; mov eax, [rbx] */
+      WINJ_JIT_EMIT(&buffer, 0x89, 0xc1, 0x8b, 0x03);
+      if (opcode == WINJ_OPCODE_ISUB)
+        WINJ_JIT_EMIT(&buffer, 0x29, 0xc8);     /* sub eax, ecx */
+      else WINJ_JIT_EMIT(&buffer, 0xd3,         /* shl, sar or shr */
+                         (opcode == WINJ_OPCODE_ISHL) ? 0xe0 :
+                         (opcode == WINJ_OPCODE_ISHR) ? 0xf8 : 0xe8);
+      break;
+    case WINJ_OPCODE_IDIV: case WINJ_OPCODE_IREM:
+      /* The interpreter deals with zero and with minus one, which
+       * would trap on the most negative dividend. */
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x85, 0xc0);       /* test eax, eax */
+      winj_jit_jump(&buffer, 0x84, ii, 1, cached);
+      WINJ_JIT_EMIT(&buffer, 0x83, 0xf8, 0xff); /* cmp eax, -1 */
+      winj_jit_jump(&buffer, 0x84, ii, 1, cached);
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x89, 0xc1, 0x8b, 0x03, /* idiv */
+                    0x99, 0xf7, 0xf9);
+      if (opcode == WINJ_OPCODE_IREM)
+        WINJ_JIT_EMIT(&buffer, 0x89, 0xd0);     /* mov eax, edx */
+      break;
+    case WINJ_OPCODE_INEG:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0xf7, 0xd8);       /* neg eax */
+      break;
+    case WINJ_OPCODE_I2B:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x0f, 0xbe, 0xc0); /* movsx eax, al */
+      break;
+    case WINJ_OPCODE_I2C:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x0f, 0xb7, 0xc0); /* movzx eax, ax */
+      break;
+    case WINJ_OPCODE_I2S:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x0f, 0xbf, 0xc0); /* movsx eax, ax */
+      break;
+    case WINJ_OPCODE_ARRAYLENGTH:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, WINJ_JIT_REX, 0x85, 0xc0); /* null? */
+      winj_jit_jump(&buffer, 0x84, ii, 1, cached);
+#ifdef WINJ_COMPRESSED_REFS
+      WINJ_JIT_EMIT(&buffer, 0x49, 0x03, 0x45, /* add rax, [r13 + base] */
+                    WINJ_JIT_STATE(base));
+#endif
+      WINJ_JIT_EMIT(&buffer, 0x8b, 0x80);       /* mov eax, [rax + n] */
+      winj_jit_u4(&buffer, offsetof(struct winj_array, count));
+      break;
+
+    case WINJ_OPCODE_IFEQ: case WINJ_OPCODE_IFNE:
+    case WINJ_OPCODE_IFLT: case WINJ_OPCODE_IFGE:
+    case WINJ_OPCODE_IFGT: case WINJ_OPCODE_IFLE:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x85, 0xc0);       /* test eax, eax */
+      cached = 0;
+      winj_jit_jump(&buffer, winj_jit_conditions
+                    [opcode - WINJ_OPCODE_IFEQ],
+                    (unsigned)(insn->operand.target - insns), 0, 0);
+      break;
+    case WINJ_OPCODE_IF_ICMPEQ: case WINJ_OPCODE_IF_ICMPNE:
+    case WINJ_OPCODE_IF_ICMPLT: case WINJ_OPCODE_IF_ICMPGE:
+    case WINJ_OPCODE_IF_ICMPGT: case WINJ_OPCODE_IF_ICMPLE:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, 0x39, 0x03);       /* cmp [rbx], eax */
+      cached = 0;
+      winj_jit_jump(&buffer, winj_jit_conditions
+                    [opcode - WINJ_OPCODE_IF_ICMPEQ],
+                    (unsigned)(insn->operand.target - insns), 0, 0);
+      break;
+    case WINJ_OPCODE_IF_ACMPEQ: case WINJ_OPCODE_IF_ACMPNE:
+      winj_jit_second(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, WINJ_JIT_REX, 0x39, 0x03);
+      cached = 0;
+      winj_jit_jump(&buffer, (opcode == WINJ_OPCODE_IF_ACMPEQ) ?
+                    0x84 : 0x85,
+                    (unsigned)(insn->operand.target - insns), 0, 0);
+      break;
+    case WINJ_OPCODE_IFNULL: case WINJ_OPCODE_IFNONNULL:
+      winj_jit_top(&buffer, &cached);
+      WINJ_JIT_EMIT(&buffer, WINJ_JIT_REX, 0x85, 0xc0);
+      cached = 0;
+      winj_jit_jump(&buffer, (opcode == WINJ_OPCODE_IFNULL) ?
+                    0x84 : 0x85,
+                    (unsigned)(insn->operand.target - insns), 0, 0);
+      break;
+    case WINJ_OPCODE_GOTO:
+      winj_jit_flush(&buffer, &cached);
+      winj_jit_jump(&buffer, 0, (unsigned)
+                    (insn->operand.target - insns), 0, 0);
+      break;
+
+    default:
+      winj_jit_exit(&buffer, ii, &cached);
+    }
+  }
+
+  /* Exits which found a problem come after everything else.  Then
+   * branches can be pointed at the code for their destinations. */
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < buffer.patch_count); ++ii) {
+    struct winj_jit_patch *patch = &buffer.patches[ii];
+
+    if (patch->exit) {
+      cached = patch->cached;
+      if (!buffer.failed)
+        winj_le_set_u4(buffer.code + patch->at,
+                       (u4)(buffer.count - (patch->at + 4)));
+      winj_jit_exit(&buffer, patch->insn, &cached);
+    }
+  }
+  for (ii = 0; (EXIT_SUCCESS == result) && !buffer.failed &&
+         (ii < buffer.patch_count); ++ii) {
+    struct winj_jit_patch *patch = &buffer.patches[ii];
+
+    if (!patch->exit)
+      winj_le_set_u4(buffer.code + patch->at,
+                     (u4)(jit->entries[patch->insn] - (patch->at + 4)));
+  }
+
+  if (EXIT_SUCCESS != result) {
+  } else if (buffer.failed) {
+    result = winj_error(params, "failed to allocate %lu bytes of "
+                        "machine code", (unsigned long)buffer.count);
+  } else if ((size = (buffer.count + sysconf(_SC_PAGESIZE) - 1) &
+              ~(size_t)(sysconf(_SC_PAGESIZE) - 1)),
+             (MAP_FAILED == (jit->code = mmap
+                             (NULL, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)))) {
+    jit->code = NULL;
+    result = winj_error(params, "failed to map %lu bytes: %s",
+                        (unsigned long)size, strerror(errno));
+  } else {
+    jit->size = size;
+    memcpy(jit->code, buffer.code, buffer.count);
+    if (mprotect(jit->code, size, PROT_READ | PROT_EXEC))
+      result = winj_error(params, "failed to protect %lu bytes: %s",
+                          (unsigned long)size, strerror(errno));
+  }
+
+  if (EXIT_SUCCESS == result) {
+    method->jit = jit;
+    jit = NULL;
+    vm->jit.compiled++;
+    vm->jit.code_bytes += buffer.count;
+  }
+  winj_jit_code_cleanup(params, jit);
+  winj_free(params, buffer.patches);
+  winj_free(params, buffer.code);
+  winj_free(params, labels);
+  return result;
+}
+
+/**
+ * Run the compiled code of the method of a frame from the current
+ * instruction of that frame, if there is any code for it.  The frame
+ * is left at the instruction where compiled code stopped for the
+ * interpreter to continue, with the operand stack as it was then.
+ *
+ * @param thread thread which owns frame
+ * @param frame innermost frame of thread */
+static void
+winj_thread_jit_run(struct winj_thread *thread,
+                    struct winj_stack_frame *frame)
+{
+  struct winj_jit_code *jit = frame->method->jit;
+  struct winj_jit_frame state;
+
+  if (jit && jit->entries[frame->program_counter]) {
+    state.locals = frame->locals;
+    state.sp     = frame->top;
+#ifdef WINJ_COMPRESSED_REFS
+    state.base   = thread->vm->space.base;
+#else
+    state.base   = NULL;
+#endif
+    state.pc     = frame->program_counter;
+    ((winj_jit_entry)(void *)jit->code)
+      (&state, jit->code + jit->entries[state.pc]);
+    frame->top = state.sp;
+    frame->program_counter = state.pc;
+    thread->vm->jit.entries++;
+  }
+}
+
+#undef WINJ_JIT_REX
+#undef WINJ_JIT_REXB
+#undef WINJ_JIT_SLOT
+#undef WINJ_JIT_STATE
+#undef WINJ_JIT_EMIT
+#endif /* WINJ_JIT */
+
+/* The interpreter keeps its state in local variables so that the
+ * compiler can hold it in registers.  Anything that may push a frame,
+ * throw an exception or otherwise look at the frame from outside must
+ * save this state first and reload it afterward. */
+#define WINJ_FRAME_SAVE()                                             \
+  (frame->program_counter = (unsigned)(pc - insns), frame->top = sp)
+#define WINJ_FRAME_LOAD()                                             \
+  (frame  = thread->frame,                                            \
+   insns  = frame->method->insns,                                     \
+   pc     = insns + frame->program_counter,                           \
+   sp     = frame->top,                                               \
+   locals = frame->locals)
+
+/* Objects to which operand stack slots refer. */
+#define WINJ_OBJECT(slot) winj_ref_decode(thread->vm, (slot).l)
+
+/* With GCC compatible compilers each instruction holds the address
+ * of its handler and each handler jumps directly to the next one.
+ * This avoids the bounds check and the single shared indirect branch
+ * of a switch statement, which gives the branch predictor one
+ * indirect branch per handler to learn from.  Define
+ * WINJ_SWITCH_DISPATCH to get a portable switch statement instead
+ * (for comparison, or for other compilers). */
+#if defined(__GNUC__) && !defined(WINJ_SWITCH_DISPATCH)
+#  define WINJ_THREADED_DISPATCH 1
+#  define WINJ_OP(name) winj_op_##name:
+#  define WINJ_OP_DEFAULT winj_op_default:
+#  define WINJ_NEXT() do { WINJ_PAIR_COUNT(); goto *pc->handler; } while (0)
+#  define WINJ_TARGET(name) [WINJ_OPCODE_##name] = &&winj_op_##name
+#  define WINJ_HANDLERS winj_dispatch
+#  define WINJ_QUICKEN(name)                                          \
+  (pc->opcode = WINJ_OPCODE_##name,                                   \
+   pc->handler = winj_dispatch[WINJ_OPCODE_##name])
+#else
+#  define WINJ_OP(name) case WINJ_OPCODE_##name:
+#  define WINJ_OP_DEFAULT default:
+#  define WINJ_NEXT() goto winj_dispatch
+#  define WINJ_HANDLERS NULL
+#  define WINJ_QUICKEN(name) (pc->opcode = WINJ_OPCODE_##name)
+#endif
+
+/* Building with WINJ_PAIR_PROFILE counts how often each opcode runs
+ * immediately after each other one and appends the counts to the file
+ * named by the WINJ_PAIRS environment variable when the virtual
+ * machine is destroyed.  Superinstructions are not formed in such
+ * builds so that the counts describe plain instructions.  The most
+ * frequent sequences are the candidates for new superinstructions:
+ *
+ *   $ awk '{n[$2" "$3] += $1} END {for (p in n) print n[p], p}' \
+ *       $WINJ_PAIRS | sort -rn | head */
+#ifdef WINJ_PAIR_PROFILE
+#  define WINJ_PAIR_COUNT()                                           \
+  (++thread->vm->pairs[previous * 256 + pc->opcode],                  \
+   previous = pc->opcode)
+#else
+#  define WINJ_PAIR_COUNT() ((void)0)
+#endif
+
+/* Methods get hotter each time they are invoked and each time they
+ * branch back to the start of a loop.  Once hot enough they are
+ * compiled, and from then on each of these events runs compiled code
+ * for as long as it can before the interpreter takes over again. */
+#ifdef WINJ_JIT
+#  define WINJ_JIT_HOT()                                              \
+  do {                                                                \
+    if (frame->method->jit ||                                         \
+        ((++frame->method->hotness == thread->vm->jit.threshold) &&   \
+         (EXIT_SUCCESS == winj_method_compile(thread, frame->method)))) { \
+      WINJ_FRAME_SAVE();                                              \
+      winj_thread_jit_run(thread, frame);                             \
+      WINJ_FRAME_LOAD();                                              \
+    }                                                                 \
+  } while (0)
+#else
+#  define WINJ_JIT_HOT() ((void)0)
+#endif
+
+/* WINJ_QUICKEN replaces the current instruction with an internal one
+ * once its operands have been resolved.  The caller then dispatches
+ * without advancing so the quickened instruction executes. */
+
+/**
+ * Execute byte code starting from the innermost frame of a thread
+ * until that frame returns.  Invoking a method with byte code pushes
+ * a frame and continues in the same loop, so deep Java recursion does
+ * not consume the C stack.  Frames above the starting one are popped
+ * before this returns, but the starting frame is left for the caller
+ * to pop.  Methods are translated to internal instructions (see
+ * winj_method_translate) the first time they are executed.
+ *
+ * @param thread thread with a frame to execute
+ * @param result destination for two slots of return value
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_interpret(struct winj_thread *thread, winj_slot *result)
+{
+#ifdef WINJ_THREADED_DISPATCH
+  static const void *const winj_dispatch[256] = {
+    WINJ_TARGET(NOP), WINJ_TARGET(ACONST_NULL),
+    WINJ_TARGET(ICONST_M1), WINJ_TARGET(ICONST_0),
+    WINJ_TARGET(ICONST_1), WINJ_TARGET(ICONST_2),
+    WINJ_TARGET(ICONST_3), WINJ_TARGET(ICONST_4),
+    WINJ_TARGET(ICONST_5), WINJ_TARGET(LCONST_0),
+    WINJ_TARGET(LCONST_1), WINJ_TARGET(FCONST_0),
+    WINJ_TARGET(FCONST_1), WINJ_TARGET(FCONST_2),
+    WINJ_TARGET(DCONST_0), WINJ_TARGET(DCONST_1),
+    WINJ_TARGET(BIPUSH), WINJ_TARGET(SIPUSH),
+    WINJ_TARGET(LDC), WINJ_TARGET(LDC_W), WINJ_TARGET(LDC2_W),
+    WINJ_TARGET(ILOAD), WINJ_TARGET(LLOAD), WINJ_TARGET(FLOAD),
+    WINJ_TARGET(DLOAD), WINJ_TARGET(ALOAD),
+    WINJ_TARGET(ILOAD_0), WINJ_TARGET(ILOAD_1),
+    WINJ_TARGET(ILOAD_2), WINJ_TARGET(ILOAD_3),
+    WINJ_TARGET(LLOAD_0), WINJ_TARGET(LLOAD_1),
+    WINJ_TARGET(LLOAD_2), WINJ_TARGET(LLOAD_3),
+    WINJ_TARGET(FLOAD_0), WINJ_TARGET(FLOAD_1),
+    WINJ_TARGET(FLOAD_2), WINJ_TARGET(FLOAD_3),
+    WINJ_TARGET(DLOAD_0), WINJ_TARGET(DLOAD_1),
+    WINJ_TARGET(DLOAD_2), WINJ_TARGET(DLOAD_3),
+    WINJ_TARGET(ALOAD_0), WINJ_TARGET(ALOAD_1),
+    WINJ_TARGET(ALOAD_2), WINJ_TARGET(ALOAD_3),
+    WINJ_TARGET(IALOAD), WINJ_TARGET(LALOAD), WINJ_TARGET(FALOAD),
+    WINJ_TARGET(DALOAD), WINJ_TARGET(AALOAD), WINJ_TARGET(BALOAD),
+    WINJ_TARGET(CALOAD), WINJ_TARGET(SALOAD),
+    WINJ_TARGET(ISTORE), WINJ_TARGET(LSTORE), WINJ_TARGET(FSTORE),
+    WINJ_TARGET(DSTORE), WINJ_TARGET(ASTORE),
+    WINJ_TARGET(ISTORE_0), WINJ_TARGET(ISTORE_1),
+    WINJ_TARGET(ISTORE_2), WINJ_TARGET(ISTORE_3),
+    WINJ_TARGET(LSTORE_0), WINJ_TARGET(LSTORE_1),
+    WINJ_TARGET(LSTORE_2), WINJ_TARGET(LSTORE_3),
+    WINJ_TARGET(FSTORE_0), WINJ_TARGET(FSTORE_1),
+    WINJ_TARGET(FSTORE_2), WINJ_TARGET(FSTORE_3),
+    WINJ_TARGET(DSTORE_0), WINJ_TARGET(DSTORE_1),
+    WINJ_TARGET(DSTORE_2), WINJ_TARGET(DSTORE_3),
+    WINJ_TARGET(ASTORE_0), WINJ_TARGET(ASTORE_1),
+    WINJ_TARGET(ASTORE_2), WINJ_TARGET(ASTORE_3),
+    WINJ_TARGET(IASTORE), WINJ_TARGET(LASTORE), WINJ_TARGET(FASTORE),
+    WINJ_TARGET(DASTORE), WINJ_TARGET(AASTORE), WINJ_TARGET(BASTORE),
+    WINJ_TARGET(CASTORE), WINJ_TARGET(SASTORE),
+    WINJ_TARGET(POP), WINJ_TARGET(POP2), WINJ_TARGET(DUP),
+    WINJ_TARGET(DUP_X1), WINJ_TARGET(DUP_X2), WINJ_TARGET(DUP2),
+    WINJ_TARGET(DUP2_X1), WINJ_TARGET(DUP2_X2), WINJ_TARGET(SWAP),
+    WINJ_TARGET(IADD), WINJ_TARGET(LADD),
+    WINJ_TARGET(FADD), WINJ_TARGET(DADD),
+    WINJ_TARGET(ISUB), WINJ_TARGET(LSUB),
+    WINJ_TARGET(FSUB), WINJ_TARGET(DSUB),
+    WINJ_TARGET(IMUL), WINJ_TARGET(LMUL),
+    WINJ_TARGET(FMUL), WINJ_TARGET(DMUL),
+    WINJ_TARGET(IDIV), WINJ_TARGET(LDIV),
+    WINJ_TARGET(FDIV), WINJ_TARGET(DDIV),
+    WINJ_TARGET(IREM), WINJ_TARGET(LREM),
+    WINJ_TARGET(FREM), WINJ_TARGET(DREM),
+    WINJ_TARGET(INEG), WINJ_TARGET(LNEG),
+    WINJ_TARGET(FNEG), WINJ_TARGET(DNEG),
+    WINJ_TARGET(ISHL), WINJ_TARGET(LSHL),
+    WINJ_TARGET(ISHR), WINJ_TARGET(LSHR),
+    WINJ_TARGET(IUSHR), WINJ_TARGET(LUSHR),
+    WINJ_TARGET(IAND), WINJ_TARGET(LAND),
+    WINJ_TARGET(IOR), WINJ_TARGET(LOR),
+    WINJ_TARGET(IXOR), WINJ_TARGET(LXOR), WINJ_TARGET(IINC),
+    WINJ_TARGET(I2L), WINJ_TARGET(I2F), WINJ_TARGET(I2D),
+    WINJ_TARGET(L2I), WINJ_TARGET(L2F), WINJ_TARGET(L2D),
+    WINJ_TARGET(F2I), WINJ_TARGET(F2L), WINJ_TARGET(F2D),
+    WINJ_TARGET(D2I), WINJ_TARGET(D2L), WINJ_TARGET(D2F),
+    WINJ_TARGET(I2B), WINJ_TARGET(I2C), WINJ_TARGET(I2S),
+    WINJ_TARGET(LCMP), WINJ_TARGET(FCMPL), WINJ_TARGET(FCMPG),
+    WINJ_TARGET(DCMPL), WINJ_TARGET(DCMPG),
+    WINJ_TARGET(IFEQ), WINJ_TARGET(IFNE), WINJ_TARGET(IFLT),
+    WINJ_TARGET(IFGE), WINJ_TARGET(IFGT), WINJ_TARGET(IFLE),
+    WINJ_TARGET(IF_ICMPEQ), WINJ_TARGET(IF_ICMPNE),
+    WINJ_TARGET(IF_ICMPLT), WINJ_TARGET(IF_ICMPGE),
+    WINJ_TARGET(IF_ICMPGT), WINJ_TARGET(IF_ICMPLE),
+    WINJ_TARGET(IF_ACMPEQ), WINJ_TARGET(IF_ACMPNE),
+    WINJ_TARGET(GOTO), WINJ_TARGET(JSR), WINJ_TARGET(RET),
+    WINJ_TARGET(TABLESWITCH), WINJ_TARGET(LOOKUPSWITCH),
+    WINJ_TARGET(IRETURN), WINJ_TARGET(LRETURN),
+    WINJ_TARGET(FRETURN), WINJ_TARGET(DRETURN),
+    WINJ_TARGET(ARETURN), WINJ_TARGET(RETURN),
+    WINJ_TARGET(GETSTATIC), WINJ_TARGET(PUTSTATIC),
+    WINJ_TARGET(GETFIELD), WINJ_TARGET(PUTFIELD),
+    WINJ_TARGET(INVOKEVIRTUAL), WINJ_TARGET(INVOKESPECIAL),
+    WINJ_TARGET(INVOKESTATIC), WINJ_TARGET(INVOKEINTERFACE),
+    WINJ_TARGET(INVOKEDYNAMIC), WINJ_TARGET(NEW),
+    WINJ_TARGET(NEWARRAY), WINJ_TARGET(ANEWARRAY),
+    WINJ_TARGET(ARRAYLENGTH), WINJ_TARGET(ATHROW),
+    WINJ_TARGET(CHECKCAST), WINJ_TARGET(INSTANCEOF),
+    WINJ_TARGET(MONITORENTER), WINJ_TARGET(MONITOREXIT),
+    WINJ_TARGET(WIDE), WINJ_TARGET(MULTIANEWARRAY),
+    WINJ_TARGET(IFNULL), WINJ_TARGET(IFNONNULL),
+    WINJ_TARGET(GOTO_W), WINJ_TARGET(JSR_W),
+    WINJ_TARGET(GETSTATIC_QUICK), WINJ_TARGET(PUTSTATIC_QUICK),
+    WINJ_TARGET(INVOKESTATIC_QUICK), WINJ_TARGET(INVOKENATIVE_QUICK),
+    WINJ_TARGET(INVOKEVIRTUAL_QUICK), WINJ_TARGET(INVOKESPECIAL_QUICK),
+    WINJ_TARGET(NEW_QUICK),
+    WINJ_TARGET(GETFIELD_BYTE_QUICK), WINJ_TARGET(GETFIELD_BOOLEAN_QUICK),
+    WINJ_TARGET(GETFIELD_CHAR_QUICK), WINJ_TARGET(GETFIELD_SHORT_QUICK),
+    WINJ_TARGET(GETFIELD_INT_QUICK), WINJ_TARGET(GETFIELD_LONG_QUICK),
+    WINJ_TARGET(GETFIELD_OBJECT_QUICK),
+    WINJ_TARGET(PUTFIELD_BYTE_QUICK), WINJ_TARGET(PUTFIELD_BOOLEAN_QUICK),
+    WINJ_TARGET(PUTFIELD_SHORT_QUICK), WINJ_TARGET(PUTFIELD_INT_QUICK),
+    WINJ_TARGET(PUTFIELD_LONG_QUICK), WINJ_TARGET(PUTFIELD_OBJECT_QUICK),
+    WINJ_TARGET(INVOKECACHED_QUICK), WINJ_TARGET(INVOKEINTERFACE_QUICK),
+    WINJ_TARGET(CHECKCAST_QUICK), WINJ_TARGET(INSTANCEOF_QUICK),
+    WINJ_TARGET(ILOAD_ILOAD), WINJ_TARGET(ILOAD_BIPUSH),
+    WINJ_TARGET(ILOAD_ILOAD_IF_ICMPGE), WINJ_TARGET(ILOAD_ILOAD_IF_ICMPLT),
+    WINJ_TARGET(ILOAD_ALOAD_ARRAYLENGTH_IF_ICMPGE),
+    WINJ_TARGET(IINC_GOTO), WINJ_TARGET(IADD_ISTORE),
+    [WINJ_OPCODE_BREAKPOINT] = &&winj_op_default,
+    [WINJ_OPCODE_QUICK_END ... WINJ_OPCODE_IMPDEP2] = &&winj_op_default,
+  };
+#endif
+  struct winj_stack_frame *entry = thread->frame;
+  struct winj_stack_frame *frame = entry;
+  struct winj_insn *insns = NULL; /* translated code of current method */
+  struct winj_insn *pc    = NULL; /* current instruction */
+  winj_slot *sp     = NULL; /* next unused operand slot */
+  winj_slot *locals = NULL;
+  struct winj_method *callee = NULL; /* selected by instance invokes */
+  unsigned count = 0;
+#ifdef WINJ_PAIR_PROFILE
+  u1 previous = WINJ_OPCODE_NOP;
+
+  if (!thread->vm->pairs && !(thread->vm->pairs = winj_calloc
+                              (&thread->vm->params, 256 * 256,
+                               sizeof(*thread->vm->pairs))))
+    return winj_error(&thread->vm->params, "failed to allocate "
+                      "opcode pair counts");
+#endif
+
+  if (!entry->method->insns &&
+      (EXIT_SUCCESS != winj_method_translate
+       (thread, entry->winj, entry->method, WINJ_HANDLERS)))
+    return EXIT_FAILURE;
+  WINJ_FRAME_LOAD();
+  WINJ_JIT_HOT();
+#ifdef WINJ_THREADED_DISPATCH
+  WINJ_NEXT();
+#else
+ winj_dispatch:
+  WINJ_PAIR_COUNT();
+  switch (pc->opcode) {
+#endif
+
+  WINJ_OP(NOP) ++pc; WINJ_NEXT();
+  WINJ_OP(ACONST_NULL) (sp++)->l = 0; ++pc; WINJ_NEXT();
+  WINJ_OP(BIPUSH) WINJ_OP(LDC) /* also iconst_* and sipush */
+    (sp++)->i = pc->value; ++pc; WINJ_NEXT();
+  WINJ_OP(LCONST_0)
+    winj_slots_set_long(sp, 0); sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LCONST_1)
+    winj_slots_set_long(sp, 1); sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(FCONST_0) (sp++)->f = 0.0f; ++pc; WINJ_NEXT();
+  WINJ_OP(FCONST_1) (sp++)->f = 1.0f; ++pc; WINJ_NEXT();
+  WINJ_OP(FCONST_2) (sp++)->f = 2.0f; ++pc; WINJ_NEXT();
+  WINJ_OP(DCONST_0)
+    winj_slots_set_double(sp, 0.0); sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DCONST_1)
+    winj_slots_set_double(sp, 1.0); sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LDC2_W) /* long and double constants have the same bits */
+    winj_slots_set_long(sp, pc->operand.j); sp += 2; ++pc; WINJ_NEXT();
+
+  /* Translation folds the forms with implicit indexes into these. */
+  WINJ_OP(ILOAD) WINJ_OP(FLOAD) WINJ_OP(ALOAD)
+    *sp++ = locals[pc->index]; ++pc; WINJ_NEXT();
+  WINJ_OP(LLOAD) WINJ_OP(DLOAD)
+    winj_slots_copy2(sp, &locals[pc->index]); sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(ISTORE) WINJ_OP(FSTORE) WINJ_OP(ASTORE)
+    locals[pc->index] = *--sp; ++pc; WINJ_NEXT();
+  WINJ_OP(LSTORE) WINJ_OP(DSTORE)
+    sp -= 2; winj_slots_copy2(&locals[pc->index], sp); ++pc; WINJ_NEXT();
+
+  WINJ_OP(AALOAD) {
+    struct winj_array *array = (struct winj_array *)WINJ_OBJECT(sp[-2]);
+    jint index = sp[-1].i;
+
+    if (!array) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                        "array is null");
+      goto winj_throw;
+    } else if ((u4)index >= array->count) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw
+        (thread, 0, "java/lang/ArrayIndexOutOfBoundsException",
+         "index is %d count is %u", index, array->count);
+      goto winj_throw;
+    }
+    sp[-2].l = array->elements.jobject[index];
+    --sp; ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(AASTORE) {
+    struct winj_array *array = (struct winj_array *)WINJ_OBJECT(sp[-3]);
+    jint index = sp[-2].i;
+    struct winj_object *value = WINJ_OBJECT(sp[-1]);
+
+    if (!array) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                        "array is null");
+      goto winj_throw;
+    } else if ((u4)index >= array->count) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw
+        (thread, 0, "java/lang/ArrayIndexOutOfBoundsException",
+         "index is %d count is %u", index, array->count);
+      goto winj_throw;
+    } else if (value && (EXIT_SUCCESS != winj_class_instance
+                         (array->element_class, value))) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                        "%.*s", value->cls->name_len, value->cls->name);
+      goto winj_throw;
+    } else if (EXIT_SUCCESS != winj_vm_gc_remember
+               (thread->vm, &array->self, value)) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                        "failed to remember array");
+      goto winj_throw;
+    }
+    array->elements.jobject[index] = sp[-1].l;
+    sp -= 3; ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(ARRAYLENGTH) {
+    struct winj_array *array = (struct winj_array *)WINJ_OBJECT(sp[-1]);
+
+    if (!array) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                        "array is null");
+      goto winj_throw;
+    }
+    sp[-1].i = (jint)array->count;
+    ++pc;
+  } WINJ_NEXT();
+
+  WINJ_OP(POP)  --sp;    ++pc; WINJ_NEXT();
+  WINJ_OP(POP2) sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DUP) sp[0] = sp[-1]; ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(DUP_X1)
+    sp[0] = sp[-1]; sp[-1] = sp[-2]; sp[-2] = sp[0];
+    ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(DUP_X2)
+    sp[0] = sp[-1]; sp[-1] = sp[-2]; sp[-2] = sp[-3]; sp[-3] = sp[0];
+    ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(DUP2)
+    sp[0] = sp[-2]; sp[1] = sp[-1]; sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DUP2_X1)
+    sp[1] = sp[-1]; sp[0] = sp[-2]; sp[-1] = sp[-3];
+    sp[-2] = sp[1]; sp[-3] = sp[0]; sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DUP2_X2)
+    sp[1] = sp[-1]; sp[0] = sp[-2]; sp[-1] = sp[-3]; sp[-2] = sp[-4];
+    sp[-3] = sp[1]; sp[-4] = sp[0]; sp += 2; ++pc; WINJ_NEXT();
+  WINJ_OP(SWAP) {
+    winj_slot swap = sp[-1];
+    sp[-1] = sp[-2];
+    sp[-2] = swap;
+    ++pc;
+  } WINJ_NEXT();
+
+  /* Integer arithmetic wraps, so use unsigned values to avoid
+   * undefined behavior in C when results overflow. */
+  WINJ_OP(IADD) sp[-2].u += sp[-1].u; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(ISUB) sp[-2].u -= sp[-1].u; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IMUL) sp[-2].u *= sp[-1].u; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IDIV) WINJ_OP(IREM) {
+    jint divisor = sp[-1].i;
+
+    if (!divisor) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/ArithmeticException",
+                        "/ by zero");
+      goto winj_throw;
+    } else if (divisor == -1) /* avoid overflow trap on minimum */
+      sp[-2].u = (pc->opcode == WINJ_OPCODE_IDIV) ? (0u - sp[-2].u) : 0;
+    else if (pc->opcode == WINJ_OPCODE_IDIV)
+      sp[-2].i /= divisor;
+    else sp[-2].i %= divisor;
+    --sp; ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(INEG) sp[-1].u = 0u - sp[-1].u; ++pc; WINJ_NEXT();
+  WINJ_OP(ISHL) sp[-2].u <<= (sp[-1].u & 0x1f); --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(ISHR) sp[-2].i >>= (sp[-1].u & 0x1f); --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IUSHR) sp[-2].u >>= (sp[-1].u & 0x1f); --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IAND) sp[-2].u &= sp[-1].u; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IOR)  sp[-2].u |= sp[-1].u; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IXOR) sp[-2].u ^= sp[-1].u; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(IINC)
+    locals[pc->index].u += (u4)pc->value; ++pc; WINJ_NEXT();
+
+  WINJ_OP(LADD)
+    winj_slots_set_long(sp - 4, (jlong)((u8)winj_slots_long(sp - 4) +
+                                        (u8)winj_slots_long(sp - 2)));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LSUB)
+    winj_slots_set_long(sp - 4, (jlong)((u8)winj_slots_long(sp - 4) -
+                                        (u8)winj_slots_long(sp - 2)));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LMUL)
+    winj_slots_set_long(sp - 4, (jlong)((u8)winj_slots_long(sp - 4) *
+                                        (u8)winj_slots_long(sp - 2)));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LDIV) WINJ_OP(LREM) {
+    jlong dividend = winj_slots_long(sp - 4);
+    jlong divisor  = winj_slots_long(sp - 2);
+
+    if (!divisor) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/ArithmeticException",
+                        "/ by zero");
+      goto winj_throw;
+    } else if (divisor == -1)
+      winj_slots_set_long(sp - 4, (pc->opcode == WINJ_OPCODE_LDIV) ?
+                          (jlong)(0u - (u8)dividend) : 0);
+    else winj_slots_set_long(sp - 4, (pc->opcode == WINJ_OPCODE_LDIV) ?
+                             (dividend / divisor) :
+                             (dividend % divisor));
+    sp -= 2; ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(LNEG)
+    winj_slots_set_long(sp - 2, (jlong)(0u - (u8)winj_slots_long
+                                        (sp - 2)));
+    ++pc; WINJ_NEXT();
+  WINJ_OP(LSHL)
+    winj_slots_set_long(sp - 3, (jlong)((u8)winj_slots_long(sp - 3) <<
+                                        (sp[-1].u & 0x3f)));
+    --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(LSHR)
+    winj_slots_set_long(sp - 3, winj_slots_long(sp - 3) >>
+                        (sp[-1].u & 0x3f));
+    --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(LUSHR)
+    winj_slots_set_long(sp - 3, (jlong)((u8)winj_slots_long(sp - 3) >>
+                                        (sp[-1].u & 0x3f)));
+    --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(LAND)
+    winj_slots_set_long(sp - 4, winj_slots_long(sp - 4) &
+                        winj_slots_long(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LOR)
+    winj_slots_set_long(sp - 4, winj_slots_long(sp - 4) |
+                        winj_slots_long(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LXOR)
+    winj_slots_set_long(sp - 4, winj_slots_long(sp - 4) ^
+                        winj_slots_long(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(LCMP) {
+    jlong aa = winj_slots_long(sp - 4);
+    jlong bb = winj_slots_long(sp - 2);
+
+    sp -= 3;
+    sp[-1].i = (aa < bb) ? -1 : (aa > bb) ? 1 : 0;
+    ++pc;
+  } WINJ_NEXT();
+
+  WINJ_OP(FADD) sp[-2].f += sp[-1].f; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(FSUB) sp[-2].f -= sp[-1].f; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(FMUL) sp[-2].f *= sp[-1].f; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(FDIV) sp[-2].f /= sp[-1].f; --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(FREM) /* truncating like C rather than IEEE remainder */
+    sp[-2].f = fmodf(sp[-2].f, sp[-1].f); --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(FNEG) sp[-1].f = -sp[-1].f; ++pc; WINJ_NEXT();
+  WINJ_OP(DADD)
+    winj_slots_set_double(sp - 4, winj_slots_double(sp - 4) +
+                          winj_slots_double(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DSUB)
+    winj_slots_set_double(sp - 4, winj_slots_double(sp - 4) -
+                          winj_slots_double(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DMUL)
+    winj_slots_set_double(sp - 4, winj_slots_double(sp - 4) *
+                          winj_slots_double(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DDIV)
+    winj_slots_set_double(sp - 4, winj_slots_double(sp - 4) /
+                          winj_slots_double(sp - 2));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DREM)
+    winj_slots_set_double(sp - 4, fmod(winj_slots_double(sp - 4),
+                                       winj_slots_double(sp - 2)));
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(DNEG)
+    winj_slots_set_double(sp - 2, -winj_slots_double(sp - 2));
+    ++pc; WINJ_NEXT();
+  WINJ_OP(FCMPL) WINJ_OP(FCMPG) {
+    jfloat aa = sp[-2].f;
+    jfloat bb = sp[-1].f;
+
+    --sp;
+    sp[-1].i = (aa < bb) ? -1 : (aa > bb) ? 1 : (aa == bb) ? 0 :
+      (pc->opcode == WINJ_OPCODE_FCMPG) ? 1 : -1;
+    ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(DCMPL) WINJ_OP(DCMPG) {
+    jdouble aa = winj_slots_double(sp - 4);
+    jdouble bb = winj_slots_double(sp - 2);
+
+    sp -= 3;
+    sp[-1].i = (aa < bb) ? -1 : (aa > bb) ? 1 : (aa == bb) ? 0 :
+      (pc->opcode == WINJ_OPCODE_DCMPG) ? 1 : -1;
+    ++pc;
+  } WINJ_NEXT();
+
+  /* Conversions from floating point saturate and turn NaN into zero
+   * rather than doing whatever the C compiler would do. */
+  WINJ_OP(I2L)
+    winj_slots_set_long(sp - 1, sp[-1].i); ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(I2F) sp[-1].f = (jfloat)sp[-1].i; ++pc; WINJ_NEXT();
+  WINJ_OP(I2D)
+    winj_slots_set_double(sp - 1, sp[-1].i); ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(L2I)
+    sp[-2].i = (jint)winj_slots_long(sp - 2); --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(L2F)
+    sp[-2].f = (jfloat)winj_slots_long(sp - 2); --sp; ++pc; WINJ_NEXT();
+  WINJ_OP(L2D)
+    winj_slots_set_double(sp - 2, (jdouble)winj_slots_long(sp - 2));
+    ++pc; WINJ_NEXT();
+  WINJ_OP(F2I) {
+    jfloat value = sp[-1].f;
+    sp[-1].i = (value != value) ? 0 :
+      (value >= 2147483648.0f) ? 0x7fffffff :
+      (value <= -2147483648.0f) ? (jint)(-0x7fffffff - 1) : (jint)value;
+    ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(F2L) {
+    jfloat value = sp[-1].f;
+    winj_slots_set_long
+      (sp - 1, (value != value) ? 0 :
+       (value >= 9223372036854775808.0f) ? (jlong)0x7fffffffffffffffLL :
+       (value <= -9223372036854775808.0f) ?
+       (jlong)(-0x7fffffffffffffffLL - 1) : (jlong)value);
+    ++sp; ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(F2D)
+    winj_slots_set_double(sp - 1, sp[-1].f); ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(D2I) {
+    jdouble value = winj_slots_double(sp - 2);
+    sp[-2].i = (value != value) ? 0 :
+      (value >= 2147483647.0) ? 0x7fffffff :
+      (value <= -2147483648.0) ? (jint)(-0x7fffffff - 1) : (jint)value;
+    --sp; ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(D2L) {
+    jdouble value = winj_slots_double(sp - 2);
+    winj_slots_set_long
+      (sp - 2, (value != value) ? 0 :
+       (value >= 9223372036854775808.0) ? (jlong)0x7fffffffffffffffLL :
+       (value <= -9223372036854775808.0) ?
+       (jlong)(-0x7fffffffffffffffLL - 1) : (jlong)value);
+    ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(D2F)
+    sp[-2].f = (jfloat)winj_slots_double(sp - 2); --sp; ++pc;
+    WINJ_NEXT();
+  WINJ_OP(I2B) sp[-1].i = (jbyte)sp[-1].i;  ++pc; WINJ_NEXT();
+  WINJ_OP(I2C) sp[-1].i = (jchar)sp[-1].i;  ++pc; WINJ_NEXT();
+  WINJ_OP(I2S) sp[-1].i = (jshort)sp[-1].i; ++pc; WINJ_NEXT();
+
+  /* Branch offsets are relative to the branch instruction itself. */
+  WINJ_OP(IFEQ)
+    --sp; pc = (sp->i == 0) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFNE)
+    --sp; pc = (sp->i != 0) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFLT)
+    --sp; pc = (sp->i <  0) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFGE)
+    --sp; pc = (sp->i >= 0) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFGT)
+    --sp; pc = (sp->i >  0) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFLE)
+    --sp; pc = (sp->i <= 0) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ICMPEQ)
+    sp -= 2;
+    pc = (sp[0].i == sp[1].i) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ICMPNE)
+    sp -= 2;
+    pc = (sp[0].i != sp[1].i) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ICMPLT)
+    sp -= 2;
+    pc = (sp[0].i <  sp[1].i) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ICMPGE)
+    sp -= 2;
+    pc = (sp[0].i >= sp[1].i) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ICMPGT)
+    sp -= 2;
+    pc = (sp[0].i >  sp[1].i) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ICMPLE)
+    sp -= 2;
+    pc = (sp[0].i <= sp[1].i) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ACMPEQ)
+    sp -= 2;
+    pc = (sp[0].l == sp[1].l) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IF_ACMPNE)
+    sp -= 2;
+    pc = (sp[0].l != sp[1].l) ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFNULL)
+    --sp; pc = !sp->l ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(IFNONNULL)
+    --sp; pc = sp->l ? pc->operand.target : pc + 1; WINJ_NEXT();
+  WINJ_OP(GOTO)
+    if (pc->operand.target > pc) {
+      pc = pc->operand.target;
+      WINJ_NEXT();
+    }
+    pc = pc->operand.target;
+    WINJ_JIT_HOT();
+    WINJ_NEXT();
+
+  /* Superinstructions take operands from the instructions they stand
+   * in for, which follow them unchanged (see winj_insns_fuse). */
+  WINJ_OP(ILOAD_ILOAD)
+    sp[0] = locals[pc[0].index]; sp[1] = locals[pc[1].index];
+    sp += 2; pc += 2; WINJ_NEXT();
+  WINJ_OP(ILOAD_BIPUSH)
+    sp[0] = locals[pc[0].index]; sp[1].i = pc[1].value;
+    sp += 2; pc += 2; WINJ_NEXT();
+  WINJ_OP(ILOAD_ILOAD_IF_ICMPGE)
+    pc = (locals[pc[0].index].i >= locals[pc[1].index].i) ?
+      pc[2].operand.target : pc + 3; WINJ_NEXT();
+  WINJ_OP(ILOAD_ILOAD_IF_ICMPLT)
+    pc = (locals[pc[0].index].i < locals[pc[1].index].i) ?
+      pc[2].operand.target : pc + 3; WINJ_NEXT();
+  WINJ_OP(ILOAD_ALOAD_ARRAYLENGTH_IF_ICMPGE) {
+    struct winj_array *array = (struct winj_array *)
+      winj_ref_decode(thread->vm, locals[pc[1].index].l);
+
+    if (!array) /* let arraylength throw */
+      *sp++ = locals[(pc++)->index];
+    else pc = (locals[pc[0].index].i >= (jint)array->count) ?
+           pc[3].operand.target : pc + 4;
+  } WINJ_NEXT();
+  WINJ_OP(IINC_GOTO)
+    locals[pc->index].u += (u4)pc->value;
+    if (pc[1].operand.target > pc) {
+      pc = pc[1].operand.target;
+      WINJ_NEXT();
+    }
+    pc = pc[1].operand.target;
+    WINJ_JIT_HOT();
+    WINJ_NEXT();
+  WINJ_OP(IADD_ISTORE)
+    sp -= 2; locals[pc[1].index].u = sp[0].u + sp[1].u;
+    pc += 2; WINJ_NEXT();
+  WINJ_OP(TABLESWITCH) {
+    const jint *table = pc->operand.table; /* low, high, default, ... */
+    jint index = (--sp)->i;
+
+    pc = insns + (((index < table[0]) || (index > table[1])) ? table[2] :
+                  table[3 + ((u4)index - (u4)table[0])]);
+  } WINJ_NEXT();
+  WINJ_OP(LOOKUPSWITCH) {
+    const jint *table = pc->operand.table; /* npairs, default, ... */
+    jint key = (--sp)->i;
+    jint target = table[1];
+    u4 bottom = 0;
+    u4 top = (u4)table[0];
+
+    while (top > bottom) { /* pairs are sorted by match value */
+      u4 middle = bottom + (top - bottom) / 2;
+      jint match = table[2 + 2 * middle];
+
+      if (key < match)
+        top = middle;
+      else if (key > match)
+        bottom = middle + 1;
+      else {
+        target = table[3 + 2 * middle];
+        break;
+      }
+    }
+    pc = insns + target;
+  } WINJ_NEXT();
+
+  WINJ_OP(IRETURN) WINJ_OP(FRETURN) WINJ_OP(ARETURN)
+    count = 1; goto winj_return;
+  WINJ_OP(LRETURN) WINJ_OP(DRETURN)
+    count = 2; goto winj_return;
+  WINJ_OP(RETURN)
+    count = 0;
+ winj_return:
+    if (frame == entry) {
+      memcpy(result, sp - count, count * sizeof(*sp));
+      WINJ_FRAME_SAVE();
+      return EXIT_SUCCESS;
+    }
+    sp -= count;
+    winj_thread_frame_pop(thread);
+    memmove(thread->frame->top, sp, count * sizeof(*sp));
+    thread->frame->top += count;
+    WINJ_FRAME_LOAD();
+    WINJ_NEXT();
+
+  /* These resolve a constant pool reference then quicken. */
+  WINJ_OP(GETSTATIC) WINJ_OP(PUTSTATIC) {
+    struct winj_class *target = NULL;
+    struct winj_field *field = NULL;
+
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_static_field_resolve
+        (thread, frame->winj, pc->index, &target, &field))
+      goto winj_throw;
+    pc->value = field->type;
+    pc->operand.value = &target->static_values[field->index];
+    if (pc->opcode == WINJ_OPCODE_GETSTATIC)
+      WINJ_QUICKEN(GETSTATIC_QUICK);
+    else WINJ_QUICKEN(PUTSTATIC_QUICK);
+  } WINJ_NEXT();
+  WINJ_OP(INVOKESTATIC) {
+    struct winj_class *target = NULL;
+    struct winj_method *method = NULL;
+
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_static_method_resolve
+        (thread, frame->winj, pc->index, &target, &method))
+      goto winj_throw;
+    pc->cls = target;
+    pc->operand.method = method;
+    pc->value = (jint)method->signature.slots;
+    if (method->call || !method->method_file ||
+        !method->method_file->code.code.value)
+      WINJ_QUICKEN(INVOKENATIVE_QUICK);
+    else WINJ_QUICKEN(INVOKESTATIC_QUICK);
+  } WINJ_NEXT();
+
+  WINJ_OP(INVOKEVIRTUAL) WINJ_OP(INVOKESPECIAL)
+  WINJ_OP(INVOKEINTERFACE) {
+    struct winj_method *method = NULL;
+
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_method_resolve
+        (thread, frame->winj, pc->index, &method))
+      goto winj_throw;
+    pc->cls = method->cls;
+    /* The receiver is the first slot. */
+    pc->value = (jint)method->signature.slots + 1;
+    if ((pc->opcode != WINJ_OPCODE_INVOKESPECIAL) &&
+        winj_method_virtual(method)) {
+      pc->operand.cache->method = method;
+      WINJ_QUICKEN(INVOKECACHED_QUICK);
+    } else {
+      pc->operand.method = method;
+      WINJ_QUICKEN(INVOKESPECIAL_QUICK);
+    }
+  } WINJ_NEXT();
+  WINJ_OP(GETFIELD) WINJ_OP(PUTFIELD) {
+    struct winj_field *field = NULL;
+
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_field_resolve
+        (thread, frame->winj, pc->index, &field))
+      goto winj_throw;
+    pc->value = (jint)field->offset;
+    if (pc->opcode == WINJ_OPCODE_GETFIELD)
+      switch (field->type) {
+      case WINJ_TYPE_BYTE:    WINJ_QUICKEN(GETFIELD_BYTE_QUICK);    break;
+      case WINJ_TYPE_BOOLEAN: WINJ_QUICKEN(GETFIELD_BOOLEAN_QUICK); break;
+      case WINJ_TYPE_CHAR:    WINJ_QUICKEN(GETFIELD_CHAR_QUICK);    break;
+      case WINJ_TYPE_SHORT:   WINJ_QUICKEN(GETFIELD_SHORT_QUICK);   break;
+      case WINJ_TYPE_LONG: case WINJ_TYPE_DOUBLE:
+        WINJ_QUICKEN(GETFIELD_LONG_QUICK); break;
+      case WINJ_TYPE_OBJECT:  WINJ_QUICKEN(GETFIELD_OBJECT_QUICK);  break;
+      default:                WINJ_QUICKEN(GETFIELD_INT_QUICK);     break;
+      }
+    else switch (field->type) {
+      case WINJ_TYPE_BYTE:    WINJ_QUICKEN(PUTFIELD_BYTE_QUICK);    break;
+      case WINJ_TYPE_BOOLEAN: WINJ_QUICKEN(PUTFIELD_BOOLEAN_QUICK); break;
+      case WINJ_TYPE_CHAR: case WINJ_TYPE_SHORT:
+        WINJ_QUICKEN(PUTFIELD_SHORT_QUICK); break;
+      case WINJ_TYPE_LONG: case WINJ_TYPE_DOUBLE:
+        WINJ_QUICKEN(PUTFIELD_LONG_QUICK); break;
+      case WINJ_TYPE_OBJECT:  WINJ_QUICKEN(PUTFIELD_OBJECT_QUICK);  break;
+      default:                WINJ_QUICKEN(PUTFIELD_INT_QUICK);     break;
+      }
+  } WINJ_NEXT();
+  WINJ_OP(NEW) {
+    struct winj_class *target = NULL;
+
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_class_resolve
+        (thread, frame->winj, pc->index, &target))
+      goto winj_throw;
+    pc->cls = target;
+    WINJ_QUICKEN(NEW_QUICK);
+  } WINJ_NEXT();
+  WINJ_OP(CHECKCAST) WINJ_OP(INSTANCEOF) {
+    struct winj_class *target = NULL;
+    const char *name = NULL;
+    unsigned name_len = 0;
+
+    WINJ_FRAME_SAVE();
+    if (frame->winj->class_file &&
+        (EXIT_SUCCESS == winj_cpool_get_class_name
+         (&thread->vm->params, frame->winj->class_file, pc->index,
+          &name_len, &name)) && name_len && (name[0] == '['))
+      target = thread->vm->class_array; /* elements are not checked */
+    else if (EXIT_SUCCESS != winj_thread_class_resolve
+             (thread, frame->winj, pc->index, &target))
+      goto winj_throw;
+    pc->cls = target;
+    if (pc->opcode == WINJ_OPCODE_CHECKCAST)
+      WINJ_QUICKEN(CHECKCAST_QUICK);
+    else WINJ_QUICKEN(INSTANCEOF_QUICK);
+  } WINJ_NEXT();
+
+  WINJ_OP(GETSTATIC_QUICK)
+    sp += winj_slots_store(thread->vm, pc->value, pc->operand.value, sp);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(PUTSTATIC_QUICK)
+    sp -= winj_type_slots(pc->value);
+    winj_slots_load(thread->vm, pc->value, sp, pc->operand.value);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(INVOKESTATIC_QUICK) {
+    struct winj_method *method = pc->operand.method;
+
+    WINJ_FRAME_SAVE();
+    if (!method->insns &&
+        (EXIT_SUCCESS != winj_method_translate
+         (thread, pc->cls, method, WINJ_HANDLERS)))
+      goto winj_throw;
+    frame->top = sp - pc->value;
+    frame->program_counter++; /* resume after this on return */
+    if (EXIT_SUCCESS != winj_thread_frame_push
+        (thread, pc->cls, method, (unsigned)pc->value, NULL))
+      goto winj_throw;
+    WINJ_FRAME_LOAD();
+    WINJ_JIT_HOT();
+  } WINJ_NEXT();
+  WINJ_OP(INVOKENATIVE_QUICK) {
+    enum winj_type return_type = WINJ_TYPE_VOID;
+    jvalue value;
+
+    sp -= pc->value;
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_invoke_slots
+        (thread, pc->cls, pc->operand.method, NULL, sp,
+         &return_type, &value))
+      goto winj_throw;
+    sp += winj_slots_store(thread->vm, return_type, &value, sp);
+    ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(INVOKEVIRTUAL_QUICK) {
+    struct winj_object *receiver = WINJ_OBJECT(sp[-pc->value]);
+
+    if (!receiver)
+      goto winj_invoke_null;
+    else if (pc->index >= receiver->cls->vtable_count) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0,
+                        "java/lang/IncompatibleClassChangeError",
+                        "%.*s has no %.*s", receiver->cls->name_len,
+                        receiver->cls->name,
+                        pc->operand.method->name_len,
+                        pc->operand.method->name);
+      goto winj_throw;
+    }
+    callee = receiver->cls->vtable[pc->index];
+  } goto winj_invoke_instance;
+  WINJ_OP(INVOKECACHED_QUICK) {
+    struct winj_call_cache *cache = pc->operand.cache;
+    struct winj_object *receiver = WINJ_OBJECT(sp[-pc->value]);
+    struct winj_method *method = cache->method;
+    int megamorphic = 0;
+
+    if (!receiver)
+      goto winj_invoke_null;
+    else if (receiver->cls == cache->entries[0].cls)
+      callee = cache->entries[0].method;
+    else {
+      WINJ_FRAME_SAVE();
+      if (EXIT_SUCCESS != winj_thread_call_miss
+          (thread, cache, receiver->cls, &callee, &megamorphic))
+        goto winj_throw;
+      else if (!megamorphic) {
+      } else if (method->cls->access_flags & WINJ_ACCESS_INTERFACE) {
+        pc->operand.method = method;
+        WINJ_QUICKEN(INVOKEINTERFACE_QUICK);
+      } else {
+        pc->index = (u2)method->vtable_index;
+        pc->operand.method = method;
+        WINJ_QUICKEN(INVOKEVIRTUAL_QUICK);
+      }
+    }
+  } goto winj_invoke_instance;
+  WINJ_OP(INVOKEINTERFACE_QUICK) {
+    struct winj_object *receiver = WINJ_OBJECT(sp[-pc->value]);
+
+    if (!receiver)
+      goto winj_invoke_null;
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_method_select
+        (thread, receiver->cls, pc->operand.method, &callee))
+      goto winj_throw;
+  } goto winj_invoke_instance;
+  WINJ_OP(INVOKESPECIAL_QUICK)
+    if (!sp[-pc->value].l)
+      goto winj_invoke_null;
+    callee = pc->operand.method;
+ winj_invoke_instance:
+    if (callee->call || !callee->method_file ||
+        !callee->method_file->code.code.value) {
+      enum winj_type return_type = WINJ_TYPE_VOID;
+      jvalue value;
+
+      sp -= pc->value;
+      WINJ_FRAME_SAVE();
+      if (EXIT_SUCCESS != winj_thread_invoke_slots
+          (thread, callee->cls, callee, WINJ_OBJECT(sp[0]), sp + 1,
+           &return_type, &value))
+        goto winj_throw;
+      sp += winj_slots_store(thread->vm, return_type, &value, sp);
+      ++pc;
+    } else {
+      WINJ_FRAME_SAVE();
+      if (!callee->insns &&
+          (EXIT_SUCCESS != winj_method_translate
+           (thread, callee->cls, callee, WINJ_HANDLERS)))
+        goto winj_throw;
+      frame->top = sp - pc->value;
+      frame->program_counter++; /* resume after this on return */
+      if (EXIT_SUCCESS != winj_thread_frame_push
+          (thread, callee->cls, callee, (unsigned)pc->value, NULL))
+        goto winj_throw;
+      WINJ_FRAME_LOAD();
+      WINJ_JIT_HOT();
+    }
+    WINJ_NEXT();
+ winj_invoke_null:
+    WINJ_FRAME_SAVE();
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "cannot invoke %.*s on null",
+                      winj_insn_method(pc)->name_len,
+                      winj_insn_method(pc)->name);
+    goto winj_throw;
+  WINJ_OP(CHECKCAST_QUICK) {
+    struct winj_object *object = WINJ_OBJECT(sp[-1]);
+
+    if (object && (EXIT_SUCCESS !=
+                   winj_class_assignable(object->cls, pc->cls))) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/ClassCastException",
+                        "%.*s cannot be cast to %.*s",
+                        object->cls->name_len, object->cls->name,
+                        pc->cls->name_len, pc->cls->name);
+      goto winj_throw;
+    }
+    ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(INSTANCEOF_QUICK) {
+    struct winj_object *object = WINJ_OBJECT(sp[-1]);
+
+    sp[-1].i = object && (EXIT_SUCCESS ==
+                          winj_class_assignable(object->cls, pc->cls));
+    ++pc;
+  } WINJ_NEXT();
+  WINJ_OP(NEW_QUICK) {
+    jobject object = NULL;
+
+    WINJ_FRAME_SAVE();
+    if (EXIT_SUCCESS != winj_thread_object_new(thread, pc->cls, &object))
+      goto winj_throw;
+    (sp++)->l = winj_ref_encode(thread->vm, object);
+    ++pc;
+  } WINJ_NEXT();
+
+  /* Instance fields are at a fixed offset from the object address.
+   * The object is the top slot for a get and below the value for a
+   * put, where a category two value takes two slots. */
+#define WINJ_FIELD(slot, type) \
+  (*(type *)((u1 *)WINJ_OBJECT(slot) + pc->value))
+  WINJ_OP(GETFIELD_BYTE_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    sp[-1].i = WINJ_FIELD(sp[-1], jbyte);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(GETFIELD_BOOLEAN_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    sp[-1].i = WINJ_FIELD(sp[-1], jboolean);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(GETFIELD_CHAR_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    sp[-1].i = WINJ_FIELD(sp[-1], jchar);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(GETFIELD_SHORT_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    sp[-1].i = WINJ_FIELD(sp[-1], jshort);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(GETFIELD_INT_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    sp[-1].i = WINJ_FIELD(sp[-1], jint);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(GETFIELD_LONG_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    winj_slots_set_long(sp - 1, WINJ_FIELD(sp[-1], jlong));
+    ++sp; ++pc; WINJ_NEXT();
+  WINJ_OP(GETFIELD_OBJECT_QUICK)
+    if (!sp[-1].l)
+      goto winj_field_null;
+    sp[-1].l = WINJ_FIELD(sp[-1], winj_ref);
+    ++pc; WINJ_NEXT();
+  WINJ_OP(PUTFIELD_BYTE_QUICK)
+    if (!sp[-2].l)
+      goto winj_field_null;
+    WINJ_FIELD(sp[-2], jbyte) = (jbyte)sp[-1].i;
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(PUTFIELD_BOOLEAN_QUICK)
+    if (!sp[-2].l)
+      goto winj_field_null;
+    WINJ_FIELD(sp[-2], jboolean) = (jboolean)(sp[-1].i & 1);
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(PUTFIELD_SHORT_QUICK)
+    if (!sp[-2].l)
+      goto winj_field_null;
+    WINJ_FIELD(sp[-2], jshort) = (jshort)sp[-1].i;
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(PUTFIELD_INT_QUICK)
+    if (!sp[-2].l)
+      goto winj_field_null;
+    WINJ_FIELD(sp[-2], jint) = sp[-1].i;
+    sp -= 2; ++pc; WINJ_NEXT();
+  WINJ_OP(PUTFIELD_LONG_QUICK)
+    if (!sp[-3].l)
+      goto winj_field_null;
+    WINJ_FIELD(sp[-3], jlong) = winj_slots_long(sp - 2);
+    sp -= 3; ++pc; WINJ_NEXT();
+  WINJ_OP(PUTFIELD_OBJECT_QUICK)
+    if (!sp[-2].l)
+      goto winj_field_null;
+    else if (EXIT_SUCCESS != winj_vm_gc_remember
+             (thread->vm, WINJ_OBJECT(sp[-2]), WINJ_OBJECT(sp[-1]))) {
+      WINJ_FRAME_SAVE();
+      winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                        "failed to remember object");
+      goto winj_throw;
+    }
+    WINJ_FIELD(sp[-2], winj_ref) = sp[-1].l;
+    sp -= 2; ++pc; WINJ_NEXT();
+ winj_field_null:
+    WINJ_FRAME_SAVE();
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "cannot access field of null");
+    goto winj_throw;
+#undef WINJ_FIELD
+
+  /* Translation folds these into other instructions. */
+  WINJ_OP(ICONST_M1) WINJ_OP(ICONST_0) WINJ_OP(ICONST_1)
+  WINJ_OP(ICONST_2) WINJ_OP(ICONST_3) WINJ_OP(ICONST_4)
+  WINJ_OP(ICONST_5) WINJ_OP(SIPUSH) WINJ_OP(WIDE) WINJ_OP(GOTO_W)
+  WINJ_OP(ILOAD_0) WINJ_OP(ILOAD_1) WINJ_OP(ILOAD_2) WINJ_OP(ILOAD_3)
+  WINJ_OP(LLOAD_0) WINJ_OP(LLOAD_1) WINJ_OP(LLOAD_2) WINJ_OP(LLOAD_3)
+  WINJ_OP(FLOAD_0) WINJ_OP(FLOAD_1) WINJ_OP(FLOAD_2) WINJ_OP(FLOAD_3)
+  WINJ_OP(DLOAD_0) WINJ_OP(DLOAD_1) WINJ_OP(DLOAD_2) WINJ_OP(DLOAD_3)
+  WINJ_OP(ALOAD_0) WINJ_OP(ALOAD_1) WINJ_OP(ALOAD_2) WINJ_OP(ALOAD_3)
+  WINJ_OP(ISTORE_0) WINJ_OP(ISTORE_1) WINJ_OP(ISTORE_2)
+  WINJ_OP(ISTORE_3) WINJ_OP(LSTORE_0) WINJ_OP(LSTORE_1)
+  WINJ_OP(LSTORE_2) WINJ_OP(LSTORE_3) WINJ_OP(FSTORE_0)
+  WINJ_OP(FSTORE_1) WINJ_OP(FSTORE_2) WINJ_OP(FSTORE_3)
+  WINJ_OP(DSTORE_0) WINJ_OP(DSTORE_1) WINJ_OP(DSTORE_2)
+  WINJ_OP(DSTORE_3) WINJ_OP(ASTORE_0) WINJ_OP(ASTORE_1)
+  WINJ_OP(ASTORE_2) WINJ_OP(ASTORE_3)
+  /* TODO: everything below needs objects, arrays or exceptions */
+  WINJ_OP(IALOAD) WINJ_OP(LALOAD) WINJ_OP(FALOAD) WINJ_OP(DALOAD)
+  WINJ_OP(BALOAD) WINJ_OP(CALOAD) WINJ_OP(SALOAD)
+  WINJ_OP(IASTORE) WINJ_OP(LASTORE) WINJ_OP(FASTORE)
+  WINJ_OP(DASTORE) WINJ_OP(BASTORE)
+  WINJ_OP(CASTORE) WINJ_OP(SASTORE) WINJ_OP(LDC_W)
+  WINJ_OP(JSR) WINJ_OP(RET)
+  WINJ_OP(JSR_W)
+  WINJ_OP(INVOKEDYNAMIC)
+  WINJ_OP(NEWARRAY) WINJ_OP(ANEWARRAY)
+  WINJ_OP(MULTIANEWARRAY) WINJ_OP(ATHROW)
+  WINJ_OP(MONITORENTER) WINJ_OP(MONITOREXIT)
+  WINJ_OP_DEFAULT
+    WINJ_FRAME_SAVE();
+    winj_thread_throw(thread, 0, "java/lang/InternalError",
+                      "opcode 0x%02x not yet implemented (%.*s.%.*s "
+                      "insn=%u)", pc->opcode, frame->winj->name_len,
+                      frame->winj->name, frame->method->name_len,
+                      frame->method->name, frame->program_counter);
+    goto winj_throw;
+
+#ifndef WINJ_THREADED_DISPATCH
+  }
+#endif
+
+ winj_throw: /* TODO: search exception tables for a handler */
+  while (thread->frame != entry)
+    winj_thread_frame_pop(thread);
+  return EXIT_FAILURE;
+}
+
+#undef WINJ_OP
+#undef WINJ_OP_DEFAULT
+#undef WINJ_NEXT
+#undef WINJ_TARGET
+#undef WINJ_HANDLERS
+#undef WINJ_QUICKEN
+#undef WINJ_THREADED_DISPATCH
+#undef WINJ_JIT_HOT
+
+
+/* === Java Native Interface (JNI) */
+
+static jint JNICALL
+JNI__GetVersion(JNIEnv *env)
+{ return JNI_VERSION_24; }
+
+static jint
+JNI__GetJavaVM(JNIEnv *env, JavaVM **jvm)
+{
+  jint rc = JNI_OK;
+  struct winj_thread *thread = (struct winj_thread *)env;
+  if (!jvm) {
+    rc = JNI_EINVAL;
+  } else *jvm = (JavaVM*)thread->vm;
+  return rc;
+}
+
+static jclass
+JNI__DefineClass
+(JNIEnv *env, const char *name, jobject loader,
+ const jbyte *buf, jsize len)
+{
+  struct winj_class *result = NULL;
+  struct winj_class *defined = NULL;
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
+  struct winj_bytes bytes = { len, 0, (unsigned char *)buf };
+  struct winj_bytes copy  = { 0, 0, NULL };
+
+  if (EXIT_SUCCESS != winj_bytes_copy(params, &bytes, &copy)) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %u bytes", bytes.count);
+  } else if (EXIT_SUCCESS != winj_thread_class_define
+             (thread, &copy, loader, &defined)) {
+  } else {
+    result = defined;
+    defined = NULL;
+  }
+  winj_free(params, copy.value);
+  winj_class_cleanup(thread ? thread->vm : NULL, defined);
+  return result ? &result->self : NULL;
+}
+
+static jclass
+JNI__FindClass(JNIEnv *env, const char *name)
+{
+  struct winj_class *result = NULL;
+  winj_thread_class_find((struct winj_thread *)env, 0, name, &result);
+  return result ? &result->self : NULL;
+}
+
+static jclass
+JNI__GetSuperclass(JNIEnv *env, jclass clazz)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_class *result = NULL;
+
+  if (!clazz) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing class");
+  } else if (EXIT_SUCCESS != winj_class_instance
+             (thread->vm->class_class, clazz)) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "class argument required");
+  } else result = ((struct winj_class *)clazz)->super;
+  return result ? &result->self : NULL;
+}
+
+static jboolean
+JNI__IsAssignableFrom(JNIEnv *env, jclass clazz1, jclass clazz2)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  jboolean result = JNI_FALSE;
+
+  if (!clazz1 || !clazz2) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing class");
+  } else if ((EXIT_SUCCESS != winj_class_instance
+              (thread->vm->class_class, clazz1)) ||
+             (EXIT_SUCCESS != winj_class_instance
+              (thread->vm->class_class, clazz2))) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "class argument required");
+  } else if (EXIT_SUCCESS == winj_class_assignable
+             ((struct winj_class *)clazz1, (struct winj_class *)clazz2))
+    result = JNI_TRUE;
+  return result;
+}
+
+static jobject
+JNI__AllocObject(JNIEnv *env, jclass clazz)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  jobject result = NULL;
+
+  if (!clazz) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing class argument");
+  } else if (clazz->cls != thread->vm->class_class) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "class argument is not actually a class");
+  } else if (EXIT_SUCCESS != winj_thread_class_init
+             (thread, (struct winj_class *)clazz)) {
+  } else if (EXIT_SUCCESS != winj_thread_object_new
+             (thread, (struct winj_class *)clazz, &result))
+    result = NULL;
+  return winj_thread_local_ref(thread, result);
+}
+
+jobject JNI__NewObject(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+    return NULL;
+}
+
+jobject JNI__NewObjectA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return NULL;
+}
+
+jobject JNI__NewObjectV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+    return NULL;
+}
+
+jclass JNI__GetObjectClass(JNIEnv *env, jobject obj) {
+    return NULL;
+}
+
+static jboolean
+JNI__IsInstanceOf(JNIEnv *env, jobject obj, jclass clazz)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  jboolean result = JNI_FALSE;
+
+  if (!clazz) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing class");
+  } else if (EXIT_SUCCESS != winj_class_instance
+             (thread->vm->class_class, clazz)) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "class argument required");
+  } else if (!obj || (EXIT_SUCCESS == winj_class_instance
+                      ((struct winj_class *)clazz, obj)))
+    result = JNI_TRUE;
+  return result;
+}
+
+static jmethodID
+JNI__GetMethodID
+(JNIEnv *env, jclass clazz, const char *name, const char *sig)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_vm_params *params = (thread && thread->vm) ?
+    &thread->vm->params : NULL;
+  struct winj_method *method = NULL;
+  char *combined = NULL;
+
+  if (clazz->cls != thread->vm->class_class) {
+    winj_error(params, "invalid class object provided");
+  } else if (EXIT_SUCCESS != winj_string_concat
+             (params, 0, name, 0, sig, NULL, &combined)) {
+    winj_error(params, "string concatenation failed");
+  } else winj_class_method_search
+           ((struct winj_class *)clazz, 0, combined, &method);
+  winj_free(params, combined);
+  return method;
+}
+
+static jfieldID
+JNI__GetFieldID
+(JNIEnv *env, jclass clazz, const char *name, const char *sig)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_vm_params *params = (thread && thread->vm) ?
+    &thread->vm->params : NULL;
+  struct winj_field *field = NULL;
+  char *combined = NULL;
+
+  if (!clazz || (clazz->cls != thread->vm->class_class)) {
+    winj_error(params, "invalid class object provided");
+  } else if (EXIT_SUCCESS != winj_string_concat
+             (params, 0, name, 0, sig, NULL, &combined)) {
+    winj_error(params, "string concatenation failed");
+  } else if (EXIT_SUCCESS != winj_thread_class_init
+             (thread, (struct winj_class *)clazz)) {
+  } else if (winj_class_field_find
+             ((struct winj_class *)clazz, 0, combined, &field), !field) {
+    winj_thread_throw(thread, 0, "java/lang/NoSuchFieldError",
+                      "%s", name);
+  }
+  winj_free(params, combined);
+  return field;
+}
+
+static jfieldID
+JNI__GetStaticFieldID
+(JNIEnv *env, jclass clazz, const char *name, const char *sig)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_vm_params *params = (thread && thread->vm) ?
+    &thread->vm->params : NULL;
+  struct winj_field *field = NULL;
+  char *combined = NULL;
+
+  if (!clazz || (clazz->cls != thread->vm->class_class)) {
+    winj_error(params, "invalid class object provided");
+  } else if (EXIT_SUCCESS != winj_string_concat
+             (params, 0, name, 0, sig, NULL, &combined)) {
+    winj_error(params, "string concatenation failed");
+  } else if (EXIT_SUCCESS != winj_thread_class_init
+             (thread, (struct winj_class *)clazz)) {
+  } else winj_class_static_field_search
+           ((struct winj_class *)clazz, 0, combined, &field);
+  winj_free(params, combined);
+  return field;
+}
+
+jobject JNI__GetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return NULL;
+}
+
+void JNI__SetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID, jobject value) {}
+
+jboolean JNI__GetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return JNI_FALSE;
+}
+
+void JNI__SetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID, jboolean value) {}
+
+jbyte JNI__GetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return 0;
+}
+
+void JNI__SetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID, jbyte value) {}
+
+jchar JNI__GetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return 0;
+}
+
+void JNI__SetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID, jchar value) {}
+
+jshort JNI__GetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return 0;
+}
+
+void JNI__SetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID, jshort value) {}
+
+static jint
+JNI__GetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID)
+{
+  return ((struct winj_class *)clazz)->static_values[fieldID->index].i;
+}
+
+static void
+JNI__SetStaticIntField
+(JNIEnv *env, jclass clazz, jfieldID fieldID, jint value)
+{
+  ((struct winj_class *)clazz)->static_values[fieldID->index].i = value;
+}
+
+jlong JNI__GetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return 0;
+}
+
+void JNI__SetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID, jlong value) {}
+
+jfloat JNI__GetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return 0.0f;
+}
+
+void JNI__SetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID, jfloat value) {}
+
+jdouble JNI__GetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+    return 0.0;
+}
+
+void JNI__SetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID, jdouble value) {}
+
+/**
+ * Check that an instance field can be accessed through JNI.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param obj object containing field
+ * @param field field to access
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_field_check
+(struct winj_thread *thread, jobject obj, jfieldID field)
+{
+  int result = EXIT_SUCCESS;
+
+  if (!obj || !field) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing %s", obj ? "field" : "object");
+    result = EXIT_FAILURE;
+  }
+  return result;
+}
+
+static jobject
+JNI__GetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  jobject result = NULL;
+
+  if (EXIT_SUCCESS == winj_thread_field_check(thread, obj, fieldID))
+    result = winj_thread_local_ref
+      (thread, winj_ref_decode
+       (thread->vm, *(winj_ref *)((u1 *)obj + fieldID->offset)));
+  return result;
+}
+
+static void
+JNI__SetObjectField
+(JNIEnv *env, jobject obj, jfieldID fieldID, jobject value)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+
+  if (EXIT_SUCCESS != winj_thread_field_check(thread, obj, fieldID)) {
+  } else if (EXIT_SUCCESS != winj_vm_gc_remember
+             (thread->vm, obj, value)) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to remember object");
+  } else *(winj_ref *)((u1 *)obj + fieldID->offset) =
+           winj_ref_encode(thread->vm, value);
+}
+
+/* Generates JNI functions to get and set primitive instance fields.
+ * Values are copied as bytes since float and double fields are
+ * stored through integer types by the interpreter. */
+#define WINJ_JNI_FIELD(Type, type)                                     \
+  static type                                                          \
+  JNI__Get##Type##Field(JNIEnv *env, jobject obj, jfieldID fieldID)    \
+  {                                                                    \
+    type result = 0;                                                   \
+    if (EXIT_SUCCESS == winj_thread_field_check                        \
+        ((struct winj_thread *)env, obj, fieldID))                     \
+      memcpy(&result, (u1 *)obj + fieldID->offset, sizeof(result));    \
+    return result;                                                     \
+  }                                                                    \
+  static void                                                          \
+  JNI__Set##Type##Field                                                \
+  (JNIEnv *env, jobject obj, jfieldID fieldID, type value)             \
+  {                                                                    \
+    if (EXIT_SUCCESS == winj_thread_field_check                        \
+        ((struct winj_thread *)env, obj, fieldID))                     \
+      memcpy((u1 *)obj + fieldID->offset, &value, sizeof(value));      \
+  }
+
+WINJ_JNI_FIELD(Boolean, jboolean)
+WINJ_JNI_FIELD(Byte, jbyte)
+WINJ_JNI_FIELD(Char, jchar)
+WINJ_JNI_FIELD(Short, jshort)
+WINJ_JNI_FIELD(Int, jint)
+WINJ_JNI_FIELD(Long, jlong)
+WINJ_JNI_FIELD(Float, jfloat)
+WINJ_JNI_FIELD(Double, jdouble)
+#undef WINJ_JNI_FIELD
+
+static jmethodID
+JNI__GetStaticMethodID
+(JNIEnv *env, jclass clazz, const char *name, const char *sig)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_vm_params *params = (thread && thread->vm) ?
+    &thread->vm->params : NULL;
+  struct winj_method *method = NULL;
+  char *combined = NULL;
+
+  if (!clazz || (clazz->cls != thread->vm->class_class)) {
+    winj_error(params, "invalid class object provided %p", clazz->cls);
+  } else if (EXIT_SUCCESS != winj_string_concat
+             (params, 0, name, 0, sig, NULL, &combined)) {
+    winj_error(params, "string concatenation failed");
+  } else winj_class_static_method_search
+           ((struct winj_class *)clazz, 0, combined, &method);
+  winj_free(params, combined);
+  return method;
+}
+
+/**
+ * Call a static method with arguments from a variable argument list
+ * on behalf of one of the JNI CallStatic*MethodV functions.
+ *
+ * @param thread thread on which to call method
+ * @param clazz class to which method belongs
+ * @param methodID method to call
+ * @param expected return type required by the caller
+ * @param args variable arguments for method
+ * @param value_out destination for return value
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_call_static_v
+(struct winj_thread *thread, jclass clazz, jmethodID methodID,
+ enum winj_type expected, va_list args, jvalue *value_out)
+{
+  int result = EXIT_FAILURE;
+  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
+  struct winj_argument buffer[WINJ_ARGUMENT_INLINE];
+  struct winj_argument *arguments = NULL;
+
+  if (!methodID) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing methodID");
+  } else if (!clazz) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing class");
+  } else if (EXIT_SUCCESS != winj_class_instance
+             (thread->vm->class_class, clazz)) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "static method requires class");
+  } else if (methodID->signature.return_type != expected) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "method returns the wrong type: \"%.*s\"",
+                      methodID->name_len, methodID->name);
+  } else if (!(arguments = winj_thread_arguments
+               (thread, &methodID->signature, buffer))) {
+  } else if (EXIT_SUCCESS != winj_arguments_varargs
+             (params, args, methodID->signature.count, arguments)) {
+    winj_thread_throw(thread, 0, "java/lang/InternalError",
+                      "failed to convert varargs: \"%.*s\"",
+                      methodID->name_len, methodID->name);
+  } else result = winj_thread_invoke
+           (thread, (struct winj_class *)clazz, methodID, NULL,
+            methodID->signature.count, arguments, value_out);
+  if (arguments)
+    winj_thread_arguments_free(thread, arguments, buffer);
+  return result;
+}
+
+static jobject
+JNI__CallStaticObjectMethodV
+(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.l = NULL;
+  winj_thread_call_static_v((struct winj_thread *)env, clazz, methodID,
+                            WINJ_TYPE_OBJECT, args, &value);
+  return winj_thread_local_ref((struct winj_thread *)env, value.l);
+}
+
+static jobject
+JNI__CallStaticObjectMethod
+(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
+{
+  jobject result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallStaticObjectMethodV(env, clazz, methodID, args);
+  va_end(args);
+  return result;
+}
+
+jobject JNI__CallStaticObjectMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return NULL;
+}
+
+static jboolean
+JNI__CallStaticBooleanMethodV
+(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.z = JNI_FALSE;
+  winj_thread_call_static_v((struct winj_thread *)env, clazz, methodID,
+                            WINJ_TYPE_BOOLEAN, args, &value);
+  return value.z;
+}
+
+static jboolean
+JNI__CallStaticBooleanMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
+{
+  jboolean result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallStaticBooleanMethodV(env, clazz, methodID, args);
+  va_end(args);
   return result;
 }
 
-int
-winj_arguments_values
-(struct winj_vm_params *params, jvalue *values,
- unsigned argument_count, struct winj_argument *arguments)
-{
-  int result = EXIT_SUCCESS;
-  unsigned ii;
+jboolean JNI__CallStaticBooleanMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return JNI_FALSE;
+}
 
-  for (ii = 0; ii < argument_count; ++ii)
-    arguments[ii].value = values[ii];
-  return result;
+jbyte JNI__CallStaticByteMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+    return 0;
 }
 
-int
-winj_arguments_varargs
-(struct winj_vm_params *params, va_list args,
- unsigned argument_count, struct winj_argument *arguments)
-{
-  int result = EXIT_SUCCESS;
-  unsigned ii;
+jbyte JNI__CallStaticByteMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0;
+}
 
-  /* TODO: something about arrays? */
-  for (ii = 0; (EXIT_SUCCESS == result) &&
-         (ii < argument_count); ++ii) {
-    struct winj_argument *argument = &arguments[ii];
-    switch (argument->argtype) {
-    case WINJ_TYPE_BOOLEAN:
-      argument->value.z = va_arg(args, jint); break;
-    case WINJ_TYPE_BYTE:
-      argument->value.b = va_arg(args, jint); break;
-    case WINJ_TYPE_CHAR:
-      argument->value.c = va_arg(args, jint); break;
-    case WINJ_TYPE_SHORT:
-      argument->value.s = va_arg(args, jint); break;
-    case WINJ_TYPE_INT:
-      argument->value.i = va_arg(args, jint); break;
-    case WINJ_TYPE_LONG:
-      argument->value.j = va_arg(args, jlong); break;
-    case WINJ_TYPE_FLOAT:
-      argument->value.f = va_arg(args, jdouble); break;
-    case WINJ_TYPE_DOUBLE:
-      argument->value.d = va_arg(args, jdouble); break;
-    case WINJ_TYPE_OBJECT:
-      argument->value.l = va_arg(args, jobject); break;
-    default:
-      result = winj_error
-        (params, "unknown type: %u", argument->argtype);
-    }
-  }
-  return result;
+jbyte JNI__CallStaticByteMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+    return 0;
 }
 
+jchar JNI__CallStaticCharMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+    return 0;
+}
 
-/* === Java Native Interface (JNI) */
+jchar JNI__CallStaticCharMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0;
+}
 
-static jint JNICALL
-JNI__GetVersion(JNIEnv *env)
-{ return JNI_VERSION_24; }
+jchar JNI__CallStaticCharMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+    return 0;
+}
+
+jshort JNI__CallStaticShortMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+    return 0;
+}
+
+jshort JNI__CallStaticShortMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0;
+}
+
+jshort JNI__CallStaticShortMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+    return 0;
+}
 
 static jint
-JNI__GetJavaVM(JNIEnv *env, JavaVM **jvm)
+JNI__CallStaticIntMethodV
+(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
 {
-  jint rc = JNI_OK;
-  struct winj_thread *thread = (struct winj_thread *)env;
-  if (!jvm) {
-    rc = JNI_EINVAL;
-  } else *jvm = (JavaVM*)thread->vm;
-  return rc;
+  jvalue value;
+  value.i = 0;
+  winj_thread_call_static_v((struct winj_thread *)env, clazz, methodID,
+                            WINJ_TYPE_INT, args, &value);
+  return value.i;
 }
 
-static jclass
-JNI__DefineClass
-(JNIEnv *env, const char *name, jobject loader,
- const jbyte *buf, jsize len)
+static jint
+JNI__CallStaticIntMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
 {
-  struct winj_class *result = NULL;
-  struct winj_class *defined = NULL;
-  struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
-  struct winj_bytes bytes = { len, 0, (unsigned char *)buf };
-  struct winj_bytes copy  = { 0, 0, NULL };
+  jint result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallStaticIntMethodV(env, clazz, methodID, args);
+  va_end(args);
+  return result;
+}
 
-  if (EXIT_SUCCESS != winj_bytes_copy(params, &bytes, &copy)) {
-    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
-                      "failed to allocate %u bytes", bytes.count);
-  } else if (EXIT_SUCCESS != winj_thread_class_define
-             (thread, &copy, loader, &defined)) {
-  } else {
-    result = defined;
-    defined = NULL;
-  }
-  winj_free(params, copy.value);
-  winj_class_cleanup(params, defined);
-  return result ? &result->self : NULL;
+jint JNI__CallStaticIntMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0;
 }
 
-static jclass
-JNI__FindClass(JNIEnv *env, const char *name)
+static jlong
+JNI__CallStaticLongMethodV
+(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
 {
-  struct winj_class *result = NULL;
-  winj_thread_class_find((struct winj_thread *)env, 0, name, &result);
-  return result ? &result->self : NULL;
+  jvalue value;
+  value.j = 0;
+  winj_thread_call_static_v((struct winj_thread *)env, clazz, methodID,
+                            WINJ_TYPE_LONG, args, &value);
+  return value.j;
 }
 
-static jclass
-JNI__GetSuperclass(JNIEnv *env, jclass clazz)
+static jlong
+JNI__CallStaticLongMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
 {
-  struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_class *result = NULL;
+  jlong result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallStaticLongMethodV(env, clazz, methodID, args);
+  va_end(args);
+  return result;
+}
 
-  if (!clazz) {
-    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
-                      "missing class");
-  } else if (EXIT_SUCCESS != winj_class_instance
-             (thread->vm->class_class, clazz)) {
-    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
-                      "class argument required");
-  } else result = ((struct winj_class *)clazz)->super;
-  return result ? &result->self : NULL;
+jlong JNI__CallStaticLongMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0;
 }
 
-jboolean JNI__IsAssignableFrom(JNIEnv *env, jclass clazz1, jclass clazz2) {
-    return JNI_FALSE;
+jfloat JNI__CallStaticFloatMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+    return 0.0f;
 }
 
-jobject JNI__AllocObject(JNIEnv *env, jclass clazz) {
-    return NULL;
+jfloat JNI__CallStaticFloatMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0.0f;
 }
 
-jobject JNI__NewObject(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
-    return NULL;
+jfloat JNI__CallStaticFloatMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+    return 0.0f;
 }
 
-jobject JNI__NewObjectA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return NULL;
+static jdouble
+JNI__CallStaticDoubleMethodV
+(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.d = 0.0;
+  winj_thread_call_static_v((struct winj_thread *)env, clazz, methodID,
+                            WINJ_TYPE_DOUBLE, args, &value);
+  return value.d;
 }
 
-jobject JNI__NewObjectV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
-    return NULL;
+static jdouble
+JNI__CallStaticDoubleMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
+{
+  jdouble result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallStaticDoubleMethodV(env, clazz, methodID, args);
+  va_end(args);
+  return result;
 }
 
-jclass JNI__GetObjectClass(JNIEnv *env, jobject obj) {
-    return NULL;
+jdouble JNI__CallStaticDoubleMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+    return 0.0;
 }
 
-jboolean JNI__IsInstanceOf(JNIEnv *env, jobject obj, jclass clazz) {
-    return JNI_FALSE;
+static void
+JNI__CallStaticVoidMethodA
+(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  winj_thread_throw(thread, 0, "java/lang/InternalError",
+                    "not yet implemented");
+  /* TODO */
 }
 
-static jmethodID
-JNI__GetMethodID
-(JNIEnv *env, jclass clazz, const char *name, const char *sig)
+static void
+JNI__CallStaticVoidMethodV
+(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  winj_thread_call_static_v((struct winj_thread *)env, clazz, methodID,
+                            WINJ_TYPE_VOID, args, &value);
+}
+
+static void
+JNI__CallStaticVoidMethod
+(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
+{
+  va_list args;
+  va_start(args, methodID);
+  JNI__CallStaticVoidMethodV(env, clazz, methodID, args);
+  va_end(args);
+}
+
+static jobject
+JNI__CallObjectMethodA
+(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args)
 {
   struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_vm_params *params = (thread && thread->vm) ?
-    &thread->vm->params : NULL;
+  winj_thread_throw(thread, 0, "java/lang/InternalError",
+                    "not yet implemented");
+  /* TODO */
+  return NULL;
+}
+
+/**
+ * Call an instance method with arguments from a variable argument
+ * list on behalf of one of the JNI Call*MethodV functions.  Virtual
+ * methods are selected by the class of the object, as invokevirtual
+ * and invokeinterface would.
+ *
+ * @param thread thread on which to call method
+ * @param obj object on which to call method
+ * @param methodID method to call
+ * @param expected return type required by the caller
+ * @param args variable arguments for method
+ * @param value_out destination for return value
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_call_v
+(struct winj_thread *thread, jobject obj, jmethodID methodID,
+ enum winj_type expected, va_list args, jvalue *value_out)
+{
+  int result = EXIT_FAILURE;
+  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
+  struct winj_argument buffer[WINJ_ARGUMENT_INLINE];
+  struct winj_argument *arguments = NULL;
   struct winj_method *method = NULL;
-  char *combined = NULL;
 
-  if (clazz->cls != thread->vm->class_class) {
-    winj_error(params, "invalid class object provided");
-  } else if (EXIT_SUCCESS != winj_string_concat
-             (params, 0, name, 0, sig, NULL, &combined)) {
-    winj_error(params, "string concatenation failed");
-  } else winj_class_method_search
-           ((struct winj_class *)clazz, 0, combined, &method);
-  winj_free(params, combined);
-  return method;
-}
+  if (!methodID) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing methodID");
+  } else if (!obj) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "cannot invoke %.*s on null",
+                      methodID->name_len, methodID->name);
+  } else if (EXIT_SUCCESS != winj_class_instance(methodID->cls, obj)) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "%.*s is not a %.*s", obj->cls->name_len,
+                      obj->cls->name, methodID->cls->name_len,
+                      methodID->cls->name);
+  } else if (methodID->signature.return_type != expected) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "method returns the wrong type: \"%.*s\"",
+                      methodID->name_len, methodID->name);
+  } else if (!winj_method_virtual(methodID)) {
+    method = methodID;
+  } else if (!(methodID->cls->access_flags & WINJ_ACCESS_INTERFACE)) {
+    method = obj->cls->vtable[methodID->vtable_index];
+  } else if (EXIT_SUCCESS != winj_class_virtual_search
+             (obj->cls, methodID->name_len, methodID->name, &method) ||
+             !method) {
+    winj_thread_throw(thread, 0, "java/lang/AbstractMethodError",
+                      "%.*s.%.*s", obj->cls->name_len, obj->cls->name,
+                      methodID->name_len, methodID->name);
+  }
 
-jfieldID JNI__GetFieldID(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
-    return NULL;
+  if (!method) {
+  } else if (!(arguments = winj_thread_arguments
+               (thread, &method->signature, buffer))) {
+  } else if (EXIT_SUCCESS != winj_arguments_varargs
+             (params, args, method->signature.count, arguments)) {
+    winj_thread_throw(thread, 0, "java/lang/InternalError",
+                      "failed to convert varargs: \"%.*s\"",
+                      method->name_len, method->name);
+  } else result = winj_thread_invoke
+           (thread, method->cls, method, obj, method->signature.count,
+            arguments, value_out);
+  if (arguments)
+    winj_thread_arguments_free(thread, arguments, buffer);
+  return result;
 }
 
-jfieldID JNI__GetStaticFieldID(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
-    return NULL;
+static jobject
+JNI__CallObjectMethodV
+(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.l = NULL;
+  winj_thread_call_v((struct winj_thread *)env, obj, methodID,
+                     WINJ_TYPE_OBJECT, args, &value);
+  return winj_thread_local_ref((struct winj_thread *)env, value.l);
 }
 
-jobject JNI__GetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
-    return NULL;
+static jobject
+JNI__CallObjectMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+{
+  jobject result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallObjectMethodV(env, obj, methodID, args);
+  va_end(args);
+  return result;
 }
 
-void JNI__SetStaticObjectField(JNIEnv *env, jclass clazz, jfieldID fieldID, jobject value) {}
 
-jboolean JNI__GetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+jboolean JNI__CallBooleanMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
     return JNI_FALSE;
 }
 
-void JNI__SetStaticBooleanField(JNIEnv *env, jclass clazz, jfieldID fieldID, jboolean value) {}
+static jboolean
+JNI__CallBooleanMethodV
+(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.z = 0;
+  winj_thread_call_v((struct winj_thread *)env, obj, methodID,
+                     WINJ_TYPE_BOOLEAN, args, &value);
+  return value.z;
+}
 
-jbyte JNI__GetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
-    return 0;
+static jboolean
+JNI__CallBooleanMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+{
+  jboolean result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallBooleanMethodV(env, obj, methodID, args);
+  va_end(args);
+  return result;
 }
 
-void JNI__SetStaticByteField(JNIEnv *env, jclass clazz, jfieldID fieldID, jbyte value) {}
 
-jchar JNI__GetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+jbyte JNI__CallByteMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
     return 0;
 }
 
-void JNI__SetStaticCharField(JNIEnv *env, jclass clazz, jfieldID fieldID, jchar value) {}
-
-jshort JNI__GetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+jbyte JNI__CallByteMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-void JNI__SetStaticShortField(JNIEnv *env, jclass clazz, jfieldID fieldID, jshort value) {}
-
-jint JNI__GetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+jbyte JNI__CallByteMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
     return 0;
 }
 
-void JNI__SetStaticIntField(JNIEnv *env, jclass clazz, jfieldID fieldID, jint value) {}
 
-jlong JNI__GetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
+jchar JNI__CallCharMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-void JNI__SetStaticLongField(JNIEnv *env, jclass clazz, jfieldID fieldID, jlong value) {}
-
-jfloat JNI__GetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
-    return 0.0f;
+static jchar
+JNI__CallCharMethodV
+(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.c = 0;
+  winj_thread_call_v((struct winj_thread *)env, obj, methodID,
+                     WINJ_TYPE_CHAR, args, &value);
+  return value.c;
 }
 
-void JNI__SetStaticFloatField(JNIEnv *env, jclass clazz, jfieldID fieldID, jfloat value) {}
-
-jdouble JNI__GetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID) {
-    return 0.0;
+static jchar
+JNI__CallCharMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+{
+  jchar result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallCharMethodV(env, obj, methodID, args);
+  va_end(args);
+  return result;
 }
 
-void JNI__SetStaticDoubleField(JNIEnv *env, jclass clazz, jfieldID fieldID, jdouble value) {}
 
-jobject JNI__GetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID) {
-    return NULL;
+jshort JNI__CallShortMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
+    return 0;
 }
 
-void JNI__SetObjectField(JNIEnv *env, jobject obj, jfieldID fieldID, jobject value) {}
+jshort JNI__CallShortMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
+    return 0;
+}
 
-jboolean JNI__GetBooleanField(JNIEnv *env, jobject obj, jfieldID fieldID) {
-    return JNI_FALSE;
+jshort JNI__CallShortMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
+    return 0;
 }
 
-void JNI__SetBooleanField(JNIEnv *env, jobject obj, jfieldID fieldID, jboolean value) {}
 
-jbyte JNI__GetByteField(JNIEnv *env, jobject obj, jfieldID fieldID) {
+jint JNI__CallIntMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-void JNI__SetByteField(JNIEnv *env, jobject obj, jfieldID fieldID, jbyte value) {}
+static jint
+JNI__CallIntMethodV
+(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.i = 0;
+  winj_thread_call_v((struct winj_thread *)env, obj, methodID,
+                     WINJ_TYPE_INT, args, &value);
+  return value.i;
+}
 
-jchar JNI__GetCharField(JNIEnv *env, jobject obj, jfieldID fieldID) {
-    return 0;
+static jint
+JNI__CallIntMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+{
+  jint result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallIntMethodV(env, obj, methodID, args);
+  va_end(args);
+  return result;
 }
 
-void JNI__SetCharField(JNIEnv *env, jobject obj, jfieldID fieldID, jchar value) {}
 
-jshort JNI__GetShortField(JNIEnv *env, jobject obj, jfieldID fieldID) {
+
+jlong JNI__CallLongMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-void JNI__SetShortField(JNIEnv *env, jobject obj, jfieldID fieldID, jshort value) {}
+static jlong
+JNI__CallLongMethodV
+(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
+{
+  jvalue value;
+  value.j = 0;
+  winj_thread_call_v((struct winj_thread *)env, obj, methodID,
+                     WINJ_TYPE_LONG, args, &value);
+  return value.j;
+}
 
-jint JNI__GetIntField(JNIEnv *env, jobject obj, jfieldID fieldID) {
-    return 0;
+static jlong
+JNI__CallLongMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+{
+  jlong result;
+  va_list args;
+  va_start(args, methodID);
+  result = JNI__CallLongMethodV(env, obj, methodID, args);
+  va_end(args);
+  return result;
 }
 
-void JNI__SetIntField(JNIEnv *env, jobject obj, jfieldID fieldID, jint value) {}
 
-jlong JNI__GetLongField(JNIEnv *env, jobject obj, jfieldID fieldID) {
-    return 0;
+jfloat JNI__CallFloatMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
+    return 0.0f;
 }
 
-void JNI__SetLongField(JNIEnv *env, jobject obj, jfieldID fieldID, jlong value) {}
+jfloat JNI__CallFloatMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
+    return 0.0f;
+}
 
-jfloat JNI__GetFloatField(JNIEnv *env, jobject obj, jfieldID fieldID) {
+jfloat JNI__CallFloatMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
     return 0.0f;
 }
 
-void JNI__SetFloatField(JNIEnv *env, jobject obj, jfieldID fieldID, jfloat value) {}
+jdouble JNI__CallDoubleMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
+    return 0.0;
+}
 
-jdouble JNI__GetDoubleField(JNIEnv *env, jobject obj, jfieldID fieldID) {
+jdouble JNI__CallDoubleMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
     return 0.0;
 }
 
-void JNI__SetDoubleField(JNIEnv *env, jobject obj, jfieldID fieldID, jdouble value) {}
+jdouble JNI__CallDoubleMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
+    return 0.0;
+}
 
-static jmethodID
-JNI__GetStaticMethodID
-(JNIEnv *env, jclass clazz, const char *name, const char *sig)
+
+void JNI__CallVoidMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {}
+
+static void
+JNI__CallVoidMethodV
+(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
 {
-  struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_vm_params *params = (thread && thread->vm) ?
-    &thread->vm->params : NULL;
-  struct winj_method *method = NULL;
-  char *combined = NULL;
+  jvalue value;
+  winj_thread_call_v((struct winj_thread *)env, obj, methodID,
+                     WINJ_TYPE_VOID, args, &value);
+}
 
-  if (!clazz || (clazz->cls != thread->vm->class_class)) {
-    winj_error(params, "invalid class object provided %p", clazz->cls);
-  } else if (EXIT_SUCCESS != winj_string_concat
-             (params, 0, name, 0, sig, NULL, &combined)) {
-    winj_error(params, "string concatenation failed");
-  } else winj_class_static_method_search
-           ((struct winj_class *)clazz, 0, combined, &method);
-  winj_free(params, combined);
-  return method;
+static void
+JNI__CallVoidMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+{
+  va_list args;
+  va_start(args, methodID);
+  JNI__CallVoidMethodV(env, obj, methodID, args);
+  va_end(args);
 }
 
-jobject JNI__CallStaticObjectMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+
+/* Call Nonvirtual Methods */
+jobject JNI__CallNonvirtualObjectMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return NULL;
 }
 
-jobject JNI__CallStaticObjectMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jobject JNI__CallNonvirtualObjectMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return NULL;
 }
 
-jobject JNI__CallStaticObjectMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jobject JNI__CallNonvirtualObjectMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return NULL;
 }
 
-jboolean JNI__CallStaticBooleanMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jboolean JNI__CallNonvirtualBooleanMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return JNI_FALSE;
 }
 
-jboolean JNI__CallStaticBooleanMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jboolean JNI__CallNonvirtualBooleanMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return JNI_FALSE;
 }
 
-jboolean JNI__CallStaticBooleanMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jboolean JNI__CallNonvirtualBooleanMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return JNI_FALSE;
 }
 
-jbyte JNI__CallStaticByteMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jbyte JNI__CallNonvirtualByteMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0;
 }
 
-jbyte JNI__CallStaticByteMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jbyte JNI__CallNonvirtualByteMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-jbyte JNI__CallStaticByteMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jbyte JNI__CallNonvirtualByteMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0;
 }
 
-jchar JNI__CallStaticCharMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jchar JNI__CallNonvirtualCharMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0;
 }
 
-jchar JNI__CallStaticCharMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jchar JNI__CallNonvirtualCharMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-jchar JNI__CallStaticCharMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jchar JNI__CallNonvirtualCharMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0;
 }
 
-jshort JNI__CallStaticShortMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jshort JNI__CallNonvirtualShortMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0;
 }
 
-jshort JNI__CallStaticShortMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jshort JNI__CallNonvirtualShortMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-jshort JNI__CallStaticShortMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jshort JNI__CallNonvirtualShortMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0;
 }
 
-jint JNI__CallStaticIntMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jint JNI__CallNonvirtualIntMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0;
 }
 
-jint JNI__CallStaticIntMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jint JNI__CallNonvirtualIntMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-jint JNI__CallStaticIntMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jint JNI__CallNonvirtualIntMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0;
 }
 
-jlong JNI__CallStaticLongMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jlong JNI__CallNonvirtualLongMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0;
 }
 
-jlong JNI__CallStaticLongMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jlong JNI__CallNonvirtualLongMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0;
 }
 
-jlong JNI__CallStaticLongMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jlong JNI__CallNonvirtualLongMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0;
 }
 
-jfloat JNI__CallStaticFloatMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jfloat JNI__CallNonvirtualFloatMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0.0f;
 }
 
-jfloat JNI__CallStaticFloatMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jfloat JNI__CallNonvirtualFloatMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0.0f;
 }
 
-jfloat JNI__CallStaticFloatMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jfloat JNI__CallNonvirtualFloatMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0.0f;
 }
 
-jdouble JNI__CallStaticDoubleMethod(JNIEnv *env, jclass clazz, jmethodID methodID, ...) {
+jdouble JNI__CallNonvirtualDoubleMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
     return 0.0;
 }
 
-jdouble JNI__CallStaticDoubleMethodA(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args) {
+jdouble JNI__CallNonvirtualDoubleMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
     return 0.0;
 }
 
-jdouble JNI__CallStaticDoubleMethodV(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args) {
+jdouble JNI__CallNonvirtualDoubleMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
     return 0.0;
 }
 
+void JNI__CallNonvirtualVoidMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {}
+
+void JNI__CallNonvirtualVoidMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {}
+
+void JNI__CallNonvirtualVoidMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {}
+
+/* String Operations */
+/**
+ * Find the characters of a string passed to a JNI function, throwing
+ * an exception unless it really is a string.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param str string provided by native code
+ * @param count_out destination for number of characters
+ * @param coder_out destination for encoding of characters
+ * @param bytes_out destination for characters of the string
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_jni_string(struct winj_thread *thread, jstring str,
+                unsigned *count_out, enum winj_coder *coder_out,
+                const u1 **bytes_out)
+{
+  int result = EXIT_FAILURE;
+
+  if (!str) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing string");
+  } else if (str->cls != thread->vm->class_string) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "%.*s is not a string",
+                      str->cls->name_len, str->cls->name);
+  } else {
+    *bytes_out = winj_string_bytes(thread->vm, str, count_out, coder_out);
+    result = EXIT_SUCCESS;
+  }
+  return result;
+}
+
+static jstring
+JNI__NewString(JNIEnv *env, const jchar *unicode, jsize len)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_object *result = NULL;
+
+  if (!unicode && len) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing unicode");
+  } else if (len < 0) {
+    winj_thread_throw(thread, 0, "java/lang/NegativeArraySizeException",
+                      "%d", len);
+  } else if (EXIT_SUCCESS != winj_thread_string_new
+             (thread, (unsigned)len, unicode, &result))
+    result = NULL;
+  return winj_thread_local_ref(thread, result);
+}
+
+static jsize
+JNI__GetStringLength(JNIEnv *env, jstring str)
+{
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = NULL;
+
+  return (EXIT_SUCCESS == winj_jni_string
+          ((struct winj_thread *)env, str, &count, &coder, &bytes)) ?
+    (jsize)count : 0;
+}
+
+static const jchar *
+JNI__GetStringChars(JNIEnv *env, jstring str, jboolean *isCopy)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  jchar *result = NULL;
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = NULL;
+
+  if (EXIT_SUCCESS != winj_jni_string
+      (thread, str, &count, &coder, &bytes)) {
+  } else if (!(result = winj_malloc
+               (&thread->vm->params, (count + 1) * sizeof(*result)))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %u characters", count + 1);
+  } else {
+    if (coder)
+      memcpy(result, bytes, (size_t)count * sizeof(*result));
+    else winj_bytes_widen(count, bytes, result);
+    result[count] = 0;
+    if (isCopy)
+      *isCopy = JNI_TRUE;
+  }
+  return result;
+}
+
 static void
-JNI__CallStaticVoidMethodA
-(JNIEnv *env, jclass clazz, jmethodID methodID, const jvalue *args)
+JNI__ReleaseStringChars(JNIEnv *env, jstring str, const jchar *chars)
 {
   struct winj_thread *thread = (struct winj_thread *)env;
-  winj_thread_throw(thread, 0, "java/lang/InternalError",
-                    "not yet implemented");
-  /* TODO */
+  winj_free(&thread->vm->params, (jchar *)chars);
+}
+
+/**
+ * Create a string from modified UTF-8.  One pass checks the text and
+ * chooses the narrowest encoding for it, then a second decodes it
+ * straight into the characters of the new string. */
+static jstring
+JNI__NewStringUTF(JNIEnv *env, const char *utf)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  struct winj_vm_params *params = &thread->vm->params;
+  struct winj_object *result = NULL;
+  struct winj_array *value = NULL;
+  unsigned length = utf ? strlen(utf) : 0;
+  unsigned count = 0;
+  enum winj_coder coder = WINJ_CODER_LATIN1;
+
+  if (!utf) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing utf");
+  } else if (EXIT_SUCCESS != winj_utf8_java_count
+             (params, length, (const u1 *)utf, &count, &coder)) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "invalid modified UTF-8");
+  } else if (EXIT_SUCCESS != winj_thread_string_value
+             (thread, count, coder, &value)) {
+  } else if (EXIT_SUCCESS != winj_utf8_java_chars
+             (params, length, (const u1 *)utf, coder,
+              (u1 *)value->elements.jbyte)) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "invalid modified UTF-8");
+  } else if (EXIT_SUCCESS != winj_thread_string_wrap
+             (thread, value, coder, &result))
+    result = NULL;
+  return winj_thread_local_ref(thread, result);
+}
+
+/**
+ * Find how many bytes modified UTF-8 needs for the characters of a
+ * string.
+ *
+ * @param count number of characters
+ * @param coder encoding of characters
+ * @param bytes characters of string
+ * @param buffer optional destination for encoded bytes
+ * @return number of bytes in encoded form */
+static unsigned
+winj_string_utf8
+(unsigned count, enum winj_coder coder, const u1 *bytes, char *buffer)
+{
+  return coder ?
+    winj_utf8_java_bytes(count, (const jchar *)bytes, buffer) :
+    winj_utf8_latin1_bytes(count, bytes, buffer);
+}
+
+static jsize
+JNI__GetStringUTFLength(JNIEnv *env, jstring str)
+{
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = NULL;
+
+  return (EXIT_SUCCESS == winj_jni_string
+          ((struct winj_thread *)env, str, &count, &coder, &bytes)) ?
+    (jsize)winj_string_utf8(count, coder, bytes, NULL) : 0;
+}
+
+static const char *
+JNI__GetStringUTFChars(JNIEnv *env, jstring str, jboolean *isCopy)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  char *result = NULL;
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = NULL;
+  unsigned size = 0;
+
+  if (EXIT_SUCCESS != winj_jni_string
+      (thread, str, &count, &coder, &bytes)) {
+  } else if (!(result = winj_malloc
+               (&thread->vm->params, (size = winj_string_utf8
+                                      (count, coder, bytes, NULL)) + 1))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate %u bytes", size + 1);
+  } else {
+    winj_string_utf8(count, coder, bytes, result);
+    result[size] = '\0';
+    if (isCopy)
+      *isCopy = JNI_TRUE;
+  }
+  return result;
+}
+
+static void
+JNI__ReleaseStringUTFChars(JNIEnv *env, jstring str, const char *chars)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  winj_free(&thread->vm->params, (char *)chars);
 }
 
-static void
-JNI__CallStaticVoidMethodV
-(JNIEnv *env, jclass clazz, jmethodID methodID, va_list args)
+/* Array Operations */
+jsize JNI__GetArrayLength(JNIEnv *env, jarray array) {
+    return 0;
+}
+
+static jobjectArray
+JNI__NewObjectArray
+(JNIEnv *env, jsize len, jclass clazz, jobject init)
 {
   struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
-  struct winj_argument *argarray = NULL;
-  unsigned argarray_count = 0;
-  enum winj_type return_type = WINJ_TYPE_VOID;
+  struct winj_array *array = NULL;
 
-  if (!methodID) {
-    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
-                      "missing methodID");
+  if (len < 0) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "invalid array size: %d", len);
   } else if (!clazz) {
     winj_thread_throw(thread, 0, "java/lang/NullPointerException",
-                      "missing class");
+                      "missing class argument");
   } else if (EXIT_SUCCESS != winj_class_instance
              (thread->vm->class_class, clazz)) {
-    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
-                      "static method requires class");
-  } else if (EXIT_SUCCESS != winj_arguments_parse
-             (params, methodID->name_len, methodID->name,
-              &return_type, &argarray_count, &argarray)) {
-    winj_thread_throw(thread, 0, "java/lang/InternalError",
-                      "method parse failure: \".*s\"",
-                      methodID->name_len, methodID->name);
-  } else if (return_type != WINJ_TYPE_VOID) {
-    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
-                      "attempt to call non-void method");
-  } else if (EXIT_SUCCESS != winj_arguments_varargs
-             (params, args, argarray_count, argarray)) {
-    winj_thread_throw(thread, 0, "java/lang/InternalError",
-                      "failed to convert varargs: \".*s\"",
-                      methodID->name_len, methodID->name);
-  } else if (methodID->call) {
-    winj_info(params, "calling internal method %.*s.%.*s",
-              ((struct winj_class *)clazz)->name_len,
-              ((struct winj_class *)clazz)->name,
-              methodID->name_len, methodID->name);
-    methodID->call(thread, methodID, NULL, clazz,
-                   argarray_count, argarray);
-  } else if (methodID->method_file) {
-    winj_info(params, "interpreting method %.*s.%.*s",
-              ((struct winj_class *)clazz)->name_len,
-              ((struct winj_class *)clazz)->name,
-              methodID->name_len, methodID->name);
-    /* TODO */
-  } else winj_thread_throw(thread, 0, "java/lang/InternalError",
-                           "invalid method %.*s on class %.*s",
-                           methodID->name_len, methodID->name,
-                           ((struct winj_class *)clazz)->name_len,
-                           ((struct winj_class *)clazz)->name);
-  winj_free(params, argarray);
-}
+    winj_thread_throw
+      (thread, 0, "java/lang/IllegalArgumentException",
+       "class argument is not actually a class: %.*s",
+       clazz->cls->name_len, clazz->cls->name);
+  } else if (EXIT_SUCCESS == winj_thread_array_new
+             (thread, WINJ_TYPE_OBJECT, (struct winj_class *)clazz,
+              len, &array)) {
+    winj_ref ref = winj_ref_encode(thread->vm, init);
+    unsigned ii;
 
-static void
-JNI__CallStaticVoidMethod
-(JNIEnv *env, jclass clazz, jmethodID methodID, ...)
-{
-  va_list args;
-  va_start(args, methodID);
-  JNI__CallStaticVoidMethodV(env, clazz, methodID, args);
-  va_end(args);
+    if (!init) {
+    } else if (EXIT_SUCCESS != winj_vm_gc_remember
+               (thread->vm, &array->self, init)) {
+      winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                        "failed to remember array");
+      array = NULL;
+    } else for (ii = 0; ii < len; ++ii)
+        array->elements.jobject[ii] = ref;
+  }
+  return winj_thread_local_ref(thread, array ? &array->self : NULL);
 }
 
 static jobject
-JNI__CallObjectMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...)
+JNI__GetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index)
 {
   struct winj_thread *thread = (struct winj_thread *)env;
-  winj_thread_throw(thread, 0, "java/lang/InternalError",
-                    "not yet implemented");
-  /* TODO */
-  return NULL;
+  struct winj_array *actual = (struct winj_array *)array;
+  struct winj_object *result = NULL;
+
+  if (!array) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing array for GetObjectArrayElement");
+  } else if ((array->cls != thread->vm->class_array) ||
+             (actual->type != WINJ_TYPE_OBJECT)) {
+    winj_thread_throw
+      (thread, 0, "java/lang/IllegalArgumentException",
+       "array argument has type %.*s but must be an object array",
+       array->cls->name_len, array->cls->name);
+  } else if ((index < 0) || (index >= actual->count)) {
+    winj_thread_throw
+      (thread, 0, "java/lang/ArrayIndexOutOfBoundsException",
+       "index is %d count is %u", index, actual->count);
+  } else result = winj_thread_local_ref
+           (thread, winj_ref_decode
+            (thread->vm, actual->elements.jobject[index]));
+  return result;
 }
 
-static jobject
-JNI__CallObjectMethodA
-(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args)
+static void
+JNI__SetObjectArrayElement
+(JNIEnv *env, jobjectArray array, jsize index, jobject value)
 {
   struct winj_thread *thread = (struct winj_thread *)env;
-  winj_thread_throw(thread, 0, "java/lang/InternalError",
-                    "not yet implemented");
-  /* TODO */
-  return NULL;
+  struct winj_array *actual = (struct winj_array *)array;
+
+  if (!array) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing array for SetObjectArrayElement");
+  } else if (array->cls != thread->vm->class_array) {
+    winj_thread_throw
+      (thread, 0, "java/lang/IllegalArgumentException",
+       "array argument has type %.*s but must be an array",
+       array->cls->name_len, array->cls->name);
+  } else if ((index < 0) || (index >= actual->count)) {
+    winj_thread_throw
+      (thread, 0, "java/lang/ArrayIndexOutOfBoundsException",
+       "index is %d count is %u", index, actual->count);
+  } else if (actual->type != WINJ_TYPE_OBJECT) {
+    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                      "primitive array asked to store object");
+  } else if (!value) {
+    actual->elements.jobject[index] = 0;
+  } else if (EXIT_SUCCESS != winj_class_instance
+             (actual->element_class, value)) {
+    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                      "attempt to store wrong class: %.*s "
+                      "(should be %.*s)",
+                      value->cls->name_len, value->cls->name,
+                      actual->element_class->name_len,
+                      actual->element_class->name);
+  } else if (EXIT_SUCCESS != winj_vm_gc_remember
+             (thread->vm, array, value)) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to remember array");
+  } else actual->elements.jobject[index] =
+           winj_ref_encode(thread->vm, value);
 }
 
-static jobject
-JNI__CallObjectMethodV
-(JNIEnv *env, jobject obj, jmethodID methodID, va_list args)
+/**
+ * Create an array of primitive values on behalf of one of the JNI
+ * New*Array functions.
+ *
+ * @param env thread on which to create array
+ * @param type type of elements
+ * @param len number of elements
+ * @return local reference to new array or NULL */
+static jarray
+winj_jni_array_new(JNIEnv *env, enum winj_type type, jsize len)
 {
   struct winj_thread *thread = (struct winj_thread *)env;
-  winj_thread_throw(thread, 0, "java/lang/InternalError",
-                    "not yet implemented");
-  /* TODO */
-  return NULL;
-}
+  struct winj_array *array = NULL;
 
-jboolean JNI__CallBooleanMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return JNI_FALSE;
+  if (EXIT_SUCCESS != winj_thread_array_new
+      (thread, type, NULL, len, &array))
+    array = NULL;
+  return winj_thread_local_ref(thread, array ? &array->self : NULL);
 }
 
-jboolean JNI__CallBooleanMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return JNI_FALSE;
+static jbooleanArray
+JNI__NewBooleanArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_BOOLEAN, len);
 }
 
-jboolean JNI__CallBooleanMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return JNI_FALSE;
+static jbyteArray
+JNI__NewByteArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_BYTE, len);
 }
 
-jbyte JNI__CallByteMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0;
+static jcharArray
+JNI__NewCharArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_CHAR, len);
 }
 
-jbyte JNI__CallByteMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0;
+static jshortArray
+JNI__NewShortArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_SHORT, len);
 }
 
-jbyte JNI__CallByteMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0;
+static jintArray
+JNI__NewIntArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_INT, len);
 }
 
-jchar JNI__CallCharMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0;
+static jlongArray
+JNI__NewLongArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_LONG, len);
 }
 
-jchar JNI__CallCharMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0;
+static jfloatArray
+JNI__NewFloatArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_FLOAT, len);
 }
 
-jchar JNI__CallCharMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0;
+static jdoubleArray
+JNI__NewDoubleArray(JNIEnv *env, jsize len)
+{
+  return winj_jni_array_new(env, WINJ_TYPE_DOUBLE, len);
 }
 
-jshort JNI__CallShortMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0;
+jboolean* JNI__GetBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jshort JNI__CallShortMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0;
+jbyte* JNI__GetByteArrayElements(JNIEnv *env, jbyteArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jshort JNI__CallShortMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0;
+jchar* JNI__GetCharArrayElements(JNIEnv *env, jcharArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jint JNI__CallIntMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0;
+jshort* JNI__GetShortArrayElements(JNIEnv *env, jshortArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jint JNI__CallIntMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0;
+jint* JNI__GetIntArrayElements(JNIEnv *env, jintArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jint JNI__CallIntMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0;
+jlong* JNI__GetLongArrayElements(JNIEnv *env, jlongArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jlong JNI__CallLongMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0;
+jfloat* JNI__GetFloatArrayElements(JNIEnv *env, jfloatArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jlong JNI__CallLongMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0;
+jdouble* JNI__GetDoubleArrayElements(JNIEnv *env, jdoubleArray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jlong JNI__CallLongMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0;
-}
+void JNI__ReleaseBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *elems, jint mode) {}
+void JNI__ReleaseByteArrayElements(JNIEnv *env, jbyteArray array, jbyte *elems, jint mode) {}
+void JNI__ReleaseCharArrayElements(JNIEnv *env, jcharArray array, jchar *elems, jint mode) {}
+void JNI__ReleaseShortArrayElements(JNIEnv *env, jshortArray array, jshort *elems, jint mode) {}
+void JNI__ReleaseIntArrayElements(JNIEnv *env, jintArray array, jint *elems, jint mode) {}
+void JNI__ReleaseLongArrayElements(JNIEnv *env, jlongArray array, jlong *elems, jint mode) {}
+void JNI__ReleaseFloatArrayElements(JNIEnv *env, jfloatArray array, jfloat *elems, jint mode) {}
+void JNI__ReleaseDoubleArrayElements(JNIEnv *env, jdoubleArray array, jdouble *elems, jint mode) {}
 
-jfloat JNI__CallFloatMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0.0f;
-}
+void JNI__GetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize len, jboolean *buf) {}
+void JNI__GetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, jbyte *buf) {}
+void JNI__GetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, jchar *buf) {}
+void JNI__GetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, jshort *buf) {}
+void JNI__GetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, jint *buf) {}
+void JNI__GetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, jlong *buf) {}
+void JNI__GetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, jfloat *buf) {}
+void JNI__GetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, jdouble *buf) {}
 
-jfloat JNI__CallFloatMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0.0f;
-}
+void JNI__SetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize len, const jboolean *buf) {}
+void JNI__SetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, const jbyte *buf) {}
+void JNI__SetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, const jchar *buf) {}
+void JNI__SetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, const jshort *buf) {}
+void JNI__SetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, const jint *buf) {}
+void JNI__SetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, const jlong *buf) {}
+void JNI__SetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, const jfloat *buf) {}
+void JNI__SetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, const jdouble *buf) {}
 
-jfloat JNI__CallFloatMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0.0f;
+jint JNI__RegisterNatives(JNIEnv *env, jclass clazz, const JNINativeMethod *methods, jint nMethods) {
+    return JNI_ERR;
 }
 
-jdouble JNI__CallDoubleMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {
-    return 0.0;
+jint JNI__UnregisterNatives(JNIEnv *env, jclass clazz) {
+    return JNI_ERR;
 }
 
-jdouble JNI__CallDoubleMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {
-    return 0.0;
+jint JNI__MonitorEnter(JNIEnv *env, jobject obj) {
+    return JNI_ERR;
 }
 
-jdouble JNI__CallDoubleMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {
-    return 0.0;
+jint JNI__MonitorExit(JNIEnv *env, jobject obj) {
+    return JNI_ERR;
 }
 
-void JNI__CallVoidMethod(JNIEnv *env, jobject obj, jmethodID methodID, ...) {}
-
-void JNI__CallVoidMethodA(JNIEnv *env, jobject obj, jmethodID methodID, const jvalue *args) {}
-
-void JNI__CallVoidMethodV(JNIEnv *env, jobject obj, jmethodID methodID, va_list args) {}
-
-/* Call Nonvirtual Methods */
-jobject JNI__CallNonvirtualObjectMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
+jthrowable JNI__ExceptionOccurred(JNIEnv *env) {
     return NULL;
 }
 
-jobject JNI__CallNonvirtualObjectMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return NULL;
-}
+void JNI__ExceptionDescribe(JNIEnv *env) {}
 
-jobject JNI__CallNonvirtualObjectMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return NULL;
+static void
+JNI__ExceptionClear(JNIEnv *env)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  thread->flags &= ~winj_thread_exception;
 }
 
-jboolean JNI__CallNonvirtualBooleanMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return JNI_FALSE;
+static jboolean
+JNI__ExceptionCheck(JNIEnv *env)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  return (thread->flags & winj_thread_exception) ? JNI_TRUE : JNI_FALSE;
 }
 
-jboolean JNI__CallNonvirtualBooleanMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return JNI_FALSE;
+void JNI__FatalError(JNIEnv *env, const char *msg) {
+  exit(EXIT_FAILURE);
 }
 
-jboolean JNI__CallNonvirtualBooleanMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return JNI_FALSE;
+static jobject
+JNI__NewLocalRef(JNIEnv *env, jobject ref)
+{
+  return winj_thread_local_ref((struct winj_thread *)env, ref);
 }
 
-jbyte JNI__CallNonvirtualByteMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0;
+static void
+JNI__DeleteLocalRef(JNIEnv *env, jobject ref)
+{
+  winj_reflist_remove(&((struct winj_thread *)env)->locals, ref);
 }
 
-jbyte JNI__CallNonvirtualByteMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0;
+static jint
+JNI__EnsureLocalCapacity(JNIEnv *env, jint capacity)
+{
+  return JNI_OK; /* local references grow as needed */
 }
 
-jbyte JNI__CallNonvirtualByteMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0;
+static jobject
+JNI__NewGlobalRef(JNIEnv *env, jobject obj)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+
+  if (obj && obj->size && (EXIT_SUCCESS != winj_reflist_append
+                           (&thread->vm->params, &thread->vm->globals,
+                            obj))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to allocate global reference");
+    obj = NULL;
+  }
+  return obj;
 }
 
-jchar JNI__CallNonvirtualCharMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0;
+static void
+JNI__DeleteGlobalRef(JNIEnv *env, jobject ref)
+{
+  winj_reflist_remove(&((struct winj_thread *)env)->vm->globals, ref);
 }
 
-jchar JNI__CallNonvirtualCharMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0;
+jobject JNI__NewWeakGlobalRef(JNIEnv *env, jobject obj) {
+    return NULL;
 }
 
-jchar JNI__CallNonvirtualCharMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0;
-}
+void JNI__DeleteWeakGlobalRef(JNIEnv *env, jobject ref) {}
 
-jshort JNI__CallNonvirtualShortMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0;
+static jint
+JNI__PushLocalFrame(JNIEnv *env, jint capacity)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
+  return (EXIT_SUCCESS == winj_reflist_append
+          (&thread->vm->params, &thread->locals, NULL)) ?
+    JNI_OK : JNI_ENOMEM;
 }
 
-jshort JNI__CallNonvirtualShortMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0;
-}
+static jobject
+JNI__PopLocalFrame(JNIEnv *env, jobject result)
+{
+  struct winj_thread *thread = (struct winj_thread *)env;
 
-jshort JNI__CallNonvirtualShortMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0;
+  while (thread->locals.count && thread->locals.refs
+         [--thread->locals.count])
+    ; /* discard references made since frame was pushed */
+  return winj_thread_local_ref(thread, result);
 }
 
-jint JNI__CallNonvirtualIntMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0;
+jobjectRefType JNI__GetObjectRefType(JNIEnv *env, jobject obj) {
+    return JNIInvalidRefType;
 }
 
-jint JNI__CallNonvirtualIntMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0;
+void* JNI__GetPrimitiveArrayCritical(JNIEnv *env, jarray array, jboolean *isCopy) {
+    return NULL;
 }
 
-jint JNI__CallNonvirtualIntMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0;
-}
+void JNI__ReleasePrimitiveArrayCritical(JNIEnv *env, jarray array, void *carray, jint mode) {}
 
-jlong JNI__CallNonvirtualLongMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0;
+const jchar* JNI__GetStringCritical(JNIEnv *env, jstring str, jboolean *isCopy) {
+    return NULL;
 }
 
-jlong JNI__CallNonvirtualLongMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0;
-}
+void JNI__ReleaseStringCritical(JNIEnv *env, jstring str, const jchar *carray) {}
 
-jlong JNI__CallNonvirtualLongMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0;
+jobject JNI__NewDirectByteBuffer(JNIEnv *env, void *address, jlong capacity) {
+    return NULL;
 }
 
-jfloat JNI__CallNonvirtualFloatMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0.0f;
+void* JNI__GetDirectBufferAddress(JNIEnv *env, jobject buf) {
+    return NULL;
 }
 
-jfloat JNI__CallNonvirtualFloatMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0.0f;
+jlong JNI__GetDirectBufferCapacity(JNIEnv *env, jobject buf) {
+    return -1;
 }
 
-jfloat JNI__CallNonvirtualFloatMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0.0f;
+jobject JNI__GetObjectRef(JNIEnv *env, jobject obj, jfieldID fieldID) {
+    return NULL;
 }
 
-jdouble JNI__CallNonvirtualDoubleMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {
-    return 0.0;
+jobject JNI__GetModule(JNIEnv *env, jclass clazz) {
+    return NULL;
 }
 
-jdouble JNI__CallNonvirtualDoubleMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {
-    return 0.0;
+static struct winj_thread *
+winj_vm_thread_create(struct winj_vm *vm, void *thread_group)
+{
+  struct winj_thread *result = NULL;
+  struct winj_thread *created = NULL;
+  struct winj_thread **next = NULL;
+  unsigned stack_size = (vm && vm->params.stack_size) ?
+    vm->params.stack_size : WINJ_STACK_SIZE;
+
+  if (!vm) {
+    winj_error(NULL, "missing vm");
+  } else if (!(created = winj_calloc
+               (&vm->params, 1, sizeof(*created)))) {
+    winj_error(&vm->params, "failed to allocate %u bytes for thread",
+                sizeof(*created));
+  } else if (!(next = winj_realloc
+               (&vm->params, vm->threads, (vm->thread_count + 1) *
+                sizeof(*vm->threads)))) {
+    winj_error(&vm->params, "failed to allocate %u bytes for thread "
+                "pointer array", (vm->thread_count + 1) *
+                sizeof(*vm->threads));
+  } else if (vm->threads = next, /* old array may be gone */
+             !(created->stack = winj_malloc
+               (&vm->params, stack_size))) {
+    winj_error(&vm->params, "failed to allocate %u bytes for thread "
+               "stack", stack_size);
+  } else {
+    created->vm = vm;
+    created->jni_env = &vm->table_env;
+    created->stack_limit = created->stack +
+      stack_size / sizeof(*created->stack);
+
+    result = vm->threads[vm->thread_count++] = created;
+    created = NULL; /* stolen */
+  }
+  if (created)
+    winj_free(&vm->params, created->stack);
+  winj_free(vm ? &vm->params : NULL, created);
+  return result;
 }
 
-jdouble JNI__CallNonvirtualDoubleMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {
-    return 0.0;
+static void
+winj_thread_cleanup
+(struct winj_vm_params *params, struct winj_thread *thread)
+{
+  if (thread) {
+    winj_free(params, thread->locals.refs);
+    winj_free(params, thread->stack);
+  }
+  winj_free(params, thread);
 }
 
-void JNI__CallNonvirtualVoidMethod(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, ...) {}
+/**
+ * Reclaim all memory allocated by a virtual machine instance.
+ *
+ * @param vm virtual machine to clean up */
+void
+winj_vm_cleanup(struct winj_vm *vm)
+{
+  struct winj_vm_params *params = vm ? &vm->params : NULL;
 
-void JNI__CallNonvirtualVoidMethodA(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, const jvalue *args) {}
+  if (vm) {
+    unsigned ii;
 
-void JNI__CallNonvirtualVoidMethodV(JNIEnv *env, jobject obj, jclass clazz, jmethodID methodID, va_list args) {}
+    for (ii = 0; ii < vm->thread_count; ++ii)
+      winj_thread_cleanup(params, vm->threads[ii]);
+    winj_free(params, vm->threads);
 
-/* String Operations */
-jstring JNI__NewString(JNIEnv *env, const jchar *unicode, jsize len) {
-    return NULL;
-}
+    while (vm->regions) {
+      struct winj_region *region = vm->regions;
+      vm->regions = region->next;
+      winj_vm_space_release(vm, region, WINJ_HEAP_ALIGN
+                            (sizeof(*region)) + region->size);
+    }
+    while (vm->nursery) {
+      struct winj_region *region = vm->nursery;
+      vm->nursery = region->next;
+      winj_vm_space_release(vm, region, WINJ_HEAP_ALIGN
+                            (sizeof(*region)) + region->size);
+    }
+    winj_free(params, vm->gc.marks);
+    winj_free(params, vm->gc.spans);
+    winj_free(params, vm->globals.refs);
+    winj_free(params, vm->remembered.refs);
 
-jsize JNI__GetStringLength(JNIEnv *env, jstring str) {
-    return 0;
-}
+    for (ii = 0; ii < vm->class_capacity; ++ii)
+      winj_class_cleanup(vm, vm->classes[ii]);
+    winj_free(params, vm->classes);
 
-const jchar* JNI__GetStringChars(JNIEnv *env, jstring str, jboolean *isCopy) {
-    return NULL;
+    /* Classes may borrow bytes from archives so those go last. */
+    for (ii = 0; ii < vm->archive_count; ++ii)
+      winj_archive_cleanup(params, vm->archives[ii]);
+    winj_free(params, vm->archives);
+    winj_classpath_cleanup(params, &vm->classpath);
+    winj_bytes_cleanup(params, &vm->snapshot.bytes);
+    winj_free(params, vm->snapshot.path);
+#ifdef WINJ_PAIR_PROFILE
+    winj_free(params, vm->pairs);
+#endif
+
+#ifdef WINJ_COMPRESSED_REFS
+    if (vm->space.base && munmap(vm->space.base, WINJ_SPACE_SIZE))
+      winj_warn(params, "munmap failed: %s", strerror(errno));
+#endif
+    winj_free(params, vm);
+  }
 }
 
-void JNI__ReleaseStringChars(JNIEnv *env, jstring str, const jchar *chars) {}
+jint JNICALL
+JNI_GetDefaultJavaVMInitArgs(void *vm_args)
+{
+  int result = JNI_OK;
+  JavaVMInitArgs *args = (JavaVMInitArgs *)vm_args;
 
-static jstring
-JNI__NewStringUTF(JNIEnv *env, const char *utf)
+  if (args->version > JNI_VERSION_24) {
+    result = JNI_EVERSION;
+  } else {
+    memset(args, 0, sizeof(*args));
+    args->version  = JNI_VERSION_24;
+    args->nOptions = 0;
+    args->options  = NULL;
+    args->ignoreUnrecognized = JNI_TRUE;
+  }
+  return result;
+}
+
+#ifdef WINJ_PAIR_PROFILE
+/**
+ * Append the opcode pair counts of a virtual machine to the file
+ * named by the WINJ_PAIRS environment variable, if any.  Each line
+ * holds a count followed by the first and second opcodes in hex.
+ *
+ * @param vm virtual machine with counts to record
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_pairs_save(struct winj_vm *vm)
 {
-  struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
-  struct winj_object *string = NULL;
-  struct winj_object *result = NULL;
+  int result = EXIT_SUCCESS;
+  struct winj_vm_params *params = &vm->params;
+  const char *path = NULL;
+  FILE *ff = NULL;
+  unsigned ii;
 
-  if (!utf) {
-    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
-                      "missing utf");
-  } else if (!(string = winj_calloc(params, 1, sizeof(*string)))) {
-    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
-                      "failed to allocate %u bytes for string class",
-                      sizeof(*string));
-  } else if (EXIT_SUCCESS != winj_vm_class_lookup
-             (thread->vm, 0, "java/lang/String", &string->cls)) {
-    winj_thread_throw(thread, 0, "java/lang/InternalError",
-                      "failed to find string class");
+  if (params->getenv)
+    path = params->getenv(params->context, "WINJ_PAIRS");
+  else path = getenv("WINJ_PAIRS");
+
+  if (!vm->pairs || !path || !*path) {
+  } else if (!(ff = fopen(path, "a"))) {
+    result = winj_error(params, "failed to open %s: %s",
+                        path, strerror(errno));
   } else {
-    /* TODO: copy characters somewhere */
-    result = winj_objlist_append(&thread->vm->objects, string);
-    string = NULL;
+    for (ii = 0; ii < 256 * 256; ++ii)
+      if (vm->pairs[ii])
+        fprintf(ff, "%llu 0x%02x 0x%02x\n",
+                (unsigned long long)vm->pairs[ii], ii / 256, ii % 256);
+    if (fclose(ff))
+      result = winj_error(params, "failed to write %s: %s",
+                          path, strerror(errno));
   }
-  winj_vm_object_cleanup(thread->vm, string);
   return result;
 }
+#endif
 
-jsize JNI__GetStringUTFLength(JNIEnv *env, jstring str) {
-    return 0;
+static jint JNICALL
+JNI__DestroyJavaVM(JavaVM *jvm)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  jint result = JNI_OK;
+
+  if (EXIT_SUCCESS != winj_vm_snapshot_save(vm))
+    result = JNI_ERR;
+#ifdef WINJ_PAIR_PROFILE
+  if (EXIT_SUCCESS != winj_vm_pairs_save(vm))
+    result = JNI_ERR;
+#endif
+  winj_vm_cleanup(vm);
+  return result;
 }
 
-const char* JNI__GetStringUTFChars(JNIEnv *env, jstring str, jboolean *isCopy) {
-    return NULL;
+static jint JNICALL
+JNI__AttachCurrentThread(JavaVM *jvm, void **p_jnienv, void *thr_args)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  (void)vm;
+  return JNI_ERR; /* not yet implemented */
+}
+
+static jint JNICALL
+JNI__DetachCurrentThread(JavaVM *jvm)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  (void)vm;
+  return JNI_ERR; /* not yet implemented */
 }
 
-void JNI__ReleaseStringUTFChars(JNIEnv *env, jstring str, const char *chars) {}
+static jint JNICALL
+JNI__GetEnv(JavaVM *jvm, void **p_jnienv, jint version)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  (void)vm;
+  return JNI_ERR; /* not yet implemented */
+}
 
-/* Array Operations */
-jsize JNI__GetArrayLength(JNIEnv *env, jarray array) {
-    return 0;
+static jint JNICALL
+JNI__AttachCurrentThreadAsDaemon
+(JavaVM *jvm, void **p_jnienv, void *thr_args)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  (void)vm;
+  return JNI_ERR; /* not yet implemented */
 }
 
-static jobjectArray
-JNI__NewObjectArray
-(JNIEnv *env, jsize len, jclass clazz, jobject init)
+static void
+winj_vm_params_init(struct winj_vm_params *params, void *vm_args)
 {
-  struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_vm_params *params = thread ? &thread->vm->params : NULL;
-  struct winj_object *result = NULL;
-  struct winj_array *array = NULL;
-  union winj_elements *elements = NULL;
+  /* TODO: support required parameters from JNI specification */
+  /* TODO: realloc */
+  /* TODO: logv */
+  /* TODO: getenv */
+  /* TODO: find_class */
+}
 
-  if (len < 0) {
-    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
-                      "invalid array size: %d", len);
-  } else if (!clazz) {
-    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
-                      "missing class argument");
-  } else if (EXIT_SUCCESS != winj_class_instance
-             (thread->vm->class_class, clazz)) {
-    winj_thread_throw
-      (thread, 0, "java/lang/IllegalArgumentException",
-       "class argument is not actually a class: %.*s",
-       clazz->cls->name_len, clazz->cls->name);
-  } else if (!(array = winj_calloc(params, 1, sizeof(*array)))) {
+/**
+ * Constructor for java/lang/Object, which has nothing to initialize.
+ * Every constructor eventually calls this through invokespecial. */
+static int
+winj_object_init
+(struct winj_thread *thread, struct winj_method *method,
+ jvalue *result, jobject self, unsigned arg_count,
+ struct winj_argument *args)
+{
+  return EXIT_SUCCESS;
+}
+
+static struct winj_method builtin_object_methods[] = {
+  { .name = "<init>()V", .access_flags = WINJ_ACCESS_PUBLIC,
+    .call = winj_object_init },
+};
+
+/**
+ * Implementation of System.gc(), which always runs a collection. */
+static int
+winj_system_gc
+(struct winj_thread *thread, struct winj_method *method,
+ jvalue *result, jobject self, unsigned arg_count,
+ struct winj_argument *args)
+{
+  int rc = winj_vm_collect(thread->vm);
+
+  if (EXIT_SUCCESS != rc)
     winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
-                      "failed to allocate %u bytes for array",
-                      sizeof(*array));
-  } else if (!(elements = winj_calloc
-               (params, len, sizeof(*elements)))) {
-  } else {
-    unsigned ii;
+                      "garbage collection failed");
+  return rc;
+}
+
+static struct winj_field builtin_string_fields[] = {
+  { 0, "value[B", 0, WINJ_ACCESS_PRIVATE | WINJ_ACCESS_FINAL,
+    WINJ_TYPE_OBJECT },
+  { 0, "coderB", 0, WINJ_ACCESS_PRIVATE | WINJ_ACCESS_FINAL,
+    WINJ_TYPE_BYTE },
+  { 0, "hashI", 0, WINJ_ACCESS_PRIVATE, WINJ_TYPE_INT },
+};
+
+static struct winj_field builtin_builder_fields[] = {
+  { 0, "value[C", 0, WINJ_ACCESS_PRIVATE, WINJ_TYPE_OBJECT },
+  { 0, "countI", 0, WINJ_ACCESS_PRIVATE, WINJ_TYPE_INT },
+};
+
+static struct winj_method builtin_system_methods[] = {
+  { .name = "gc()V", .access_flags = WINJ_ACCESS_PUBLIC | WINJ_ACCESS_STATIC,
+    .call = winj_system_gc },
+};
 
-    array->self.cls = thread->vm->class_array;
-    array->count = len;
-    array->type = WINJ_TYPE_OBJECT;
-    array->element_class = (struct winj_class *)clazz;
-    array->elements = elements;
-    for (ii = 0; ii < len; ++ii)
-      elements[ii].jobject = init;
-    elements = NULL;
+/* === Bulk array operations
+ * Each operation has a plain version along with SSE2 and AVX2
+ * versions for x86-64.  Vector loops use unaligned loads and stores
+ * and leave any partial vector at the end to the plain version. */
 
-    result = winj_objlist_append(&thread->vm->objects, &array->self);
-    array = NULL;
+static void
+winj_fill_scalar(u1 *dst, size_t size, unsigned width, const void *value)
+{
+  size_t ii;
+  u2 two;
+  u4 four;
+  u8 eight;
+
+  switch (width) {
+  case 1: memset(dst, *(const u1 *)value, size); break;
+  case 2: memcpy(&two, value, 2);
+    for (ii = 0; ii < size / 2; ++ii)
+      ((u2 *)dst)[ii] = two;
+    break;
+  case 4: memcpy(&four, value, 4);
+    for (ii = 0; ii < size / 4; ++ii)
+      ((u4 *)dst)[ii] = four;
+    break;
+  case 8: memcpy(&eight, value, 8);
+    for (ii = 0; ii < size / 8; ++ii)
+      ((u8 *)dst)[ii] = eight;
+    break;
+  default: break;
   }
-  winj_free(params, elements);
-  winj_free(params, array);
-  return result;
 }
 
-jobject JNI__GetObjectArrayElement(JNIEnv *env, jobjectArray array, jsize index) {
-    return NULL;
+static size_t
+winj_mismatch_scalar(const u1 *aa, const u1 *bb, size_t size)
+{
+  size_t ii = 0;
+  u8 left, right;
+
+  for (; ii + 8 <= size; ii += 8) {
+    memcpy(&left, aa + ii, 8);
+    memcpy(&right, bb + ii, 8);
+    if (left != right)
+      break;
+  }
+  while ((ii < size) && (aa[ii] == bb[ii]))
+    ++ii;
+  return ii;
+}
+
+/* Four elements per step keeps the multiplications independent:
+ * h' = h * 31^4 + a * 31^3 + b * 31^2 + c * 31 + d */
+#define WINJ_HASH_SCALAR(type)                                         \
+  do {                                                                 \
+    const type *src = elements;                                        \
+    for (ii = 0; ii + 4 <= count; ii += 4)                             \
+      hash = hash * 923521u + (u4)src[ii] * 29791u +                   \
+        (u4)src[ii + 1] * 961u + (u4)src[ii + 2] * 31u +               \
+        (u4)src[ii + 3];                                               \
+    for (; ii < count; ++ii)                                           \
+      hash = hash * 31u + (u4)src[ii];                                 \
+  } while (0)
+
+/**
+ * Continue the polynomial hash which Java uses for strings and
+ * arrays over integral elements no wider than an int.
+ *
+ * @param hash result of hashing preceding elements
+ * @param type byte, char, short or int, or boolean for unsigned bytes
+ * @param count number of elements
+ * @param elements elements to hash
+ * @return hash including elements */
+static u4
+winj_hash_scalar
+(u4 hash, enum winj_type type, size_t count, const void *elements)
+{
+  size_t ii;
+
+  switch (type) {
+  case WINJ_TYPE_BOOLEAN: WINJ_HASH_SCALAR(jboolean); break;
+  case WINJ_TYPE_BYTE:  WINJ_HASH_SCALAR(jbyte);  break;
+  case WINJ_TYPE_CHAR:  WINJ_HASH_SCALAR(jchar);  break;
+  case WINJ_TYPE_SHORT: WINJ_HASH_SCALAR(jshort); break;
+  case WINJ_TYPE_INT:   WINJ_HASH_SCALAR(jint);   break;
+  default: break;
+  }
+  return hash;
 }
 
+#ifdef WINJ_SIMD
+/* Vector fills store copies of a pattern made by the plain version,
+ * which also supplies any partial vector at the end. */
 static void
-JNI__SetObjectArrayElement
-(JNIEnv *env, jobjectArray array, jsize index, jobject value)
+winj_fill_sse2(u1 *dst, size_t size, unsigned width, const void *value)
 {
-  struct winj_thread *thread = (struct winj_thread *)env;
-  struct winj_array *actual = (struct winj_array *)array;
+  u1 pattern[16];
+  __m128i vector;
+  size_t ii;
 
-  if (!array) {
-    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
-                      "missing array for SetObjectArrayElement");
-  } else if (array->cls != thread->vm->class_array) {
-    winj_thread_throw
-      (thread, 0, "java/lang/IllegalArgumentException",
-       "array argument has type %.*s but must be an array",
-       array->cls->name_len, array->cls->name);
-  } else if ((index < 0) || (index > actual->count)) {
-    winj_thread_throw
-      (thread, 0, "java/lang/ArrayIndexOutOfBoundsException",
-       "index is %d count is %u", index, actual->count);
-  } else if (actual->type != WINJ_TYPE_OBJECT) {
-    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
-                      "primitive array asked to store object");
-  } else if (!value) {
-    actual->elements[index].jobject = NULL;
-  } else if (EXIT_SUCCESS != winj_class_instance
-             (actual->element_class, value)) {
-    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
-                      "attempt to store wrong class: %.*s "
-                      "(should be %.*s)",
-                      value->cls->name_len, value->cls->name,
-                      actual->element_class->name_len,
-                      actual->element_class->name);
-  } else actual->elements[index].jobject = value;
+  winj_fill_scalar(pattern, sizeof(pattern), width, value);
+  vector = _mm_loadu_si128((const __m128i *)pattern);
+  for (ii = 0; ii + 16 <= size; ii += 16)
+    _mm_storeu_si128((__m128i *)(dst + ii), vector);
+  memcpy(dst + ii, pattern, size - ii);
 }
 
-jbooleanArray JNI__NewBooleanArray(JNIEnv *env, jsize len) {
-    return NULL;
-}
+static size_t
+winj_mismatch_sse2(const u1 *aa, const u1 *bb, size_t size)
+{
+  size_t ii;
+  unsigned mask = 0xFFFF;
 
-jbyteArray JNI__NewByteArray(JNIEnv *env, jsize len) {
-    return NULL;
+  for (ii = 0; (mask == 0xFFFF) && (ii + 16 <= size); ii += 16)
+    mask = (unsigned)_mm_movemask_epi8
+      (_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(aa + ii)),
+                      _mm_loadu_si128((const __m128i *)(bb + ii))));
+  return (mask != 0xFFFF) ? (ii - 16 + __builtin_ctz(~mask)) :
+    (ii + winj_mismatch_scalar(aa + ii, bb + ii, size - ii));
 }
 
-jcharArray JNI__NewCharArray(JNIEnv *env, jsize len) {
-    return NULL;
-}
+__attribute__((target("avx2"))) static void
+winj_fill_avx2(u1 *dst, size_t size, unsigned width, const void *value)
+{
+  u1 pattern[32];
+  __m256i vector;
+  size_t ii;
 
-jshortArray JNI__NewShortArray(JNIEnv *env, jsize len) {
-    return NULL;
+  winj_fill_scalar(pattern, sizeof(pattern), width, value);
+  vector = _mm256_loadu_si256((const __m256i *)pattern);
+  for (ii = 0; ii + 32 <= size; ii += 32)
+    _mm256_storeu_si256((__m256i *)(dst + ii), vector);
+  memcpy(dst + ii, pattern, size - ii);
 }
 
-jintArray JNI__NewIntArray(JNIEnv *env, jsize len) {
-    return NULL;
-}
+__attribute__((target("avx2"))) static size_t
+winj_mismatch_avx2(const u1 *aa, const u1 *bb, size_t size)
+{
+  size_t ii;
+  unsigned mask = 0xFFFFFFFFu;
 
-jlongArray JNI__NewLongArray(JNIEnv *env, jsize len) {
-    return NULL;
+  for (ii = 0; (mask == 0xFFFFFFFFu) && (ii + 32 <= size); ii += 32)
+    mask = (unsigned)_mm256_movemask_epi8
+      (_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(aa + ii)),
+                         _mm256_loadu_si256((const __m256i *)(bb + ii))));
+  return (mask != 0xFFFFFFFFu) ? (ii - 32 + __builtin_ctz(~mask)) :
+    (ii + winj_mismatch_sse2(aa + ii, bb + ii, size - ii));
 }
 
-jfloatArray JNI__NewFloatArray(JNIEnv *env, jsize len) {
-    return NULL;
+/**
+ * Hash eight elements at a time.  Each lane accumulates every eighth
+ * element, multiplying by 31^8 per step, and the lanes are weighted
+ * by descending powers of 31 once at the end. */
+__attribute__((target("avx2"))) static u4
+winj_hash_avx2
+(u4 hash, enum winj_type type, size_t count, const void *elements)
+{
+  __m256i acc = _mm256_setzero_si256();
+  __m256i step;
+  u4 weights[8];
+  u4 lanes[8];
+  u4 power = 1;
+  u4 scale = 1;
+  size_t ii;
+
+  for (ii = 8; ii-- > 0; power *= 31)
+    weights[ii] = power;
+  step = _mm256_set1_epi32((int)power);
+
+  for (ii = 0; ii + 8 <= count; ii += 8) {
+    __m256i value;
+
+    switch (type) {
+    case WINJ_TYPE_BOOLEAN:
+      value = _mm256_cvtepu8_epi32(_mm_loadl_epi64
+                                   ((const __m128i *)
+                                    ((const jboolean *)elements + ii)));
+      break;
+    case WINJ_TYPE_BYTE:
+      value = _mm256_cvtepi8_epi32(_mm_loadl_epi64
+                                   ((const __m128i *)
+                                    ((const jbyte *)elements + ii)));
+      break;
+    case WINJ_TYPE_CHAR:
+      value = _mm256_cvtepu16_epi32(_mm_loadu_si128
+                                    ((const __m128i *)
+                                     ((const jchar *)elements + ii)));
+      break;
+    case WINJ_TYPE_SHORT:
+      value = _mm256_cvtepi16_epi32(_mm_loadu_si128
+                                    ((const __m128i *)
+                                     ((const jshort *)elements + ii)));
+      break;
+    default:
+      value = _mm256_loadu_si256((const __m256i *)
+                                 ((const jint *)elements + ii));
+      break;
+    }
+    acc = _mm256_add_epi32(_mm256_mullo_epi32(acc, step), value);
+    scale *= power;
+  }
+  _mm256_storeu_si256((__m256i *)lanes, _mm256_mullo_epi32
+                      (acc, _mm256_loadu_si256
+                       ((const __m256i *)weights)));
+  hash *= scale;
+  for (ii = 0; ii < 8; ++ii)
+    hash += lanes[ii];
+  ii = count & ~(size_t)7;
+  return winj_hash_scalar(hash, type, count - ii, (const u1 *)elements +
+                          ii * winj_type_size(type));
+}
+#endif /* WINJ_SIMD */
+
+/**
+ * Choose the bulk array operations for a vm.  Environment variable
+ * WINJ_SIMD can be "off" or "sse2" to hold back from what the
+ * processor supports.
+ *
+ * @param kernels destination for chosen operations
+ * @param mode value of WINJ_SIMD or NULL */
+static void
+winj_kernels_select(struct winj_kernels *kernels, const char *mode)
+{
+  kernels->fill     = winj_fill_scalar;
+  kernels->mismatch = winj_mismatch_scalar;
+  kernels->hash     = winj_hash_scalar;
+#ifdef WINJ_SIMD
+  __builtin_cpu_init();
+  if (mode && !strcmp(mode, "off")) {
+  } else if ((mode && !strcmp(mode, "sse2")) ||
+             !__builtin_cpu_supports("avx2")) {
+    kernels->fill     = winj_fill_sse2;
+    kernels->mismatch = winj_mismatch_sse2;
+  } else {
+    kernels->fill     = winj_fill_avx2;
+    kernels->mismatch = winj_mismatch_avx2;
+    kernels->hash     = winj_hash_avx2;
+  }
+#endif
 }
 
-jdoubleArray JNI__NewDoubleArray(JNIEnv *env, jsize len) {
-    return NULL;
+/**
+ * Find the first element at which two arrays of the same primitive
+ * type differ.  Floating point elements are compared by their bits
+ * as in Java, except that every NaN matches every other NaN.
+ *
+ * @param vm virtual machine with bulk array operations
+ * @param aa an array
+ * @param bb an array of the same type
+ * @param count number of elements to compare
+ * @return index of first mismatch or -1 if there is none */
+static jint
+winj_array_mismatch
+(const struct winj_vm *vm, const struct winj_array *aa,
+ const struct winj_array *bb, unsigned count)
+{
+  jint result = -1;
+  unsigned width = winj_type_size(aa->type);
+  unsigned start = 0;
+
+  while ((result < 0) && (start < count)) {
+    unsigned found = start + (unsigned)(vm->kernels.mismatch
+      ((const u1 *)aa->elements.jbyte + (size_t)start * width,
+       (const u1 *)bb->elements.jbyte + (size_t)start * width,
+       (size_t)(count - start) * width) / width);
+
+    if (found >= count)
+      start = count;
+    else if (((aa->type == WINJ_TYPE_FLOAT) &&
+              isnan(aa->elements.jfloat[found]) &&
+              isnan(bb->elements.jfloat[found])) ||
+             ((aa->type == WINJ_TYPE_DOUBLE) &&
+              isnan(aa->elements.jdouble[found]) &&
+              isnan(bb->elements.jdouble[found])))
+      start = found + 1;
+    else result = (jint)found;
+  }
+  return result;
 }
 
-jboolean* JNI__GetBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *isCopy) {
-    return NULL;
+/* === Intrinsics
+ * Methods which dominate typical profiles are implemented in C and
+ * installed through the call member of a method.  Synthetic classes
+ * declare them outright.  A class loaded from a class file keeps its
+ * byte code for everything else but has these methods replaced, and a
+ * class with no class file anywhere is made from its intrinsics. */
+
+#define WINJ_INTRINSIC(name)                                           \
+  static int name                                                      \
+  (struct winj_thread *thread, struct winj_method *method,             \
+   jvalue *result, jobject self, unsigned arg_count,                   \
+   struct winj_argument *args)
+
+/**
+ * Encode a code point as UTF-16.
+ *
+ * @param code code point to encode
+ * @param units destination with room for two code units
+ * @return number of code units or zero for an invalid code point */
+static unsigned
+winj_code_point_chars(jint code, jchar *units)
+{
+  unsigned result = 0;
+
+  if ((code < 0) || (code > 0x10FFFF)) {
+  } else if (code < 0x10000) {
+    units[0] = (jchar)code;
+    result = 1;
+  } else {
+    units[0] = 0xD800 | (0x3FF & ((code - 0x10000) >> 10));
+    units[1] = 0xDC00 | (0x3FF & (code - 0x10000));
+    result = 2;
+  }
+  return result;
 }
 
-jbyte* JNI__GetByteArrayElements(JNIEnv *env, jbyteArray array, jboolean *isCopy) {
-    return NULL;
+/**
+ * Find the first place at or after a starting index where one
+ * sequence of characters appears within another.  Characters with
+ * the same encoding are compared as bytes.  Latin-1 text cannot hold
+ * anything that needs UTF-16, since strings are compact whenever they
+ * can be.
+ *
+ * @param count number of characters to search
+ * @param coder encoding of characters to search
+ * @param bytes characters to search
+ * @param from index at which to start
+ * @param target_count number of characters sought
+ * @param target_coder encoding of characters sought
+ * @param target characters sought
+ * @return index of first match or -1 if there is none */
+static jint
+winj_string_index
+(unsigned count, enum winj_coder coder, const u1 *bytes, jint from,
+ unsigned target_count, enum winj_coder target_coder, const u1 *target)
+{
+  jint result = -1;
+  unsigned ii, jj;
+
+  if (from < 0)
+    from = 0;
+  if ((unsigned)from > count)
+    from = (jint)count;
+  if (!target_count) {
+    result = from;
+  } else if (coder == target_coder) {
+    for (ii = (unsigned)from; (result < 0) &&
+           (target_count <= count - ii); ++ii)
+      if (!memcmp(bytes + ((size_t)ii << coder), target,
+                  (size_t)target_count << coder))
+        result = (jint)ii;
+  } else if (coder == WINJ_CODER_UTF16) {
+    for (ii = (unsigned)from; (result < 0) &&
+           (target_count <= count - ii); ++ii) {
+      for (jj = 0; (jj < target_count) &&
+             (winj_string_unit(bytes, coder, ii + jj) == target[jj]); ++jj)
+        ;
+      if (jj == target_count)
+        result = (jint)ii;
+    }
+  }
+  return result;
 }
 
-jchar* JNI__GetCharArrayElements(JNIEnv *env, jcharArray array, jboolean *isCopy) {
-    return NULL;
+WINJ_INTRINSIC(winj_string_init)
+{
+  return EXIT_SUCCESS; /* an empty string needs no characters */
 }
 
-jshort* JNI__GetShortArrayElements(JNIEnv *env, jshortArray array, jboolean *isCopy) {
-    return NULL;
+WINJ_INTRINSIC(winj_string_length)
+{
+  unsigned count = 0;
+  enum winj_coder coder;
+
+  winj_string_bytes(thread->vm, self, &count, &coder);
+  result->i = (jint)count;
+  return EXIT_SUCCESS;
 }
 
-jint* JNI__GetIntArrayElements(JNIEnv *env, jintArray array, jboolean *isCopy) {
-    return NULL;
+WINJ_INTRINSIC(winj_string_char_at)
+{
+  int rc = EXIT_SUCCESS;
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = winj_string_bytes(thread->vm, self, &count, &coder);
+  jint index = args[0].value.i;
+
+  if ((u4)index >= count) {
+    winj_thread_throw(thread, 0, "java/lang/StringIndexOutOfBoundsException",
+                      "index %d, length %u", index, count);
+    rc = EXIT_FAILURE;
+  } else result->c = winj_string_unit(bytes, coder, (unsigned)index);
+  return rc;
 }
 
-jlong* JNI__GetLongArrayElements(JNIEnv *env, jlongArray array, jboolean *isCopy) {
-    return NULL;
+WINJ_INTRINSIC(winj_string_equals)
+{
+  struct winj_object *other = args[0].value.l;
+  unsigned count = 0;
+  unsigned other_count = 0;
+  enum winj_coder coder, other_coder;
+  const u1 *bytes = winj_string_bytes(thread->vm, self, &count, &coder);
+  const u1 *other_bytes = NULL;
+  size_t size = (size_t)count << coder;
+
+  result->z = JNI_FALSE;
+  if (other == self) {
+    result->z = JNI_TRUE;
+  } else if (other && (other->cls == thread->vm->class_string)) {
+    other_bytes = winj_string_bytes
+      (thread->vm, other, &other_count, &other_coder);
+    result->z = (count == other_count) && (!count ||
+      ((coder == other_coder) &&
+       (thread->vm->kernels.mismatch(bytes, other_bytes, size) == size)));
+  }
+  return EXIT_SUCCESS;
 }
 
-jfloat* JNI__GetFloatArrayElements(JNIEnv *env, jfloatArray array, jboolean *isCopy) {
-    return NULL;
+/**
+ * Implementation of String.hashCode(), which caches the result in the
+ * string as the Java class library does.  A string which hashes to
+ * zero is simply hashed again each time.  Latin-1 characters are
+ * unsigned, which the hash kernel takes booleans to mean. */
+WINJ_INTRINSIC(winj_string_hash_code)
+{
+  struct winj_vm *vm = thread->vm;
+  u4 hash = (u4)WINJ_OFFSET(self, vm->offsets.string_hash, jint);
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = NULL;
+
+  if (!hash) {
+    bytes = winj_string_bytes(vm, self, &count, &coder);
+    hash = !count ? 0 : vm->kernels.hash
+      (0, coder ? WINJ_TYPE_CHAR : WINJ_TYPE_BOOLEAN, count, bytes);
+    WINJ_OFFSET(self, vm->offsets.string_hash, jint) = (jint)hash;
+  }
+  result->i = (jint)hash;
+  return EXIT_SUCCESS;
 }
 
-jdouble* JNI__GetDoubleArrayElements(JNIEnv *env, jdoubleArray array, jboolean *isCopy) {
-    return NULL;
+WINJ_INTRINSIC(winj_string_index_of)
+{
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = winj_string_bytes(thread->vm, self, &count, &coder);
+  jint from = (arg_count > 1) ? args[1].value.i : 0;
+  jchar units[2] = { 0, 0 };
+  unsigned found = winj_code_point_chars(args[0].value.i, units);
+  u1 latin1 = (u1)units[0];
+
+  result->i = !found ? -1 : ((found == 1) && (units[0] <= 0xFF)) ?
+    winj_string_index(count, coder, bytes, from,
+                      1, WINJ_CODER_LATIN1, &latin1) :
+    winj_string_index(count, coder, bytes, from,
+                      found, WINJ_CODER_UTF16, (const u1 *)units);
+  return EXIT_SUCCESS;
 }
 
-void JNI__ReleaseBooleanArrayElements(JNIEnv *env, jbooleanArray array, jboolean *elems, jint mode) {}
-void JNI__ReleaseByteArrayElements(JNIEnv *env, jbyteArray array, jbyte *elems, jint mode) {}
-void JNI__ReleaseCharArrayElements(JNIEnv *env, jcharArray array, jchar *elems, jint mode) {}
-void JNI__ReleaseShortArrayElements(JNIEnv *env, jshortArray array, jshort *elems, jint mode) {}
-void JNI__ReleaseIntArrayElements(JNIEnv *env, jintArray array, jint *elems, jint mode) {}
-void JNI__ReleaseLongArrayElements(JNIEnv *env, jlongArray array, jlong *elems, jint mode) {}
-void JNI__ReleaseFloatArrayElements(JNIEnv *env, jfloatArray array, jfloat *elems, jint mode) {}
-void JNI__ReleaseDoubleArrayElements(JNIEnv *env, jdoubleArray array, jdouble *elems, jint mode) {}
+WINJ_INTRINSIC(winj_string_index_of_string)
+{
+  int rc = EXIT_SUCCESS;
+  struct winj_object *target = args[0].value.l;
+  unsigned count = 0;
+  unsigned target_count = 0;
+  enum winj_coder coder, target_coder;
+  const u1 *bytes = winj_string_bytes(thread->vm, self, &count, &coder);
+  const u1 *target_bytes = NULL;
 
-void JNI__GetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize len, jboolean *buf) {}
-void JNI__GetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, jbyte *buf) {}
-void JNI__GetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, jchar *buf) {}
-void JNI__GetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, jshort *buf) {}
-void JNI__GetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, jint *buf) {}
-void JNI__GetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, jlong *buf) {}
-void JNI__GetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, jfloat *buf) {}
-void JNI__GetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, jdouble *buf) {}
+  if (!target) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing string");
+    rc = EXIT_FAILURE;
+  } else {
+    target_bytes = winj_string_bytes
+      (thread->vm, target, &target_count, &target_coder);
+    result->i = winj_string_index
+      (count, coder, bytes, (arg_count > 1) ? args[1].value.i : 0,
+       target_count, target_coder, target_bytes);
+  }
+  return rc;
+}
 
-void JNI__SetBooleanArrayRegion(JNIEnv *env, jbooleanArray array, jsize start, jsize len, const jboolean *buf) {}
-void JNI__SetByteArrayRegion(JNIEnv *env, jbyteArray array, jsize start, jsize len, const jbyte *buf) {}
-void JNI__SetCharArrayRegion(JNIEnv *env, jcharArray array, jsize start, jsize len, const jchar *buf) {}
-void JNI__SetShortArrayRegion(JNIEnv *env, jshortArray array, jsize start, jsize len, const jshort *buf) {}
-void JNI__SetIntArrayRegion(JNIEnv *env, jintArray array, jsize start, jsize len, const jint *buf) {}
-void JNI__SetLongArrayRegion(JNIEnv *env, jlongArray array, jsize start, jsize len, const jlong *buf) {}
-void JNI__SetFloatArrayRegion(JNIEnv *env, jfloatArray array, jsize start, jsize len, const jfloat *buf) {}
-void JNI__SetDoubleArrayRegion(JNIEnv *env, jdoubleArray array, jsize start, jsize len, const jdouble *buf) {}
+/**
+ * Implementation of Integer.parseInt() for both the decimal and the
+ * explicit radix forms.  Only ASCII digits are accepted. */
+WINJ_INTRINSIC(winj_integer_parse_int)
+{
+  int rc = EXIT_SUCCESS;
+  struct winj_object *string = args[0].value.l;
+  jint radix = (arg_count > 1) ? args[1].value.i : 10;
+  unsigned count = 0;
+  enum winj_coder coder = WINJ_CODER_LATIN1;
+  const u1 *bytes = string ?
+    winj_string_bytes(thread->vm, string, &count, &coder) : NULL;
+  jchar first = count ? winj_string_unit(bytes, coder, 0) : 0;
+  int negative = (first == '-');
+  unsigned ii = ((first == '-') || (first == '+'));
+  int64_t value = 0;
+  jchar shown[64];
+  char text[sizeof(shown) / sizeof(*shown) * 3];
+
+  if (!string) {
+    winj_thread_throw(thread, 0, "java/lang/NumberFormatException",
+                      "null");
+    rc = EXIT_FAILURE;
+  } else if ((radix < 2) || (radix > 36)) {
+    winj_thread_throw(thread, 0, "java/lang/NumberFormatException",
+                      "radix %d out of range", radix);
+    rc = EXIT_FAILURE;
+  } else if (ii >= count) {
+    rc = EXIT_FAILURE;
+  } else for (; (EXIT_SUCCESS == rc) && (ii < count); ++ii) {
+      jchar unit = winj_string_unit(bytes, coder, ii);
+      unsigned digit =
+        ((unit >= '0') && (unit <= '9')) ? (unsigned)(unit - '0') :
+        ((unit >= 'a') && (unit <= 'z')) ? (unsigned)(unit - 'a' + 10) :
+        ((unit >= 'A') && (unit <= 'Z')) ? (unsigned)(unit - 'A' + 10) :
+        36;
+
+      if ((digit >= (unsigned)radix) ||
+          ((value = value * radix + digit) >
+           (int64_t)INT32_MAX + negative))
+        rc = EXIT_FAILURE;
+    }
 
-jint JNI__RegisterNatives(JNIEnv *env, jclass clazz, const JNINativeMethod *methods, jint nMethods) {
-    return JNI_ERR;
+  if (!string || (radix < 2) || (radix > 36)) {
+  } else if (EXIT_SUCCESS != rc) {
+    for (ii = 0; (ii < count) && (ii < sizeof(shown) / sizeof(*shown));
+         ++ii)
+      shown[ii] = winj_string_unit(bytes, coder, ii);
+    winj_thread_throw(thread, 0, "java/lang/NumberFormatException",
+                      "For input string: \"%.*s\"",
+                      winj_utf8_java_bytes(ii, shown, text), text);
+  } else result->i = (jint)(negative ? -value : value);
+  return rc;
 }
 
-jint JNI__UnregisterNatives(JNIEnv *env, jclass clazz) {
-    return JNI_ERR;
+WINJ_INTRINSIC(winj_math_abs_int)
+{
+  jint value = args[0].value.i;
+  result->i = (jint)((value < 0) ? -(u4)value : (u4)value);
+  return EXIT_SUCCESS;
 }
 
-jint JNI__MonitorEnter(JNIEnv *env, jobject obj) {
-    return JNI_ERR;
+WINJ_INTRINSIC(winj_math_abs_long)
+{
+  jlong value = args[0].value.j;
+  result->j = (jlong)((value < 0) ? -(u8)value : (u8)value);
+  return EXIT_SUCCESS;
 }
 
-jint JNI__MonitorExit(JNIEnv *env, jobject obj) {
-    return JNI_ERR;
+WINJ_INTRINSIC(winj_math_abs_float)
+{
+  result->f = fabsf(args[0].value.f);
+  return EXIT_SUCCESS;
 }
 
-jthrowable JNI__ExceptionOccurred(JNIEnv *env) {
-    return NULL;
+WINJ_INTRINSIC(winj_math_abs_double)
+{
+  result->d = fabs(args[0].value.d);
+  return EXIT_SUCCESS;
 }
 
-void JNI__ExceptionDescribe(JNIEnv *env) {}
+WINJ_INTRINSIC(winj_math_max_int)
+{
+  result->i = (args[0].value.i >= args[1].value.i) ?
+    args[0].value.i : args[1].value.i;
+  return EXIT_SUCCESS;
+}
 
-void JNI__ExceptionClear(JNIEnv *env) {}
+WINJ_INTRINSIC(winj_math_min_int)
+{
+  result->i = (args[0].value.i <= args[1].value.i) ?
+    args[0].value.i : args[1].value.i;
+  return EXIT_SUCCESS;
+}
 
-jboolean JNI__ExceptionCheck(JNIEnv *env) { return JNI_FALSE; }
+WINJ_INTRINSIC(winj_math_max_long)
+{
+  result->j = (args[0].value.j >= args[1].value.j) ?
+    args[0].value.j : args[1].value.j;
+  return EXIT_SUCCESS;
+}
 
-void JNI__FatalError(JNIEnv *env, const char *msg) {
-  exit(EXIT_FAILURE);
+WINJ_INTRINSIC(winj_math_min_long)
+{
+  result->j = (args[0].value.j <= args[1].value.j) ?
+    args[0].value.j : args[1].value.j;
+  return EXIT_SUCCESS;
 }
 
-jobject JNI__NewLocalRef(JNIEnv *env, jobject ref) {
-  return NULL;
+/* Java requires NaN from either argument to win and negative zero to
+ * be less than positive zero, neither of which the obvious comparison
+ * does.  Floats are exact as doubles so these serve for both. */
+static jdouble
+winj_math_maximum(jdouble aa, jdouble bb)
+{
+  return isnan(aa) ? aa : isnan(bb) ? bb :
+    ((aa == 0.0) && (bb == 0.0)) ? (signbit(aa) ? bb : aa) :
+    (aa >= bb) ? aa : bb;
 }
 
-void JNI__DeleteLocalRef(JNIEnv *env, jobject ref) {}
+static jdouble
+winj_math_minimum(jdouble aa, jdouble bb)
+{
+  return isnan(aa) ? aa : isnan(bb) ? bb :
+    ((aa == 0.0) && (bb == 0.0)) ? (signbit(aa) ? aa : bb) :
+    (aa <= bb) ? aa : bb;
+}
 
-jint JNI__EnsureLocalCapacity(JNIEnv *env, jint capacity) {
-  return JNI_ERR;
+WINJ_INTRINSIC(winj_math_max_float)
+{
+  result->f = (jfloat)winj_math_maximum
+    (args[0].value.f, args[1].value.f);
+  return EXIT_SUCCESS;
 }
 
-jobject JNI__NewGlobalRef(JNIEnv *env, jobject obj) {
-    return NULL;
+WINJ_INTRINSIC(winj_math_min_float)
+{
+  result->f = (jfloat)winj_math_minimum
+    (args[0].value.f, args[1].value.f);
+  return EXIT_SUCCESS;
 }
 
-void JNI__DeleteGlobalRef(JNIEnv *env, jobject ref) {}
+WINJ_INTRINSIC(winj_math_max_double)
+{
+  result->d = winj_math_maximum(args[0].value.d, args[1].value.d);
+  return EXIT_SUCCESS;
+}
 
-jobject JNI__NewWeakGlobalRef(JNIEnv *env, jobject obj) {
-    return NULL;
+WINJ_INTRINSIC(winj_math_min_double)
+{
+  result->d = winj_math_minimum(args[0].value.d, args[1].value.d);
+  return EXIT_SUCCESS;
 }
 
-void JNI__DeleteWeakGlobalRef(JNIEnv *env, jobject ref) {}
+/* Generates intrinsics for Math methods which the C library already
+ * provides with matching semantics. */
+#define WINJ_MATH_UNARY(name)                                          \
+  WINJ_INTRINSIC(winj_math_##name)                                     \
+  {                                                                    \
+    result->d = name(args[0].value.d);                                 \
+    return EXIT_SUCCESS;                                               \
+  }
+#define WINJ_MATH_BINARY(name)                                         \
+  WINJ_INTRINSIC(winj_math_##name)                                     \
+  {                                                                    \
+    result->d = name(args[0].value.d, args[1].value.d);                \
+    return EXIT_SUCCESS;                                               \
+  }
 
-jint JNI__PushLocalFrame(JNIEnv *env, jint capacity) {
-    return JNI_ERR;
+WINJ_MATH_UNARY(sqrt)
+WINJ_MATH_UNARY(cbrt)
+WINJ_MATH_UNARY(exp)
+WINJ_MATH_UNARY(log)
+WINJ_MATH_UNARY(log10)
+WINJ_MATH_UNARY(sin)
+WINJ_MATH_UNARY(cos)
+WINJ_MATH_UNARY(tan)
+WINJ_MATH_UNARY(asin)
+WINJ_MATH_UNARY(acos)
+WINJ_MATH_UNARY(atan)
+WINJ_MATH_UNARY(floor)
+WINJ_MATH_UNARY(ceil)
+WINJ_MATH_UNARY(rint)
+WINJ_MATH_BINARY(pow)
+WINJ_MATH_BINARY(atan2)
+WINJ_MATH_BINARY(hypot)
+
+/* Math.round() rounds halves up, saturates and maps NaN to zero. */
+WINJ_INTRINSIC(winj_math_round_double)
+{
+  jdouble value = args[0].value.d;
+  jdouble rounded = floor(value);
+
+  if (value - rounded >= 0.5)
+    rounded += 1.0;
+  result->j = isnan(value) ? 0 :
+    (rounded >= 9223372036854775807.0) ? INT64_MAX :
+    (rounded <= -9223372036854775808.0) ? INT64_MIN : (jlong)rounded;
+  return EXIT_SUCCESS;
 }
 
-jobject JNI__PopLocalFrame(JNIEnv *env, jobject result) {
-    return NULL;
+WINJ_INTRINSIC(winj_math_round_float)
+{
+  jdouble value = args[0].value.f;
+  jdouble rounded = floor(value);
+
+  if (value - rounded >= 0.5)
+    rounded += 1.0;
+  result->i = isnan(value) ? 0 : (rounded >= 2147483647.0) ? INT32_MAX :
+    (rounded <= -2147483648.0) ? INT32_MIN : (jint)rounded;
+  return EXIT_SUCCESS;
 }
 
-jobjectRefType JNI__GetObjectRefType(JNIEnv *env, jobject obj) {
-    return JNIInvalidRefType;
+/**
+ * Implementation of System.arraycopy().  Primitive elements move
+ * with a single memmove, which also handles copies within one array.
+ * References go through the write barrier once per copy and, unless
+ * the element classes are compatible, need a store check for each
+ * element.  As in Java, the elements before one that fails the check
+ * are still copied. */
+WINJ_INTRINSIC(winj_system_arraycopy)
+{
+  int rc = EXIT_FAILURE;
+  struct winj_vm *vm = thread->vm;
+  struct winj_array *src = (struct winj_array *)args[0].value.l;
+  struct winj_array *dst = (struct winj_array *)args[2].value.l;
+  jint src_pos = args[1].value.i;
+  jint dst_pos = args[3].value.i;
+  jint length = args[4].value.i;
+  unsigned width = 0;
+  jint ii;
+
+  if (!src || !dst) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing %s array", src ? "destination" : "source");
+  } else if ((src->self.cls != vm->class_array) ||
+             (dst->self.cls != vm->class_array)) {
+    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                      "arraycopy: %s type %.*s is not an array",
+                      (src->self.cls != vm->class_array) ?
+                      "source" : "destination",
+                      (src->self.cls != vm->class_array) ?
+                      src->self.cls->name_len : dst->self.cls->name_len,
+                      (src->self.cls != vm->class_array) ?
+                      src->self.cls->name : dst->self.cls->name);
+  } else if (src->type != dst->type) {
+    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                      "arraycopy: type mismatch");
+  } else if ((src_pos < 0) || (dst_pos < 0) || (length < 0) ||
+             ((u4)length > src->count - (u4)src_pos) ||
+             ((u4)src_pos > src->count) ||
+             ((u4)length > dst->count - (u4)dst_pos) ||
+             ((u4)dst_pos > dst->count)) {
+    winj_thread_throw(thread, 0,
+                      "java/lang/ArrayIndexOutOfBoundsException",
+                      "arraycopy: last source index %lld out of bounds "
+                      "for length %u", (long long)src_pos + length,
+                      src->count);
+  } else if (src->type != WINJ_TYPE_OBJECT) {
+    width = winj_type_size(src->type);
+    memmove(dst->elements.jbyte + (size_t)dst_pos * width,
+            src->elements.jbyte + (size_t)src_pos * width,
+            (size_t)length * width);
+    rc = EXIT_SUCCESS;
+  } else if ((src->element_class == dst->element_class) ||
+             (EXIT_SUCCESS == winj_class_assignable
+              (src->element_class, dst->element_class))) {
+    if (EXIT_SUCCESS != (rc = winj_vm_gc_remember_refs
+                         (vm, &dst->self, length,
+                          &src->elements.jobject[src_pos])))
+      winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                        "failed to remember array");
+    else memmove(&dst->elements.jobject[dst_pos],
+                 &src->elements.jobject[src_pos],
+                 (size_t)length * sizeof(*src->elements.jobject));
+  } else {
+    struct winj_object *value = NULL;
+
+    for (ii = 0; (ii < length) &&
+           (!(value = winj_ref_decode
+              (vm, src->elements.jobject[src_pos + ii])) ||
+            (EXIT_SUCCESS == winj_class_instance
+             (dst->element_class, value))); ++ii)
+      dst->elements.jobject[dst_pos + ii] =
+        src->elements.jobject[src_pos + ii];
+
+    if (EXIT_SUCCESS != winj_vm_gc_remember_refs
+        (vm, &dst->self, ii, &dst->elements.jobject[dst_pos]))
+      winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                        "failed to remember array");
+    else if (ii < length)
+      winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                        "arraycopy: element type %.*s",
+                        value->cls->name_len, value->cls->name);
+    else rc = EXIT_SUCCESS;
+  }
+  return rc;
 }
 
-void* JNI__GetPrimitiveArrayCritical(JNIEnv *env, jarray array, jboolean *isCopy) {
-    return NULL;
+/**
+ * Implementation of every Arrays.fill() which sets a whole array.
+ * The type of the second argument says which kind of array to
+ * expect. */
+WINJ_INTRINSIC(winj_arrays_fill)
+{
+  int rc = EXIT_FAILURE;
+  struct winj_vm *vm = thread->vm;
+  struct winj_array *array = (struct winj_array *)args[0].value.l;
+  jvalue value = args[1].value;
+
+  if (!array) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing array");
+  } else if ((array->self.cls != vm->class_array) ||
+             (array->type != method->signature.types[1])) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "wrong type of array");
+  } else if ((array->type == WINJ_TYPE_OBJECT) && value.l &&
+             (EXIT_SUCCESS != winj_class_instance
+              (array->element_class, value.l))) {
+    winj_thread_throw(thread, 0, "java/lang/ArrayStoreException",
+                      "%.*s", value.l->cls->name_len,
+                      value.l->cls->name);
+  } else if ((array->type == WINJ_TYPE_OBJECT) &&
+             (EXIT_SUCCESS != winj_vm_gc_remember
+              (vm, &array->self, value.l))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to remember array");
+  } else {
+    winj_ref ref = winj_ref_encode(vm, value.l);
+    const void *pattern =
+      (array->type == WINJ_TYPE_BOOLEAN) ? (const void *)&value.z :
+      (array->type == WINJ_TYPE_BYTE)    ? (const void *)&value.b :
+      (array->type == WINJ_TYPE_CHAR)    ? (const void *)&value.c :
+      (array->type == WINJ_TYPE_SHORT)   ? (const void *)&value.s :
+      (array->type == WINJ_TYPE_INT)     ? (const void *)&value.i :
+      (array->type == WINJ_TYPE_LONG)    ? (const void *)&value.j :
+      (array->type == WINJ_TYPE_FLOAT)   ? (const void *)&value.f :
+      (array->type == WINJ_TYPE_DOUBLE)  ? (const void *)&value.d :
+      (const void *)&ref;
+    unsigned width = winj_type_size(array->type);
+
+    vm->kernels.fill((u1 *)array->elements.jbyte,
+                     (size_t)array->count * width, width, pattern);
+    rc = EXIT_SUCCESS;
+  }
+  return rc;
 }
 
-void JNI__ReleasePrimitiveArrayCritical(JNIEnv *env, jarray array, void *carray, jint mode) {}
+/**
+ * Throw an exception unless arrays passed to an intrinsic hold the
+ * same primitive type.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param aa an array
+ * @param bb another array or NULL to check only the first
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_thread_primitive_arrays
+(struct winj_thread *thread, struct winj_array *aa, struct winj_array *bb)
+{
+  int result = EXIT_SUCCESS;
+  struct winj_class *class_array = thread->vm->class_array;
 
-const jchar* JNI__GetStringCritical(JNIEnv *env, jstring str, jboolean *isCopy) {
-    return NULL;
+  if ((aa->self.cls != class_array) || (aa->type == WINJ_TYPE_OBJECT) ||
+      (bb && ((bb->self.cls != class_array) || (bb->type != aa->type)))) {
+    winj_thread_throw(thread, 0, "java/lang/IllegalArgumentException",
+                      "wrong type of array");
+    result = EXIT_FAILURE;
+  }
+  return result;
 }
 
-void JNI__ReleaseStringCritical(JNIEnv *env, jstring str, const jchar *carray) {}
-
-jobject JNI__NewDirectByteBuffer(JNIEnv *env, void *address, jlong capacity) {
-    return NULL;
+WINJ_INTRINSIC(winj_arrays_equals)
+{
+  int rc = EXIT_SUCCESS;
+  struct winj_array *aa = (struct winj_array *)args[0].value.l;
+  struct winj_array *bb = (struct winj_array *)args[1].value.l;
+
+  if (aa == bb) {
+    result->z = JNI_TRUE;
+  } else if (!aa || !bb) {
+    result->z = JNI_FALSE;
+  } else if (EXIT_SUCCESS == (rc = winj_thread_primitive_arrays
+                              (thread, aa, bb)))
+    result->z = (aa->count == bb->count) &&
+      (winj_array_mismatch(thread->vm, aa, bb, aa->count) < 0);
+  return rc;
 }
 
-void* JNI__GetDirectBufferAddress(JNIEnv *env, jobject buf) {
-    return NULL;
-}
+/**
+ * Implementation of Arrays.mismatch(), which gives the index of the
+ * first difference, the length of the shorter array if it is a
+ * prefix of the other or -1 if the arrays are equal. */
+WINJ_INTRINSIC(winj_arrays_mismatch)
+{
+  int rc = EXIT_FAILURE;
+  struct winj_array *aa = (struct winj_array *)args[0].value.l;
+  struct winj_array *bb = (struct winj_array *)args[1].value.l;
+  unsigned count = 0;
+  jint index = -1;
 
-jlong JNI__GetDirectBufferCapacity(JNIEnv *env, jobject buf) {
-    return -1;
+  if (!aa || !bb) {
+    winj_thread_throw(thread, 0, "java/lang/NullPointerException",
+                      "missing array");
+  } else if (EXIT_SUCCESS == (rc = winj_thread_primitive_arrays
+                              (thread, aa, bb))) {
+    count = (aa->count < bb->count) ? aa->count : bb->count;
+    if (aa != bb)
+      index = winj_array_mismatch(thread->vm, aa, bb, count);
+    result->i = (index >= 0) ? index :
+      (aa->count != bb->count) ? (jint)count : -1;
+  }
+  return rc;
 }
 
-jobject JNI__GetObjectRef(JNIEnv *env, jobject obj, jfieldID fieldID) {
-    return NULL;
-}
+/**
+ * Implementation of Arrays.hashCode() for primitive arrays.  Wider
+ * elements are folded to an int the way their wrapper classes do,
+ * with every NaN treated alike. */
+WINJ_INTRINSIC(winj_arrays_hash_code)
+{
+  int rc = EXIT_SUCCESS;
+  struct winj_array *array = (struct winj_array *)args[0].value.l;
+  u4 hash = 1;
+  u8 bits;
+  u4 half;
+  unsigned ii;
 
-jobject JNI__GetModule(JNIEnv *env, jclass clazz) {
-    return NULL;
+  if (!array) {
+    hash = 0;
+  } else if (EXIT_SUCCESS != (rc = winj_thread_primitive_arrays
+                              (thread, array, NULL))) {
+  } else switch (array->type) {
+    case WINJ_TYPE_BOOLEAN:
+      for (ii = 0; ii < array->count; ++ii)
+        hash = 31 * hash + (array->elements.jboolean[ii] ? 1231 : 1237);
+      break;
+    case WINJ_TYPE_LONG:
+      for (ii = 0; ii < array->count; ++ii) {
+        bits = (u8)array->elements.jlong[ii];
+        hash = 31 * hash + (u4)(bits ^ (bits >> 32));
+      }
+      break;
+    case WINJ_TYPE_FLOAT:
+      for (ii = 0; ii < array->count; ++ii) {
+        memcpy(&half, &array->elements.jfloat[ii], sizeof(half));
+        hash = 31 * hash + (isnan(array->elements.jfloat[ii]) ?
+                            0x7FC00000u : half);
+      }
+      break;
+    case WINJ_TYPE_DOUBLE:
+      for (ii = 0; ii < array->count; ++ii) {
+        memcpy(&bits, &array->elements.jdouble[ii], sizeof(bits));
+        if (isnan(array->elements.jdouble[ii]))
+          bits = 0x7FF8000000000000ull;
+        hash = 31 * hash + (u4)(bits ^ (bits >> 32));
+      }
+      break;
+    default:
+      if (array->count)
+        hash = thread->vm->kernels.hash
+          (hash, array->type, array->count, array->elements.jbyte);
+      break;
+    }
+
+  if (EXIT_SUCCESS == rc)
+    result->i = (jint)hash;
+  return rc;
 }
 
-static struct winj_thread *
-winj_vm_thread_create(struct winj_vm *vm, void *thread_group)
+/**
+ * Make room at the end of a StringBuilder for more characters.  When
+ * the char array is full it is replaced by one twice as large.  The
+ * new array is allocated first, which may move the old one, so that
+ * is found again before its characters are copied.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param builder a java/lang/StringBuilder
+ * @param extra number of characters to make room for
+ * @param end_out destination for place to put new characters
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_builder_reserve
+(struct winj_thread *thread, struct winj_object *builder,
+ unsigned extra, jchar **end_out)
 {
-  struct winj_thread *result = NULL;
-  struct winj_thread *created = NULL;
-  struct winj_thread **next = NULL;
-
-  if (!vm) {
-    winj_error(NULL, "missing vm");
-  } else if (!(created = winj_calloc
-               (&vm->params, 1, sizeof(*created)))) {
-    winj_error(&vm->params, "failed to allocate %u bytes for thread",
-                sizeof(*created));
-  } else if (!(next = winj_realloc
-               (&vm->params, vm->threads, (vm->thread_count + 1) *
-                sizeof(*vm->threads)))) {
-    winj_error(&vm->params, "failed to allocate %u bytes for thread "
-                "pointer array", (vm->thread_count + 1) *
-                sizeof(*vm->threads));
+  int result = EXIT_SUCCESS;
+  struct winj_vm *vm = thread->vm;
+  struct winj_array *value = (struct winj_array *)winj_ref_decode
+    (vm, WINJ_OFFSET(builder, vm->offsets.builder_value, winj_ref));
+  unsigned count = (unsigned)WINJ_OFFSET
+    (builder, vm->offsets.builder_count, jint);
+  struct winj_array *grown = NULL;
+  unsigned capacity = value ? value->count : 0;
+  unsigned wanted = (capacity > INT32_MAX / 2 - 1) ? INT32_MAX :
+    (capacity * 2 + 2);
+
+  if (extra > (unsigned)INT32_MAX - count) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "StringBuilder too long");
+    result = EXIT_FAILURE;
+  } else if (count + extra <= capacity) {
+  } else if (EXIT_SUCCESS != (result = winj_thread_array_new
+                              (thread, WINJ_TYPE_CHAR, NULL, (jint)
+                               ((wanted < count + extra) ?
+                                (count + extra) : wanted), &grown))) {
+  } else if (EXIT_SUCCESS != (result = winj_vm_gc_remember
+                              (vm, builder, &grown->self))) {
+    winj_thread_throw(thread, 0, "java/lang/OutOfMemoryError",
+                      "failed to remember builder");
   } else {
-    vm->threads = next;
-
-    created->vm = vm;
-    created->jni_env = &vm->table_env;
-
-    result = vm->threads[vm->thread_count++] = created;
-    created = NULL; /* stolen */
+    value = (struct winj_array *)winj_ref_decode
+      (vm, WINJ_OFFSET(builder, vm->offsets.builder_value, winj_ref));
+    if (count)
+      memcpy(grown->elements.jchar, value->elements.jchar,
+             count * sizeof(jchar));
+    WINJ_OFFSET(builder, vm->offsets.builder_value, winj_ref) =
+      winj_ref_encode(vm, &grown->self);
+    value = grown;
   }
-  winj_free(vm ? &vm->params : NULL, created);
+
+  if (EXIT_SUCCESS == result)
+    *end_out = value ? (value->elements.jchar + count) : NULL;
   return result;
 }
 
-static void
-winj_thread_cleanup
-(struct winj_vm_params *params, struct winj_thread *thread)
+/**
+ * Add characters to the end of a StringBuilder.  The characters must
+ * not be in the heap unless whatever holds them is pinned.
+ *
+ * @param thread thread on which to throw exceptions
+ * @param builder a java/lang/StringBuilder
+ * @param count number of characters to add
+ * @param chars characters to add
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_builder_append
+(struct winj_thread *thread, struct winj_object *builder,
+ unsigned count, const jchar *chars)
 {
-  if (thread) {
-    winj_free(params, thread->frames);
-    winj_free(params, thread->operands);
-    winj_free(params, thread->locals);
+  int result = EXIT_SUCCESS;
+  jchar *end = NULL;
+
+  if (EXIT_SUCCESS == (result = winj_builder_reserve
+                       (thread, builder, count, &end))) {
+    if (count)
+      memcpy(end, chars, count * sizeof(*chars));
+    WINJ_OFFSET(builder, thread->vm->offsets.builder_count, jint) +=
+      (jint)count;
   }
-  winj_free(params, thread);
+  return result;
 }
 
 /**
- * Reclaim all memory allocated by a virtual machine instance.
+ * Add the decimal representation of a number to a StringBuilder.
  *
- * @param vm virtual machine to clean up */
-void
-winj_vm_cleanup(struct winj_vm *vm)
+ * @param thread thread on which to throw exceptions
+ * @param builder a java/lang/StringBuilder
+ * @param value number to represent
+ * @return EXIT_SUCCESS unless an exception was thrown */
+static int
+winj_builder_append_long
+(struct winj_thread *thread, struct winj_object *builder, jlong value)
 {
-  struct winj_vm_params *params = vm ? &vm->params : NULL;
-
-  if (vm) {
-    unsigned ii;
+  jchar digits[20];
+  unsigned count = 0;
+  u8 magnitude = (value < 0) ? -(u8)value : (u8)value;
 
-    while (vm->objects.head) {
-      struct winj_object *obj = winj_objlist_remove
-        (&vm->objects, vm->objects.head);
-      winj_vm_object_cleanup(vm, obj);
-    }
+  do {
+    digits[sizeof(digits) / sizeof(*digits) - ++count] =
+      (jchar)('0' + magnitude % 10);
+  } while (magnitude /= 10);
+  if (value < 0)
+    digits[sizeof(digits) / sizeof(*digits) - ++count] = '-';
+  return winj_builder_append
+    (thread, builder, count,
+     digits + sizeof(digits) / sizeof(*digits) - count);
+}
 
-    for (ii = 0; ii < vm->thread_count; ++ii)
-      winj_thread_cleanup(params, vm->threads[ii]);
-    winj_free(params, vm->threads);
+WINJ_INTRINSIC(winj_builder_init)
+{
+  return EXIT_SUCCESS; /* the char array is made by the first append */
+}
 
-    for (ii = 0; ii < vm->class_count; ++ii)
-      winj_class_cleanup(params, vm->classes[ii]);
-    winj_free(params, vm->classes);
+WINJ_INTRINSIC(winj_builder_append_string)
+{
+  int rc = EXIT_SUCCESS;
+  static const jchar null_chars[] = { 'n', 'u', 'l', 'l' };
+  struct winj_object *string = args[0].value.l;
+  struct winj_array *value = string ?
+    winj_string_value(thread->vm, string) : NULL;
+  unsigned count = 0;
+  enum winj_coder coder;
+  const u1 *bytes = NULL;
+  jchar *end = NULL;
 
-    winj_free(params, vm);
+  /* Growing the builder may move characters that are not pinned. */
+  if (!string) {
+    rc = winj_builder_append(thread, self, 4, null_chars);
+  } else if (!value) {
+  } else if (!winj_thread_local_ref(thread, &value->self)) {
+    rc = EXIT_FAILURE;
+  } else if (bytes = winj_string_bytes
+             (thread->vm, string, &count, &coder), coder) {
+    rc = winj_builder_append(thread, self, count, (const jchar *)bytes);
+  } else if (EXIT_SUCCESS == (rc = winj_builder_reserve
+                              (thread, self, count, &end))) {
+    winj_bytes_widen(count, bytes, end);
+    WINJ_OFFSET(self, thread->vm->offsets.builder_count, jint) +=
+      (jint)count;
   }
+  result->l = self;
+  return rc;
 }
 
-jint JNICALL
-JNI_GetDefaultJavaVMInitArgs(void *vm_args)
+WINJ_INTRINSIC(winj_builder_append_char)
 {
-  int result = JNI_OK;
-  JavaVMInitArgs *args = (JavaVMInitArgs *)vm_args;
+  result->l = self;
+  return winj_builder_append(thread, self, 1, &args[0].value.c);
+}
 
-  if (args->version > JNI_VERSION_24) {
-    result = JNI_EVERSION;
-  } else {
-    memset(args, 0, sizeof(*args));
-    args->version  = JNI_VERSION_24;
-    args->nOptions = 0;
-    args->options  = NULL;
-    args->ignoreUnrecognized = JNI_TRUE;
-  }
-  return result;
+WINJ_INTRINSIC(winj_builder_append_boolean)
+{
+  static const jchar true_chars[] = { 't', 'r', 'u', 'e' };
+  static const jchar false_chars[] = { 'f', 'a', 'l', 's', 'e' };
+
+  result->l = self;
+  return args[0].value.z ?
+    winj_builder_append(thread, self, 4, true_chars) :
+    winj_builder_append(thread, self, 5, false_chars);
 }
 
-static jint JNICALL
-JNI__DestroyJavaVM(JavaVM *jvm)
+WINJ_INTRINSIC(winj_builder_append_int)
 {
-  struct winj_vm *vm = (struct winj_vm *)jvm;
-  winj_vm_cleanup(vm);
-  return JNI_OK;
+  result->l = self;
+  return winj_builder_append_long(thread, self, args[0].value.i);
 }
 
-static jint JNICALL
-JNI__AttachCurrentThread(JavaVM *jvm, void **p_jnienv, void *thr_args)
+WINJ_INTRINSIC(winj_builder_append_long_value)
 {
-  struct winj_vm *vm = (struct winj_vm *)jvm;
-  (void)vm;
-  return JNI_ERR; /* not yet implemented */
+  result->l = self;
+  return winj_builder_append_long(thread, self, args[0].value.j);
 }
 
-static jint JNICALL
-JNI__DetachCurrentThread(JavaVM *jvm)
+WINJ_INTRINSIC(winj_builder_length)
 {
-  struct winj_vm *vm = (struct winj_vm *)jvm;
-  (void)vm;
-  return JNI_ERR; /* not yet implemented */
+  result->i = WINJ_OFFSET(self, thread->vm->offsets.builder_count, jint);
+  return EXIT_SUCCESS;
 }
 
-static jint JNICALL
-JNI__GetEnv(JavaVM *jvm, void **p_jnienv, jint version)
+/**
+ * Implementation of StringBuilder.toString(), which copies the
+ * characters so that the builder can carry on changing.  The string
+ * is compact if every character fits in Latin-1.  Its array is
+ * allocated before copying since that can move the builder's array. */
+WINJ_INTRINSIC(winj_builder_to_string)
 {
-  struct winj_vm *vm = (struct winj_vm *)jvm;
-  (void)vm;
-  return JNI_ERR; /* not yet implemented */
+  int rc = EXIT_SUCCESS;
+  struct winj_vm *vm = thread->vm;
+  unsigned count = (unsigned)WINJ_OFFSET
+    (self, vm->offsets.builder_count, jint);
+  struct winj_array *value = (struct winj_array *)winj_ref_decode
+    (vm, WINJ_OFFSET(self, vm->offsets.builder_value, winj_ref));
+  enum winj_coder coder = count ? winj_chars_coder
+    (count, value->elements.jchar) : WINJ_CODER_LATIN1;
+  struct winj_array *copy = NULL;
+  struct winj_object *string = NULL;
+
+  if (EXIT_SUCCESS != (rc = winj_thread_string_value
+                       (thread, count, coder, &copy))) {
+  } else {
+    value = (struct winj_array *)winj_ref_decode
+      (vm, WINJ_OFFSET(self, vm->offsets.builder_value, winj_ref));
+    if (count)
+      winj_chars_store(count, value->elements.jchar, coder,
+                       (u1 *)copy->elements.jbyte);
+    if (EXIT_SUCCESS == (rc = winj_thread_string_wrap
+                         (thread, copy, coder, &string)))
+      result->l = string;
+  }
+  return rc;
 }
 
-static jint JNICALL
-JNI__AttachCurrentThreadAsDaemon
-(JavaVM *jvm, void **p_jnienv, void *thr_args)
+struct winj_intrinsic {
+  const char *cls;  /* name of class which has the method */
+  const char *name; /* method name followed by its descriptor */
+  u2 access_flags;
+  int (*call)(struct winj_thread *thread, struct winj_method *method,
+              jvalue *result, jobject self, unsigned arg_count,
+              struct winj_argument *args);
+} winj_intrinsics[] = {
+#define WINJ_STATIC (WINJ_ACCESS_PUBLIC | WINJ_ACCESS_STATIC)
+  { "java/lang/String", "<init>()V", WINJ_ACCESS_PUBLIC,
+    winj_string_init },
+  { "java/lang/String", "length()I", WINJ_ACCESS_PUBLIC,
+    winj_string_length },
+  { "java/lang/String", "charAt(I)C", WINJ_ACCESS_PUBLIC,
+    winj_string_char_at },
+  { "java/lang/String", "equals(Ljava/lang/Object;)Z", WINJ_ACCESS_PUBLIC,
+    winj_string_equals },
+  { "java/lang/String", "hashCode()I", WINJ_ACCESS_PUBLIC,
+    winj_string_hash_code },
+  { "java/lang/String", "indexOf(I)I", WINJ_ACCESS_PUBLIC,
+    winj_string_index_of },
+  { "java/lang/String", "indexOf(II)I", WINJ_ACCESS_PUBLIC,
+    winj_string_index_of },
+  { "java/lang/String", "indexOf(Ljava/lang/String;)I",
+    WINJ_ACCESS_PUBLIC, winj_string_index_of_string },
+  { "java/lang/String", "indexOf(Ljava/lang/String;I)I",
+    WINJ_ACCESS_PUBLIC, winj_string_index_of_string },
+
+  { "java/lang/StringBuilder", "<init>()V", WINJ_ACCESS_PUBLIC,
+    winj_builder_init },
+  { "java/lang/StringBuilder",
+    "append(Ljava/lang/String;)Ljava/lang/StringBuilder;",
+    WINJ_ACCESS_PUBLIC, winj_builder_append_string },
+  { "java/lang/StringBuilder", "append(C)Ljava/lang/StringBuilder;",
+    WINJ_ACCESS_PUBLIC, winj_builder_append_char },
+  { "java/lang/StringBuilder", "append(Z)Ljava/lang/StringBuilder;",
+    WINJ_ACCESS_PUBLIC, winj_builder_append_boolean },
+  { "java/lang/StringBuilder", "append(I)Ljava/lang/StringBuilder;",
+    WINJ_ACCESS_PUBLIC, winj_builder_append_int },
+  { "java/lang/StringBuilder", "append(J)Ljava/lang/StringBuilder;",
+    WINJ_ACCESS_PUBLIC, winj_builder_append_long_value },
+  { "java/lang/StringBuilder", "length()I", WINJ_ACCESS_PUBLIC,
+    winj_builder_length },
+  { "java/lang/StringBuilder", "toString()Ljava/lang/String;",
+    WINJ_ACCESS_PUBLIC, winj_builder_to_string },
+
+  { "java/lang/Integer", "parseInt(Ljava/lang/String;)I", WINJ_STATIC,
+    winj_integer_parse_int },
+  { "java/lang/Integer", "parseInt(Ljava/lang/String;I)I", WINJ_STATIC,
+    winj_integer_parse_int },
+
+  { "java/lang/Math", "abs(I)I", WINJ_STATIC, winj_math_abs_int },
+  { "java/lang/Math", "abs(J)J", WINJ_STATIC, winj_math_abs_long },
+  { "java/lang/Math", "abs(F)F", WINJ_STATIC, winj_math_abs_float },
+  { "java/lang/Math", "abs(D)D", WINJ_STATIC, winj_math_abs_double },
+  { "java/lang/Math", "max(II)I", WINJ_STATIC, winj_math_max_int },
+  { "java/lang/Math", "min(II)I", WINJ_STATIC, winj_math_min_int },
+  { "java/lang/Math", "max(JJ)J", WINJ_STATIC, winj_math_max_long },
+  { "java/lang/Math", "min(JJ)J", WINJ_STATIC, winj_math_min_long },
+  { "java/lang/Math", "max(FF)F", WINJ_STATIC, winj_math_max_float },
+  { "java/lang/Math", "min(FF)F", WINJ_STATIC, winj_math_min_float },
+  { "java/lang/Math", "max(DD)D", WINJ_STATIC, winj_math_max_double },
+  { "java/lang/Math", "min(DD)D", WINJ_STATIC, winj_math_min_double },
+  { "java/lang/Math", "sqrt(D)D",  WINJ_STATIC, winj_math_sqrt },
+  { "java/lang/Math", "cbrt(D)D",  WINJ_STATIC, winj_math_cbrt },
+  { "java/lang/Math", "exp(D)D",   WINJ_STATIC, winj_math_exp },
+  { "java/lang/Math", "log(D)D",   WINJ_STATIC, winj_math_log },
+  { "java/lang/Math", "log10(D)D", WINJ_STATIC, winj_math_log10 },
+  { "java/lang/Math", "sin(D)D",   WINJ_STATIC, winj_math_sin },
+  { "java/lang/Math", "cos(D)D",   WINJ_STATIC, winj_math_cos },
+  { "java/lang/Math", "tan(D)D",   WINJ_STATIC, winj_math_tan },
+  { "java/lang/Math", "asin(D)D",  WINJ_STATIC, winj_math_asin },
+  { "java/lang/Math", "acos(D)D",  WINJ_STATIC, winj_math_acos },
+  { "java/lang/Math", "atan(D)D",  WINJ_STATIC, winj_math_atan },
+  { "java/lang/Math", "floor(D)D", WINJ_STATIC, winj_math_floor },
+  { "java/lang/Math", "ceil(D)D",  WINJ_STATIC, winj_math_ceil },
+  { "java/lang/Math", "rint(D)D",  WINJ_STATIC, winj_math_rint },
+  { "java/lang/Math", "pow(DD)D",  WINJ_STATIC, winj_math_pow },
+  { "java/lang/Math", "atan2(DD)D", WINJ_STATIC, winj_math_atan2 },
+  { "java/lang/Math", "hypot(DD)D", WINJ_STATIC, winj_math_hypot },
+  { "java/lang/Math", "round(D)J", WINJ_STATIC, winj_math_round_double },
+  { "java/lang/Math", "round(F)I", WINJ_STATIC, winj_math_round_float },
+
+  { "java/lang/System",
+    "arraycopy(Ljava/lang/Object;ILjava/lang/Object;II)V", WINJ_STATIC,
+    winj_system_arraycopy },
+
+  { "java/util/Arrays", "fill([ZZ)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([BB)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([CC)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([SS)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([II)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([JJ)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([FF)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([DD)V", WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "fill([Ljava/lang/Object;Ljava/lang/Object;)V",
+    WINJ_STATIC, winj_arrays_fill },
+  { "java/util/Arrays", "equals([Z[Z)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([B[B)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([C[C)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([S[S)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([I[I)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([J[J)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([F[F)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "equals([D[D)Z", WINJ_STATIC,
+    winj_arrays_equals },
+  { "java/util/Arrays", "mismatch([Z[Z)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([B[B)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([C[C)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([S[S)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([I[I)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([J[J)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([F[F)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "mismatch([D[D)I", WINJ_STATIC,
+    winj_arrays_mismatch },
+  { "java/util/Arrays", "hashCode([Z)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([B)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([C)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([S)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([I)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([J)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([F)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+  { "java/util/Arrays", "hashCode([D)I", WINJ_STATIC,
+    winj_arrays_hash_code },
+#undef WINJ_STATIC
+};
+
+/**
+ * Install the intrinsics registered for a class.  Methods the class
+ * already has get their call replaced, so intrinsics win over byte
+ * code, while any others are declared only if requested.
+ *
+ * @param params parameters for system customization
+ * @param cls class in which to install intrinsics
+ * @param name_len number of bytes in name of class
+ * @param name name of class, which may not yet be set
+ * @param declare non-zero to add methods the class lacks
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_class_intrinsics
+(struct winj_vm_params *params, struct winj_class *cls,
+ unsigned name_len, const char *name, int declare)
 {
-  struct winj_vm *vm = (struct winj_vm *)jvm;
-  (void)vm;
-  return JNI_ERR; /* not yet implemented */
+  int result = EXIT_SUCCESS;
+  unsigned count = sizeof(winj_intrinsics) / sizeof(*winj_intrinsics);
+  unsigned ii;
+
+  if (name && !name_len)
+    name_len = strlen(name);
+  for (ii = 0; (EXIT_SUCCESS == result) && (ii < count); ++ii) {
+    const struct winj_intrinsic *intrinsic = &winj_intrinsics[ii];
+    struct winj_method *found = NULL;
+    struct winj_method method;
+
+    if ((strlen(intrinsic->cls) != name_len) ||
+        memcmp(intrinsic->cls, name, name_len))
+      continue;
+    if (intrinsic->access_flags & WINJ_ACCESS_STATIC)
+      winj_class_static_method_search(cls, 0, intrinsic->name, &found);
+    else winj_class_method_search(cls, 0, intrinsic->name, &found);
+
+    if (found) {
+      found->call = intrinsic->call;
+      continue;
+    } else if (!declare)
+      continue;
+
+    memset(&method, 0, sizeof(method));
+    method.access_flags = intrinsic->access_flags;
+    method.call = intrinsic->call;
+    if (EXIT_SUCCESS != (result = winj_string_copy
+                         (params, 0, intrinsic->name,
+                          &method.name_len, &method.name))) {
+    } else if (EXIT_SUCCESS != (result = winj_method_signature
+                                (params, &method))) {
+    } else if ((method.access_flags & WINJ_ACCESS_STATIC) &&
+               (EXIT_SUCCESS != (result = winj_class_static_method_store
+                                 (params, cls, &method)))) {
+    } else if (!(method.access_flags & WINJ_ACCESS_STATIC) &&
+               (EXIT_SUCCESS != (result = winj_class_method_store
+                                 (params, cls, &method)))) {
+    } else {
+      method.name = NULL;
+      method.signature.types = NULL;
+    }
+    winj_free(params, method.name);
+    winj_free(params, method.signature.types);
+  }
+  return result;
 }
 
-static void
-winj_vm_params_init(struct winj_vm_params *params, void *vm_args)
+/**
+ * Make a class from nothing but its intrinsics, for use when no class
+ * file can be found.
+ *
+ * @param vm virtual machine in which to create class
+ * @param name_len number of bytes in name of class
+ * @param name name of class to create
+ * @param class_out destination for class or NULL if none registered
+ * @return EXIT_SUCCESS unless something went wrong */
+static int
+winj_vm_class_intrinsic
+(struct winj_vm *vm, unsigned name_len, const char *name,
+ struct winj_class **class_out)
 {
-  /* TODO: support required parameters from JNI specification */
-  /* TODO: realloc */
-  /* TODO: logv */
-  /* TODO: getenv */
-  /* TODO: find_class */
+  int result = EXIT_SUCCESS;
+  unsigned count = sizeof(winj_intrinsics) / sizeof(*winj_intrinsics);
+  unsigned ii;
+
+  *class_out = NULL;
+  for (ii = 0; ii < count; ++ii)
+    if ((strlen(winj_intrinsics[ii].cls) == name_len) &&
+        !memcmp(winj_intrinsics[ii].cls, name, name_len)) {
+      result = winj_vm_class_synthetic
+        (vm, name_len, name, "java/lang/Object",
+         0, NULL, 0, NULL, class_out);
+      break;
+    }
+  return result;
 }
 
 struct winj_class_spec {
@@ -5209,12 +14138,60 @@ struct winj_class_spec {
   unsigned method_count;
   struct winj_method *methods;
 } builtin_classes[] = {
-  { "java/lang/Object", NULL },
+  { "java/lang/Object", NULL, WINJ_ACCESS_PUBLIC, 0, NULL,
+    sizeof(builtin_object_methods) / sizeof(*builtin_object_methods),
+    builtin_object_methods },
   { "java/lang/Class", "java/lang/Object" },
   { "java/lang/Array", "java/lang/Object" },
-  { "java/lang/String", "java/lang/Object" },  
+  { "java/lang/String", "java/lang/Object",
+    WINJ_ACCESS_PUBLIC | WINJ_ACCESS_FINAL,
+    sizeof(builtin_string_fields) / sizeof(*builtin_string_fields),
+    builtin_string_fields },
+  { "java/lang/StringBuilder", "java/lang/Object",
+    WINJ_ACCESS_PUBLIC | WINJ_ACCESS_FINAL,
+    sizeof(builtin_builder_fields) / sizeof(*builtin_builder_fields),
+    builtin_builder_fields },
+  { "java/lang/System", "java/lang/Object", WINJ_ACCESS_PUBLIC, 0, NULL,
+    sizeof(builtin_system_methods) / sizeof(*builtin_system_methods),
+    builtin_system_methods },
 };
 
+/**
+ * Find the fields of built in classes which intrinsics use directly.
+ *
+ * @param vm virtual machine with built in classes
+ * @return EXIT_SUCCESS unless a field is missing */
+static int
+winj_vm_offsets(struct winj_vm *vm)
+{
+  int result = EXIT_SUCCESS;
+  struct {
+    struct winj_class *cls;
+    const char *name;
+    unsigned *offset;
+  } wanted[] = {
+    { vm->class_string,  "value[B", &vm->offsets.string_value },
+    { vm->class_string,  "coderB",  &vm->offsets.string_coder },
+    { vm->class_string,  "hashI",   &vm->offsets.string_hash },
+    { vm->class_builder, "value[C", &vm->offsets.builder_value },
+    { vm->class_builder, "countI",  &vm->offsets.builder_count },
+  };
+  unsigned ii;
+
+  for (ii = 0; (EXIT_SUCCESS == result) &&
+         (ii < sizeof(wanted) / sizeof(*wanted)); ++ii) {
+    struct winj_field *field = NULL;
+
+    winj_class_field_search(wanted[ii].cls, 0, wanted[ii].name, &field);
+    if (!field)
+      result = winj_error(&vm->params, "missing field %.*s.%s",
+                          wanted[ii].cls->name_len, wanted[ii].cls->name,
+                          wanted[ii].name);
+    else *wanted[ii].offset = field->offset;
+  }
+  return result;
+}
+
 /**
  * Create a Java Virtual Machine instance.
  *
@@ -5232,13 +14209,30 @@ winj_vm_create(struct winj_vm_params *params, struct winj_vm **vm)
     result = winj_error(params, "failed to allocate %u bytes "
                          "for vm", sizeof(*out));
   } else {
+    out->gc.threshold = WINJ_GC_THRESHOLD;
     unsigned count = sizeof(builtin_classes)/sizeof(*builtin_classes);
+    const char *mode = params->getenv ?
+      params->getenv(params->context, "WINJ_GC") : getenv("WINJ_GC");
 
     out->params = *params;
+    out->gc.generational = !mode || strcmp(mode, "marksweep");
+    out->gc.born = out->gc.generational ? 0 : WINJ_OBJECT_OLD;
+    winj_kernels_select
+      (&out->kernels, params->getenv ?
+       params->getenv(params->context, "WINJ_SIMD") : getenv("WINJ_SIMD"));
+#ifdef WINJ_JIT
+    /* WINJ_JIT is either "off" or the hotness at which to compile. */
+    mode = params->getenv ?
+      params->getenv(params->context, "WINJ_JIT") : getenv("WINJ_JIT");
+    out->jit.threshold = !mode ? WINJ_JIT_THRESHOLD :
+      !strcmp(mode, "off") ? 0 : (atoi(mode) > 0) ?
+      (unsigned)atoi(mode) : WINJ_JIT_THRESHOLD;
+#endif
 
     for (ii = 0; (result == EXIT_SUCCESS) && (ii < count); ++ii)
       result = winj_vm_class_synthetic
         (out, 0, builtin_classes[ii].name,
+         builtin_classes[ii].parent,
          builtin_classes[ii].field_count,
          builtin_classes[ii].fields,
          builtin_classes[ii].method_count,
@@ -5252,6 +14246,13 @@ winj_vm_create(struct winj_vm_params *params, struct winj_vm **vm)
   } else if (EXIT_SUCCESS !=
              (result = winj_vm_class_lookup
               (out, 0, "java/lang/Array", &out->class_array))) {
+  } else if (EXIT_SUCCESS !=
+             (result = winj_vm_class_lookup
+              (out, 0, "java/lang/String", &out->class_string))) {
+  } else if (EXIT_SUCCESS !=
+             (result = winj_vm_class_lookup
+              (out, 0, "java/lang/StringBuilder", &out->class_builder))) {
+  } else if (EXIT_SUCCESS != (result = winj_vm_offsets(out))) {
   } else if (vm) {
     out->table_invoke.DestroyJavaVM = JNI__DestroyJavaVM;
     out->table_invoke.GetEnv = JNI__GetEnv;
@@ -5561,8 +14562,9 @@ winj_vm_create(struct winj_vm_params *params, struct winj_vm **vm)
     /* java.lang.Class is a synthentic class so it and other synthetic
      * classes must be created without a pointer to it.  This should
      * fix that right up... */
-    for (ii = 0; ii < out->class_count; ++ii)
-      out->classes[ii]->self.cls = out->class_class;
+    for (ii = 0; ii < out->class_capacity; ++ii)
+      if (out->classes[ii])
+        out->classes[ii]->self.cls = out->class_class;
 
     *vm = out;
     out = NULL;
@@ -5571,6 +14573,54 @@ winj_vm_create(struct winj_vm_params *params, struct winj_vm **vm)
   return result;
 }
 
+jint JNICALL
+WINJ_GetGCStats(JavaVM *jvm, WINJGCStats *stats)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  struct winj_region *region = NULL;
+  jint result = JNI_OK;
+
+  if (!vm || !stats) {
+    result = JNI_EINVAL;
+  } else {
+    memset(stats, 0, sizeof(*stats));
+    stats->collections = vm->gc.collections;
+    stats->pause_total = vm->gc.pause_total;
+    stats->pause_last  = vm->gc.pause_last;
+    stats->pause_max   = vm->gc.pause_max;
+    stats->live_bytes  = vm->gc.live_bytes;
+    stats->freed_bytes = vm->gc.freed_bytes;
+    stats->minor_collections = vm->gc.minor_collections;
+    stats->minor_pause_total = vm->gc.minor_pause_total;
+    stats->minor_pause_max   = vm->gc.minor_pause_max;
+    stats->promoted_bytes    = vm->gc.promoted_bytes;
+    for (region = vm->regions; region; region = region->next)
+      stats->heap_bytes += region->size;
+    for (region = vm->nursery; region; region = region->next)
+      stats->heap_bytes += region->size;
+  }
+  return result;
+}
+
+jint JNICALL
+WINJ_GetJITStats(JavaVM *jvm, WINJJITStats *stats)
+{
+  struct winj_vm *vm = (struct winj_vm *)jvm;
+  jint result = JNI_OK;
+
+  if (!vm || !stats) {
+    result = JNI_EINVAL;
+  } else {
+    memset(stats, 0, sizeof(*stats));
+#ifdef WINJ_JIT
+    stats->compiled   = vm->jit.compiled;
+    stats->code_bytes = vm->jit.code_bytes;
+    stats->entries    = vm->jit.entries;
+#endif
+  }
+  return result;
+}
+
 jint JNICALL
 JNI_CreateJavaVM(JavaVM **p_jvm, void **p_jnienv, void *vm_args)
 {